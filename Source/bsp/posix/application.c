@@ -0,0 +1,63 @@
+/*
+ * Application of the hosted board: one thread with a host sized stack, the
+ * applications built into the image are started from it.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_TEST
+#include <stdlib.h>
+#include "test.h"
+#endif
+#ifdef RT_USING_BENCHMARK
+#include "bench.h"
+#endif
+
+#ifndef RT_APP_THREAD_STACK_SIZE
+#define RT_APP_THREAD_STACK_SIZE    (64 * 1024)
+#endif
+#ifndef RT_APP_THREAD_PRIORITY
+#define RT_APP_THREAD_PRIORITY      (RT_THREAD_PRIORITY_MAX / 3)
+#endif
+
+static void rt_init_thread_entry(void *parameter)
+{
+#if defined(RT_USING_TEST)
+    int failed;
+
+    failed = test_run(RT_NULL);
+
+#ifdef RT_USING_KPRINTF_ASYNC
+    rt_kprintf_flush();
+#endif
+
+    /* the exit status tells if a test failed */
+    exit(failed != 0);
+#elif defined(RT_USING_BENCHMARK)
+    bench_run(RT_NULL);
+
+#ifdef RT_USING_KPRINTF_ASYNC
+    rt_kprintf_flush();
+#endif
+
+    /* the process exits when the benchmarks are done */
+    rt_hw_cpu_shutdown();
+#else
+    rt_kprintf("hello, RT-Thread on POSIX host\n");
+#endif
+}
+
+int rt_application_init(void)
+{
+    rt_thread_t tid;
+
+    tid = rt_thread_create("init",
+                           rt_init_thread_entry, RT_NULL,
+                           RT_APP_THREAD_STACK_SIZE, RT_APP_THREAD_PRIORITY, 20);
+    RT_ASSERT(tid != RT_NULL);
+
+    rt_thread_startup(tid);
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Board support for running RT-Thread as a Linux process.
+ *
+ * The OS tick is SIGALRM from an interval timer, and the system heap is a
+ * static array in the process image.
+ *
+ * With RT_USING_TICKLESS the tick is counted on the host monotonic clock:
+ * every SIGALRM announces the whole ticks elapsed since the last announced
+ * one, so the one-shot wakeup of the tickless idle and a late SIGALRM never
+ * count a tick twice.
+ *
+ * With RT_USING_CPU_USAGE the cycle counter of the run-time accounting is
+ * the host monotonic clock in nanoseconds.
+ *
+ * With RT_USING_SMP every cpu has its own tick, a timer which signals the
+ * host thread of the cpu, and the IPI of the scheduler is RT_SCHEDULE_IPI.
+ */
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "board.h"
+
+#ifdef RT_USING_HEAP
+ALIGN(RT_ALIGN_SIZE)
+static rt_uint8_t rt_heap[RT_HEAP_SIZE];
+#endif
+
+#if defined(RT_USING_TICKLESS) || defined(RT_USING_CPU_USAGE)
+static rt_uint64_t rt_hw_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rt_uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+/**
+ * This function will return the free-running cycle counter, which is the
+ * host monotonic clock in nanoseconds here.
+ *
+ * @return the cycle counter
+ */
+rt_uint64_t rt_hw_cycle_get(void)
+{
+    return rt_hw_time_ns();
+}
+
+/**
+ * This function will return the frequency of the cycle counter.
+ *
+ * @return the cycles per second
+ */
+rt_uint64_t rt_hw_cycle_freq(void)
+{
+    return 1000000000ULL;
+}
+#endif
+
+#ifdef RT_USING_TICKLESS
+#define TICK_NS                     (1000000000ULL / RT_TICK_PER_SECOND)
+
+/* host time of the last announced tick */
+static rt_uint64_t tick_last_ns;
+
+/* return the ticks elapsed since the last announced tick, and announce them */
+static rt_tick_t rt_hw_tick_elapsed(void)
+{
+    rt_uint64_t ticks;
+
+    ticks = (rt_hw_time_ns() - tick_last_ns) / TICK_NS;
+    tick_last_ns += ticks * TICK_NS;
+
+    return (rt_tick_t)ticks;
+}
+
+/* program the interval timer to expire at the host time 'expire_ns' */
+static void rt_hw_timer_set(rt_uint64_t expire_ns, rt_uint64_t interval_ns)
+{
+    struct itimerval itimer;
+    rt_uint64_t now_ns, delta_ns;
+
+    now_ns = rt_hw_time_ns();
+    /* an expired deadline still needs a signal to wake up the sleeper */
+    delta_ns = expire_ns > now_ns ? expire_ns - now_ns : 1000;
+
+    itimer.it_value.tv_sec     = delta_ns / 1000000000ULL;
+    itimer.it_value.tv_usec    = (delta_ns % 1000000000ULL + 999) / 1000;
+    itimer.it_interval.tv_sec  = interval_ns / 1000000000ULL;
+    itimer.it_interval.tv_usec = (interval_ns % 1000000000ULL) / 1000;
+    setitimer(ITIMER_REAL, &itimer, RT_NULL);
+}
+
+/**
+ * This function will stop the periodic tick and program the tick timer to
+ * expire after 'timeout' ticks.
+ *
+ * @param timeout the ticks to next timer expiry, RT_TICK_MAX for no timer
+ */
+void rt_hw_tick_suspend(rt_tick_t timeout)
+{
+    if (timeout > RT_TICKLESS_MAX_TICK)
+        timeout = RT_TICKLESS_MAX_TICK;
+
+    rt_hw_timer_set(tick_last_ns + timeout * TICK_NS, 0);
+}
+
+/**
+ * This function will restart the periodic tick, in phase with the ticks
+ * before suspending.
+ *
+ * @return the ticks elapsed while the tick was suspended
+ */
+rt_tick_t rt_hw_tick_resume(void)
+{
+    rt_tick_t ticks;
+
+    ticks = rt_hw_tick_elapsed();
+    rt_hw_timer_set(tick_last_ns + TICK_NS, TICK_NS);
+
+    return ticks;
+}
+#endif
+
+static void rt_hw_timer_isr(int vector, void *param)
+{
+#ifdef RT_USING_TICKLESS
+    rt_tick_increase_n(rt_hw_tick_elapsed());
+#else
+    rt_tick_increase();
+#endif
+}
+
+#ifdef RT_USING_SMP
+/* older C libraries don't name the thread of SIGEV_THREAD_ID */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id      _sigev_un._tid
+#endif
+
+/* start the tick of the running cpu */
+static void rt_hw_cpu_timer_start(void)
+{
+    struct sigevent event;
+    struct itimerspec its;
+    timer_t timer;
+
+    rt_memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo  = SIGALRM;
+    event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_MONOTONIC, &event, &timer) != 0)
+    {
+        rt_kprintf("cpu%d: no tick timer\n", rt_hw_cpu_id());
+        return;
+    }
+
+    its.it_interval.tv_sec  = 0;
+    its.it_interval.tv_nsec = 1000000000 / RT_TICK_PER_SECOND;
+    its.it_value = its.it_interval;
+    timer_settime(timer, 0, &its, RT_NULL);
+}
+
+/**
+ * This function will initialize the tick source of the hosted board and the
+ * IPI of the scheduler.
+ */
+void rt_hw_timer_init(void)
+{
+    rt_hw_interrupt_install(SIGALRM, rt_hw_timer_isr, RT_NULL, "tick");
+    rt_hw_interrupt_install(RT_SCHEDULE_IPI, rt_scheduler_ipi_handler, RT_NULL, "ipi");
+
+    rt_hw_cpu_timer_start();
+}
+
+/**
+ * This function is the entry of a secondary cpu, started by
+ * rt_hw_secondary_cpu_up() in its own host thread.
+ */
+void secondary_cpu_c_start(void)
+{
+    rt_hw_cpu_timer_start();
+
+    rt_system_scheduler_start();
+}
+#else
+/**
+ * This function will initialize the tick source of the hosted board.
+ */
+void rt_hw_timer_init(void)
+{
+    struct itimerval itimer;
+
+    rt_hw_interrupt_install(SIGALRM, rt_hw_timer_isr, RT_NULL, "tick");
+
+#ifdef RT_USING_TICKLESS
+    tick_last_ns = rt_hw_time_ns();
+#endif
+
+    itimer.it_interval.tv_sec  = 0;
+    itimer.it_interval.tv_usec = 1000000 / RT_TICK_PER_SECOND;
+    itimer.it_value = itimer.it_interval;
+    setitimer(ITIMER_REAL, &itimer, RT_NULL);
+}
+#endif
+
+/**
+ * This function will initialize the hosted board.
+ */
+void rt_hw_board_init(void)
+{
+    rt_hw_interrupt_init();
+
+    rt_hw_timer_init();
+
+#ifdef RT_USING_HEAP
+    rt_system_heap_init((void *)rt_heap, (void *)(rt_heap + RT_HEAP_SIZE));
+#endif
+}
@@ -0,0 +1,18 @@
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <rtthread.h>
+
+#ifndef RT_HEAP_SIZE
+#define RT_HEAP_SIZE                (1024 * 1024)
+#endif
+
+/* the longest sleep of the tickless idle */
+#ifndef RT_TICKLESS_MAX_TICK
+#define RT_TICKLESS_MAX_TICK        (RT_TICK_PER_SECOND * 60)
+#endif
+
+void rt_hw_board_init(void);
+void rt_hw_timer_init(void);
+
+#endif
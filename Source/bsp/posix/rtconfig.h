@@ -0,0 +1,89 @@
+#ifndef RT_CONFIG_H__
+#define RT_CONFIG_H__
+
+/* RT-Thread hosted on a POSIX (Linux) process, see libcpu/posix */
+
+#define ARCH_POSIX
+
+/* RT-Thread KERNEL */
+
+#define RT_NAME_MAX                    8
+#define RT_ALIGN_SIZE                  8
+#define RT_THREAD_PRIORITY_32
+#define RT_THREAD_PRIORITY_MAX         32
+#define RT_TICK_PER_SECOND             1000
+#define RT_DEBUG
+#define RT_USING_OVERFLOW_CHECK
+#define RT_DEBUG_INIT                  0
+#define RT_DEBUG_THREAD                0
+#define RT_USING_HOOK
+#define RT_USING_INTERRUPT_INFO
+#define RT_USING_OBJECT_HASH
+#define RT_USING_CPU_USAGE
+#define RT_CPU_USAGE_PERIOD            1000
+
+/* each cpu is a host thread, the IPI is SIGUSR2 */
+/* #define RT_USING_SMP */
+#ifdef RT_USING_SMP
+#define RT_CPUS_NR                     8
+#endif
+#define RT_SCHEDULE_IPI                12
+
+#ifndef RT_USING_SMP
+#define RT_USING_TICKLESS
+#endif
+
+/* signal handlers run on the thread stack, see RT_HW_STACK_MIN */
+#define RT_HW_STACK_MIN                (16 * 1024)
+#define IDLE_THREAD_STACK_SIZE         16384
+#define RT_TIMER_THREAD_STACK_SIZE     16384
+
+/* Inter-Thread Communication */
+
+#define RT_USING_IPC_PRIO_QUEUE
+#define RT_USING_IPC_FAST_PATH
+#define RT_USING_IPC_POLL
+#define RT_USING_IPC_PROFILE
+#define RT_USING_SEMAPHORE
+#define RT_USING_MUTEX
+#define RT_USING_RWLOCK
+#define RT_USING_EVENT
+#define RT_USING_EVENT_INDEX
+#define RT_USING_MAILBOX
+#define RT_USING_MAILBOX_SPSC
+#define RT_USING_MESSAGEQUEUE
+
+/* Memory Management */
+
+#define RT_USING_MEMPOOL
+#define RT_USING_MEMPOOL_LOCKFREE
+/* the per cpu magazines are only used with RT_USING_SMP */
+#define RT_USING_MEMPOOL_MAGAZINE
+#define RT_USING_MEMHEAP
+/* RT_USING_SLAB or RT_USING_TLSF may be given by make HEAP= instead */
+#if !defined(RT_USING_SLAB) && !defined(RT_USING_TLSF)
+#define RT_USING_SMALL_MEM
+#endif
+#define RT_USING_HEAP
+#define RT_HEAP_SIZE                   (8 * 1024 * 1024)
+
+/* KERNEL Device Object */
+#define RT_USING_DEVICE
+#define RT_USING_CONSOLE
+#define RT_CONSOLEBUF_SIZE             256
+#define RT_USING_KPRINTF_ASYNC
+#define RT_KPRINTF_ASYNC_SLOTS         64
+#define RT_KPRINTF_THREAD_STACK_SIZE   16384
+
+/* RT-Thread Components */
+
+#define RT_APP_THREAD_STACK_SIZE       (64 * 1024)
+
+/* kernel micro-benchmarks in examples/benchmark, run by the init thread */
+#define RT_USING_BENCHMARK
+
+/* POSIX layer and C standard library */
+
+#define RT_USING_NEWLIB
+
+#endif
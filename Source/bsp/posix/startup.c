@@ -0,0 +1,68 @@
+/*
+ * Entry of the hosted RT-Thread process.
+ *
+ * The sequence is the same as rtthread_startup() in components.c, the
+ * application thread is created by rt_application_init() of the application
+ * linked with this board, e.g. examples/benchmark.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "board.h"
+
+extern int rt_application_init(void);
+
+/**
+ * This function will startup RT-Thread RTOS.
+ */
+void rtthread_startup(void)
+{
+    /* board level initialization */
+    rt_hw_board_init();
+
+    /* show RT-Thread version */
+    rt_show_version();
+
+    /* timer system initialization */
+    rt_system_timer_init();
+
+    /* scheduler system initialization */
+    rt_system_scheduler_init();
+
+    /* create application thread */
+    rt_application_init();
+
+    /* timer thread initialization */
+    rt_system_timer_thread_init();
+
+#if defined(RT_USING_CONSOLE) && defined(RT_USING_KPRINTF_ASYNC)
+    /* log thread initialization */
+    rt_kprintf_thread_init();
+#endif
+
+    /* idle thread initialization */
+    rt_thread_idle_init();
+
+#ifdef RT_USING_SMP
+    /* the secondary cpus start their scheduler in their host threads */
+    rt_hw_secondary_cpu_up();
+#endif
+
+    /* start scheduler */
+    rt_system_scheduler_start();
+
+    /* never reach here */
+    return;
+}
+
+int main(void)
+{
+    /* disable interrupt first */
+    rt_hw_interrupt_disable();
+
+    /* startup RT-Thread RTOS */
+    rtthread_startup();
+
+    return 0;
+}
@@ -0,0 +1,288 @@
+/*
+ * Kernel micro-benchmarks: time source, result reporting and the runner.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "bench.h"
+
+#ifdef ARCH_POSIX
+#include <signal.h>
+#include <time.h>
+#endif
+
+static const struct bench_case bench_cases[] =
+{
+    {"sched_yield",   bench_sched_yield},
+    {"sem_pingpong",  bench_sem_pingpong},
+    {"mb_pingpong",   bench_mb_pingpong},
+    {"mq_pingpong",   bench_mq_pingpong},
+    {"sem_waiters",   bench_sem_waiters},
+    {"event_waiters", bench_event_waiters},
+    {"lock",          bench_lock},
+    {"mutex_chain",   bench_mutex_chain},
+    {"rwlock",        bench_rwlock},
+    {"mb_fanin",      bench_mb_fanin},
+    {"mb_fanout",     bench_mb_fanout},
+    {"mq_fanin",      bench_mq_fanin},
+    {"mq_fanout",     bench_mq_fanout},
+    {"mq_frame",      bench_mq_frame},
+    {"ipc_batch",     bench_ipc_batch},
+    {"ipc_poll",      bench_ipc_poll},
+    {"irq_wakeup",    bench_irq_wakeup},
+    {"irq_mb",        bench_irq_mb},
+    {"timer",         bench_timer},
+    {"mem",           bench_mem},
+    {"mempool",       bench_mempool},
+    {"object_find",   bench_object_find},
+    {"smp",           bench_smp},
+};
+
+/**
+ * This function will return a monotonic time in nanosecond.
+ *
+ * The hosted port reads the host monotonic clock; other ports fall back to
+ * the OS tick, which is only good for the throughput numbers.
+ */
+rt_uint64_t bench_time_ns(void)
+{
+#ifdef ARCH_POSIX
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (rt_uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    return (rt_uint64_t)rt_tick_get() * (1000000000ULL / RT_TICK_PER_SECOND);
+#endif
+}
+
+/**
+ * This function will initialize a benchmark result.
+ *
+ * @param result the result object
+ * @param name the name of benchmark
+ * @param max_samples the maximum number of latency samples
+ *
+ * @return RT_EOK on successful, -RT_ENOMEM if the sample buffer can't be
+ *         allocated, the result is still usable but has no percentiles.
+ */
+rt_err_t bench_result_init(struct bench_result *result, const char *name, rt_uint32_t max_samples)
+{
+    rt_memset(result, 0, sizeof(struct bench_result));
+    result->name = name;
+
+    result->samples = (rt_uint32_t *)rt_malloc(max_samples * sizeof(rt_uint32_t));
+    if (result->samples == RT_NULL)
+        return -RT_ENOMEM;
+
+    result->max_samples = max_samples;
+
+    return RT_EOK;
+}
+
+/**
+ * This function will record the latency of one operation. It can be invoked
+ * by several threads or by interrupt service routine.
+ */
+void bench_result_sample(struct bench_result *result, rt_uint32_t ns)
+{
+    register rt_base_t level;
+
+    level = rt_hw_interrupt_disable();
+    if (result->nr_samples < result->max_samples)
+        result->samples[result->nr_samples ++] = ns;
+    rt_hw_interrupt_enable(level);
+}
+
+static void bench_sort(rt_uint32_t *array, rt_uint32_t count)
+{
+    rt_uint32_t gap, i, j, value;
+
+    /* shell sort, no recursion on the thread stack */
+    for (gap = count / 2; gap > 0; gap /= 2)
+    {
+        for (i = gap; i < count; i ++)
+        {
+            value = array[i];
+            for (j = i; j >= gap && array[j - gap] > value; j -= gap)
+                array[j] = array[j - gap];
+            array[j] = value;
+        }
+    }
+}
+
+static rt_uint32_t bench_percentile(struct bench_result *result, rt_uint32_t percent)
+{
+    rt_uint32_t index;
+
+    if (result->nr_samples == 0)
+        return 0;
+
+    index = (rt_uint32_t)(((rt_uint64_t)result->nr_samples * percent) / 100);
+    if (index >= result->nr_samples)
+        index = result->nr_samples - 1;
+
+    return result->samples[index];
+}
+
+/**
+ * This function will print the result line of a benchmark and release the
+ * sample buffer.
+ */
+void bench_result_report(struct bench_result *result)
+{
+    rt_uint32_t ns_op = 0, ops_s = 0;
+
+    if (result->ops != 0 && result->elapsed != 0)
+    {
+        ns_op = (rt_uint32_t)(result->elapsed / result->ops);
+        ops_s = (rt_uint32_t)(((rt_uint64_t)result->ops * 1000000000ULL) / result->elapsed);
+    }
+
+    bench_sort(result->samples, result->nr_samples);
+
+    rt_kprintf("BENCH name=%s ops=%lu total_us=%lu ns_op=%lu ops_s=%lu "
+               "min=%lu p50=%lu p90=%lu p99=%lu max=%lu\n",
+               result->name,
+               result->ops,
+               (rt_uint32_t)(result->elapsed / 1000),
+               ns_op,
+               ops_s,
+               bench_percentile(result, 0),
+               bench_percentile(result, 50),
+               bench_percentile(result, 90),
+               bench_percentile(result, 99),
+               bench_percentile(result, 100));
+
+    if (result->samples != RT_NULL)
+        rt_free(result->samples);
+    result->samples = RT_NULL;
+    result->nr_samples = result->max_samples = 0;
+}
+
+/**
+ * This function will print the result line of a benchmark which can't run
+ * on this port or configuration.
+ */
+void bench_result_skip(const char *name, const char *reason)
+{
+    rt_kprintf("BENCH name=%s skipped=%s\n", name, reason);
+}
+
+/**
+ * This function will create a worker thread of benchmark, the thread is not
+ * started.
+ */
+rt_thread_t bench_thread_create(const char *name,
+                                void (*entry)(void *parameter),
+                                void       *parameter,
+                                rt_uint8_t  priority)
+{
+    return rt_thread_create(name, entry, parameter,
+                            BENCH_THREAD_STACK_SIZE, priority, BENCH_THREAD_TICK);
+}
+
+#ifdef ARCH_POSIX
+static void (*bench_irq_handler)(void *param);
+static void *bench_irq_param;
+
+static void bench_irq_isr(int vector, void *param)
+{
+    if (bench_irq_handler != RT_NULL)
+        bench_irq_handler(bench_irq_param);
+}
+
+/**
+ * This function will install the handler of the benchmark interrupt, which is
+ * SIGUSR1 on the hosted port.
+ */
+rt_err_t bench_irq_install(void (*handler)(void *param), void *param)
+{
+    bench_irq_handler = handler;
+    bench_irq_param   = param;
+
+    rt_hw_interrupt_install(SIGUSR1, bench_irq_isr, RT_NULL, "bench");
+    rt_hw_interrupt_umask(SIGUSR1);
+
+    return RT_EOK;
+}
+
+/**
+ * This function will raise the benchmark interrupt, it returns after the
+ * interrupt has been serviced.
+ */
+void bench_irq_trigger(void)
+{
+    raise(SIGUSR1);
+}
+
+void bench_irq_uninstall(void)
+{
+    rt_hw_interrupt_mask(SIGUSR1);
+
+    bench_irq_handler = RT_NULL;
+    bench_irq_param   = RT_NULL;
+}
+#else
+rt_err_t bench_irq_install(void (*handler)(void *param), void *param)
+{
+    return -RT_ENOSYS;
+}
+
+void bench_irq_trigger(void)
+{
+}
+
+void bench_irq_uninstall(void)
+{
+}
+#endif
+
+/**
+ * This function will run the benchmarks.
+ *
+ * @param name the name of benchmark to run, RT_NULL or "all" for all of them
+ *
+ * @return the number of benchmarks executed
+ */
+int bench_run(const char *name)
+{
+    int index, count = 0;
+
+    if (name != RT_NULL && rt_strcmp(name, "all") == 0)
+        name = RT_NULL;
+
+    rt_kprintf("BENCH_BEGIN version=%ld.%ld.%ld tick=%d loops=%d\n",
+               RT_VERSION, RT_SUBVERSION, RT_REVISION,
+               RT_TICK_PER_SECOND, BENCH_LOOPS);
+
+    for (index = 0; index < sizeof(bench_cases) / sizeof(bench_cases[0]); index ++)
+    {
+        if (name != RT_NULL && rt_strcmp(name, bench_cases[index].name) != 0)
+            continue;
+
+        bench_cases[index].run();
+        count ++;
+
+        /* the idle thread reclaims the workers exited */
+        rt_thread_delay(1);
+    }
+
+    rt_kprintf("BENCH_END count=%d\n", count);
+
+    return count;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int bench(int argc, char **argv)
+{
+    bench_run(argc > 1 ? argv[1] : RT_NULL);
+
+    return 0;
+}
+MSH_CMD_EXPORT(bench, run kernel micro-benchmarks: bench [name|all]);
+#endif
@@ -0,0 +1,106 @@
+/*
+ * Kernel micro-benchmarks.
+ *
+ * Every benchmark prints one result line in a fixed key=value format, so the
+ * numbers of two builds can be compared by a script:
+ *
+ * BENCH name=sem_pingpong ops=10000 total_us=21345 ns_op=2134 ops_s=468493 min=1980 p50=2101 p90=2230 p99=2901 max=15022
+ *
+ * the latency fields are in nanoseconds, "ops" is the number of measured
+ * operations and each benchmark documents what one operation is.
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <rtthread.h>
+
+#ifndef BENCH_LOOPS
+#define BENCH_LOOPS                 10000
+#endif
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP                100
+#endif
+
+#ifndef BENCH_THREAD_STACK_SIZE
+#ifdef ARCH_POSIX
+#define BENCH_THREAD_STACK_SIZE     (32 * 1024)
+#else
+#define BENCH_THREAD_STACK_SIZE     1024
+#endif
+#endif
+
+/* the benchmark runner is expected to run below these priorities */
+#define BENCH_PRIORITY_HIGH         (RT_THREAD_PRIORITY_MAX / 8)
+#define BENCH_PRIORITY_MIDDLE       (RT_THREAD_PRIORITY_MAX / 4)
+#define BENCH_PRIORITY_LOW          (RT_THREAD_PRIORITY_MAX / 2)
+
+#define BENCH_THREAD_TICK           10
+
+struct bench_result
+{
+    const char  *name;
+
+    rt_uint32_t  ops;                                   /**< number of measured operations */
+    rt_uint64_t  elapsed;                               /**< wall time of all operations, ns */
+
+    rt_uint32_t *samples;                               /**< latency of each operation, ns */
+    rt_uint32_t  nr_samples;
+    rt_uint32_t  max_samples;
+};
+
+struct bench_case
+{
+    const char *name;
+    void (*run)(void);
+};
+
+/* time source */
+rt_uint64_t bench_time_ns(void);
+
+/* result */
+rt_err_t bench_result_init(struct bench_result *result, const char *name, rt_uint32_t max_samples);
+void bench_result_sample(struct bench_result *result, rt_uint32_t ns);
+void bench_result_report(struct bench_result *result);
+void bench_result_skip(const char *name, const char *reason);
+
+/* worker threads */
+rt_thread_t bench_thread_create(const char *name,
+                                void (*entry)(void *parameter),
+                                void       *parameter,
+                                rt_uint8_t  priority);
+
+/* interrupt source for the ISR to thread wakeup */
+rt_err_t bench_irq_install(void (*handler)(void *param), void *param);
+void bench_irq_trigger(void);
+void bench_irq_uninstall(void);
+
+/* benchmarks */
+void bench_sched_yield(void);
+void bench_sem_pingpong(void);
+void bench_mb_pingpong(void);
+void bench_mq_pingpong(void);
+void bench_sem_waiters(void);
+void bench_event_waiters(void);
+void bench_lock(void);
+void bench_mutex_chain(void);
+void bench_rwlock(void);
+void bench_mb_fanin(void);
+void bench_mb_fanout(void);
+void bench_mq_fanin(void);
+void bench_mq_fanout(void);
+void bench_mq_frame(void);
+void bench_ipc_batch(void);
+void bench_ipc_poll(void);
+void bench_irq_wakeup(void);
+void bench_irq_mb(void);
+void bench_timer(void);
+void bench_mem(void);
+void bench_mempool(void);
+void bench_object_find(void);
+void bench_smp(void);
+
+int bench_run(const char *name);
+
+#endif
@@ -0,0 +1,1678 @@
+/*
+ * IPC benchmarks: semaphore, mutex, rwlock, mailbox and message queue.
+ *
+ * - pingpong: two threads bounce a token through a pair of IPC objects, one
+ *   operation is a round trip, i.e. two hand-offs and two context switches;
+ * - sem_waiters: 1 to 64 threads of the same priority wait on a semaphore of
+ *   RT_IPC_FLAG_PRIO, one operation is a release, which wakes the first one
+ *   and returns when it is pended again at the end of the queue. The
+ *   insertion is done with interrupt disabled;
+ * - event_waiters: one thread waits for a bit of an event and 1 to 64
+ *   threads wait for another bit which is not sent, one operation is a
+ *   send of the first bit, which returns when the first thread is pended
+ *   again. The waiters are searched with interrupt disabled;
+ * - lock: one thread takes and releases a free semaphore ("sem") and mutex
+ *   ("mutex"), one operation is a pair of calls, the latency is the average
+ *   of a batch. With RT_USING_IPC_FAST_PATH no interrupt is disabled. It's
+ *   run again with the contention profile started ("profiled");
+ * - mutex_chain: a high thread waits for a mutex held by a middle thread,
+ *   which waits for a mutex held by a low thread in its critical section,
+ *   and a hog thread between high and middle becomes ready as the section
+ *   goes on. One operation is one such chain, the latency is the blocking
+ *   time of the high thread from then, which is the section only if the low
+ *   thread is raised over the hog. It's run with priority inheritance
+ *   ("inherit") and with the ceilings set to the high priority ("ceiling"),
+ *   and skipped with RT_USING_SMP as the hog needs to share the cpu;
+ * - rwlock: 1 to 16 threads of the same priority read a table under a
+ *   mutex ("mutex") and under a rwlock taken for read ("read"), one
+ *   operation is one read, total_us is the wall time of all the readers and
+ *   the latency is the average of a batch. The readers of the rwlock don't
+ *   block each other, which shows on SMP and when a reader is preempted
+ *   in the section;
+ * - fanin/fanout: producers stream time stamped messages to consumers, one
+ *   operation is one message, the latency is from send to receive. Each is
+ *   run with the producers above ("hi"), at ("eq") and below ("lo") the
+ *   priority of the consumers;
+ * - irq_wakeup: an interrupt releases a semaphore a thread is blocked on,
+ *   one operation is one interrupt, the latency is from raising the
+ *   interrupt to the thread running;
+ * - irq_mb: an interrupt sends a burst of mails to a thread, one operation
+ *   is one rt_mb_send in the interrupt, the latency is of that call. It's
+ *   run on a mailbox with lock ("lock") and with RT_IPC_FLAG_SPSC ("spsc");
+ * - mq_frame: frames of 32 to 1024 bytes are written, sent, received and
+ *   checked by one thread, with rt_mq_send/rt_mq_recv ("copy") and with the
+ *   loaned buffers of rt_mq_loan/rt_mq_recv_loan ("loan"). One operation is
+ *   one frame, the latency is the average of a full queue;
+ * - ipc_batch: bursts of a full queue are sent to a thread above, which
+ *   drains them, through a mailbox ("mb") and a message queue ("mq"), item by
+ *   item ("single") and with the _n functions ("n"). One operation is one
+ *   item, the latency is the average of a burst and its ack;
+ * - ipc_poll: requests go round robin to a mailbox, a message queue and an
+ *   event, served by a thread for each ("threads") or by one thread with
+ *   rt_ipc_poll ("poll"), one operation is a request and its ack on a
+ *   semaphore, which is a round trip.
+ */
+
+#include <rtthread.h>
+
+#include "bench.h"
+
+#ifndef BENCH_QUEUE_DEPTH
+#define BENCH_QUEUE_DEPTH           32
+#endif
+
+#ifndef BENCH_MQ_MSG_SIZE
+#define BENCH_MQ_MSG_SIZE           32
+#endif
+
+#ifndef BENCH_STREAM_THREADS
+#define BENCH_STREAM_THREADS        4
+#endif
+
+#ifndef BENCH_IRQ_BURST
+#define BENCH_IRQ_BURST             8
+#endif
+
+/*
+ * An IPC object used as a blocking channel of 32 bits values.
+ */
+struct bench_channel
+{
+    const char *name;
+
+    void       *(*create)(void);
+    void        (*destroy)(void *object);
+    void        (*send)(void *object, rt_uint32_t value);
+    rt_uint32_t (*recv)(void *object);
+};
+
+static void *bench_sem_create(void)
+{
+    return rt_sem_create("bsem", 0, RT_IPC_FLAG_FIFO);
+}
+
+static void bench_sem_destroy(void *object)
+{
+    rt_sem_delete((rt_sem_t)object);
+}
+
+static void bench_sem_send(void *object, rt_uint32_t value)
+{
+    rt_sem_release((rt_sem_t)object);
+}
+
+static rt_uint32_t bench_sem_recv(void *object)
+{
+    rt_sem_take((rt_sem_t)object, RT_WAITING_FOREVER);
+
+    return 0;
+}
+
+static const struct bench_channel bench_sem_channel =
+{
+    "sem",
+    bench_sem_create, bench_sem_destroy, bench_sem_send, bench_sem_recv
+};
+
+static void *bench_mb_create(void)
+{
+    return rt_mb_create("bmb", BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+}
+
+static void bench_mb_destroy(void *object)
+{
+    rt_mb_delete((rt_mailbox_t)object);
+}
+
+static void bench_mb_send(void *object, rt_uint32_t value)
+{
+    rt_mb_send_wait((rt_mailbox_t)object, value, RT_WAITING_FOREVER);
+}
+
+static rt_uint32_t bench_mb_recv(void *object)
+{
+    rt_uint32_t value = 0;
+
+    rt_mb_recv((rt_mailbox_t)object, &value, RT_WAITING_FOREVER);
+
+    return value;
+}
+
+static const struct bench_channel bench_mb_channel =
+{
+    "mb",
+    bench_mb_create, bench_mb_destroy, bench_mb_send, bench_mb_recv
+};
+
+/*
+ * rt_mq_send() does not block on a full queue, a semaphore counting the free
+ * slots gives the producers the same back-pressure as the mailbox.
+ */
+struct bench_mq
+{
+    rt_mq_t  mq;
+    rt_sem_t slot;
+};
+
+struct bench_mq_msg
+{
+    rt_uint32_t value;
+    rt_uint8_t  payload[BENCH_MQ_MSG_SIZE - sizeof(rt_uint32_t)];
+};
+
+static void *bench_mq_create(void)
+{
+    struct bench_mq *bmq;
+
+    bmq = (struct bench_mq *)rt_malloc(sizeof(struct bench_mq));
+    if (bmq == RT_NULL)
+        return RT_NULL;
+
+    bmq->mq   = rt_mq_create("bmq", sizeof(struct bench_mq_msg), BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    bmq->slot = rt_sem_create("bslot", BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(bmq->mq != RT_NULL && bmq->slot != RT_NULL);
+
+    return bmq;
+}
+
+static void bench_mq_destroy(void *object)
+{
+    struct bench_mq *bmq = (struct bench_mq *)object;
+
+    rt_mq_delete(bmq->mq);
+    rt_sem_delete(bmq->slot);
+    rt_free(bmq);
+}
+
+static void bench_mq_send(void *object, rt_uint32_t value)
+{
+    struct bench_mq *bmq = (struct bench_mq *)object;
+    struct bench_mq_msg msg;
+
+    msg.value = value;
+
+    rt_sem_take(bmq->slot, RT_WAITING_FOREVER);
+    rt_mq_send(bmq->mq, &msg, sizeof(msg));
+}
+
+static rt_uint32_t bench_mq_recv(void *object)
+{
+    struct bench_mq *bmq = (struct bench_mq *)object;
+    struct bench_mq_msg msg;
+
+    rt_mq_recv(bmq->mq, &msg, sizeof(msg), RT_WAITING_FOREVER);
+    rt_sem_release(bmq->slot);
+
+    return msg.value;
+}
+
+static const struct bench_channel bench_mq_channel =
+{
+    "mq",
+    bench_mq_create, bench_mq_destroy, bench_mq_send, bench_mq_recv
+};
+
+/*
+ * ping-pong
+ */
+struct bench_pingpong
+{
+    const struct bench_channel *channel;
+    void *ping;
+    void *pong;
+
+    struct bench_result result;
+    rt_sem_t done;
+};
+
+static void bench_ping_entry(void *parameter)
+{
+    struct bench_pingpong *pp = (struct bench_pingpong *)parameter;
+    rt_uint64_t begin = 0, stamp;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        if (index == BENCH_WARMUP)
+            begin = bench_time_ns();
+
+        stamp = bench_time_ns();
+        pp->channel->send(pp->ping, index);
+        pp->channel->recv(pp->pong);
+        if (index >= BENCH_WARMUP)
+            bench_result_sample(&(pp->result), (rt_uint32_t)(bench_time_ns() - stamp));
+    }
+
+    pp->result.elapsed = bench_time_ns() - begin;
+    pp->result.ops     = BENCH_LOOPS;
+
+    rt_sem_release(pp->done);
+}
+
+static void bench_pong_entry(void *parameter)
+{
+    struct bench_pingpong *pp = (struct bench_pingpong *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+        pp->channel->send(pp->pong, pp->channel->recv(pp->ping));
+
+    rt_sem_release(pp->done);
+}
+
+static void bench_pingpong(const struct bench_channel *channel, const char *name)
+{
+    struct bench_pingpong pp;
+    rt_thread_t ping, pong;
+
+    pp.channel = channel;
+    pp.ping = channel->create();
+    pp.pong = channel->create();
+    pp.done = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(pp.ping != RT_NULL && pp.pong != RT_NULL && pp.done != RT_NULL);
+
+    bench_result_init(&(pp.result), name, BENCH_LOOPS);
+
+    ping = bench_thread_create("bping", bench_ping_entry, &pp, BENCH_PRIORITY_MIDDLE);
+    pong = bench_thread_create("bpong", bench_pong_entry, &pp, BENCH_PRIORITY_MIDDLE);
+    RT_ASSERT(ping != RT_NULL && pong != RT_NULL);
+
+    /* the pong side shall wait first */
+    rt_thread_startup(pong);
+    rt_thread_startup(ping);
+
+    rt_sem_take(pp.done, RT_WAITING_FOREVER);
+    rt_sem_take(pp.done, RT_WAITING_FOREVER);
+
+    bench_result_report(&(pp.result));
+
+    channel->destroy(pp.ping);
+    channel->destroy(pp.pong);
+    rt_sem_delete(pp.done);
+}
+
+void bench_sem_pingpong(void)
+{
+    bench_pingpong(&bench_sem_channel, "sem_pingpong");
+}
+
+void bench_mb_pingpong(void)
+{
+    bench_pingpong(&bench_mb_channel, "mb_pingpong");
+}
+
+void bench_mq_pingpong(void)
+{
+    bench_pingpong(&bench_mq_channel, "mq_pingpong");
+}
+
+/*
+ * semaphore with many waiters
+ */
+static const rt_uint32_t bench_waiters_count[] = {1, 16, 64};
+
+struct bench_waiters
+{
+    rt_sem_t sem;
+    rt_sem_t done;
+
+    volatile rt_bool_t stop;
+};
+
+static void bench_waiter_entry(void *parameter)
+{
+    struct bench_waiters *waiters = (struct bench_waiters *)parameter;
+
+    do
+    {
+        rt_sem_take(waiters->sem, RT_WAITING_FOREVER);
+    } while (!waiters->stop);
+
+    rt_sem_release(waiters->done);
+}
+
+static void bench_sem_waiters_run(rt_uint32_t count)
+{
+    struct bench_waiters waiters;
+    struct bench_result result;
+    rt_thread_t tid;
+    char name[RT_NAME_MAX * 4];
+    rt_uint32_t index;
+    rt_uint64_t begin = 0, stamp;
+
+    rt_snprintf(name, sizeof(name), "sem_waiters_%d", count);
+
+    waiters.sem  = rt_sem_create("bsem", 0, RT_IPC_FLAG_PRIO);
+    waiters.done = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    waiters.stop = RT_FALSE;
+    RT_ASSERT(waiters.sem != RT_NULL && waiters.done != RT_NULL);
+    bench_result_init(&result, name, BENCH_LOOPS);
+
+    /* the waiters run above the runner, each one is pended when started */
+    for (index = 0; index < count; index ++)
+    {
+        tid = bench_thread_create("bwait", bench_waiter_entry, &waiters, BENCH_PRIORITY_HIGH);
+        RT_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+    }
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        if (index == BENCH_WARMUP)
+            begin = bench_time_ns();
+
+        stamp = bench_time_ns();
+        rt_sem_release(waiters.sem);
+        if (index >= BENCH_WARMUP)
+            bench_result_sample(&result, (rt_uint32_t)(bench_time_ns() - stamp));
+    }
+    result.elapsed = bench_time_ns() - begin;
+    result.ops     = BENCH_LOOPS;
+
+    bench_result_report(&result);
+
+    waiters.stop = RT_TRUE;
+    for (index = 0; index < count; index ++)
+        rt_sem_release(waiters.sem);
+    for (index = 0; index < count; index ++)
+        rt_sem_take(waiters.done, RT_WAITING_FOREVER);
+
+    rt_sem_delete(waiters.sem);
+    rt_sem_delete(waiters.done);
+}
+
+void bench_sem_waiters(void)
+{
+    int index;
+
+    for (index = 0; index < sizeof(bench_waiters_count) / sizeof(bench_waiters_count[0]); index ++)
+        bench_sem_waiters_run(bench_waiters_count[index]);
+}
+
+/*
+ * event with many waiters
+ */
+#define BENCH_EVENT_PROBE           0x01
+#define BENCH_EVENT_IDLE            0x02
+
+struct bench_event_waiters
+{
+    rt_event_t event;
+    rt_sem_t   done;
+
+    volatile rt_bool_t stop;
+};
+
+static void bench_event_probe_entry(void *parameter)
+{
+    struct bench_event_waiters *waiters = (struct bench_event_waiters *)parameter;
+    rt_uint32_t recved;
+
+    do
+    {
+        rt_event_recv(waiters->event, BENCH_EVENT_PROBE,
+                      RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, &recved);
+    } while (!waiters->stop);
+
+    rt_sem_release(waiters->done);
+}
+
+static void bench_event_idle_entry(void *parameter)
+{
+    struct bench_event_waiters *waiters = (struct bench_event_waiters *)parameter;
+    rt_uint32_t recved;
+
+    rt_event_recv(waiters->event, BENCH_EVENT_IDLE,
+                  RT_EVENT_FLAG_OR, RT_WAITING_FOREVER, &recved);
+
+    rt_sem_release(waiters->done);
+}
+
+static void bench_event_waiters_run(rt_uint32_t count)
+{
+    struct bench_event_waiters waiters;
+    struct bench_result result;
+    rt_thread_t tid;
+    char name[RT_NAME_MAX * 4];
+    rt_uint32_t index;
+    rt_uint64_t begin = 0, stamp;
+
+    rt_snprintf(name, sizeof(name), "event_waiters_%d", count);
+
+    waiters.event = rt_event_create("bevt", RT_IPC_FLAG_PRIO);
+    waiters.done  = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    waiters.stop  = RT_FALSE;
+    RT_ASSERT(waiters.event != RT_NULL && waiters.done != RT_NULL);
+    bench_result_init(&result, name, BENCH_LOOPS);
+
+    /* the waiters run above the runner, each one is pended when started */
+    for (index = 0; index < count; index ++)
+    {
+        tid = bench_thread_create("bidle", bench_event_idle_entry, &waiters, BENCH_PRIORITY_MIDDLE);
+        RT_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+    }
+    tid = bench_thread_create("bprobe", bench_event_probe_entry, &waiters, BENCH_PRIORITY_HIGH);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        if (index == BENCH_WARMUP)
+            begin = bench_time_ns();
+
+        stamp = bench_time_ns();
+        rt_event_send(waiters.event, BENCH_EVENT_PROBE);
+        if (index >= BENCH_WARMUP)
+            bench_result_sample(&result, (rt_uint32_t)(bench_time_ns() - stamp));
+    }
+    result.elapsed = bench_time_ns() - begin;
+    result.ops     = BENCH_LOOPS;
+
+    bench_result_report(&result);
+
+    waiters.stop = RT_TRUE;
+    rt_event_send(waiters.event, BENCH_EVENT_PROBE | BENCH_EVENT_IDLE);
+    for (index = 0; index < count + 1; index ++)
+        rt_sem_take(waiters.done, RT_WAITING_FOREVER);
+
+    rt_event_delete(waiters.event);
+    rt_sem_delete(waiters.done);
+}
+
+void bench_event_waiters(void)
+{
+    int index;
+
+    for (index = 0; index < sizeof(bench_waiters_count) / sizeof(bench_waiters_count[0]); index ++)
+        bench_event_waiters_run(bench_waiters_count[index]);
+}
+
+/*
+ * uncontended locks
+ */
+#define BENCH_LOCK_BATCH            100
+
+static void bench_lock_run(const char *name, rt_sem_t sem, rt_mutex_t mutex)
+{
+    struct bench_result result;
+    rt_uint32_t loop, index;
+    rt_uint64_t stamp, ns;
+
+    if (bench_result_init(&result, name, BENCH_LOOPS) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+    for (loop = 0; loop < (BENCH_WARMUP + BENCH_LOOPS) / BENCH_LOCK_BATCH; loop ++)
+    {
+        stamp = bench_time_ns();
+        for (index = 0; index < BENCH_LOCK_BATCH; index ++)
+        {
+            if (sem != RT_NULL)
+            {
+                rt_sem_take(sem, RT_WAITING_FOREVER);
+                rt_sem_release(sem);
+            }
+            else
+            {
+                rt_mutex_take(mutex, RT_WAITING_FOREVER);
+                rt_mutex_release(mutex);
+            }
+        }
+        ns = bench_time_ns() - stamp;
+
+        if (loop >= BENCH_WARMUP / BENCH_LOCK_BATCH)
+        {
+            result.elapsed += ns;
+            result.ops     += BENCH_LOCK_BATCH;
+            for (index = 0; index < BENCH_LOCK_BATCH; index ++)
+                bench_result_sample(&result, (rt_uint32_t)(ns / BENCH_LOCK_BATCH));
+        }
+    }
+
+    bench_result_report(&result);
+}
+
+void bench_lock(void)
+{
+    rt_sem_t sem;
+    rt_mutex_t mutex;
+
+    sem   = rt_sem_create("bsem", 1, RT_IPC_FLAG_FIFO);
+    mutex = rt_mutex_create("bmutex", RT_IPC_FLAG_FIFO);
+    RT_ASSERT(sem != RT_NULL && mutex != RT_NULL);
+
+    bench_lock_run("lock_sem", sem, RT_NULL);
+    bench_lock_run("lock_mutex", RT_NULL, mutex);
+
+    /* the cost of the contention profile */
+#ifdef RT_USING_IPC_PROFILE
+    rt_ipc_profile_start();
+    bench_lock_run("lock_sem_profiled", sem, RT_NULL);
+    bench_lock_run("lock_mutex_profiled", RT_NULL, mutex);
+    rt_ipc_profile_stop();
+#else
+    bench_result_skip("lock_sem_profiled", "no_profile");
+    bench_result_skip("lock_mutex_profiled", "no_profile");
+#endif
+
+    rt_sem_delete(sem);
+    rt_mutex_delete(mutex);
+}
+
+/*
+ * nested mutexes, the helpers are only used on one cpu
+ */
+#ifndef RT_USING_SMP
+#define BENCH_CHAIN_LOOPS           (BENCH_LOOPS / 10)
+#define BENCH_CHAIN_SECTION         10000               /* ns */
+#define BENCH_CHAIN_HOG             100000              /* ns */
+
+struct bench_chain
+{
+    struct rt_mutex outer;                              /* held by middle, waited by high */
+    struct rt_mutex inner;                              /* held by low, waited by middle */
+
+    struct rt_semaphore high, hog, middle, low;         /* start an operation */
+    struct rt_semaphore section;                        /* lets low go on */
+    struct rt_semaphore done;
+
+    struct bench_result result;
+    volatile rt_uint64_t stamp;
+};
+
+static void bench_chain_spin(rt_uint32_t ns)
+{
+    rt_uint64_t end;
+
+    end = bench_time_ns() + ns;
+    while (bench_time_ns() < end);
+}
+
+static void bench_chain_high_entry(void *parameter)
+{
+    struct bench_chain *chain = (struct bench_chain *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_CHAIN_LOOPS; index ++)
+    {
+        rt_sem_take(&(chain->high), RT_WAITING_FOREVER);
+
+        rt_mutex_take(&(chain->outer), RT_WAITING_FOREVER);
+        bench_result_sample(&(chain->result), (rt_uint32_t)(bench_time_ns() - chain->stamp));
+        rt_mutex_release(&(chain->outer));
+
+        rt_sem_release(&(chain->done));
+    }
+}
+
+static void bench_chain_hog_entry(void *parameter)
+{
+    struct bench_chain *chain = (struct bench_chain *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_CHAIN_LOOPS; index ++)
+    {
+        rt_sem_take(&(chain->hog), RT_WAITING_FOREVER);
+
+        chain->stamp = bench_time_ns();
+        rt_sem_release(&(chain->section));
+        bench_chain_spin(BENCH_CHAIN_HOG);
+
+        rt_sem_release(&(chain->done));
+    }
+}
+
+static void bench_chain_middle_entry(void *parameter)
+{
+    struct bench_chain *chain = (struct bench_chain *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_CHAIN_LOOPS; index ++)
+    {
+        rt_sem_take(&(chain->middle), RT_WAITING_FOREVER);
+
+        rt_mutex_take(&(chain->outer), RT_WAITING_FOREVER);
+        rt_mutex_take(&(chain->inner), RT_WAITING_FOREVER);
+        rt_mutex_release(&(chain->inner));
+        rt_mutex_release(&(chain->outer));
+
+        rt_sem_release(&(chain->done));
+    }
+}
+
+static void bench_chain_low_entry(void *parameter)
+{
+    struct bench_chain *chain = (struct bench_chain *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_CHAIN_LOOPS; index ++)
+    {
+        rt_sem_take(&(chain->low), RT_WAITING_FOREVER);
+
+        rt_mutex_take(&(chain->inner), RT_WAITING_FOREVER);
+        rt_sem_take(&(chain->section), RT_WAITING_FOREVER);
+        bench_chain_spin(BENCH_CHAIN_SECTION);
+        rt_mutex_release(&(chain->inner));
+
+        rt_sem_release(&(chain->done));
+    }
+}
+
+static void bench_chain_run(const char *name, rt_bool_t ceiling)
+{
+    struct bench_chain chain;
+    rt_thread_t tid;
+    rt_uint32_t index;
+    rt_uint64_t begin;
+
+    if (bench_result_init(&(chain.result), name, BENCH_CHAIN_LOOPS) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+    rt_mutex_init(&(chain.outer), "bouter", RT_IPC_FLAG_PRIO);
+    rt_mutex_init(&(chain.inner), "binner", RT_IPC_FLAG_PRIO);
+    if (ceiling)
+    {
+        rt_mutex_setprioceiling(&(chain.outer), BENCH_PRIORITY_HIGH);
+        rt_mutex_setprioceiling(&(chain.inner), BENCH_PRIORITY_HIGH);
+    }
+    rt_sem_init(&(chain.high), "bhigh", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(chain.hog), "bhog", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(chain.middle), "bmiddle", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(chain.low), "blow", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(chain.section), "bsect", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&(chain.done), "bdone", 0, RT_IPC_FLAG_FIFO);
+
+    /* all of them run above the runner */
+    tid = bench_thread_create("bhigh", bench_chain_high_entry, &chain, BENCH_PRIORITY_HIGH);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    tid = bench_thread_create("bhog", bench_chain_hog_entry, &chain, BENCH_PRIORITY_HIGH + 1);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    tid = bench_thread_create("bmiddle", bench_chain_middle_entry, &chain, BENCH_PRIORITY_HIGH + 2);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    tid = bench_thread_create("blow", bench_chain_low_entry, &chain, BENCH_PRIORITY_HIGH + 3);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    begin = bench_time_ns();
+    for (index = 0; index < BENCH_CHAIN_LOOPS; index ++)
+    {
+        /* each one runs until it's blocked, the hog starts the section */
+        rt_sem_release(&(chain.low));
+        rt_sem_release(&(chain.middle));
+        rt_sem_release(&(chain.high));
+        rt_sem_release(&(chain.hog));
+
+        rt_sem_take(&(chain.done), RT_WAITING_FOREVER);
+        rt_sem_take(&(chain.done), RT_WAITING_FOREVER);
+        rt_sem_take(&(chain.done), RT_WAITING_FOREVER);
+        rt_sem_take(&(chain.done), RT_WAITING_FOREVER);
+    }
+    chain.result.elapsed = bench_time_ns() - begin;
+    chain.result.ops     = BENCH_CHAIN_LOOPS;
+
+    bench_result_report(&(chain.result));
+
+    rt_mutex_detach(&(chain.outer));
+    rt_mutex_detach(&(chain.inner));
+    rt_sem_detach(&(chain.high));
+    rt_sem_detach(&(chain.hog));
+    rt_sem_detach(&(chain.middle));
+    rt_sem_detach(&(chain.low));
+    rt_sem_detach(&(chain.section));
+    rt_sem_detach(&(chain.done));
+}
+#endif
+
+void bench_mutex_chain(void)
+{
+#ifdef RT_USING_SMP
+    bench_result_skip("mutex_chain_inherit", "smp");
+    bench_result_skip("mutex_chain_ceiling", "smp");
+#else
+    bench_chain_run("mutex_chain_inherit", RT_FALSE);
+    bench_chain_run("mutex_chain_ceiling", RT_TRUE);
+#endif
+}
+
+/*
+ * readers of a shared table
+ */
+#define BENCH_READERS_MAX           16
+#define BENCH_READERS_TABLE         16
+
+static const rt_uint32_t bench_readers_count[] = {1, 4, BENCH_READERS_MAX};
+
+struct bench_readers
+{
+#ifdef RT_USING_RWLOCK
+    rt_rwlock_t rwlock;
+#endif
+    rt_mutex_t mutex;
+
+    rt_uint32_t chunks;                                 /**< chunks of each reader */
+    volatile rt_uint32_t table[BENCH_READERS_TABLE];
+    volatile rt_uint32_t sink;
+
+    struct bench_result result;
+    rt_sem_t done;
+};
+
+static rt_uint32_t bench_readers_sum(struct bench_readers *readers)
+{
+    rt_uint32_t index, sum = 0;
+
+    for (index = 0; index < BENCH_READERS_TABLE; index ++)
+        sum += readers->table[index];
+
+    return sum;
+}
+
+static void bench_reader_entry(void *parameter)
+{
+    struct bench_readers *readers = (struct bench_readers *)parameter;
+    rt_uint32_t chunk, index, sum = 0;
+    rt_uint64_t stamp;
+
+    for (chunk = 0; chunk < readers->chunks; chunk ++)
+    {
+        stamp = bench_time_ns();
+        for (index = 0; index < BENCH_LOCK_BATCH; index ++)
+        {
+#ifdef RT_USING_RWLOCK
+            if (readers->rwlock != RT_NULL)
+            {
+                rt_rwlock_take_read(readers->rwlock, RT_WAITING_FOREVER);
+                sum += bench_readers_sum(readers);
+                rt_rwlock_release(readers->rwlock);
+
+                continue;
+            }
+#endif
+            rt_mutex_take(readers->mutex, RT_WAITING_FOREVER);
+            sum += bench_readers_sum(readers);
+            rt_mutex_release(readers->mutex);
+        }
+        bench_result_sample(&(readers->result),
+                            (rt_uint32_t)((bench_time_ns() - stamp) / BENCH_LOCK_BATCH));
+    }
+    readers->sink = sum;
+
+    rt_sem_release(readers->done);
+}
+
+static void bench_readers_run(const char *kind, rt_bool_t rwlock, rt_uint32_t count)
+{
+    struct bench_readers readers;
+    rt_thread_t threads[BENCH_READERS_MAX];
+    char name[RT_NAME_MAX * 4];
+    rt_uint32_t index;
+    rt_uint64_t stamp;
+
+    rt_snprintf(name, sizeof(name), "rwlock_%s_%d", kind, count);
+
+    rt_memset(&readers, 0, sizeof(readers));
+    readers.chunks = BENCH_LOOPS / BENCH_LOCK_BATCH / count;
+    if (bench_result_init(&(readers.result), name, readers.chunks * count) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+#ifdef RT_USING_RWLOCK
+    if (rwlock)
+        readers.rwlock = rt_rwlock_create("brwlock", RT_IPC_FLAG_PRIO);
+#endif
+    readers.mutex = rt_mutex_create("bmutex", RT_IPC_FLAG_PRIO);
+    readers.done  = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(readers.mutex != RT_NULL && readers.done != RT_NULL);
+    for (index = 0; index < BENCH_READERS_TABLE; index ++)
+        readers.table[index] = index;
+
+    /* the readers share the priority and the cpus */
+    for (index = 0; index < count; index ++)
+    {
+        threads[index] = bench_thread_create("breader", bench_reader_entry, &readers, BENCH_PRIORITY_MIDDLE);
+        RT_ASSERT(threads[index] != RT_NULL);
+    }
+
+    stamp = bench_time_ns();
+    for (index = 0; index < count; index ++)
+        rt_thread_startup(threads[index]);
+    for (index = 0; index < count; index ++)
+        rt_sem_take(readers.done, RT_WAITING_FOREVER);
+    readers.result.elapsed = bench_time_ns() - stamp;
+    readers.result.ops     = readers.chunks * count * BENCH_LOCK_BATCH;
+
+    bench_result_report(&(readers.result));
+
+#ifdef RT_USING_RWLOCK
+    if (readers.rwlock != RT_NULL)
+        rt_rwlock_delete(readers.rwlock);
+#endif
+    rt_mutex_delete(readers.mutex);
+    rt_sem_delete(readers.done);
+}
+
+void bench_rwlock(void)
+{
+    int index;
+
+    for (index = 0; index < sizeof(bench_readers_count) / sizeof(bench_readers_count[0]); index ++)
+    {
+        bench_readers_run("mutex", RT_FALSE, bench_readers_count[index]);
+#ifdef RT_USING_RWLOCK
+        bench_readers_run("read", RT_TRUE, bench_readers_count[index]);
+#else
+        bench_result_skip("rwlock_read", "no_rwlock");
+#endif
+    }
+}
+
+/*
+ * producer/consumer stream
+ */
+struct bench_stream
+{
+    const struct bench_channel *channel;
+    void *object;
+
+    rt_uint32_t per_producer;                           /**< messages sent by each producer */
+    rt_uint32_t per_consumer;                           /**< messages received by each consumer */
+
+    rt_uint64_t begin;
+    rt_uint64_t end;
+
+    struct bench_result result;
+    rt_sem_t done;
+};
+
+static const struct
+{
+    const char *name;
+    rt_uint8_t  producer;
+    rt_uint8_t  consumer;
+} bench_stream_priority[] =
+{
+    {"hi", BENCH_PRIORITY_HIGH,   BENCH_PRIORITY_MIDDLE},
+    {"eq", BENCH_PRIORITY_MIDDLE, BENCH_PRIORITY_MIDDLE},
+    {"lo", BENCH_PRIORITY_LOW,    BENCH_PRIORITY_MIDDLE},
+};
+
+static void bench_producer_entry(void *parameter)
+{
+    struct bench_stream *stream = (struct bench_stream *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < stream->per_producer; index ++)
+        stream->channel->send(stream->object, (rt_uint32_t)bench_time_ns());
+
+    rt_sem_release(stream->done);
+}
+
+static void bench_consumer_entry(void *parameter)
+{
+    struct bench_stream *stream = (struct bench_stream *)parameter;
+    rt_uint32_t index, stamp;
+
+    for (index = 0; index < stream->per_consumer; index ++)
+    {
+        stamp = stream->channel->recv(stream->object);
+        /* the time stamp is truncated to 32 bits, so is the difference */
+        bench_result_sample(&(stream->result), (rt_uint32_t)bench_time_ns() - stamp);
+    }
+
+    /* the last consumer finishing gives the end of stream */
+    stream->end = bench_time_ns();
+
+    rt_sem_release(stream->done);
+}
+
+static void bench_stream(const struct bench_channel *channel, const char *kind,
+                         int producers, int consumers)
+{
+    struct bench_stream stream;
+    rt_thread_t tid;
+    char name[RT_NAME_MAX * 4];
+    int index, prio;
+
+    for (prio = 0; prio < sizeof(bench_stream_priority) / sizeof(bench_stream_priority[0]); prio ++)
+    {
+        rt_snprintf(name, sizeof(name), "%s_%s_%s",
+                    channel->name, kind, bench_stream_priority[prio].name);
+
+        stream.channel = channel;
+        stream.object  = channel->create();
+        stream.done    = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+        RT_ASSERT(stream.object != RT_NULL && stream.done != RT_NULL);
+
+        /* the same number of messages in total whatever the shape is */
+        stream.per_producer = BENCH_LOOPS / producers;
+        stream.per_consumer = stream.per_producer * producers / consumers;
+
+        bench_result_init(&(stream.result), name, stream.per_consumer * consumers);
+
+        /* consumers first, they block on the empty channel */
+        for (index = 0; index < consumers; index ++)
+        {
+            tid = bench_thread_create("bcons", bench_consumer_entry, &stream,
+                                      bench_stream_priority[prio].consumer);
+            RT_ASSERT(tid != RT_NULL);
+            rt_thread_startup(tid);
+        }
+
+        stream.begin = bench_time_ns();
+        rt_enter_critical();
+        for (index = 0; index < producers; index ++)
+        {
+            tid = bench_thread_create("bprod", bench_producer_entry, &stream,
+                                      bench_stream_priority[prio].producer);
+            RT_ASSERT(tid != RT_NULL);
+            rt_thread_startup(tid);
+        }
+        rt_exit_critical();
+
+        for (index = 0; index < producers + consumers; index ++)
+            rt_sem_take(stream.done, RT_WAITING_FOREVER);
+
+        stream.result.ops     = stream.per_consumer * consumers;
+        stream.result.elapsed = stream.end - stream.begin;
+        bench_result_report(&(stream.result));
+
+        channel->destroy(stream.object);
+        rt_sem_delete(stream.done);
+    }
+}
+
+void bench_mb_fanin(void)
+{
+    bench_stream(&bench_mb_channel, "fanin", BENCH_STREAM_THREADS, 1);
+}
+
+void bench_mb_fanout(void)
+{
+    bench_stream(&bench_mb_channel, "fanout", 1, BENCH_STREAM_THREADS);
+}
+
+void bench_mq_fanin(void)
+{
+    bench_stream(&bench_mq_channel, "fanin", BENCH_STREAM_THREADS, 1);
+}
+
+void bench_mq_fanout(void)
+{
+    bench_stream(&bench_mq_channel, "fanout", 1, BENCH_STREAM_THREADS);
+}
+
+/*
+ * interrupt to thread wakeup
+ */
+struct bench_wakeup
+{
+    rt_sem_t sem;
+    rt_sem_t done;
+
+    volatile rt_uint64_t stamp;
+    struct bench_result result;
+};
+
+static void bench_wakeup_isr(void *param)
+{
+    struct bench_wakeup *wakeup = (struct bench_wakeup *)param;
+
+    rt_sem_release(wakeup->sem);
+}
+
+static void bench_wakeup_entry(void *parameter)
+{
+    struct bench_wakeup *wakeup = (struct bench_wakeup *)parameter;
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        rt_sem_take(wakeup->sem, RT_WAITING_FOREVER);
+        if (index >= BENCH_WARMUP)
+            bench_result_sample(&(wakeup->result), (rt_uint32_t)(bench_time_ns() - wakeup->stamp));
+    }
+
+    rt_sem_release(wakeup->done);
+}
+
+void bench_irq_wakeup(void)
+{
+    struct bench_wakeup wakeup;
+    rt_thread_t tid;
+    rt_uint64_t begin = 0;
+    rt_uint32_t index;
+
+    if (bench_irq_install(bench_wakeup_isr, &wakeup) != RT_EOK)
+    {
+        bench_result_skip("irq_wakeup", "no_irq_source");
+        return;
+    }
+
+    wakeup.sem  = rt_sem_create("bsem", 0, RT_IPC_FLAG_FIFO);
+    wakeup.done = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(wakeup.sem != RT_NULL && wakeup.done != RT_NULL);
+    bench_result_init(&(wakeup.result), "irq_wakeup", BENCH_LOOPS);
+
+    /* the waiter runs above the runner, it's blocked when the trigger returns */
+    tid = bench_thread_create("bwake", bench_wakeup_entry, &wakeup, BENCH_PRIORITY_HIGH);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        if (index == BENCH_WARMUP)
+            begin = bench_time_ns();
+
+        wakeup.stamp = bench_time_ns();
+        bench_irq_trigger();
+    }
+    wakeup.result.elapsed = bench_time_ns() - begin;
+    wakeup.result.ops     = BENCH_LOOPS;
+
+    rt_sem_take(wakeup.done, RT_WAITING_FOREVER);
+    bench_irq_uninstall();
+
+    bench_result_report(&(wakeup.result));
+
+    rt_sem_delete(wakeup.sem);
+    rt_sem_delete(wakeup.done);
+}
+
+/*
+ * interrupt to thread mail stream
+ */
+#define BENCH_IRQ_MB_STOP           0xffffffff
+
+struct bench_irq_mb
+{
+    rt_mailbox_t mb;
+    rt_sem_t done;
+
+    volatile rt_bool_t measure;
+    volatile rt_bool_t stop;
+    struct bench_result result;
+};
+
+static void bench_irq_mb_isr(void *param)
+{
+    struct bench_irq_mb *stream = (struct bench_irq_mb *)param;
+    rt_uint64_t stamp, ns;
+    rt_uint32_t index;
+
+    if (stream->stop)
+    {
+        rt_mb_send(stream->mb, BENCH_IRQ_MB_STOP);
+        return;
+    }
+
+    for (index = 0; index < BENCH_IRQ_BURST; index ++)
+    {
+        stamp = bench_time_ns();
+        rt_mb_send(stream->mb, index);
+        ns = bench_time_ns() - stamp;
+
+        if (stream->measure)
+        {
+            stream->result.elapsed += ns;
+            bench_result_sample(&(stream->result), (rt_uint32_t)ns);
+        }
+    }
+}
+
+static void bench_irq_mb_entry(void *parameter)
+{
+    struct bench_irq_mb *stream = (struct bench_irq_mb *)parameter;
+    rt_uint32_t value;
+
+    do
+    {
+        rt_mb_recv(stream->mb, &value, RT_WAITING_FOREVER);
+    } while (value != BENCH_IRQ_MB_STOP);
+
+    rt_sem_release(stream->done);
+}
+
+static void bench_irq_mb_run(const char *name, rt_uint8_t flag)
+{
+    struct bench_irq_mb stream;
+    rt_thread_t tid;
+    rt_uint32_t index;
+
+    if (bench_irq_install(bench_irq_mb_isr, &stream) != RT_EOK)
+    {
+        bench_result_skip(name, "no_irq_source");
+        return;
+    }
+
+    stream.mb      = rt_mb_create("bmb", BENCH_QUEUE_DEPTH, flag);
+    stream.done    = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    stream.measure = RT_FALSE;
+    stream.stop    = RT_FALSE;
+    RT_ASSERT(stream.mb != RT_NULL && stream.done != RT_NULL);
+    bench_result_init(&(stream.result), name, BENCH_LOOPS);
+
+    /* the receiver runs above the runner, it drains each burst */
+    tid = bench_thread_create("bmbr", bench_irq_mb_entry, &stream, BENCH_PRIORITY_HIGH);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    for (index = 0; index < (BENCH_WARMUP + BENCH_LOOPS) / BENCH_IRQ_BURST; index ++)
+    {
+        if (index == BENCH_WARMUP / BENCH_IRQ_BURST)
+            stream.measure = RT_TRUE;
+
+        bench_irq_trigger();
+    }
+    stream.result.ops = stream.result.nr_samples;
+
+    /* the stop mail is lost on a full mailbox, the receiver may run on another cpu */
+    stream.stop = RT_TRUE;
+    do
+    {
+        bench_irq_trigger();
+    } while (rt_sem_take(stream.done, 1) != RT_EOK);
+    bench_irq_uninstall();
+
+    bench_result_report(&(stream.result));
+
+    rt_mb_delete(stream.mb);
+    rt_sem_delete(stream.done);
+}
+
+void bench_irq_mb(void)
+{
+    bench_irq_mb_run("irq_mb_lock", RT_IPC_FLAG_FIFO);
+#ifdef RT_USING_MAILBOX_SPSC
+    bench_irq_mb_run("irq_mb_spsc", RT_IPC_FLAG_SPSC);
+#else
+    bench_result_skip("irq_mb_spsc", "no_spsc");
+#endif
+}
+
+/*
+ * message queue of frames, copied and loaned
+ */
+static const rt_size_t bench_mq_frame_size[] = {32, 256, 1024};
+
+static void bench_mq_frame_run(rt_size_t size, rt_bool_t loan)
+{
+    struct bench_result result;
+    rt_mq_t mq;
+    rt_uint8_t *frame, *buffer;
+    char name[RT_NAME_MAX * 4];
+    rt_uint32_t loop, index, broken;
+    rt_uint64_t stamp, ns;
+
+    rt_snprintf(name, sizeof(name), "mq_frame_%s_%d", loan ? "loan" : "copy", size);
+
+    mq    = rt_mq_create("bmq", size, BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    frame = (rt_uint8_t *)rt_malloc(size);
+    if (mq == RT_NULL || frame == RT_NULL || bench_result_init(&result, name, BENCH_LOOPS) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        if (mq != RT_NULL)
+            rt_mq_delete(mq);
+        rt_free(frame);
+
+        return;
+    }
+
+    /*
+     * the queue is filled up and drained by turns, one operation is a frame
+     * written, sent, received and checked.
+     */
+    broken = 0;
+    for (loop = 0; loop < (BENCH_WARMUP + BENCH_LOOPS) / BENCH_QUEUE_DEPTH; loop ++)
+    {
+        stamp = bench_time_ns();
+        for (index = 0; index < BENCH_QUEUE_DEPTH; index ++)
+        {
+            if (loan)
+            {
+                buffer = (rt_uint8_t *)rt_mq_loan(mq);
+                rt_memset(buffer, index, size);
+                rt_mq_commit(mq, buffer);
+            }
+            else
+            {
+                rt_memset(frame, index, size);
+                rt_mq_send(mq, frame, size);
+            }
+        }
+        for (index = 0; index < BENCH_QUEUE_DEPTH; index ++)
+        {
+            if (loan)
+            {
+                rt_mq_recv_loan(mq, (void **)&buffer, RT_WAITING_FOREVER);
+                broken += buffer[0] != (rt_uint8_t)index || buffer[size - 1] != (rt_uint8_t)index;
+                rt_mq_release(mq, buffer);
+            }
+            else
+            {
+                rt_mq_recv(mq, frame, size, RT_WAITING_FOREVER);
+                broken += frame[0] != (rt_uint8_t)index || frame[size - 1] != (rt_uint8_t)index;
+            }
+        }
+        ns = bench_time_ns() - stamp;
+
+        if (loop >= BENCH_WARMUP / BENCH_QUEUE_DEPTH)
+        {
+            result.elapsed += ns;
+            result.ops     += BENCH_QUEUE_DEPTH;
+            for (index = 0; index < BENCH_QUEUE_DEPTH; index ++)
+                bench_result_sample(&result, (rt_uint32_t)(ns / BENCH_QUEUE_DEPTH));
+        }
+    }
+
+    if (broken)
+        rt_kprintf("%s: %d frames broken\n", name, broken);
+
+    bench_result_report(&result);
+
+    rt_mq_delete(mq);
+    rt_free(frame);
+}
+
+void bench_mq_frame(void)
+{
+    int index;
+
+    for (index = 0; index < sizeof(bench_mq_frame_size) / sizeof(bench_mq_frame_size[0]); index ++)
+    {
+        bench_mq_frame_run(bench_mq_frame_size[index], RT_FALSE);
+        bench_mq_frame_run(bench_mq_frame_size[index], RT_TRUE);
+    }
+}
+
+/*
+ * bursts drained by a thread, item by item and batched
+ */
+#define BENCH_BATCH_STOP            0xffffffff
+
+struct bench_batch
+{
+    rt_mailbox_t mb;                /* RT_NULL for the message queue */
+    rt_mq_t      mq;
+    rt_bool_t    batched;
+
+    rt_sem_t     ack;
+    rt_uint32_t  broken;
+};
+
+/* send count items, the queue is empty as the last burst was acked */
+static void bench_batch_send(struct bench_batch *batch, rt_uint32_t *values, rt_size_t count)
+{
+    rt_size_t index;
+
+    if (batch->batched)
+    {
+        if (batch->mb != RT_NULL)
+            rt_mb_send_wait_n(batch->mb, values, count, RT_WAITING_FOREVER);
+        else
+            rt_mq_send_n(batch->mq, values, sizeof(values[0]), count);
+
+        return;
+    }
+
+    for (index = 0; index < count; index ++)
+    {
+        if (batch->mb != RT_NULL)
+            rt_mb_send_wait(batch->mb, values[index], RT_WAITING_FOREVER);
+        else
+            rt_mq_send(batch->mq, &values[index], sizeof(values[0]));
+    }
+}
+
+/* receive one item, or all the items there are if batched */
+static rt_size_t bench_batch_recv(struct bench_batch *batch, rt_uint32_t *values)
+{
+    if (batch->batched)
+    {
+        if (batch->mb != RT_NULL)
+            return rt_mb_recv_n(batch->mb, values, BENCH_QUEUE_DEPTH, RT_WAITING_FOREVER);
+
+        return rt_mq_recv_n(batch->mq, values, sizeof(values[0]), BENCH_QUEUE_DEPTH,
+                            RT_WAITING_FOREVER);
+    }
+
+    if (batch->mb != RT_NULL)
+        return rt_mb_recv(batch->mb, values, RT_WAITING_FOREVER) == RT_EOK;
+
+    return rt_mq_recv(batch->mq, values, sizeof(values[0]), RT_WAITING_FOREVER) == RT_EOK;
+}
+
+static void bench_batch_entry(void *parameter)
+{
+    struct bench_batch *batch = (struct bench_batch *)parameter;
+    rt_uint32_t values[BENCH_QUEUE_DEPTH];
+    rt_uint32_t expect;
+    rt_size_t count, index;
+
+    expect = 0;
+    while (1)
+    {
+        count = bench_batch_recv(batch, values);
+        for (index = 0; index < count; index ++)
+        {
+            if (values[index] == BENCH_BATCH_STOP)
+            {
+                rt_sem_release(batch->ack);
+
+                return;
+            }
+
+            batch->broken += values[index] != expect;
+            if (++ expect == BENCH_QUEUE_DEPTH)
+            {
+                /* a whole burst is drained */
+                expect = 0;
+                rt_sem_release(batch->ack);
+            }
+        }
+    }
+}
+
+static void bench_batch_run(const char *name, rt_bool_t mq, rt_bool_t batched)
+{
+    struct bench_batch batch;
+    struct bench_result result;
+    rt_thread_t tid;
+    rt_uint32_t values[BENCH_QUEUE_DEPTH];
+    rt_uint32_t loop, index;
+    rt_uint64_t stamp, ns;
+
+    if (bench_result_init(&result, name, BENCH_LOOPS) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+    batch.mb      = RT_NULL;
+    batch.mq      = RT_NULL;
+    if (mq)
+        batch.mq = rt_mq_create("bmq", sizeof(rt_uint32_t), BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    else
+        batch.mb = rt_mb_create("bmb", BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    batch.batched = batched;
+    batch.ack     = rt_sem_create("back", 0, RT_IPC_FLAG_FIFO);
+    batch.broken  = 0;
+    RT_ASSERT(batch.mb != RT_NULL || batch.mq != RT_NULL);
+    RT_ASSERT(batch.ack != RT_NULL);
+
+    for (index = 0; index < BENCH_QUEUE_DEPTH; index ++)
+        values[index] = index;
+
+    /* the drainer runs above the runner, so a single item wakes it each */
+    tid = bench_thread_create("bbatch", bench_batch_entry, &batch, BENCH_PRIORITY_HIGH);
+    RT_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    for (loop = 0; loop < (BENCH_WARMUP + BENCH_LOOPS) / BENCH_QUEUE_DEPTH; loop ++)
+    {
+        stamp = bench_time_ns();
+        bench_batch_send(&batch, values, BENCH_QUEUE_DEPTH);
+        rt_sem_take(batch.ack, RT_WAITING_FOREVER);
+        ns = bench_time_ns() - stamp;
+
+        if (loop >= BENCH_WARMUP / BENCH_QUEUE_DEPTH)
+        {
+            result.elapsed += ns;
+            result.ops     += BENCH_QUEUE_DEPTH;
+            for (index = 0; index < BENCH_QUEUE_DEPTH; index ++)
+                bench_result_sample(&result, (rt_uint32_t)(ns / BENCH_QUEUE_DEPTH));
+        }
+    }
+
+    if (batch.broken)
+        rt_kprintf("%s: %d items broken\n", name, batch.broken);
+
+    bench_result_report(&result);
+
+    values[0] = BENCH_BATCH_STOP;
+    bench_batch_send(&batch, values, 1);
+    rt_sem_take(batch.ack, RT_WAITING_FOREVER);
+
+    if (batch.mb != RT_NULL)
+        rt_mb_delete(batch.mb);
+    else
+        rt_mq_delete(batch.mq);
+    rt_sem_delete(batch.ack);
+}
+
+void bench_ipc_batch(void)
+{
+    bench_batch_run("ipc_batch_mb_single", RT_FALSE, RT_FALSE);
+    bench_batch_run("ipc_batch_mb_n", RT_FALSE, RT_TRUE);
+    bench_batch_run("ipc_batch_mq_single", RT_TRUE, RT_FALSE);
+    bench_batch_run("ipc_batch_mq_n", RT_TRUE, RT_TRUE);
+}
+
+/*
+ * one thread serving several objects
+ */
+#define BENCH_POLL_STOP             0xffffffff
+#define BENCH_POLL_EVENT            0x01
+#define BENCH_POLL_EVENT_STOP       0x02
+
+struct bench_poll
+{
+    rt_mailbox_t mb;
+    rt_mq_t      mq;
+    rt_event_t   event;
+
+    rt_sem_t     ack;
+    rt_sem_t     done;
+};
+
+static void bench_poll_mb_entry(void *parameter)
+{
+    struct bench_poll *poll = (struct bench_poll *)parameter;
+    rt_uint32_t value;
+
+    do
+    {
+        rt_mb_recv(poll->mb, &value, RT_WAITING_FOREVER);
+        rt_sem_release(poll->ack);
+    } while (value != BENCH_POLL_STOP);
+
+    rt_sem_release(poll->done);
+}
+
+static void bench_poll_mq_entry(void *parameter)
+{
+    struct bench_poll *poll = (struct bench_poll *)parameter;
+    rt_uint32_t value;
+
+    do
+    {
+        rt_mq_recv(poll->mq, &value, sizeof(value), RT_WAITING_FOREVER);
+        rt_sem_release(poll->ack);
+    } while (value != BENCH_POLL_STOP);
+
+    rt_sem_release(poll->done);
+}
+
+static void bench_poll_event_entry(void *parameter)
+{
+    struct bench_poll *poll = (struct bench_poll *)parameter;
+    rt_uint32_t set;
+
+    do
+    {
+        rt_event_recv(poll->event, BENCH_POLL_EVENT | BENCH_POLL_EVENT_STOP,
+                      RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, RT_WAITING_FOREVER, &set);
+        rt_sem_release(poll->ack);
+    } while (!(set & BENCH_POLL_EVENT_STOP));
+
+    rt_sem_release(poll->done);
+}
+
+#ifdef RT_USING_IPC_POLL
+static void bench_poll_entry(void *parameter)
+{
+    struct bench_poll *poll = (struct bench_poll *)parameter;
+    struct rt_ipc_poll polls[3];
+    rt_uint32_t value;
+    int stopped = 0;
+
+    rt_memset(polls, 0, sizeof(polls));
+    polls[0].object = &(poll->mb->parent);
+    polls[1].object = &(poll->mq->parent);
+    polls[2].object = &(poll->event->parent);
+    polls[2].set    = BENCH_POLL_EVENT | BENCH_POLL_EVENT_STOP;
+    polls[2].option = RT_EVENT_FLAG_OR;
+
+    while (stopped < 3)
+    {
+        rt_ipc_poll(polls, 3, RT_WAITING_FOREVER);
+
+        if (polls[0].result == RT_EOK && rt_mb_recv(poll->mb, &value, 0) == RT_EOK)
+        {
+            if (value == BENCH_POLL_STOP)
+                stopped ++;
+            rt_sem_release(poll->ack);
+        }
+        if (polls[1].result == RT_EOK &&
+            rt_mq_recv(poll->mq, &value, sizeof(value), 0) == RT_EOK)
+        {
+            if (value == BENCH_POLL_STOP)
+                stopped ++;
+            rt_sem_release(poll->ack);
+        }
+        if (polls[2].result == RT_EOK &&
+            rt_event_recv(poll->event, polls[2].set, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                          0, &value) == RT_EOK)
+        {
+            if (value & BENCH_POLL_EVENT_STOP)
+                stopped ++;
+            rt_sem_release(poll->ack);
+        }
+    }
+
+    rt_sem_release(poll->done);
+}
+#endif
+
+/* send one request to the object of index, RT_TRUE for the last one */
+static void bench_poll_send(struct bench_poll *poll, rt_uint32_t index, rt_bool_t stop)
+{
+    rt_uint32_t value = stop ? BENCH_POLL_STOP : index;
+
+    switch (index % 3)
+    {
+    case 0:
+        rt_mb_send(poll->mb, value);
+        break;
+    case 1:
+        rt_mq_send(poll->mq, &value, sizeof(value));
+        break;
+    default:
+        rt_event_send(poll->event, stop ? BENCH_POLL_EVENT_STOP : BENCH_POLL_EVENT);
+        break;
+    }
+}
+
+static void bench_poll_run(const char *name, rt_bool_t polled)
+{
+    struct bench_poll poll;
+    struct bench_result result;
+    rt_thread_t tid;
+    rt_uint32_t index, servers;
+    rt_uint64_t begin = 0, stamp;
+
+    if (bench_result_init(&result, name, BENCH_LOOPS) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+    poll.mb    = rt_mb_create("bmb", BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    poll.mq    = rt_mq_create("bmq", sizeof(rt_uint32_t), BENCH_QUEUE_DEPTH, RT_IPC_FLAG_FIFO);
+    poll.event = rt_event_create("bevent", RT_IPC_FLAG_FIFO);
+    poll.ack   = rt_sem_create("back", 0, RT_IPC_FLAG_FIFO);
+    poll.done  = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(poll.mb != RT_NULL && poll.mq != RT_NULL && poll.event != RT_NULL);
+    RT_ASSERT(poll.ack != RT_NULL && poll.done != RT_NULL);
+
+    /* the servers run above the runner */
+    servers = 0;
+#ifdef RT_USING_IPC_POLL
+    if (polled)
+    {
+        tid = bench_thread_create("bpoll", bench_poll_entry, &poll, BENCH_PRIORITY_HIGH);
+        RT_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+        servers = 1;
+    }
+#endif
+    if (servers == 0)
+    {
+        tid = bench_thread_create("bpollmb", bench_poll_mb_entry, &poll, BENCH_PRIORITY_HIGH);
+        RT_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+        tid = bench_thread_create("bpollmq", bench_poll_mq_entry, &poll, BENCH_PRIORITY_HIGH);
+        RT_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+        tid = bench_thread_create("bpollev", bench_poll_event_entry, &poll, BENCH_PRIORITY_HIGH);
+        RT_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+        servers = 3;
+    }
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        if (index == BENCH_WARMUP)
+            begin = bench_time_ns();
+
+        stamp = bench_time_ns();
+        bench_poll_send(&poll, index, RT_FALSE);
+        rt_sem_take(poll.ack, RT_WAITING_FOREVER);
+        if (index >= BENCH_WARMUP)
+            bench_result_sample(&result, (rt_uint32_t)(bench_time_ns() - stamp));
+    }
+    result.elapsed = bench_time_ns() - begin;
+    result.ops     = BENCH_LOOPS;
+
+    bench_result_report(&result);
+
+    for (index = 0; index < 3; index ++)
+    {
+        bench_poll_send(&poll, index, RT_TRUE);
+        rt_sem_take(poll.ack, RT_WAITING_FOREVER);
+    }
+    for (index = 0; index < servers; index ++)
+        rt_sem_take(poll.done, RT_WAITING_FOREVER);
+
+    rt_mb_delete(poll.mb);
+    rt_mq_delete(poll.mq);
+    rt_event_delete(poll.event);
+    rt_sem_delete(poll.ack);
+    rt_sem_delete(poll.done);
+}
+
+void bench_ipc_poll(void)
+{
+    bench_poll_run("ipc_poll_threads", RT_FALSE);
+#ifdef RT_USING_IPC_POLL
+    bench_poll_run("ipc_poll_poll", RT_TRUE);
+#else
+    bench_result_skip("ipc_poll_poll", "no_poll");
+#endif
+}
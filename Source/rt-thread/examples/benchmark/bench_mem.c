@@ -0,0 +1,319 @@
+/*
+ * Heap benchmark: rt_malloc and rt_free on a fragmented system heap.
+ *
+ * The heap is fragmented first by allocating blocks of random size and
+ * freeing every other one, then a random live block is freed and a block of
+ * a new random size is allocated in its place. One operation is one rt_malloc
+ * or one rt_free; the max field is the worst case seen, which is the number
+ * to look at for a real-time allocator.
+ *
+ * The name tells the heap backend, mem_small_*, mem_tlsf_* or mem_memheap_*,
+ * so the builds can be compared line by line.
+ *
+ * Memory pool benchmark: one thread takes a block of a memory pool with
+ * rt_mp_alloc(mp, 0) and gives it back with rt_mp_free, one operation is a
+ * pair of calls, the latency is the average of a batch. Then 2 to 16 threads
+ * of the same priority share a pool, each one takes a few blocks and gives
+ * them back in turn, and the hit rate of the magazines is printed. The name
+ * tells the free block list, mempool_lockfree with RT_USING_MEMPOOL_LOCKFREE
+ * and mempool_lock otherwise, mempool_magazine_* with
+ * RT_USING_MEMPOOL_MAGAZINE, and the number of threads.
+ */
+
+#include <rtthread.h>
+
+#include "bench.h"
+
+#ifdef RT_USING_HEAP
+
+#if defined(RT_USING_TLSF)
+#define BENCH_MEM_BACKEND           "tlsf"
+#elif defined(RT_USING_MEMHEAP_AS_HEAP)
+#define BENCH_MEM_BACKEND           "memheap"
+#elif defined(RT_USING_SLAB)
+#define BENCH_MEM_BACKEND           "slab"
+#else
+#define BENCH_MEM_BACKEND           "small"
+#endif
+
+#ifndef BENCH_MEM_BLOCKS
+#ifdef ARCH_POSIX
+#define BENCH_MEM_BLOCKS            2000
+#else
+#define BENCH_MEM_BLOCKS            100
+#endif
+#endif
+
+#define BENCH_MEM_SIZE_MIN          8
+#define BENCH_MEM_SIZE_SPAN         1024
+
+static rt_uint32_t bench_mem_seed;
+
+static rt_uint32_t bench_mem_random(void)
+{
+    bench_mem_seed = bench_mem_seed * 1103515245 + 12345;
+
+    return bench_mem_seed >> 8;
+}
+
+static rt_size_t bench_mem_size(void)
+{
+    return BENCH_MEM_SIZE_MIN + bench_mem_random() % BENCH_MEM_SIZE_SPAN;
+}
+
+void bench_mem(void)
+{
+    void **blocks;
+    struct bench_result malloc_result, free_result;
+    rt_uint32_t index, loop, failed;
+    rt_uint64_t stamp, ns;
+    rt_size_t size;
+
+    blocks = (void **)rt_malloc(sizeof(void *) * BENCH_MEM_BLOCKS);
+    if (blocks == RT_NULL)
+    {
+        bench_result_skip("mem_" BENCH_MEM_BACKEND "_malloc", "no_memory");
+        bench_result_skip("mem_" BENCH_MEM_BACKEND "_free", "no_memory");
+
+        return;
+    }
+
+    /* same sizes for all backends */
+    bench_mem_seed = BENCH_MEM_BLOCKS;
+
+    /* fragment the heap */
+    for (index = 0; index < BENCH_MEM_BLOCKS; index ++)
+        blocks[index] = rt_malloc(bench_mem_size());
+    for (index = 0; index < BENCH_MEM_BLOCKS; index += 2)
+    {
+        rt_free(blocks[index]);
+        blocks[index] = RT_NULL;
+    }
+
+    bench_result_init(&malloc_result, "mem_" BENCH_MEM_BACKEND "_malloc", BENCH_LOOPS);
+    bench_result_init(&free_result, "mem_" BENCH_MEM_BACKEND "_free", BENCH_LOOPS);
+
+    failed = 0;
+    for (loop = 0; loop < BENCH_WARMUP + BENCH_LOOPS; loop ++)
+    {
+        index = bench_mem_random() % BENCH_MEM_BLOCKS;
+        size  = bench_mem_size();
+
+        if (blocks[index] != RT_NULL)
+        {
+            stamp = bench_time_ns();
+            rt_free(blocks[index]);
+            ns = bench_time_ns() - stamp;
+
+            if (loop >= BENCH_WARMUP)
+            {
+                free_result.elapsed += ns;
+                free_result.ops ++;
+                bench_result_sample(&free_result, (rt_uint32_t)ns);
+            }
+        }
+
+        stamp = bench_time_ns();
+        blocks[index] = rt_malloc(size);
+        ns = bench_time_ns() - stamp;
+
+        if (blocks[index] == RT_NULL)
+            failed ++;
+
+        if (loop >= BENCH_WARMUP)
+        {
+            malloc_result.elapsed += ns;
+            malloc_result.ops ++;
+            bench_result_sample(&malloc_result, (rt_uint32_t)ns);
+        }
+    }
+
+    if (failed)
+        rt_kprintf("mem: %d allocations failed\n", failed);
+
+    bench_result_report(&malloc_result);
+    bench_result_report(&free_result);
+
+    for (index = 0; index < BENCH_MEM_BLOCKS; index ++)
+        rt_free(blocks[index]);
+
+    rt_free(blocks);
+}
+
+#else
+
+void bench_mem(void)
+{
+    bench_result_skip("mem", "no_heap");
+}
+
+#endif
+
+#ifdef RT_USING_MEMPOOL
+
+#ifdef RT_USING_MEMPOOL_LOCKFREE
+#define BENCH_MP_LIST               "lockfree"
+#else
+#define BENCH_MP_LIST               "lock"
+#endif
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+#define BENCH_MP_NAME               "mempool_magazine_" BENCH_MP_LIST
+#else
+#define BENCH_MP_NAME               "mempool_" BENCH_MP_LIST
+#endif
+
+#define BENCH_MP_BLOCKS             16
+#define BENCH_MP_BLOCK_SIZE         64
+#define BENCH_MP_BATCH              100
+
+#define BENCH_MP_THREADS_MAX        16
+#define BENCH_MP_HOLD               4                   /* blocks a thread holds */
+
+static const rt_uint32_t bench_mp_threads[] = {2, 4, 8, BENCH_MP_THREADS_MAX};
+
+struct bench_mp_shared
+{
+    rt_mp_t mp;
+    rt_uint32_t chunks;                                 /**< chunks of each thread */
+
+    struct bench_result result;
+    rt_sem_t done;
+};
+
+static rt_uint8_t bench_mp_pool[BENCH_MP_BLOCKS * (BENCH_MP_BLOCK_SIZE + sizeof(rt_uint8_t *))];
+
+static void bench_mp_shared_entry(void *parameter)
+{
+    struct bench_mp_shared *shared = (struct bench_mp_shared *)parameter;
+    void *blocks[BENCH_MP_HOLD];
+    rt_uint32_t chunk, loop, index;
+    rt_uint64_t stamp;
+
+    for (chunk = 0; chunk < shared->chunks; chunk ++)
+    {
+        stamp = bench_time_ns();
+        for (loop = 0; loop < BENCH_MP_BATCH / BENCH_MP_HOLD; loop ++)
+        {
+            for (index = 0; index < BENCH_MP_HOLD; index ++)
+            {
+                blocks[index] = rt_mp_alloc(shared->mp, RT_WAITING_FOREVER);
+                RT_ASSERT(blocks[index] != RT_NULL);
+            }
+            for (index = 0; index < BENCH_MP_HOLD; index ++)
+                rt_mp_free(blocks[index]);
+        }
+        bench_result_sample(&(shared->result),
+                            (rt_uint32_t)((bench_time_ns() - stamp) / BENCH_MP_BATCH));
+    }
+
+    rt_sem_release(shared->done);
+}
+
+static void bench_mp_shared_run(rt_uint32_t count)
+{
+    struct bench_mp_shared shared;
+    rt_thread_t threads[BENCH_MP_THREADS_MAX];
+    char name[RT_NAME_MAX * 4];
+    rt_uint32_t index;
+    rt_uint64_t stamp;
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    struct rt_mp_magazine_info info;
+#endif
+
+    rt_snprintf(name, sizeof(name), "%s_%d", BENCH_MP_NAME, count);
+
+    rt_memset(&shared, 0, sizeof(shared));
+    shared.chunks = BENCH_LOOPS / BENCH_MP_BATCH / count;
+    if (bench_result_init(&(shared.result), name, shared.chunks * count) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+    /* twice the blocks the threads hold, the rest are cached */
+    shared.mp   = rt_mp_create("bmp", count * BENCH_MP_HOLD * 2, BENCH_MP_BLOCK_SIZE);
+    shared.done = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(shared.mp != RT_NULL && shared.done != RT_NULL);
+
+    for (index = 0; index < count; index ++)
+    {
+        threads[index] = bench_thread_create("bmpool", bench_mp_shared_entry, &shared, BENCH_PRIORITY_MIDDLE);
+        RT_ASSERT(threads[index] != RT_NULL);
+    }
+
+    stamp = bench_time_ns();
+    for (index = 0; index < count; index ++)
+        rt_thread_startup(threads[index]);
+    for (index = 0; index < count; index ++)
+        rt_sem_take(shared.done, RT_WAITING_FOREVER);
+    shared.result.elapsed = bench_time_ns() - stamp;
+    shared.result.ops     = shared.chunks * count * BENCH_MP_BATCH;
+
+    bench_result_report(&(shared.result));
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    rt_mp_magazine_get(shared.mp, &info);
+    rt_kprintf("%s: alloc hit %d/%d free hit %d/%d\n", name,
+               info.alloc_hit, info.alloc_hit + info.alloc_miss,
+               info.free_hit, info.free_hit + info.free_miss);
+#endif
+
+    rt_mp_delete(shared.mp);
+    rt_sem_delete(shared.done);
+}
+
+void bench_mempool(void)
+{
+    struct rt_mempool mp;
+    struct bench_result result;
+    rt_uint32_t loop, index;
+    rt_uint64_t stamp, ns;
+    void *block;
+
+    if (bench_result_init(&result, BENCH_MP_NAME, BENCH_LOOPS) != RT_EOK)
+    {
+        bench_result_skip(BENCH_MP_NAME, "no_memory");
+
+        return;
+    }
+
+    rt_mp_init(&mp, "bmp", bench_mp_pool, sizeof(bench_mp_pool), BENCH_MP_BLOCK_SIZE);
+
+    for (loop = 0; loop < (BENCH_WARMUP + BENCH_LOOPS) / BENCH_MP_BATCH; loop ++)
+    {
+        stamp = bench_time_ns();
+        for (index = 0; index < BENCH_MP_BATCH; index ++)
+        {
+            block = rt_mp_alloc(&mp, 0);
+            RT_ASSERT(block != RT_NULL);
+            rt_mp_free(block);
+        }
+        ns = bench_time_ns() - stamp;
+
+        if (loop >= BENCH_WARMUP / BENCH_MP_BATCH)
+        {
+            result.elapsed += ns;
+            result.ops     += BENCH_MP_BATCH;
+            for (index = 0; index < BENCH_MP_BATCH; index ++)
+                bench_result_sample(&result, (rt_uint32_t)(ns / BENCH_MP_BATCH));
+        }
+    }
+
+    bench_result_report(&result);
+
+    rt_mp_detach(&mp);
+
+    for (index = 0; index < sizeof(bench_mp_threads) / sizeof(bench_mp_threads[0]); index ++)
+        bench_mp_shared_run(bench_mp_threads[index]);
+}
+
+#else
+
+void bench_mempool(void)
+{
+    bench_result_skip("mempool", "no_mempool");
+}
+
+#endif
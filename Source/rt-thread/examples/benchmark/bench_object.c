@@ -0,0 +1,102 @@
+/*
+ * Object benchmark: rt_object_find of a semaphore among 10, 100 and 1000
+ * semaphores, which is what rt_device_find and rt_thread_find do.
+ *
+ * One operation is one rt_object_find of an existing name. The name tells
+ * the lookup, object_list_* for the object list walk and object_hash_* for
+ * the name hash index.
+ */
+
+#include <rtthread.h>
+
+#include "bench.h"
+
+#ifdef RT_USING_SEMAPHORE
+
+#ifdef RT_USING_OBJECT_HASH
+#define BENCH_OBJECT_LOOKUP         "hash"
+#else
+#define BENCH_OBJECT_LOOKUP         "list"
+#endif
+
+static const rt_uint32_t bench_object_count[] = {10, 100, 1000};
+
+static rt_uint32_t bench_object_seed;
+
+static rt_uint32_t bench_object_random(void)
+{
+    bench_object_seed = bench_object_seed * 1103515245 + 12345;
+
+    return bench_object_seed >> 8;
+}
+
+static void bench_object_run(rt_uint32_t count)
+{
+    struct rt_semaphore *sems;
+    struct bench_result find;
+    char find_name[RT_NAME_MAX * 4], name[RT_NAME_MAX + 1];
+    rt_uint32_t index, loop;
+    rt_uint64_t stamp, ns;
+    rt_object_t object;
+
+    rt_snprintf(find_name, sizeof(find_name), "object_%s_find_%d", BENCH_OBJECT_LOOKUP, count);
+
+    sems = (struct rt_semaphore *)rt_malloc(sizeof(struct rt_semaphore) * count);
+    if (sems == RT_NULL)
+    {
+        bench_result_skip(find_name, "no_memory");
+
+        return;
+    }
+
+    for (index = 0; index < count; index ++)
+    {
+        rt_snprintf(name, sizeof(name), "bo%d", index);
+        rt_sem_init(&sems[index], name, 0, RT_IPC_FLAG_FIFO);
+    }
+
+    bench_object_seed = count;
+
+    bench_result_init(&find, find_name, BENCH_LOOPS);
+    for (loop = 0; loop < BENCH_WARMUP + BENCH_LOOPS; loop ++)
+    {
+        index = bench_object_random() % count;
+        rt_snprintf(name, sizeof(name), "bo%d", index);
+
+        stamp  = bench_time_ns();
+        object = rt_object_find(name, RT_Object_Class_Semaphore);
+        ns     = bench_time_ns() - stamp;
+
+        RT_ASSERT(object == &sems[index].parent.parent);
+
+        if (loop >= BENCH_WARMUP)
+        {
+            find.elapsed += ns;
+            bench_result_sample(&find, (rt_uint32_t)ns);
+        }
+    }
+    find.ops = BENCH_LOOPS;
+    bench_result_report(&find);
+
+    for (index = 0; index < count; index ++)
+        rt_sem_detach(&sems[index]);
+
+    rt_free(sems);
+}
+
+void bench_object_find(void)
+{
+    int index;
+
+    for (index = 0; index < sizeof(bench_object_count) / sizeof(bench_object_count[0]); index ++)
+        bench_object_run(bench_object_count[index]);
+}
+
+#else
+
+void bench_object_find(void)
+{
+    bench_result_skip("object_find", "no_semaphore");
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Scheduler benchmark: context switch between two threads of the same
+ * priority with rt_thread_yield().
+ *
+ * One operation is one context switch, a yield round trip of the measuring
+ * thread is two of them.
+ */
+
+#include <rtthread.h>
+
+#include "bench.h"
+
+struct bench_yield
+{
+    struct bench_result result;
+
+    rt_sem_t start;
+    rt_sem_t done;
+};
+
+static void bench_yield_measure_entry(void *parameter)
+{
+    struct bench_yield *yield = (struct bench_yield *)parameter;
+    rt_uint64_t begin = 0, stamp;
+    rt_uint32_t index;
+
+    rt_sem_take(yield->start, RT_WAITING_FOREVER);
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+    {
+        if (index == BENCH_WARMUP)
+            begin = bench_time_ns();
+
+        stamp = bench_time_ns();
+        rt_thread_yield();
+        if (index >= BENCH_WARMUP)
+            bench_result_sample(&(yield->result), (rt_uint32_t)((bench_time_ns() - stamp) / 2));
+    }
+
+    yield->result.elapsed = bench_time_ns() - begin;
+    yield->result.ops     = BENCH_LOOPS * 2;
+
+    rt_sem_release(yield->done);
+}
+
+static void bench_yield_peer_entry(void *parameter)
+{
+    struct bench_yield *yield = (struct bench_yield *)parameter;
+    rt_uint32_t index;
+
+    rt_sem_take(yield->start, RT_WAITING_FOREVER);
+
+    for (index = 0; index < BENCH_WARMUP + BENCH_LOOPS; index ++)
+        rt_thread_yield();
+
+    rt_sem_release(yield->done);
+}
+
+void bench_sched_yield(void)
+{
+    struct bench_yield yield;
+    rt_thread_t measure, peer;
+
+    bench_result_init(&(yield.result), "sched_yield", BENCH_LOOPS);
+    yield.start = rt_sem_create("bstart", 0, RT_IPC_FLAG_FIFO);
+    yield.done  = rt_sem_create("bdone", 0, RT_IPC_FLAG_FIFO);
+
+    measure = bench_thread_create("bmeas", bench_yield_measure_entry, &yield, BENCH_PRIORITY_MIDDLE);
+    peer    = bench_thread_create("bpeer", bench_yield_peer_entry, &yield, BENCH_PRIORITY_MIDDLE);
+    RT_ASSERT(measure != RT_NULL && peer != RT_NULL);
+
+    rt_thread_startup(measure);
+    rt_thread_startup(peer);
+
+    /* both threads are blocked on the start semaphore, let them go together */
+    rt_enter_critical();
+    rt_sem_release(yield.start);
+    rt_sem_release(yield.start);
+    rt_exit_critical();
+
+    rt_sem_take(yield.done, RT_WAITING_FOREVER);
+    rt_sem_take(yield.done, RT_WAITING_FOREVER);
+
+    bench_result_report(&(yield.result));
+
+    rt_sem_delete(yield.start);
+    rt_sem_delete(yield.done);
+}
@@ -0,0 +1,147 @@
+/*
+ * SMP benchmark: the same work on 1 to RT_CPUS_NR cpus.
+ *
+ * RT_CPUS_NR workers share a fixed amount of work, they are bound round
+ * robin to the first n cpus, so the wall time of smp_*_<n> against smp_*_1
+ * is the scaling of n cpus. Two kinds of work are measured:
+ *
+ * - smp_compute_<n>: a chunk of computation, no kernel call, which shows the
+ *   scaling of the scheduler itself;
+ * - smp_sem_<n>: a chunk of rt_sem_release and rt_sem_take on a semaphore of
+ *   the worker, which shows the contention of the kernel lock.
+ *
+ * One operation is one chunk, total_us is the wall time from the start of
+ * the first worker to the end of the last one, the latency is per chunk. On
+ * the hosted port a cpu is a host thread, the scaling is bounded by the host
+ * cpus.
+ */
+
+#include <rtthread.h>
+
+#include "bench.h"
+
+#ifdef RT_USING_SMP
+
+#define BENCH_SMP_CHUNKS            (BENCH_LOOPS / 10)
+#define BENCH_SMP_COMPUTE           20000
+#define BENCH_SMP_SEM_OPS           100
+
+struct bench_smp_worker
+{
+    struct rt_semaphore sem;
+    rt_uint32_t chunks;
+    rt_bool_t compute;
+};
+
+static struct bench_smp_worker bench_smp_workers[RT_CPUS_NR];
+static struct bench_result bench_smp_result;
+static struct rt_semaphore bench_smp_done;
+static volatile rt_uint32_t bench_smp_sink;
+
+static void bench_smp_compute(void)
+{
+    rt_uint32_t index, value;
+
+    value = bench_smp_sink;
+    for (index = 0; index < BENCH_SMP_COMPUTE; index ++)
+        value = value * 1103515245 + 12345;
+    bench_smp_sink = value;
+}
+
+static void bench_smp_sem(struct bench_smp_worker *worker)
+{
+    rt_uint32_t index;
+
+    for (index = 0; index < BENCH_SMP_SEM_OPS; index ++)
+    {
+        rt_sem_release(&worker->sem);
+        rt_sem_take(&worker->sem, RT_WAITING_FOREVER);
+    }
+}
+
+static void bench_smp_entry(void *parameter)
+{
+    struct bench_smp_worker *worker = (struct bench_smp_worker *)parameter;
+    rt_uint32_t chunk;
+    rt_uint64_t stamp, ns;
+
+    for (chunk = 0; chunk < worker->chunks; chunk ++)
+    {
+        stamp = bench_time_ns();
+        if (worker->compute)
+            bench_smp_compute();
+        else
+            bench_smp_sem(worker);
+        ns = bench_time_ns() - stamp;
+
+        bench_result_sample(&bench_smp_result, (rt_uint32_t)ns);
+    }
+
+    rt_sem_release(&bench_smp_done);
+}
+
+static void bench_smp_run(const char *kind, rt_bool_t compute, int cpus)
+{
+    rt_thread_t threads[RT_CPUS_NR];
+    char name[RT_NAME_MAX * 4];
+    rt_uint64_t stamp;
+    int index;
+
+    rt_snprintf(name, sizeof(name), "smp_%s_%d", kind, cpus);
+
+    if (bench_result_init(&bench_smp_result, name, BENCH_SMP_CHUNKS) != RT_EOK)
+    {
+        bench_result_skip(name, "no_memory");
+
+        return;
+    }
+
+    for (index = 0; index < RT_CPUS_NR; index ++)
+    {
+        bench_smp_workers[index].chunks  = BENCH_SMP_CHUNKS / RT_CPUS_NR;
+        bench_smp_workers[index].compute = compute;
+        rt_sem_init(&bench_smp_workers[index].sem, "bsmp", 0, RT_IPC_FLAG_FIFO);
+
+        threads[index] = bench_thread_create("bsmp", bench_smp_entry,
+                                             &bench_smp_workers[index], BENCH_PRIORITY_MIDDLE);
+        RT_ASSERT(threads[index] != RT_NULL);
+        rt_thread_control(threads[index], RT_THREAD_CTRL_BIND_CPU,
+                          (void *)(rt_ubase_t)(index % cpus));
+    }
+
+    stamp = bench_time_ns();
+    for (index = 0; index < RT_CPUS_NR; index ++)
+        rt_thread_startup(threads[index]);
+    for (index = 0; index < RT_CPUS_NR; index ++)
+        rt_sem_take(&bench_smp_done, RT_WAITING_FOREVER);
+    bench_smp_result.elapsed = bench_time_ns() - stamp;
+    bench_smp_result.ops = bench_smp_result.nr_samples;
+
+    bench_result_report(&bench_smp_result);
+
+    for (index = 0; index < RT_CPUS_NR; index ++)
+        rt_sem_detach(&bench_smp_workers[index].sem);
+}
+
+void bench_smp(void)
+{
+    int cpus;
+
+    rt_sem_init(&bench_smp_done, "bsmpd", 0, RT_IPC_FLAG_FIFO);
+
+    for (cpus = 1; cpus <= RT_CPUS_NR; cpus ++)
+        bench_smp_run("compute", RT_TRUE, cpus);
+    for (cpus = 1; cpus <= RT_CPUS_NR; cpus ++)
+        bench_smp_run("sem", RT_FALSE, cpus);
+
+    rt_sem_detach(&bench_smp_done);
+}
+
+#else
+
+void bench_smp(void)
+{
+    bench_result_skip("smp", "no_smp");
+}
+
+#endif
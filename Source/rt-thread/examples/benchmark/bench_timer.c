@@ -0,0 +1,134 @@
+/*
+ * Timer benchmark: start and stop of a timer among 10, 100 and 1000 active
+ * timers, which is what every blocking IPC call with a timeout does to the
+ * thread timer.
+ *
+ * One operation is one rt_timer_start of an active timer with a new timeout
+ * (remove and insert), or one rt_timer_stop. The name tells the backend,
+ * timer_list_* for the skip list and timer_wheel_* for the timing wheel, so
+ * the two builds can be compared line by line.
+ */
+
+#include <rtthread.h>
+
+#include "bench.h"
+
+/* far enough to never expire during the benchmark */
+#define BENCH_TIMER_TIMEOUT_BASE    (RT_TICK_PER_SECOND * 1000)
+#define BENCH_TIMER_TIMEOUT_SPAN    0x10000
+
+#ifdef RT_USING_TIMER_WHEEL
+#define BENCH_TIMER_BACKEND         "wheel"
+#else
+#define BENCH_TIMER_BACKEND         "list"
+#endif
+
+static const rt_uint32_t bench_timer_count[] = {10, 100, 1000};
+
+static rt_uint32_t bench_timer_seed;
+
+static rt_uint32_t bench_timer_random(void)
+{
+    bench_timer_seed = bench_timer_seed * 1103515245 + 12345;
+
+    return bench_timer_seed >> 8;
+}
+
+static rt_tick_t bench_timer_timeout_tick(void)
+{
+    return BENCH_TIMER_TIMEOUT_BASE + bench_timer_random() % BENCH_TIMER_TIMEOUT_SPAN;
+}
+
+static void bench_timer_timeout(void *parameter)
+{
+}
+
+static void bench_timer_run(rt_uint32_t count)
+{
+    struct rt_timer *timers;
+    struct bench_result start, stop;
+    char start_name[RT_NAME_MAX * 4], stop_name[RT_NAME_MAX * 4];
+    rt_uint32_t index, loop;
+    rt_uint64_t stamp, ns;
+    rt_tick_t tick;
+
+    rt_snprintf(start_name, sizeof(start_name), "timer_%s_start_%d", BENCH_TIMER_BACKEND, count);
+    rt_snprintf(stop_name, sizeof(stop_name), "timer_%s_stop_%d", BENCH_TIMER_BACKEND, count);
+
+    timers = (struct rt_timer *)rt_malloc(sizeof(struct rt_timer) * count);
+    if (timers == RT_NULL)
+    {
+        bench_result_skip(start_name, "no_memory");
+        bench_result_skip(stop_name, "no_memory");
+
+        return;
+    }
+
+    /* same timeouts for both backends */
+    bench_timer_seed = count;
+
+    for (index = 0; index < count; index ++)
+    {
+        rt_timer_init(&timers[index], "btimer", bench_timer_timeout, RT_NULL,
+                      bench_timer_timeout_tick(), RT_TIMER_FLAG_ONE_SHOT);
+        rt_timer_start(&timers[index]);
+    }
+
+    /* restart a random active timer with a new timeout */
+    bench_result_init(&start, start_name, BENCH_LOOPS);
+    for (loop = 0; loop < BENCH_WARMUP + BENCH_LOOPS; loop ++)
+    {
+        index = bench_timer_random() % count;
+        tick  = bench_timer_timeout_tick();
+        rt_timer_control(&timers[index], RT_TIMER_CTRL_SET_TIME, &tick);
+
+        stamp = bench_time_ns();
+        rt_timer_start(&timers[index]);
+        ns = bench_time_ns() - stamp;
+
+        if (loop >= BENCH_WARMUP)
+        {
+            start.elapsed += ns;
+            bench_result_sample(&start, (rt_uint32_t)ns);
+        }
+    }
+    start.ops = BENCH_LOOPS;
+    bench_result_report(&start);
+
+    /* stop a random active timer, and start it again unmeasured */
+    bench_result_init(&stop, stop_name, BENCH_LOOPS);
+    for (loop = 0; loop < BENCH_WARMUP + BENCH_LOOPS; loop ++)
+    {
+        index = bench_timer_random() % count;
+
+        stamp = bench_time_ns();
+        rt_timer_stop(&timers[index]);
+        ns = bench_time_ns() - stamp;
+
+        rt_timer_start(&timers[index]);
+
+        if (loop >= BENCH_WARMUP)
+        {
+            stop.elapsed += ns;
+            bench_result_sample(&stop, (rt_uint32_t)ns);
+        }
+    }
+    stop.ops = BENCH_LOOPS;
+    bench_result_report(&stop);
+
+    for (index = 0; index < count; index ++)
+    {
+        rt_timer_stop(&timers[index]);
+        rt_timer_detach(&timers[index]);
+    }
+
+    rt_free(timers);
+}
+
+void bench_timer(void)
+{
+    int index;
+
+    for (index = 0; index < sizeof(bench_timer_count) / sizeof(bench_timer_count[0]); index ++)
+        bench_timer_run(bench_timer_count[index]);
+}
@@ -0,0 +1,103 @@
+/*
+ * Kernel regression tests: result reporting and the runner.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "test.h"
+
+static const struct test_case test_cases[] =
+{
+    {"mempool_intr",  test_mempool_intr},
+    {"mempool_contend", test_mempool_contend},
+    {"mp_magazine",   test_mp_magazine},
+    {"object_find",   test_object_find},
+    {"rwlock_object", test_rwlock_object},
+    {"rwlock_exclude", test_rwlock_exclude},
+    {"rwlock_profile", test_rwlock_profile},
+    {"sem_prio",      test_sem_prio},
+    {"event_clear",   test_event_clear},
+    {"heap",          test_heap},
+    {"heap_large",    test_heap_large},
+    {"heap_align",    test_heap_align},
+    {"heap_realloc",  test_heap_realloc},
+    {"memheap_fit",   test_memheap_fit},
+    {"memheap_realloc", test_memheap_realloc},
+    {"memheap_align", test_memheap_align},
+    {"mb_spsc",       test_mb_spsc},
+    {"mq_loan",       test_mq_loan},
+    {"lock_contend",  test_lock_contend},
+    {"mutex_inherit", test_mutex_inherit},
+    {"ipc_poll",      test_ipc_poll},
+    {"ipc_batch",     test_ipc_batch},
+    {"smp_sched",     test_smp_sched},
+    {"thread_usage",  test_thread_usage},
+    {"kprintf_async", test_kprintf_async},
+    {"timer_expire",  test_timer_expire},
+    {"timer_tickless", test_timer_tickless},
+};
+
+static const char *test_name;
+
+/**
+ * This function will report a failed condition of the running test.
+ *
+ * @param line the source line of the condition
+ * @param cond the condition as written
+ */
+void test_fail(int line, const char *cond)
+{
+    rt_kprintf("TEST name=%s result=failed line=%d cond=%s\n",
+               test_name, line, cond);
+}
+
+/**
+ * This function will run the tests.
+ *
+ * @param name the name of test to run, RT_NULL or "all" for every test
+ *
+ * @return the number of failed tests
+ */
+int test_run(const char *name)
+{
+    int index, count = 0, failed = 0;
+
+    if (name != RT_NULL && rt_strcmp(name, "all") == 0)
+        name = RT_NULL;
+
+    rt_kprintf("TEST_BEGIN version=%ld.%ld.%ld\n",
+               RT_VERSION, RT_SUBVERSION, RT_REVISION);
+
+    for (index = 0; index < sizeof(test_cases) / sizeof(test_cases[0]); index ++)
+    {
+        if (name != RT_NULL && rt_strcmp(name, test_cases[index].name) != 0)
+            continue;
+
+        test_name = test_cases[index].name;
+        if (test_cases[index].run() == RT_EOK)
+            rt_kprintf("TEST name=%s result=ok\n", test_name);
+        else
+            failed ++;
+        count ++;
+
+        /* the idle thread reclaims the threads exited */
+        rt_thread_delay(1);
+    }
+
+    rt_kprintf("TEST_END count=%d failed=%d\n", count, failed);
+
+    return failed;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int test(int argc, char **argv)
+{
+    test_run(argc > 1 ? argv[1] : RT_NULL);
+
+    return 0;
+}
+MSH_CMD_EXPORT(test, run kernel regression tests: test [name|all]);
+#endif
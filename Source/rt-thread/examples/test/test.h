@@ -0,0 +1,77 @@
+/*
+ * Kernel regression tests.
+ *
+ * Every test prints one result line, so a script can tell which one failed:
+ *
+ * TEST name=mempool_intr result=ok
+ * TEST name=mempool_intr result=failed line=62 cond=mp.suspend_thread_count == 0
+ */
+
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <rtthread.h>
+
+#ifndef TEST_THREAD_STACK_SIZE
+#ifdef ARCH_POSIX
+#define TEST_THREAD_STACK_SIZE      (32 * 1024)
+#else
+#define TEST_THREAD_STACK_SIZE      1024
+#endif
+#endif
+
+/* the test runner is expected to run below this priority */
+#define TEST_PRIORITY_HIGH          (RT_THREAD_PRIORITY_MAX / 8)
+
+#define TEST_THREAD_TICK            10
+
+/* fail the running test if 'cond' doesn't hold */
+#define TEST_ASSERT(cond)                                       \
+    do                                                          \
+    {                                                           \
+        if (!(cond))                                            \
+        {                                                       \
+            test_fail(__LINE__, #cond);                         \
+            return -RT_ERROR;                                   \
+        }                                                       \
+    } while (0)
+
+struct test_case
+{
+    const char *name;
+    rt_err_t (*run)(void);
+};
+
+void test_fail(int line, const char *cond);
+int test_run(const char *name);
+
+/* tests */
+rt_err_t test_mempool_intr(void);
+rt_err_t test_mempool_contend(void);
+rt_err_t test_mp_magazine(void);
+rt_err_t test_object_find(void);
+rt_err_t test_rwlock_object(void);
+rt_err_t test_rwlock_exclude(void);
+rt_err_t test_rwlock_profile(void);
+rt_err_t test_sem_prio(void);
+rt_err_t test_event_clear(void);
+rt_err_t test_heap(void);
+rt_err_t test_heap_large(void);
+rt_err_t test_heap_align(void);
+rt_err_t test_heap_realloc(void);
+rt_err_t test_memheap_fit(void);
+rt_err_t test_memheap_realloc(void);
+rt_err_t test_memheap_align(void);
+rt_err_t test_smp_sched(void);
+rt_err_t test_thread_usage(void);
+rt_err_t test_kprintf_async(void);
+rt_err_t test_mb_spsc(void);
+rt_err_t test_mq_loan(void);
+rt_err_t test_lock_contend(void);
+rt_err_t test_mutex_inherit(void);
+rt_err_t test_ipc_poll(void);
+rt_err_t test_ipc_batch(void);
+rt_err_t test_timer_expire(void);
+rt_err_t test_timer_tickless(void);
+
+#endif
@@ -0,0 +1,864 @@
+/*
+ * IPC regression tests.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "test.h"
+
+#ifdef RT_USING_RWLOCK
+/*
+ * The mutex of the writer is a part of the rwlock, only the rwlock is found
+ * by its name.
+ */
+rt_err_t test_rwlock_object(void)
+{
+    struct rt_rwlock rwlock;
+    rt_rwlock_t dynamic;
+
+    rt_rwlock_init(&rwlock, "t_rw", RT_IPC_FLAG_PRIO);
+    TEST_ASSERT(rt_object_find("t_rw", RT_Object_Class_RWLock) == &(rwlock.parent.parent));
+    TEST_ASSERT(rt_object_find("t_rw", RT_Object_Class_Mutex) == RT_NULL);
+
+    /* the writer lock still works */
+    TEST_ASSERT(rt_rwlock_take_write(&rwlock, 0) == RT_EOK);
+    TEST_ASSERT(rt_rwlock_release(&rwlock) == RT_EOK);
+    TEST_ASSERT(rt_rwlock_take_read(&rwlock, 0) == RT_EOK);
+    TEST_ASSERT(rt_rwlock_release(&rwlock) == RT_EOK);
+
+    rt_rwlock_detach(&rwlock);
+    TEST_ASSERT(rt_object_find("t_rw", RT_Object_Class_RWLock) == RT_NULL);
+
+    dynamic = rt_rwlock_create("t_rwd", RT_IPC_FLAG_FIFO);
+    TEST_ASSERT(dynamic != RT_NULL);
+    TEST_ASSERT(rt_object_find("t_rwd", RT_Object_Class_Mutex) == RT_NULL);
+    rt_rwlock_delete(dynamic);
+
+    return RT_EOK;
+}
+
+static struct rt_rwlock test_rwx;
+static struct rt_semaphore test_rwx_reader_go, test_rwx_writer_go;
+static volatile int test_rwx_reader_in, test_rwx_writer_in;
+static volatile rt_err_t test_rwx_late_result;
+
+static void test_rwx_reader_entry(void *parameter)
+{
+    if (rt_rwlock_take_read(&test_rwx, RT_WAITING_FOREVER) != RT_EOK)
+        return;
+
+    test_rwx_reader_in = 1;
+    rt_sem_take(&test_rwx_reader_go, RT_WAITING_FOREVER);
+    test_rwx_reader_in = 0;
+    rt_rwlock_release(&test_rwx);
+}
+
+static void test_rwx_writer_entry(void *parameter)
+{
+    if (rt_rwlock_take_write(&test_rwx, RT_WAITING_FOREVER) != RT_EOK)
+        return;
+
+    test_rwx_writer_in = 1;
+    rt_sem_take(&test_rwx_writer_go, RT_WAITING_FOREVER);
+    test_rwx_writer_in = 0;
+    rt_rwlock_release(&test_rwx);
+}
+
+static void test_rwx_late_entry(void *parameter)
+{
+    test_rwx_late_result = rt_rwlock_take_read(&test_rwx, 0);
+    if (test_rwx_late_result == RT_EOK)
+        rt_rwlock_release(&test_rwx);
+}
+
+static rt_err_t test_rwx_start(void (*entry)(void *parameter))
+{
+    rt_thread_t tid;
+
+    tid = rt_thread_create("t_rwx", entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    if (tid == RT_NULL)
+        return -RT_ERROR;
+
+    rt_thread_startup(tid);
+    rt_thread_delay(2);
+
+    return RT_EOK;
+}
+
+/*
+ * Readers hold a rwlock together; a writer waits for them to leave, and a
+ * reader coming meanwhile waits for the writer; the writer holds it alone.
+ */
+rt_err_t test_rwlock_exclude(void)
+{
+    rt_rwlock_init(&test_rwx, "t_rwx", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&test_rwx_reader_go, "t_rwxr", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&test_rwx_writer_go, "t_rwxw", 0, RT_IPC_FLAG_FIFO);
+    test_rwx_reader_in = test_rwx_writer_in = 0;
+
+    TEST_ASSERT(rt_rwlock_take_read(&test_rwx, 0) == RT_EOK);
+    TEST_ASSERT(test_rwx_start(test_rwx_reader_entry) == RT_EOK);
+    TEST_ASSERT(test_rwx_reader_in == 1);
+
+    TEST_ASSERT(test_rwx_start(test_rwx_writer_entry) == RT_EOK);
+    TEST_ASSERT(test_rwx_writer_in == 0);
+    TEST_ASSERT(test_rwx_start(test_rwx_late_entry) == RT_EOK);
+    TEST_ASSERT(test_rwx_late_result == -RT_ETIMEOUT);
+
+    /* the writer gets it once both readers leave */
+    TEST_ASSERT(rt_rwlock_release(&test_rwx) == RT_EOK);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_rwx_writer_in == 0);
+    rt_sem_release(&test_rwx_reader_go);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_rwx_reader_in == 0);
+    TEST_ASSERT(test_rwx_writer_in == 1);
+
+    TEST_ASSERT(rt_rwlock_take_read(&test_rwx, 0) == -RT_ETIMEOUT);
+    TEST_ASSERT(rt_rwlock_take_write(&test_rwx, 0) == -RT_ETIMEOUT);
+
+    rt_sem_release(&test_rwx_writer_go);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_rwx_writer_in == 0);
+    TEST_ASSERT(rt_rwlock_take_write(&test_rwx, 0) == RT_EOK);
+    TEST_ASSERT(rt_rwlock_release(&test_rwx) == RT_EOK);
+
+    rt_rwlock_detach(&test_rwx);
+    rt_sem_detach(&test_rwx_reader_go);
+    rt_sem_detach(&test_rwx_writer_go);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_rwlock_object(void)
+{
+    return RT_EOK;
+}
+
+rt_err_t test_rwlock_exclude(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#if defined(RT_USING_RWLOCK) && defined(RT_USING_IPC_PROFILE)
+static struct rt_rwlock test_rw;
+
+static void test_rwlock_writer_entry(void *parameter)
+{
+    rt_rwlock_take_write(&test_rw, RT_WAITING_FOREVER);
+    rt_rwlock_release(&test_rw);
+}
+
+/*
+ * A writer blocked on a rwlock held by another writer is counted in the
+ * profile of the rwlock, as contended and with the ticks it waited.
+ */
+rt_err_t test_rwlock_profile(void)
+{
+    struct rt_ipc_profile profile;
+    rt_thread_t writer;
+
+    rt_rwlock_init(&test_rw, "t_rwp", RT_IPC_FLAG_PRIO);
+    rt_ipc_profile_start();
+
+    TEST_ASSERT(rt_rwlock_take_write(&test_rw, 0) == RT_EOK);
+
+    writer = rt_thread_create("t_rww", test_rwlock_writer_entry, RT_NULL,
+                              TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(writer != RT_NULL);
+    rt_thread_startup(writer);
+    rt_thread_delay(2);
+
+    /* the writer takes it as it's released */
+    rt_rwlock_release(&test_rw);
+    rt_thread_delay(2);
+
+    rt_ipc_profile_stop();
+    rt_ipc_profile_get(&(test_rw.parent.parent), &profile);
+    rt_rwlock_detach(&test_rw);
+
+    TEST_ASSERT(profile.acquire == 2);
+    TEST_ASSERT(profile.contended == 1);
+    TEST_ASSERT(profile.wait_max >= 1);
+    TEST_ASSERT(profile.wait_total == profile.wait_max);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_rwlock_profile(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_SEMAPHORE
+static struct rt_semaphore test_sem;
+static volatile int test_sem_order[5], test_sem_count;
+
+static void test_sem_prio_entry(void *parameter)
+{
+    if (rt_sem_take(&test_sem, RT_WAITING_FOREVER) == RT_EOK)
+        test_sem_order[test_sem_count ++] = (int)(rt_ubase_t)parameter;
+}
+
+/*
+ * The waiters of a RT_IPC_FLAG_PRIO semaphore get it by priority, and the
+ * ones of the same priority in the order they came.
+ */
+rt_err_t test_sem_prio(void)
+{
+    static const rt_uint8_t priority[] = {3, 1, 4, 1, 0};
+    rt_thread_t tid;
+    int index;
+
+    rt_sem_init(&test_sem, "t_sem", 0, RT_IPC_FLAG_PRIO);
+    test_sem_count = 0;
+
+    for (index = 0; index < 5; index ++)
+    {
+        tid = rt_thread_create("t_sem", test_sem_prio_entry, (void *)(rt_ubase_t)index,
+                               TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH + priority[index],
+                               TEST_THREAD_TICK);
+        TEST_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+    }
+    rt_thread_delay(2);
+
+    for (index = 0; index < 5; index ++)
+        rt_sem_release(&test_sem);
+    rt_thread_delay(2);
+
+    TEST_ASSERT(test_sem_count == 5);
+    TEST_ASSERT(test_sem_order[0] == 4);
+    TEST_ASSERT(test_sem_order[1] == 1);
+    TEST_ASSERT(test_sem_order[2] == 3);
+    TEST_ASSERT(test_sem_order[3] == 0);
+    TEST_ASSERT(test_sem_order[4] == 2);
+
+    rt_sem_detach(&test_sem);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_sem_prio(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_EVENT
+static struct rt_event test_event;
+static volatile int test_event_high, test_event_low;
+
+static void test_event_high_entry(void *parameter)
+{
+    rt_uint32_t recved;
+
+    if (rt_event_recv(&test_event, (1 << 0) | (1 << 5),
+                      RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+                      RT_WAITING_FOREVER, &recved) == RT_EOK)
+        test_event_high = recved;
+}
+
+static void test_event_low_entry(void *parameter)
+{
+    rt_uint32_t recved;
+
+    if (rt_event_recv(&test_event, (1 << 0),
+                      RT_EVENT_FLAG_AND | RT_EVENT_FLAG_CLEAR,
+                      RT_WAITING_FOREVER, &recved) == RT_EOK)
+        test_event_low = recved;
+}
+
+/*
+ * Two threads of a RT_IPC_FLAG_PRIO event wait for bit 0 and clear it, the
+ * higher priority one gets it first, however the threads are indexed.
+ */
+rt_err_t test_event_clear(void)
+{
+    rt_thread_t high, low;
+
+    rt_event_init(&test_event, "t_ev", RT_IPC_FLAG_PRIO);
+    test_event_high = test_event_low = 0;
+
+    low  = rt_thread_create("t_evl", test_event_low_entry, RT_NULL,
+                            TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH + 2, TEST_THREAD_TICK);
+    high = rt_thread_create("t_evh", test_event_high_entry, RT_NULL,
+                            TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(low != RT_NULL && high != RT_NULL);
+    rt_thread_startup(low);
+    rt_thread_startup(high);
+    rt_thread_delay(2);
+
+    rt_event_send(&test_event, (1 << 0));
+    rt_thread_delay(2);
+    TEST_ASSERT(test_event_high == (1 << 0));
+    TEST_ASSERT(test_event_low == 0);
+    TEST_ASSERT(test_event.set == 0);
+
+    rt_event_send(&test_event, (1 << 0));
+    rt_thread_delay(2);
+    TEST_ASSERT(test_event_low == (1 << 0));
+
+    rt_event_detach(&test_event);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_event_clear(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_MAILBOX_SPSC
+#define TEST_MB_COUNT               10000
+#define TEST_MB_TIMER_COUNT         20
+
+static struct rt_mailbox test_mb;
+static rt_uint32_t test_mb_pool[4];
+static volatile rt_uint32_t test_mb_sent;
+
+static void test_mb_producer_entry(void *parameter)
+{
+    rt_uint32_t value;
+
+    for (value = 0; value < TEST_MB_COUNT; value ++)
+    {
+        if (rt_mb_send_wait(&test_mb, value, RT_WAITING_FOREVER) != RT_EOK)
+            break;
+    }
+}
+
+/* the producer in interrupt, one mail each tick */
+static void test_mb_timeout(void *parameter)
+{
+    if (test_mb_sent < TEST_MB_TIMER_COUNT && rt_mb_send(&test_mb, test_mb_sent) == RT_EOK)
+        test_mb_sent ++;
+}
+
+/*
+ * The mails of a RT_IPC_FLAG_SPSC mailbox come in order, from a thread which
+ * waits while it's full and from the timer interrupt.
+ */
+rt_err_t test_mb_spsc(void)
+{
+    struct rt_timer timer;
+    rt_thread_t tid;
+    rt_uint32_t value, expected;
+
+    rt_mb_init(&test_mb, "t_mb", test_mb_pool, sizeof(test_mb_pool) / sizeof(test_mb_pool[0]),
+               RT_IPC_FLAG_SPSC);
+
+    tid = rt_thread_create("t_mbp", test_mb_producer_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    for (expected = 0; expected < TEST_MB_COUNT; expected ++)
+    {
+        TEST_ASSERT(rt_mb_recv(&test_mb, &value, RT_TICK_PER_SECOND) == RT_EOK);
+        TEST_ASSERT(value == expected);
+    }
+
+    test_mb_sent = 0;
+    rt_timer_init(&timer, "t_mbt", test_mb_timeout, RT_NULL, 1,
+                  RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+    rt_timer_start(&timer);
+    for (expected = 0; expected < TEST_MB_TIMER_COUNT; expected ++)
+    {
+        TEST_ASSERT(rt_mb_recv(&test_mb, &value, RT_TICK_PER_SECOND) == RT_EOK);
+        TEST_ASSERT(value == expected);
+    }
+    rt_timer_detach(&timer);
+
+    /* full without a receiver */
+    for (value = 0; value < sizeof(test_mb_pool) / sizeof(test_mb_pool[0]); value ++)
+        TEST_ASSERT(rt_mb_send(&test_mb, value) == RT_EOK);
+    TEST_ASSERT(rt_mb_send(&test_mb, value) == -RT_EFULL);
+    TEST_ASSERT(rt_mb_recv(&test_mb, &value, 0) == RT_EOK && value == 0);
+
+    rt_mb_detach(&test_mb);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_mb_spsc(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_MESSAGEQUEUE
+#define TEST_MQ_COUNT               4
+
+static rt_mq_t test_mq;
+static void *volatile test_mq_buffer;
+
+static void test_mq_receiver_entry(void *parameter)
+{
+    void *buffer;
+
+    if (rt_mq_recv_loan(test_mq, &buffer, RT_WAITING_FOREVER) == RT_EOK)
+        test_mq_buffer = buffer;
+}
+
+/*
+ * A loaned buffer is received in place, the one the sender filled, and is
+ * back to the free buffers once released; there are msg_max of them.
+ */
+rt_err_t test_mq_loan(void)
+{
+    void *buffers[TEST_MQ_COUNT];
+    void *buffer;
+    char message[16];
+    rt_thread_t tid;
+    int index;
+
+    test_mq = rt_mq_create("t_mq", sizeof(message), TEST_MQ_COUNT, RT_IPC_FLAG_FIFO);
+    TEST_ASSERT(test_mq != RT_NULL);
+
+    for (index = 0; index < TEST_MQ_COUNT; index ++)
+    {
+        buffers[index] = rt_mq_loan(test_mq);
+        TEST_ASSERT(buffers[index] != RT_NULL);
+        rt_snprintf((char *)buffers[index], sizeof(message), "loan %d", index);
+    }
+    TEST_ASSERT(rt_mq_loan(test_mq) == RT_NULL);
+    TEST_ASSERT(rt_mq_send(test_mq, "full", 5) == -RT_EFULL);
+
+    for (index = 0; index < TEST_MQ_COUNT - 1; index ++)
+        TEST_ASSERT(rt_mq_commit(test_mq, buffers[index]) == RT_EOK);
+    rt_mq_release(test_mq, buffers[TEST_MQ_COUNT - 1]);
+
+    /* in place, or copied */
+    TEST_ASSERT(rt_mq_recv_loan(test_mq, &buffer, 0) == RT_EOK);
+    TEST_ASSERT(buffer == buffers[0]);
+    TEST_ASSERT(rt_strcmp((char *)buffer, "loan 0") == 0);
+    rt_mq_release(test_mq, buffer);
+    TEST_ASSERT(rt_mq_recv(test_mq, message, sizeof(message), 0) == RT_EOK);
+    TEST_ASSERT(rt_strcmp(message, "loan 1") == 0);
+    TEST_ASSERT(rt_mq_recv_loan(test_mq, &buffer, 0) == RT_EOK);
+    TEST_ASSERT(buffer == buffers[2]);
+    rt_mq_release(test_mq, buffer);
+    TEST_ASSERT(rt_mq_recv_loan(test_mq, &buffer, 0) == -RT_ETIMEOUT);
+
+    /* a waiting receiver gets the buffer committed */
+    test_mq_buffer = RT_NULL;
+    tid = rt_thread_create("t_mqr", test_mq_receiver_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    rt_thread_delay(2);
+    buffer = rt_mq_loan(test_mq);
+    TEST_ASSERT(buffer != RT_NULL);
+    TEST_ASSERT(rt_mq_commit(test_mq, buffer) == RT_EOK);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_mq_buffer == buffer);
+    rt_mq_release(test_mq, buffer);
+
+    /* all the buffers are free again */
+    for (index = 0; index < TEST_MQ_COUNT; index ++)
+        TEST_ASSERT((buffers[index] = rt_mq_loan(test_mq)) != RT_NULL);
+    for (index = 0; index < TEST_MQ_COUNT; index ++)
+        rt_mq_release(test_mq, buffers[index]);
+
+    rt_mq_delete(test_mq);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_mq_loan(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#if defined(RT_USING_SEMAPHORE) && defined(RT_USING_MUTEX)
+#define TEST_LOCK_THREADS           4
+#define TEST_LOCK_LOOPS             2000
+
+static struct rt_mutex test_lock_mutex;
+static struct rt_semaphore test_lock_sem, test_lock_done;
+static volatile rt_uint32_t test_lock_mutex_count, test_lock_sem_count;
+static volatile int test_lock_woken;
+
+static void test_lock_waiter_entry(void *parameter)
+{
+    if (rt_sem_take(&test_lock_sem, RT_WAITING_FOREVER) == RT_EOK)
+        test_lock_woken |= 1;
+
+    if (rt_mutex_take(&test_lock_mutex, RT_WAITING_FOREVER) == RT_EOK)
+    {
+        test_lock_woken |= 2;
+        rt_mutex_release(&test_lock_mutex);
+    }
+}
+
+static void test_lock_entry(void *parameter)
+{
+    rt_uint32_t count;
+    int loop;
+
+    for (loop = 0; loop < TEST_LOCK_LOOPS; loop ++)
+    {
+        rt_mutex_take(&test_lock_mutex, RT_WAITING_FOREVER);
+        count = test_lock_mutex_count;
+        /* let the others find it taken and wait, now and then */
+        if (loop % 16 == 0)
+            rt_thread_yield();
+        test_lock_mutex_count = count + 1;
+        rt_mutex_release(&test_lock_mutex);
+
+        rt_sem_take(&test_lock_sem, RT_WAITING_FOREVER);
+        count = test_lock_sem_count;
+        if (loop % 16 == 8)
+            rt_thread_yield();
+        test_lock_sem_count = count + 1;
+        rt_sem_release(&test_lock_sem);
+    }
+
+    rt_sem_release(&test_lock_done);
+}
+
+/*
+ * A thread waiting for a semaphore or a mutex gets it from the release,
+ * which looks at the waiters without disabling interrupt. Then threads of the same priority take a mutex and a semaphore
+ * of one, by the fast path or waiting for it, and no one is lost or let in
+ * twice.
+ */
+rt_err_t test_lock_contend(void)
+{
+    rt_thread_t tid;
+    int index;
+
+    rt_mutex_init(&test_lock_mutex, "t_lkm", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&test_lock_sem, "t_lks", 0, RT_IPC_FLAG_PRIO);
+    rt_sem_init(&test_lock_done, "t_lkd", 0, RT_IPC_FLAG_FIFO);
+    test_lock_mutex_count = test_lock_sem_count = 0;
+    test_lock_woken = 0;
+
+    TEST_ASSERT(rt_mutex_take(&test_lock_mutex, 0) == RT_EOK);
+    tid = rt_thread_create("t_lkw", test_lock_waiter_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_lock_woken == 0);
+    rt_sem_release(&test_lock_sem);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_lock_woken == 1);
+    rt_mutex_release(&test_lock_mutex);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_lock_woken == 3);
+    TEST_ASSERT(rt_sem_take(&test_lock_sem, 0) == -RT_ETIMEOUT);
+    rt_sem_release(&test_lock_sem);
+
+    for (index = 0; index < TEST_LOCK_THREADS; index ++)
+    {
+        tid = rt_thread_create("t_lk", test_lock_entry, RT_NULL,
+                               TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, 1);
+        TEST_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+    }
+    for (index = 0; index < TEST_LOCK_THREADS; index ++)
+        TEST_ASSERT(rt_sem_take(&test_lock_done, 10 * RT_TICK_PER_SECOND) == RT_EOK);
+
+    TEST_ASSERT(test_lock_mutex_count == TEST_LOCK_THREADS * TEST_LOCK_LOOPS);
+    TEST_ASSERT(test_lock_sem_count == TEST_LOCK_THREADS * TEST_LOCK_LOOPS);
+    TEST_ASSERT(test_lock_mutex.owner == RT_NULL);
+    TEST_ASSERT(rt_sem_take(&test_lock_sem, 0) == RT_EOK);
+    TEST_ASSERT(rt_sem_take(&test_lock_sem, 0) == -RT_ETIMEOUT);
+
+    rt_mutex_detach(&test_lock_mutex);
+    rt_sem_detach(&test_lock_sem);
+    rt_sem_detach(&test_lock_done);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_lock_contend(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_MUTEX
+static struct rt_mutex test_pi_outer, test_pi_inner, test_pi_ceiling;
+static struct rt_semaphore test_pi_go;
+static volatile rt_uint8_t test_pi_low_after, test_pi_middle_after;
+static volatile rt_uint8_t test_pi_ceiling_held, test_pi_ceiling_after;
+static volatile int test_pi_high_done;
+
+static void test_pi_low_entry(void *parameter)
+{
+    rt_mutex_take(&test_pi_inner, RT_WAITING_FOREVER);
+    rt_sem_take(&test_pi_go, RT_WAITING_FOREVER);
+    rt_mutex_release(&test_pi_inner);
+    test_pi_low_after = rt_thread_self()->current_priority;
+}
+
+static void test_pi_middle_entry(void *parameter)
+{
+    rt_mutex_take(&test_pi_outer, RT_WAITING_FOREVER);
+    rt_mutex_take(&test_pi_inner, RT_WAITING_FOREVER);
+    rt_mutex_release(&test_pi_inner);
+    rt_mutex_release(&test_pi_outer);
+    test_pi_middle_after = rt_thread_self()->current_priority;
+}
+
+static void test_pi_high_entry(void *parameter)
+{
+    rt_mutex_take(&test_pi_outer, RT_WAITING_FOREVER);
+    rt_mutex_release(&test_pi_outer);
+    test_pi_high_done = 1;
+}
+
+static void test_pi_ceiling_entry(void *parameter)
+{
+    rt_mutex_take(&test_pi_ceiling, RT_WAITING_FOREVER);
+    test_pi_ceiling_held = rt_thread_self()->current_priority;
+    rt_mutex_release(&test_pi_ceiling);
+    test_pi_ceiling_after = rt_thread_self()->current_priority;
+}
+
+/*
+ * The high thread waits for the outer mutex held by the middle one, which
+ * waits for the inner mutex held by the low one: both are raised to the
+ * high priority, and are back to their own once they release them. The
+ * owner of a mutex with a priority ceiling runs at the ceiling.
+ */
+rt_err_t test_mutex_inherit(void)
+{
+    rt_thread_t low, middle, high, ceiling;
+
+    rt_mutex_init(&test_pi_outer, "t_pio", RT_IPC_FLAG_PRIO);
+    rt_mutex_init(&test_pi_inner, "t_pii", RT_IPC_FLAG_PRIO);
+    rt_mutex_init(&test_pi_ceiling, "t_pic", RT_IPC_FLAG_PRIO);
+    rt_sem_init(&test_pi_go, "t_pig", 0, RT_IPC_FLAG_FIFO);
+    test_pi_low_after = test_pi_middle_after = RT_UINT8_MAX;
+    test_pi_ceiling_held = test_pi_ceiling_after = RT_UINT8_MAX;
+    test_pi_high_done = 0;
+
+    low    = rt_thread_create("t_pil", test_pi_low_entry, RT_NULL,
+                              TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH + 4, TEST_THREAD_TICK);
+    middle = rt_thread_create("t_pim", test_pi_middle_entry, RT_NULL,
+                              TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH + 2, TEST_THREAD_TICK);
+    high   = rt_thread_create("t_pih", test_pi_high_entry, RT_NULL,
+                              TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(low != RT_NULL && middle != RT_NULL && high != RT_NULL);
+
+    rt_thread_startup(low);
+    rt_thread_delay(2);
+    rt_thread_startup(middle);
+    rt_thread_delay(2);
+    TEST_ASSERT(low->current_priority == TEST_PRIORITY_HIGH + 2);
+    rt_thread_startup(high);
+    rt_thread_delay(2);
+    TEST_ASSERT(middle->current_priority == TEST_PRIORITY_HIGH);
+    TEST_ASSERT(low->current_priority == TEST_PRIORITY_HIGH);
+
+    rt_sem_release(&test_pi_go);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_pi_high_done == 1);
+    TEST_ASSERT(test_pi_low_after == TEST_PRIORITY_HIGH + 4);
+    TEST_ASSERT(test_pi_middle_after == TEST_PRIORITY_HIGH + 2);
+
+    TEST_ASSERT(rt_mutex_setprioceiling(&test_pi_ceiling, TEST_PRIORITY_HIGH - 1) == RT_UINT8_MAX);
+    TEST_ASSERT(rt_mutex_getprioceiling(&test_pi_ceiling) == TEST_PRIORITY_HIGH - 1);
+    ceiling = rt_thread_create("t_pic", test_pi_ceiling_entry, RT_NULL,
+                               TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH + 4, TEST_THREAD_TICK);
+    TEST_ASSERT(ceiling != RT_NULL);
+    rt_thread_startup(ceiling);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_pi_ceiling_held == TEST_PRIORITY_HIGH - 1);
+    TEST_ASSERT(test_pi_ceiling_after == TEST_PRIORITY_HIGH + 4);
+
+    rt_mutex_detach(&test_pi_outer);
+    rt_mutex_detach(&test_pi_inner);
+    rt_mutex_detach(&test_pi_ceiling);
+    rt_sem_detach(&test_pi_go);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_mutex_inherit(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#if defined(RT_USING_IPC_POLL) && defined(RT_USING_MAILBOX) && defined(RT_USING_EVENT)
+static struct rt_semaphore test_poll_sem;
+static struct rt_mailbox test_poll_mb;
+static struct rt_event test_poll_event;
+static rt_uint32_t test_poll_mb_pool[4];
+static struct rt_ipc_poll test_poll_polls[3];
+static volatile int test_poll_ready;
+static volatile rt_uint32_t test_poll_mail;
+
+static void test_poll_init(struct rt_ipc_poll *polls)
+{
+    rt_memset(polls, 0, sizeof(struct rt_ipc_poll) * 3);
+    polls[0].object = &(test_poll_sem.parent);
+    polls[1].object = &(test_poll_mb.parent);
+    polls[2].object = &(test_poll_event.parent);
+    polls[2].set    = (1 << 0) | (1 << 1);
+    polls[2].option = RT_EVENT_FLAG_AND;
+}
+
+static void test_poll_entry(void *parameter)
+{
+    rt_uint32_t value;
+
+    test_poll_ready = rt_ipc_poll(test_poll_polls, 3, RT_WAITING_FOREVER);
+    if (test_poll_polls[1].result == RT_EOK && rt_mb_recv(&test_poll_mb, &value, 0) == RT_EOK)
+        test_poll_mail = value;
+}
+
+/*
+ * A thread polling a semaphore, a mailbox and an event is woken by a mail,
+ * and the poll tells which object is ready; the event is ready with all of
+ * its bits, and a detached object wakes the poll too.
+ */
+rt_err_t test_ipc_poll(void)
+{
+    struct rt_ipc_poll polls[3];
+    rt_thread_t tid;
+    rt_uint32_t set;
+
+    rt_sem_init(&test_poll_sem, "t_pls", 0, RT_IPC_FLAG_FIFO);
+    rt_mb_init(&test_poll_mb, "t_plm", test_poll_mb_pool,
+               sizeof(test_poll_mb_pool) / sizeof(test_poll_mb_pool[0]), RT_IPC_FLAG_FIFO);
+    rt_event_init(&test_poll_event, "t_ple", RT_IPC_FLAG_FIFO);
+
+    test_poll_init(polls);
+    TEST_ASSERT(rt_ipc_poll(polls, 3, 0) == -RT_ETIMEOUT);
+    rt_event_send(&test_poll_event, (1 << 0));
+    TEST_ASSERT(rt_ipc_poll(polls, 3, 0) == -RT_ETIMEOUT);
+
+    test_poll_init(test_poll_polls);
+    test_poll_ready = 0;
+    test_poll_mail = 0;
+    tid = rt_thread_create("t_pl", test_poll_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_poll_ready == 0);
+    rt_mb_send(&test_poll_mb, 0x55aa);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_poll_ready == 1);
+    TEST_ASSERT(test_poll_polls[0].result == -RT_ETIMEOUT);
+    TEST_ASSERT(test_poll_polls[1].result == RT_EOK);
+    TEST_ASSERT(test_poll_polls[2].result == -RT_ETIMEOUT);
+    TEST_ASSERT(test_poll_mail == 0x55aa);
+
+    rt_sem_release(&test_poll_sem);
+    rt_event_send(&test_poll_event, (1 << 1));
+    test_poll_init(polls);
+    TEST_ASSERT(rt_ipc_poll(polls, 3, 0) == 2);
+    TEST_ASSERT(polls[0].result == RT_EOK);
+    TEST_ASSERT(polls[1].result == -RT_ETIMEOUT);
+    TEST_ASSERT(polls[2].result == RT_EOK);
+    TEST_ASSERT(rt_sem_take(&test_poll_sem, 0) == RT_EOK);
+    TEST_ASSERT(rt_event_recv(&test_poll_event, (1 << 0) | (1 << 1),
+                              RT_EVENT_FLAG_AND | RT_EVENT_FLAG_CLEAR, 0, &set) == RT_EOK);
+
+    /* the poll is woken by detaching the semaphore */
+    test_poll_init(test_poll_polls);
+    test_poll_ready = 0;
+    tid = rt_thread_create("t_pl", test_poll_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    rt_thread_delay(2);
+    rt_sem_detach(&test_poll_sem);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_poll_ready >= 1);
+    TEST_ASSERT(test_poll_polls[0].result == -RT_ERROR);
+
+    rt_mb_detach(&test_poll_mb);
+    rt_event_detach(&test_poll_event);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_ipc_poll(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#if defined(RT_USING_MAILBOX) && defined(RT_USING_MESSAGEQUEUE)
+#define TEST_BATCH_MB_SIZE          8
+#define TEST_BATCH_MQ_COUNT         4
+
+static struct rt_mailbox test_batch_mb;
+static rt_uint32_t test_batch_mb_pool[TEST_BATCH_MB_SIZE];
+static rt_uint32_t test_batch_received[4];
+static volatile rt_size_t test_batch_count;
+
+static void test_batch_receiver_entry(void *parameter)
+{
+    test_batch_count = rt_mb_recv_n(&test_batch_mb, test_batch_received, 4, RT_WAITING_FOREVER);
+}
+
+/*
+ * The mails and messages sent in a batch are as many as there is room for,
+ * and are received in order in batches of any size; a receiver waiting for
+ * a batch gets the mails sent at once.
+ */
+rt_err_t test_ipc_batch(void)
+{
+    rt_uint32_t values[12], received[12];
+    rt_mq_t mq;
+    rt_thread_t tid;
+    rt_size_t index;
+
+    for (index = 0; index < 12; index ++)
+        values[index] = index;
+
+    rt_mb_init(&test_batch_mb, "t_btm", test_batch_mb_pool, TEST_BATCH_MB_SIZE, RT_IPC_FLAG_FIFO);
+    TEST_ASSERT(rt_mb_send_wait_n(&test_batch_mb, values, 12, 0) == TEST_BATCH_MB_SIZE);
+    TEST_ASSERT(rt_mb_recv_n(&test_batch_mb, received, 5, 0) == 5);
+    TEST_ASSERT(rt_mb_recv_n(&test_batch_mb, received + 5, 7, 0) == 3);
+    TEST_ASSERT(rt_mb_recv_n(&test_batch_mb, received, 1, 0) == 0);
+    for (index = 0; index < TEST_BATCH_MB_SIZE; index ++)
+        TEST_ASSERT(received[index] == index);
+
+    test_batch_count = 0;
+    tid = rt_thread_create("t_bt", test_batch_receiver_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+    rt_thread_delay(2);
+    TEST_ASSERT(rt_mb_send_wait_n(&test_batch_mb, values + 4, 3, 0) == 3);
+    rt_thread_delay(2);
+    TEST_ASSERT(test_batch_count == 3);
+    for (index = 0; index < 3; index ++)
+        TEST_ASSERT(test_batch_received[index] == 4 + index);
+    rt_mb_detach(&test_batch_mb);
+
+    mq = rt_mq_create("t_btq", 8, TEST_BATCH_MQ_COUNT, RT_IPC_FLAG_FIFO);
+    TEST_ASSERT(mq != RT_NULL);
+    TEST_ASSERT(rt_mq_send_n(mq, values, sizeof(rt_uint32_t), 6) == TEST_BATCH_MQ_COUNT);
+    TEST_ASSERT(rt_mq_send_n(mq, values, sizeof(rt_uint32_t), 1) == 0);
+    rt_memset(received, 0, sizeof(received));
+    TEST_ASSERT(rt_mq_recv_n(mq, received, sizeof(rt_uint32_t), 6, 0) == TEST_BATCH_MQ_COUNT);
+    TEST_ASSERT(rt_mq_recv_n(mq, received, sizeof(rt_uint32_t), 1, 0) == 0);
+    for (index = 0; index < TEST_BATCH_MQ_COUNT; index ++)
+        TEST_ASSERT(received[index] == index);
+    rt_mq_delete(mq);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_ipc_batch(void)
+{
+    return RT_EOK;
+}
+#endif
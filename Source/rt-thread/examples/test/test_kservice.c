@@ -0,0 +1,48 @@
+/*
+ * Kernel service regression tests.
+ */
+
+#include <rtthread.h>
+
+#include "test.h"
+
+#if defined(RT_USING_CONSOLE) && defined(RT_USING_KPRINTF_ASYNC)
+
+/* twice the default ring, so it fills up whatever RT_KPRINTF_ASYNC_SLOTS is */
+#define TEST_KPRINTF_COUNT          256
+
+/*
+ * The messages printed while the log thread can't run fill the log ring,
+ * and the ones after it's full are dropped and counted; once flushed, the
+ * ring takes messages again.
+ */
+rt_err_t test_kprintf_async(void)
+{
+    rt_uint32_t drop;
+    int index;
+
+    rt_kprintf_flush();
+    drop = rt_kprintf_drop_get();
+
+    /* empty messages, which write nothing out */
+    rt_enter_critical();
+    for (index = 0; index < TEST_KPRINTF_COUNT; index ++)
+        rt_kprintf("%s", "");
+    rt_exit_critical();
+
+    TEST_ASSERT(rt_kprintf_drop_get() != drop);
+
+    rt_kprintf_flush();
+    drop = rt_kprintf_drop_get();
+    rt_kprintf("%s", "");
+    TEST_ASSERT(rt_kprintf_drop_get() == drop);
+    rt_kprintf_flush();
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_kprintf_async(void)
+{
+    return RT_EOK;
+}
+#endif
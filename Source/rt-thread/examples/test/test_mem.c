@@ -0,0 +1,468 @@
+/*
+ * Heap regression tests, of whichever system heap is configured.
+ */
+
+#include <rtthread.h>
+
+#include "test.h"
+
+#if defined(RT_USING_HEAP) || defined(RT_USING_MEMHEAP)
+/* fill a block with a pattern of the seed */
+static void test_heap_fill(void *ptr, rt_size_t size, int seed)
+{
+    rt_uint8_t *data = (rt_uint8_t *)ptr;
+    rt_size_t index;
+
+    for (index = 0; index < size; index ++)
+        data[index] = (rt_uint8_t)(seed + index);
+}
+
+/* check the pattern of test_heap_fill */
+static rt_bool_t test_heap_check(void *ptr, rt_size_t size, int seed)
+{
+    rt_uint8_t *data = (rt_uint8_t *)ptr;
+    rt_size_t index;
+
+    for (index = 0; index < size; index ++)
+    {
+        if (data[index] != (rt_uint8_t)(seed + index))
+            return RT_FALSE;
+    }
+
+    return RT_TRUE;
+}
+#endif
+
+#ifdef RT_USING_HEAP
+
+#define TEST_HEAP_COUNT             64
+
+/*
+ * Blocks of many sizes are allocated, freed in a mixed order, grown and
+ * shrunk, and keep their data; the used size is back once they are freed.
+ */
+rt_err_t test_heap(void)
+{
+    void *ptrs[TEST_HEAP_COUNT];
+    rt_size_t sizes[TEST_HEAP_COUNT];
+    rt_uint32_t total, used, used_before, max_used;
+    rt_size_t offset;
+    int index;
+
+    rt_memory_info(&total, &used_before, &max_used);
+
+    for (index = 0; index < TEST_HEAP_COUNT; index ++)
+    {
+        sizes[index] = (index * 37) % 2000 + 1;
+        ptrs[index]  = rt_malloc(sizes[index]);
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        TEST_ASSERT(((rt_ubase_t)ptrs[index] & (RT_ALIGN_SIZE - 1)) == 0);
+        test_heap_fill(ptrs[index], sizes[index], index);
+    }
+
+    /* holes between the blocks */
+    for (index = 1; index < TEST_HEAP_COUNT; index += 2)
+    {
+        rt_free(ptrs[index]);
+        ptrs[index] = RT_NULL;
+    }
+
+    /* grow and shrink the blocks left, into the holes or elsewhere */
+    for (index = 0; index < TEST_HEAP_COUNT; index += 2)
+    {
+        TEST_ASSERT(test_heap_check(ptrs[index], sizes[index], index));
+
+        ptrs[index] = rt_realloc(ptrs[index], sizes[index] * 3);
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        TEST_ASSERT(test_heap_check(ptrs[index], sizes[index], index));
+
+        sizes[index] = sizes[index] / 2 + 1;
+        ptrs[index]  = rt_realloc(ptrs[index], sizes[index]);
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        TEST_ASSERT(test_heap_check(ptrs[index], sizes[index], index));
+    }
+
+    /* the holes again, zeroed */
+    for (index = 1; index < TEST_HEAP_COUNT; index += 2)
+    {
+        ptrs[index] = rt_calloc(sizes[index], 1);
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        for (offset = 0; offset < sizes[index]; offset ++)
+            TEST_ASSERT(((rt_uint8_t *)ptrs[index])[offset] == 0);
+        test_heap_fill(ptrs[index], sizes[index], index);
+    }
+
+    for (index = 0; index < TEST_HEAP_COUNT; index ++)
+    {
+        TEST_ASSERT(test_heap_check(ptrs[index], sizes[index], index));
+        rt_free(ptrs[index]);
+    }
+
+    /* the idle thread may free the stacks of the threads exited meanwhile */
+    rt_memory_info(&total, &used, &max_used);
+    TEST_ASSERT(used <= used_before);
+
+    return RT_EOK;
+}
+
+#define TEST_HEAP_LARGE_COUNT       4
+
+/*
+ * Blocks from a few pages up, which the slab heap takes as whole pages
+ * rather than from a zone, and a block moved between the two by realloc.
+ */
+rt_err_t test_heap_large(void)
+{
+    static const rt_size_t sizes[TEST_HEAP_LARGE_COUNT] = {16 * 1024, 16 * 1024 + 1, 40000, 100000};
+    void *ptrs[TEST_HEAP_LARGE_COUNT];
+    void *ptr;
+    rt_uint32_t total, used, used_before, max_used;
+    int index;
+
+    rt_memory_info(&total, &used_before, &max_used);
+
+    for (index = 0; index < TEST_HEAP_LARGE_COUNT; index ++)
+    {
+        ptrs[index] = rt_malloc(sizes[index]);
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        TEST_ASSERT(((rt_ubase_t)ptrs[index] & (RT_ALIGN_SIZE - 1)) == 0);
+        test_heap_fill(ptrs[index], sizes[index], index);
+    }
+
+    ptr = rt_malloc(100);
+    TEST_ASSERT(ptr != RT_NULL);
+    test_heap_fill(ptr, 100, 7);
+    ptr = rt_realloc(ptr, 50000);
+    TEST_ASSERT(ptr != RT_NULL);
+    TEST_ASSERT(test_heap_check(ptr, 100, 7));
+    test_heap_fill(ptr, 50000, 7);
+    ptr = rt_realloc(ptr, 100);
+    TEST_ASSERT(ptr != RT_NULL);
+    TEST_ASSERT(test_heap_check(ptr, 100, 7));
+    rt_free(ptr);
+
+    for (index = 0; index < TEST_HEAP_LARGE_COUNT; index ++)
+    {
+        TEST_ASSERT(test_heap_check(ptrs[index], sizes[index], index));
+        rt_free(ptrs[index]);
+    }
+
+    rt_memory_info(&total, &used, &max_used);
+    TEST_ASSERT(used <= used_before);
+
+    return RT_EOK;
+}
+
+#define TEST_ALIGN_COUNT            6
+
+static const rt_size_t test_aligns[TEST_ALIGN_COUNT] = {8, 16, 64, 256, 1024, 4096};
+
+/*
+ * Blocks of each alignment are aligned and hold their size; the small
+ * memory heap takes them from a free block without the alignment added to
+ * the size, and the used size is back once they are freed.
+ */
+rt_err_t test_heap_align(void)
+{
+    void *ptrs[TEST_ALIGN_COUNT];
+    rt_uint32_t total, used, used_before, max_used;
+    int index;
+
+    for (index = 0; index < TEST_ALIGN_COUNT; index ++)
+    {
+        rt_memory_info(&total, &used_before, &max_used);
+        ptrs[index] = rt_malloc_align(100, test_aligns[index]);
+        rt_memory_info(&total, &used, &max_used);
+
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        TEST_ASSERT(((rt_ubase_t)ptrs[index] & (test_aligns[index] - 1)) == 0);
+        test_heap_fill(ptrs[index], 100, index);
+#ifdef RT_USING_SMALL_MEM
+        TEST_ASSERT(used - used_before < 256);
+#endif
+    }
+
+    rt_memory_info(&total, &used_before, &max_used);
+    for (index = 0; index < TEST_ALIGN_COUNT; index ++)
+    {
+        TEST_ASSERT(test_heap_check(ptrs[index], 100, index));
+        rt_free_align(ptrs[index]);
+    }
+
+    rt_memory_info(&total, &used, &max_used);
+    TEST_ASSERT(used < used_before);
+
+    return RT_EOK;
+}
+
+#if defined(RT_USING_SMALL_MEM) || defined(RT_USING_MEMHEAP_AS_HEAP)
+/* larger than any hole left by the threads exited, so they are taken one
+ * after another from the rest of the heap */
+#define TEST_REALLOC_SIZE           (128 * 1024)
+
+/*
+ * A block grows into the free block after it in place, into the free block
+ * before it too if that's not enough, and is copied only if both are not;
+ * the data is kept all the ways.
+ */
+rt_err_t test_heap_realloc(void)
+{
+    struct rt_realloc_stat before, after;
+    rt_uint8_t *lead, *prev, *block, *next, *guard;
+    void *ptr;
+
+    /* the idle thread frees the stacks of the threads exited before */
+    rt_thread_delay(2);
+
+    /* 'prev' freed isn't merged with a free block before it */
+    lead  = (rt_uint8_t *)rt_malloc(TEST_REALLOC_SIZE);
+    prev  = (rt_uint8_t *)rt_malloc(TEST_REALLOC_SIZE);
+    block = (rt_uint8_t *)rt_malloc(TEST_REALLOC_SIZE);
+    next  = (rt_uint8_t *)rt_malloc(TEST_REALLOC_SIZE);
+    guard = (rt_uint8_t *)rt_malloc(TEST_REALLOC_SIZE);
+    TEST_ASSERT(lead != RT_NULL && prev != RT_NULL && block != RT_NULL &&
+                next != RT_NULL && guard != RT_NULL);
+    TEST_ASSERT(lead < prev && prev < block && block < next && next < guard);
+    test_heap_fill(block, TEST_REALLOC_SIZE, 1);
+
+    rt_memory_realloc_stat(&before);
+    rt_free(next);
+    ptr = rt_realloc(block, TEST_REALLOC_SIZE * 3 / 2);
+    rt_memory_realloc_stat(&after);
+    TEST_ASSERT(ptr == block);
+    TEST_ASSERT(after.grow_next == before.grow_next + 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_REALLOC_SIZE, 1));
+
+    rt_free(prev);
+    ptr = rt_realloc(ptr, TEST_REALLOC_SIZE * 5 / 2);
+    rt_memory_realloc_stat(&before);
+    TEST_ASSERT(ptr == prev);
+    TEST_ASSERT(before.grow_prev == after.grow_prev + 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_REALLOC_SIZE, 1));
+
+    ptr = rt_realloc(ptr, TEST_REALLOC_SIZE * 4);
+    rt_memory_realloc_stat(&after);
+    TEST_ASSERT(ptr != RT_NULL);
+    TEST_ASSERT(after.copy == before.copy + 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_REALLOC_SIZE, 1));
+
+    rt_free(ptr);
+    rt_free(guard);
+    rt_free(lead);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_heap_realloc(void)
+{
+    return RT_EOK;
+}
+#endif
+#else
+rt_err_t test_heap(void)
+{
+    return RT_EOK;
+}
+
+rt_err_t test_heap_large(void)
+{
+    return RT_EOK;
+}
+
+rt_err_t test_heap_align(void)
+{
+    return RT_EOK;
+}
+
+rt_err_t test_heap_realloc(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_MEMHEAP
+#define TEST_MEMHEAP_SIZE           (16 * 1024)
+
+static struct rt_memheap test_memheap;
+static rt_uint8_t test_memheap_pool[TEST_MEMHEAP_SIZE];
+
+/*
+ * Of the free blocks of a memory heap, an allocation takes the one fitting
+ * best rather than the first one large enough, and the information tells
+ * the free blocks and the largest one; they are one block again once freed.
+ */
+rt_err_t test_memheap_fit(void)
+{
+    struct rt_memheap_info info;
+    void *small, *large, *middle, *sep[3];
+    rt_uint32_t available;
+    int index;
+
+    rt_memheap_init(&test_memheap, "t_mh", test_memheap_pool, sizeof(test_memheap_pool));
+
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.free_blocks == 1);
+    TEST_ASSERT(info.largest_free == info.available);
+    TEST_ASSERT(info.fragmentation == 0);
+    available = info.available;
+
+    /* holes of 96, 304 and 200 bytes in the address order, kept apart by
+     * the blocks between them, and the rest of the heap */
+    small  = rt_memheap_alloc(&test_memheap, 96);
+    sep[0] = rt_memheap_alloc(&test_memheap, 16);
+    large  = rt_memheap_alloc(&test_memheap, 304);
+    sep[1] = rt_memheap_alloc(&test_memheap, 16);
+    middle = rt_memheap_alloc(&test_memheap, 200);
+    sep[2] = rt_memheap_alloc(&test_memheap, 16);
+    TEST_ASSERT(small != RT_NULL && large != RT_NULL && middle != RT_NULL);
+    for (index = 0; index < 3; index ++)
+        TEST_ASSERT(sep[index] != RT_NULL);
+    rt_memheap_free(small);
+    rt_memheap_free(large);
+    rt_memheap_free(middle);
+
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.free_blocks == 4);
+    TEST_ASSERT(info.largest_free < available);
+    TEST_ASSERT(info.fragmentation != 0);
+
+    /* the first fit of 150 would be the hole of 304 */
+    TEST_ASSERT(rt_memheap_alloc(&test_memheap, 150) == middle);
+    TEST_ASSERT(rt_memheap_alloc(&test_memheap, 250) == large);
+    TEST_ASSERT(rt_memheap_alloc(&test_memheap, 64) == small);
+
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.free_blocks == 1);
+
+    rt_memheap_free(small);
+    rt_memheap_free(large);
+    rt_memheap_free(middle);
+    for (index = 0; index < 3; index ++)
+        rt_memheap_free(sep[index]);
+
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.free_blocks == 1);
+    TEST_ASSERT(info.available == available);
+    TEST_ASSERT(info.largest_free == available);
+
+    rt_memheap_detach(&test_memheap);
+
+    return RT_EOK;
+}
+
+#define TEST_MEMHEAP_BLOCK          1024
+
+/*
+ * The same as test_heap_realloc, on a memory heap of its own, where the
+ * blocks are laid out in the order allocated.
+ */
+rt_err_t test_memheap_realloc(void)
+{
+    struct rt_memheap_info info;
+    rt_uint8_t *prev, *block, *next, *guard;
+    void *ptr;
+
+    rt_memheap_init(&test_memheap, "t_mh", test_memheap_pool, sizeof(test_memheap_pool));
+
+    prev  = (rt_uint8_t *)rt_memheap_alloc(&test_memheap, TEST_MEMHEAP_BLOCK);
+    block = (rt_uint8_t *)rt_memheap_alloc(&test_memheap, TEST_MEMHEAP_BLOCK);
+    next  = (rt_uint8_t *)rt_memheap_alloc(&test_memheap, TEST_MEMHEAP_BLOCK);
+    guard = (rt_uint8_t *)rt_memheap_alloc(&test_memheap, TEST_MEMHEAP_BLOCK);
+    TEST_ASSERT(prev != RT_NULL && block != RT_NULL && next != RT_NULL && guard != RT_NULL);
+    test_heap_fill(block, TEST_MEMHEAP_BLOCK, 1);
+
+    rt_memheap_free(next);
+    ptr = rt_memheap_realloc(&test_memheap, block, TEST_MEMHEAP_BLOCK * 3 / 2);
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(ptr == block);
+    TEST_ASSERT(info.realloc_stat.grow_next == 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_MEMHEAP_BLOCK, 1));
+
+    rt_memheap_free(prev);
+    ptr = rt_memheap_realloc(&test_memheap, ptr, TEST_MEMHEAP_BLOCK * 5 / 2);
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(ptr == prev);
+    TEST_ASSERT(info.realloc_stat.grow_prev == 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_MEMHEAP_BLOCK, 1));
+
+    ptr = rt_memheap_realloc(&test_memheap, ptr, TEST_MEMHEAP_BLOCK * 4);
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(ptr != RT_NULL);
+    TEST_ASSERT(info.realloc_stat.copy == 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_MEMHEAP_BLOCK, 1));
+
+    /* shrunk in place */
+    TEST_ASSERT(rt_memheap_realloc(&test_memheap, ptr, TEST_MEMHEAP_BLOCK) == ptr);
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.realloc_stat.shrink == 1);
+    TEST_ASSERT(test_heap_check(ptr, TEST_MEMHEAP_BLOCK, 1));
+
+    rt_memheap_free(ptr);
+    rt_memheap_free(guard);
+
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.free_blocks == 1);
+
+    rt_memheap_detach(&test_memheap);
+
+    return RT_EOK;
+}
+
+/*
+ * The same as test_heap_align, on a memory heap of its own; the part of a
+ * free block before an aligned block is left free, and they are one free
+ * block again once freed.
+ */
+rt_err_t test_memheap_align(void)
+{
+    struct rt_memheap_info info;
+    void *ptrs[TEST_ALIGN_COUNT];
+    rt_uint32_t available;
+    int index;
+
+    rt_memheap_init(&test_memheap, "t_mh", test_memheap_pool, sizeof(test_memheap_pool));
+
+    for (index = 0; index < TEST_ALIGN_COUNT; index ++)
+    {
+        rt_memheap_info_get(&test_memheap, &info);
+        available = info.available;
+
+        ptrs[index] = rt_memheap_alloc_align(&test_memheap, 100, test_aligns[index]);
+        TEST_ASSERT(ptrs[index] != RT_NULL);
+        TEST_ASSERT(((rt_ubase_t)ptrs[index] & (test_aligns[index] - 1)) == 0);
+        test_heap_fill(ptrs[index], 100, index);
+
+        rt_memheap_info_get(&test_memheap, &info);
+        TEST_ASSERT(available - info.available < 256);
+    }
+
+    for (index = 0; index < TEST_ALIGN_COUNT; index ++)
+    {
+        TEST_ASSERT(test_heap_check(ptrs[index], 100, index));
+        rt_memheap_free(ptrs[index]);
+    }
+
+    rt_memheap_info_get(&test_memheap, &info);
+    TEST_ASSERT(info.free_blocks == 1);
+    TEST_ASSERT(info.largest_free == info.available);
+
+    rt_memheap_detach(&test_memheap);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_memheap_fit(void)
+{
+    return RT_EOK;
+}
+
+rt_err_t test_memheap_realloc(void)
+{
+    return RT_EOK;
+}
+
+rt_err_t test_memheap_align(void)
+{
+    return RT_EOK;
+}
+#endif
@@ -0,0 +1,317 @@
+/*
+ * Memory pool regression tests.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "test.h"
+
+#define TEST_MP_BLOCK_SIZE          32
+#define TEST_MP_BLOCK_COUNT         4
+
+static struct rt_mempool test_mp;
+static rt_uint8_t test_mp_pool[TEST_MP_BLOCK_COUNT * (TEST_MP_BLOCK_SIZE + sizeof(rt_uint8_t *))];
+static void *test_mp_result;
+
+static void test_mp_waiter_entry(void *parameter)
+{
+    test_mp_result = rt_mp_alloc(&test_mp, RT_WAITING_FOREVER);
+}
+
+/*
+ * A thread blocked in rt_mp_alloc() is woken up with -RT_EINTR the way a
+ * signal does it. The allocation fails, the waiter is counted off, and the
+ * pool goes on as before, with its blocks cached by a free again.
+ */
+rt_err_t test_mempool_intr(void)
+{
+    void *blocks[TEST_MP_BLOCK_COUNT];
+    register rt_base_t level;
+    rt_thread_t waiter;
+    int index;
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    struct rt_mp_magazine_info info;
+#endif
+
+    rt_mp_init(&test_mp, "t_mp", test_mp_pool, sizeof(test_mp_pool), TEST_MP_BLOCK_SIZE);
+
+    /* take every block, the waiter has to block */
+    for (index = 0; index < TEST_MP_BLOCK_COUNT; index ++)
+    {
+        blocks[index] = rt_mp_alloc(&test_mp, 0);
+        TEST_ASSERT(blocks[index] != RT_NULL);
+    }
+
+    test_mp_result = (void *)&test_mp;
+    waiter = rt_thread_create("t_mpw", test_mp_waiter_entry, RT_NULL,
+                              TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(waiter != RT_NULL);
+    rt_thread_startup(waiter);
+    rt_thread_delay(2);
+
+    TEST_ASSERT(test_mp.suspend_thread_count == 1);
+
+    /* the same as _signal_deliver() for a suspended thread */
+    level = rt_hw_interrupt_disable();
+    waiter->error = -RT_EINTR;
+    rt_thread_resume(waiter);
+    rt_hw_interrupt_enable(level);
+    rt_schedule();
+    rt_thread_delay(2);
+
+    TEST_ASSERT(test_mp_result == RT_NULL);
+    TEST_ASSERT(test_mp.suspend_thread_count == 0);
+
+    for (index = 0; index < TEST_MP_BLOCK_COUNT; index ++)
+        rt_mp_free(blocks[index]);
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    /* no waiter, so the free caches the blocks */
+    rt_mp_magazine_get(&test_mp, &info);
+    TEST_ASSERT(info.cached != 0);
+#endif
+
+    TEST_ASSERT(rt_mp_alloc(&test_mp, 0) != RT_NULL);
+
+    rt_mp_detach(&test_mp);
+
+    return RT_EOK;
+}
+
+#define TEST_MP_THREAD_COUNT        4
+#define TEST_MP_TICKS               50
+#define TEST_MP_POOL_COUNT          (TEST_MP_THREAD_COUNT + 2)
+
+static struct rt_mempool test_mp_contend;
+static rt_uint8_t test_mp_contend_pool[TEST_MP_POOL_COUNT * (TEST_MP_BLOCK_SIZE + sizeof(rt_uint8_t *))];
+static struct rt_semaphore test_mp_done;
+static volatile int test_mp_error;
+static volatile int test_mp_timer_hit;
+
+static void test_mp_contend_entry(void *parameter)
+{
+    rt_ubase_t *block;
+    rt_tick_t start;
+    int loop;
+
+    /* long enough for the ticks to come in between */
+    start = rt_tick_get();
+    for (loop = 0; rt_tick_get() - start < TEST_MP_TICKS; loop ++)
+    {
+        block = (rt_ubase_t *)rt_mp_alloc(&test_mp_contend, RT_WAITING_FOREVER);
+        if (block == RT_NULL)
+        {
+            test_mp_error ++;
+            break;
+        }
+
+        /* nobody else has the block while it's taken */
+        *block = (rt_ubase_t)parameter;
+        if (loop % 16 == 0)
+            rt_thread_yield();
+        if (*block != (rt_ubase_t)parameter)
+            test_mp_error ++;
+
+        rt_mp_free(block);
+    }
+
+    rt_sem_release(&test_mp_done);
+}
+
+/* in the tick interrupt, without waiting */
+static void test_mp_contend_timeout(void *parameter)
+{
+    rt_ubase_t *block;
+
+    block = (rt_ubase_t *)rt_mp_alloc(&test_mp_contend, 0);
+    if (block == RT_NULL)
+        return;
+
+    *block = (rt_ubase_t)parameter;
+    test_mp_timer_hit ++;
+    rt_mp_free(block);
+}
+
+/*
+ * Threads of the same priority, on all cpus with RT_USING_SMP, and the tick
+ * interrupt allocate and free the blocks of a pool at the same time. A block
+ * is never given to two of them, and none is lost once they are done.
+ */
+rt_err_t test_mempool_contend(void)
+{
+    void *blocks[TEST_MP_POOL_COUNT];
+    struct rt_timer timer;
+    rt_thread_t tid;
+    int index, other;
+
+    rt_mp_init(&test_mp_contend, "t_mpc", test_mp_contend_pool,
+               sizeof(test_mp_contend_pool), TEST_MP_BLOCK_SIZE);
+    rt_sem_init(&test_mp_done, "t_mpc", 0, RT_IPC_FLAG_FIFO);
+    rt_timer_init(&timer, "t_mpc", test_mp_contend_timeout, (void *)TEST_MP_THREAD_COUNT, 1,
+                  RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+    test_mp_error = 0;
+    test_mp_timer_hit = 0;
+
+    rt_timer_start(&timer);
+    for (index = 0; index < TEST_MP_THREAD_COUNT; index ++)
+    {
+        tid = rt_thread_create("t_mpc", test_mp_contend_entry, (void *)(rt_ubase_t)index,
+                               TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, 1);
+        TEST_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+    }
+    for (index = 0; index < TEST_MP_THREAD_COUNT; index ++)
+        TEST_ASSERT(rt_sem_take(&test_mp_done, 10 * RT_TICK_PER_SECOND) == RT_EOK);
+    rt_timer_stop(&timer);
+    rt_timer_detach(&timer);
+
+    TEST_ASSERT(test_mp_error == 0);
+    TEST_ASSERT(test_mp_timer_hit != 0);
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    rt_mp_magazine_flush(&test_mp_contend);
+#endif
+    TEST_ASSERT(test_mp_contend.block_free_count == TEST_MP_POOL_COUNT);
+    TEST_ASSERT(test_mp_contend.suspend_thread_count == 0);
+
+    /* every block is there once */
+    for (index = 0; index < TEST_MP_POOL_COUNT; index ++)
+    {
+        blocks[index] = rt_mp_alloc(&test_mp_contend, 0);
+        TEST_ASSERT(blocks[index] != RT_NULL);
+        for (other = 0; other < index; other ++)
+            TEST_ASSERT(blocks[other] != blocks[index]);
+    }
+    TEST_ASSERT(rt_mp_alloc(&test_mp_contend, 0) == RT_NULL);
+
+    rt_mp_detach(&test_mp_contend);
+    rt_sem_detach(&test_mp_done);
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+#define TEST_MP_MAGAZINE_COUNT      (RT_MP_MAGAZINE_SIZE * 4)
+#define TEST_MP_MAGAZINE_BATCH      (RT_MP_MAGAZINE_SIZE / 2)
+
+static struct rt_mempool test_mpm;
+static rt_uint8_t test_mp_magazine_pool[TEST_MP_MAGAZINE_COUNT * (TEST_MP_BLOCK_SIZE + sizeof(rt_uint8_t *))];
+static void *test_mp_magazine_blocks[TEST_MP_MAGAZINE_COUNT];
+static rt_err_t test_mp_magazine_result;
+
+/* on cpu 1: the magazine is refilled by half, taken and filled up by the
+ * frees, and gives the older half back once it's full */
+static rt_err_t test_mp_magazine_cache(void)
+{
+    struct rt_mp_magazine_info info, before;
+    void *block;
+    int index;
+
+    block = rt_mp_alloc(&test_mpm, 0);
+    TEST_ASSERT(block != RT_NULL);
+    rt_mp_magazine_get(&test_mpm, &info);
+    TEST_ASSERT(info.alloc_miss == 1 && info.alloc_hit == 0);
+    TEST_ASSERT(info.cached == TEST_MP_MAGAZINE_BATCH);
+    TEST_ASSERT(test_mpm.block_free_count == TEST_MP_MAGAZINE_COUNT - TEST_MP_MAGAZINE_BATCH - 1);
+
+    /* the last freed is the first taken */
+    rt_mp_free(block);
+    TEST_ASSERT(rt_mp_alloc(&test_mpm, 0) == block);
+    rt_mp_free(block);
+
+    for (index = 0; index < RT_MP_MAGAZINE_SIZE + 1; index ++)
+    {
+        test_mp_magazine_blocks[index] = rt_mp_alloc(&test_mpm, 0);
+        TEST_ASSERT(test_mp_magazine_blocks[index] != RT_NULL);
+    }
+
+    /* from empty, the frees fill it up and the one more gives half back */
+    rt_mp_magazine_flush(&test_mpm);
+    rt_mp_magazine_get(&test_mpm, &before);
+    TEST_ASSERT(before.cached == 0);
+    for (index = 0; index < RT_MP_MAGAZINE_SIZE + 1; index ++)
+        rt_mp_free(test_mp_magazine_blocks[index]);
+
+    rt_mp_magazine_get(&test_mpm, &info);
+    TEST_ASSERT(info.free_hit - before.free_hit == RT_MP_MAGAZINE_SIZE);
+    TEST_ASSERT(info.free_miss - before.free_miss == 1);
+    TEST_ASSERT(info.cached == RT_MP_MAGAZINE_SIZE - TEST_MP_MAGAZINE_BATCH + 1);
+    TEST_ASSERT(test_mpm.block_free_count + info.cached == TEST_MP_MAGAZINE_COUNT);
+
+    return RT_EOK;
+}
+
+/* on cpu 2: all blocks are taken, the ones cached by cpu 1 too */
+static rt_err_t test_mp_magazine_reclaim(void)
+{
+    struct rt_mp_magazine_info info;
+    int index;
+
+    for (index = 0; index < TEST_MP_MAGAZINE_COUNT; index ++)
+    {
+        test_mp_magazine_blocks[index] = rt_mp_alloc(&test_mpm, 0);
+        TEST_ASSERT(test_mp_magazine_blocks[index] != RT_NULL);
+    }
+    TEST_ASSERT(rt_mp_alloc(&test_mpm, 0) == RT_NULL);
+
+    for (index = 0; index < TEST_MP_MAGAZINE_COUNT; index ++)
+        rt_mp_free(test_mp_magazine_blocks[index]);
+
+    rt_mp_magazine_flush(&test_mpm);
+    rt_mp_magazine_get(&test_mpm, &info);
+    TEST_ASSERT(info.cached == 0);
+    TEST_ASSERT(test_mpm.block_free_count == TEST_MP_MAGAZINE_COUNT);
+
+    return RT_EOK;
+}
+
+static void test_mp_magazine_entry(void *parameter)
+{
+    rt_err_t (*step)(void) = (rt_err_t (*)(void))parameter;
+
+    test_mp_magazine_result = step();
+    rt_sem_release(&test_mp_done);
+}
+
+/* run a step in a thread bound to the cpu */
+static rt_err_t test_mp_magazine_run(rt_err_t (*step)(void), int cpu)
+{
+    rt_thread_t tid;
+
+    test_mp_magazine_result = -RT_ERROR;
+    tid = rt_thread_create("t_mpm", test_mp_magazine_entry, (void *)step,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_control(tid, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)cpu);
+    rt_thread_startup(tid);
+    TEST_ASSERT(rt_sem_take(&test_mp_done, RT_TICK_PER_SECOND) == RT_EOK);
+
+    return test_mp_magazine_result;
+}
+
+/*
+ * The magazine of a cpu caches the blocks it frees and takes, with the hit
+ * counters telling so; the blocks cached by a cpu are taken by another one
+ * once the free blocks run out, and flushed back.
+ */
+rt_err_t test_mp_magazine(void)
+{
+    rt_mp_init(&test_mpm, "t_mpm", test_mp_magazine_pool,
+               sizeof(test_mp_magazine_pool), TEST_MP_BLOCK_SIZE);
+    rt_sem_init(&test_mp_done, "t_mpm", 0, RT_IPC_FLAG_FIFO);
+
+    TEST_ASSERT(test_mp_magazine_run(test_mp_magazine_cache, 1) == RT_EOK);
+    TEST_ASSERT(test_mp_magazine_run(test_mp_magazine_reclaim, 2) == RT_EOK);
+
+    rt_mp_detach(&test_mpm);
+    rt_sem_detach(&test_mp_done);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_mp_magazine(void)
+{
+    return RT_EOK;
+}
+#endif
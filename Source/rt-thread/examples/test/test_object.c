@@ -0,0 +1,63 @@
+/*
+ * Object regression tests.
+ */
+
+#include <rtthread.h>
+
+#include "test.h"
+
+#ifdef RT_USING_SEMAPHORE
+
+#define TEST_OBJECT_COUNT           1000
+
+/*
+ * Enough semaphores to grow the object hash table a few times, each of them
+ * is found by its name while and after the table grows, and none is found
+ * once they are detached.
+ */
+rt_err_t test_object_find(void)
+{
+    struct rt_semaphore *sems;
+    char name[RT_NAME_MAX + 1];
+    int index, found;
+
+    sems = (struct rt_semaphore *)rt_malloc(sizeof(struct rt_semaphore) * TEST_OBJECT_COUNT);
+    TEST_ASSERT(sems != RT_NULL);
+
+    for (index = 0; index < TEST_OBJECT_COUNT; index ++)
+    {
+        rt_snprintf(name, sizeof(name), "to%d", index);
+        rt_sem_init(&sems[index], name, 0, RT_IPC_FLAG_FIFO);
+
+        rt_snprintf(name, sizeof(name), "to%d", index / 2);
+        if (rt_object_find(name, RT_Object_Class_Semaphore) != &sems[index / 2].parent.parent)
+            break;
+    }
+
+    for (found = 0; found < TEST_OBJECT_COUNT; found ++)
+    {
+        rt_snprintf(name, sizeof(name), "to%d", found);
+        if (rt_object_find(name, RT_Object_Class_Semaphore) != &sems[found].parent.parent)
+            break;
+    }
+
+    for (index = 0; index < TEST_OBJECT_COUNT; index ++)
+        rt_sem_detach(&sems[index]);
+
+    TEST_ASSERT(found == TEST_OBJECT_COUNT);
+    TEST_ASSERT(rt_object_find("to0", RT_Object_Class_Semaphore) == RT_NULL);
+    TEST_ASSERT(rt_object_find("to999", RT_Object_Class_Semaphore) == RT_NULL);
+
+    rt_free(sems);
+
+    return RT_EOK;
+}
+
+#else
+
+rt_err_t test_object_find(void)
+{
+    return RT_EOK;
+}
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Thread and scheduler regression tests.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "test.h"
+
+#ifdef RT_USING_SMP
+static struct rt_semaphore test_smp_done;
+static volatile int test_smp_cpu[RT_CPUS_NR];
+static volatile rt_uint32_t test_smp_running;
+
+static void test_smp_bound_entry(void *parameter)
+{
+    test_smp_cpu[(rt_ubase_t)parameter] = rt_hw_cpu_id();
+    rt_sem_release(&test_smp_done);
+}
+
+static void test_smp_spin_entry(void *parameter)
+{
+    rt_tick_t start;
+
+    /* wait for all of them running, a second at most */
+    rt_hw_atomic_add(&test_smp_running, 1);
+    start = rt_tick_get();
+    while (test_smp_running < RT_CPUS_NR - 1 && rt_tick_get() - start < RT_TICK_PER_SECOND);
+
+    /* and keep the cpu a while, so none of them moves to a free one */
+    test_smp_cpu[(rt_ubase_t)parameter] = rt_hw_cpu_id();
+    start = rt_tick_get();
+    while (rt_tick_get() - start < RT_TICK_PER_SECOND / 10);
+
+    rt_sem_release(&test_smp_done);
+}
+
+/*
+ * A thread bound to a cpu runs there; the threads not bound run on the
+ * other cpus at the same time, one cpu is left to the test itself.
+ */
+rt_err_t test_smp_sched(void)
+{
+    rt_thread_t tid;
+    int index, other;
+
+    rt_sem_init(&test_smp_done, "t_smp", 0, RT_IPC_FLAG_FIFO);
+
+    for (index = 0; index < RT_CPUS_NR; index ++)
+    {
+        test_smp_cpu[index] = -1;
+        tid = rt_thread_create("t_smpb", test_smp_bound_entry, (void *)(rt_ubase_t)index,
+                               TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+        TEST_ASSERT(tid != RT_NULL);
+        rt_thread_control(tid, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)index);
+        rt_thread_startup(tid);
+    }
+    for (index = 0; index < RT_CPUS_NR; index ++)
+        TEST_ASSERT(rt_sem_take(&test_smp_done, RT_TICK_PER_SECOND) == RT_EOK);
+    for (index = 0; index < RT_CPUS_NR; index ++)
+        TEST_ASSERT(test_smp_cpu[index] == index);
+
+    test_smp_running = 0;
+    for (index = 0; index < RT_CPUS_NR - 1; index ++)
+    {
+        test_smp_cpu[index] = -1;
+        tid = rt_thread_create("t_smps", test_smp_spin_entry, (void *)(rt_ubase_t)index,
+                               TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+        TEST_ASSERT(tid != RT_NULL);
+        rt_thread_startup(tid);
+    }
+    for (index = 0; index < RT_CPUS_NR - 1; index ++)
+        TEST_ASSERT(rt_sem_take(&test_smp_done, 10 * RT_TICK_PER_SECOND) == RT_EOK);
+
+    TEST_ASSERT(test_smp_running == RT_CPUS_NR - 1);
+    for (index = 0; index < RT_CPUS_NR - 1; index ++)
+    {
+        TEST_ASSERT(test_smp_cpu[index] >= 0);
+        for (other = 0; other < index; other ++)
+            TEST_ASSERT(test_smp_cpu[other] != test_smp_cpu[index]);
+    }
+
+    rt_sem_detach(&test_smp_done);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_smp_sched(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+static struct rt_semaphore test_usage_sem;
+
+static void test_usage_entry(void *parameter)
+{
+    rt_tick_t start;
+
+    /* run a while, then wait without running */
+    start = rt_tick_get();
+    while (rt_tick_get() - start < 20);
+
+    rt_sem_take(&test_usage_sem, RT_WAITING_FOREVER);
+}
+
+/*
+ * A thread is charged the cycles it ran and counted the times switched in;
+ * while it's suspended, the cycles others run aren't charged to it.
+ */
+rt_err_t test_thread_usage(void)
+{
+    struct rt_thread_info info, again;
+    rt_thread_t tid;
+    rt_tick_t start;
+
+    rt_sem_init(&test_usage_sem, "t_use", 0, RT_IPC_FLAG_FIFO);
+
+    tid = rt_thread_create("t_use", test_usage_entry, RT_NULL,
+                           TEST_THREAD_STACK_SIZE, TEST_PRIORITY_HIGH, TEST_THREAD_TICK);
+    TEST_ASSERT(tid != RT_NULL);
+    rt_thread_startup(tid);
+
+    /* it has suspended on the semaphore once it's done */
+    start = rt_tick_get();
+    while ((tid->stat & RT_THREAD_STAT_MASK) != RT_THREAD_SUSPEND)
+    {
+        TEST_ASSERT(rt_tick_get() - start < RT_TICK_PER_SECOND);
+        rt_thread_delay(1);
+    }
+
+    rt_thread_usage_get(tid, &info);
+    TEST_ASSERT(info.cycle != 0);
+    TEST_ASSERT(info.switches >= 1);
+
+    start = rt_tick_get();
+    while (rt_tick_get() - start < 10);
+
+    rt_thread_usage_get(tid, &again);
+    TEST_ASSERT(again.cycle == info.cycle);
+    TEST_ASSERT(again.switches == info.switches);
+
+    rt_thread_usage_get(rt_thread_self(), &info);
+    TEST_ASSERT(info.cycle != 0);
+    TEST_ASSERT(rt_cpu_load_get() <= 1000);
+
+    rt_sem_release(&test_usage_sem);
+    rt_thread_delay(1);
+    rt_sem_detach(&test_usage_sem);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_thread_usage(void)
+{
+    return RT_EOK;
+}
+#endif
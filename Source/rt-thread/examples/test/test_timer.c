@@ -0,0 +1,114 @@
+/*
+ * Timer regression tests.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include "test.h"
+
+static volatile int test_timer_count;
+
+static void test_timer_timeout(void *parameter)
+{
+    test_timer_count ++;
+}
+
+#ifndef RT_USING_SMP
+#define TEST_TIMER_COUNT            6
+
+/* on the levels 0 to 2 of the timer wheel, and right after the wrap */
+static const rt_tick_t test_timer_ticks[TEST_TIMER_COUNT] = {3, 64, 65, 200, 4095, 4100};
+static struct rt_timer test_timers[TEST_TIMER_COUNT];
+static rt_tick_t test_timer_fired[TEST_TIMER_COUNT];
+
+static void test_timer_record(void *parameter)
+{
+    test_timer_fired[(rt_ubase_t)parameter] = rt_tick_get();
+}
+
+/*
+ * One shot timers started in any order expire at their timeout tick, the
+ * ticks are given here one by one. Only cpu 0 moves the global tick on SMP,
+ * where it's skipped.
+ */
+rt_err_t test_timer_expire(void)
+{
+    rt_base_t level;
+    rt_tick_t start, next;
+    int index;
+
+    /* no tick comes in between, and the time slice doesn't switch */
+    rt_enter_critical();
+    level = rt_hw_interrupt_disable();
+    start = rt_tick_get();
+    for (index = TEST_TIMER_COUNT - 1; index >= 0; index --)
+    {
+        test_timer_fired[index] = 0;
+        rt_timer_init(&test_timers[index], "t_tm", test_timer_record, (void *)(rt_ubase_t)index,
+                      test_timer_ticks[index], RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_HARD_TIMER);
+        rt_timer_start(&test_timers[index]);
+    }
+    next = rt_timer_next_timeout_tick();
+    while (rt_tick_get() - start < test_timer_ticks[TEST_TIMER_COUNT - 1])
+        rt_tick_increase();
+    rt_hw_interrupt_enable(level);
+    rt_exit_critical();
+
+    for (index = 0; index < TEST_TIMER_COUNT; index ++)
+        rt_timer_detach(&test_timers[index]);
+
+    TEST_ASSERT(next == start + test_timer_ticks[0]);
+    for (index = 0; index < TEST_TIMER_COUNT; index ++)
+        TEST_ASSERT(test_timer_fired[index] == start + test_timer_ticks[index]);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_timer_expire(void)
+{
+    return RT_EOK;
+}
+#endif
+
+#ifdef RT_USING_TICKLESS
+/*
+ * A periodic timer due twice while the tick was suspended is called once,
+ * and its next timeout is still on its period.
+ */
+rt_err_t test_timer_tickless(void)
+{
+    struct rt_timer timer;
+    rt_base_t level;
+    rt_tick_t start, timeout;
+    int count;
+
+    rt_timer_init(&timer, "t_tm", test_timer_timeout, RT_NULL, 5,
+                  RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_HARD_TIMER);
+    test_timer_count = 0;
+
+    /* no tick comes in between, and the time slice doesn't switch */
+    rt_enter_critical();
+    level = rt_hw_interrupt_disable();
+    start = rt_tick_get();
+    rt_timer_start(&timer);
+    rt_tick_increase_n(12);
+    count   = test_timer_count;
+    timeout = timer.timeout_tick;
+    rt_timer_stop(&timer);
+    rt_hw_interrupt_enable(level);
+    rt_exit_critical();
+
+    rt_timer_detach(&timer);
+
+    TEST_ASSERT(count == 1);
+    TEST_ASSERT(timeout == start + 15);
+
+    return RT_EOK;
+}
+#else
+rt_err_t test_timer_tickless(void)
+{
+    return RT_EOK;
+}
+#endif
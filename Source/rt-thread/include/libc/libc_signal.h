@@ -0,0 +1,69 @@
+#ifndef LIBC_SIGNAL_H__
+#define LIBC_SIGNAL_H__
+
+#if defined(RT_USING_NEWLIB) || defined(__GNUC__)
+/* the toolchain provides them */
+#include <signal.h>
+#else
+
+union sigval
+{
+    int    sival_int;    /* Integer signal value */
+    void  *sival_ptr;    /* Pointer signal value */
+};
+
+struct sigevent
+{
+    int          sigev_notify;  /* Notification type */
+    int          sigev_signo;   /* Signal number */
+    union sigval sigev_value;   /* Signal value */
+};
+
+struct siginfo
+{
+    rt_uint16_t si_signo;
+    rt_uint16_t si_code;
+
+    union sigval si_value;
+};
+typedef struct siginfo siginfo_t;
+
+#define SI_USER     0x01    /* Signal sent by kill(). */
+#define SI_QUEUE    0x02    /* Signal sent by sigqueue(). */
+#define SI_TIMER    0x03    /* Signal generated by expiration of a timer set by timer_settime(). */
+#define SI_ASYNCIO  0x04    /* Signal generated by completion of an asynchronous I/O request. */
+#define SI_MESGQ    0x05    /* Signal generated by arrival of a message on an empty message queue. */
+
+#define SIGHUP       1
+#define SIGINT       2
+#define SIGQUIT      3
+#define SIGILL       4
+#define SIGTRAP      5
+#define SIGABRT      6
+#define SIGEMT       7
+#define SIGFPE       8
+#define SIGKILL      9
+#define SIGBUS      10
+#define SIGSEGV     11
+#define SIGSYS      12
+#define SIGPIPE     13
+#define SIGALRM     14
+#define SIGTERM     15
+#define SIGURG      16
+#define SIGSTOP     17
+#define SIGTSTP     18
+#define SIGCONT     19
+#define SIGCHLD     20
+#define SIGTTIN     21
+#define SIGTTOU     22
+#define SIGPOLL     23
+#define SIGWINCH    24
+#define SIGUSR1     25
+#define SIGUSR2     26
+#define SIGRTMIN    27
+#define SIGRTMAX    31
+#define NSIG        32
+
+#endif
+
+#endif
@@ -30,6 +30,8 @@ typedef signed   long                   rt_int32_t;
 typedef unsigned char                   rt_uint8_t;
 typedef unsigned short                  rt_uint16_t;
 typedef unsigned long                   rt_uint32_t;
+typedef signed long long                rt_int64_t;
+typedef unsigned long long              rt_uint64_t;
 typedef int                             rt_bool_t;
 
 /* 32bit CPU */
@@ -283,7 +285,7 @@ typedef struct rt_list_node rt_list_t;
  */
 struct rt_slist_node
 {
-    struct rt_slisst_node *next;
+    struct rt_slist_node *next;
 };
 typedef struct rt_slist_node rt_slist_t;
 
@@ -311,6 +313,10 @@ struct rt_object
     void      *module_id;                               /**< id of application module */
 #endif
     rt_list_t  list;                                    /**< list node of kernel object */
+
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object *hash_next;                        /**< next object of the name hash bucket */
+#endif
 };
 typedef struct rt_object *rt_object_t;                  /**< Type for kernel objects. */
 
@@ -328,8 +334,12 @@ typedef struct rt_object *rt_object_t;                  /**< Type for kernel obj
  *  - Device
  *  - Timer
  *  - Module
+ *  - RWLock
  *  - Unknown
  *  - Static
+ *
+ *  A new class is added just before Unknown, so the classes before keep
+ *  their values for the modules built with them.
  */
 enum rt_object_class_type
 {
@@ -344,6 +354,7 @@ enum rt_object_class_type
     RT_Object_Class_Device,
     RT_Object_Class_Timer,
     RT_Object_Class_Module,
+    RT_Object_Class_RWLock,
     RT_Object_Class_Unknown,
     RT_Object_Class_Static = 0x80
 };
@@ -452,7 +463,10 @@ typedef siginfo_t rt_siginfo_t;
 #define RT_THREAD_RUNNING               0x03
 #define RT_THREAD_BLOCK                 RT_THREAD_SUSPEND
 #define RT_THREAD_CLOSE                 0x04
-#define RT_THREAD_STAT_MASK             0x0f
+#define RT_THREAD_STAT_MASK             0x07
+
+#define RT_THREAD_STAT_YIELD            0x08            /**< yield the cpu to the same priority */
+#define RT_THREAD_STAT_YIELD_MASK       RT_THREAD_STAT_YIELD
 
 #define RT_THREAD_STAT_SIGNAL           0x10
 #define RT_THREAD_STAT_SIGNAL_READY     (RT_THREAD_STAT_SIGNAL | RT_THREAD_READY)
@@ -466,6 +480,32 @@ typedef siginfo_t rt_siginfo_t;
 #define RT_THREAD_CTRL_CLOSE            0x01
 #define RT_THREAD_CTRL_CHANGE_PRIORITY  0x02
 #define RT_THREAD_CTRL_INFO             0x03
+#define RT_THREAD_CTRL_BIND_CPU         0x04
+
+#ifndef RT_CPUS_NR
+#define RT_CPUS_NR                      1
+#endif
+
+#ifdef RT_USING_SMP
+#define RT_CPU_DETACHED                 RT_CPUS_NR      /**< the thread is not on any cpu */
+#define RT_CPU_MASK                     ((1 << RT_CPUS_NR) - 1)
+
+#ifndef RT_SCHEDULE_IPI
+#define RT_SCHEDULE_IPI                 0
+#endif
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+/**
+ * Run-time information of thread, got by RT_THREAD_CTRL_INFO
+ */
+struct rt_thread_info
+{
+    rt_uint64_t cycle;                                  /**< the cycles it ran, see rt_hw_cycle_freq */
+    rt_uint32_t switches;                               /**< the times switched in */
+    rt_uint16_t usage;                                  /**< per mille of a cpu in the last period */
+};
+#endif
 
 /**
  * Thread structure
@@ -482,6 +522,9 @@ struct rt_thread
 #endif
 
     rt_list_t   list;                                   /**< the object list */
+#ifdef RT_USING_OBJECT_HASH
+    struct rt_object *hash_next;                        /**< the name hash bucket */
+#endif
     rt_list_t   tlist;                                  /**< the thread list */
 
     /* stack point and entry */
@@ -496,6 +539,17 @@ struct rt_thread
 
     rt_uint8_t  stat;                                   /**< thread status */
 
+#ifdef RT_USING_SMP
+    rt_uint8_t  bind_cpu;                               /**< the cpu bound to, RT_CPUS_NR for any cpu */
+    rt_uint8_t  oncpu;                                  /**< the cpu running it, or RT_CPU_DETACHED */
+    rt_uint8_t  ready_cpu;                              /**< the cpu of ready queue, or RT_CPU_DETACHED */
+    rt_uint8_t  last_cpu;                               /**< the cpu it ran on last time */
+
+    rt_uint16_t scheduler_lock_nest;                    /**< scheduler lock count */
+    rt_uint16_t cpus_lock_nest;                         /**< cpus lock count */
+    rt_uint16_t critical_lock_nest;                     /**< critical lock count */
+#endif
+
     /* priority */
     rt_uint8_t  current_priority;
     rt_uint8_t  init_priority;
@@ -511,6 +565,28 @@ struct rt_thread
     rt_uint8_t  event_info;
 #endif
 
+#if defined(RT_USING_MUTEX)
+    /* priority inheritance */
+    void       *pending_object;                         /**< the mutex it's blocked on */
+    rt_list_t   taken_object_list;                      /**< the held mutexes raising its priority */
+#endif
+
+#ifdef RT_USING_IPC_PROFILE
+    /* contention profile */
+    struct rt_object *profile_object;                   /**< the IPC object it's trying to take */
+    rt_tick_t   profile_tick;                           /**< the tick it tried */
+    rt_bool_t   profile_switched;                       /**< switched out since it tried */
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+    /* run-time accounting */
+    rt_uint64_t cycle;                                  /**< the cycles it ran */
+    rt_uint64_t cycle_stamp;                            /**< the cycle counter when switched in */
+    rt_uint64_t cycle_period;                           /**< the cycles at the start of the period */
+    rt_uint32_t switches;                               /**< the times switched in */
+    rt_uint16_t usage;                                  /**< per mille of a cpu in the last period */
+#endif
+
 #if defined(RT_USING_SIGNALS)
     rt_sigset_t     sig_pending;                        /**< the pending signals */
     rt_sigset_t     sig_mask;                           /**< the mask bits of signal */
@@ -536,6 +612,30 @@ struct rt_thread
 };
 typedef struct rt_thread *rt_thread_t;
 
+#ifdef RT_USING_SMP
+/**
+ * CPU structure, the scheduler state of one cpu
+ */
+struct rt_cpu
+{
+    struct rt_thread *current_thread;                   /**< the running thread */
+
+    rt_uint16_t irq_nest;                               /**< interrupt nest */
+    rt_uint8_t  irq_switch_flag;                        /**< schedule at interrupt exit */
+
+    rt_uint8_t  current_priority;                       /**< priority of the running thread */
+    rt_list_t   priority_table[RT_THREAD_PRIORITY_MAX]; /**< ready queue */
+    rt_uint32_t priority_group;                         /**< ready priority group */
+#if RT_THREAD_PRIORITY_MAX > 32
+    rt_uint8_t  ready_table[32];
+#endif
+
+    /* the ready threads not bound to this cpu, which may be stolen */
+    rt_uint32_t steal_group;                            /**< ready priority group of them */
+    rt_uint16_t steal_count[32];                        /**< number of them in each group */
+};
+#endif
+
 /*@}*/
 
 /**
@@ -547,12 +647,104 @@ typedef struct rt_thread *rt_thread_t;
 /**
  * IPC flags and control command definitions
  */
+#define RT_IPC_FLAG_FIFO                0x00            /**< FIFOed IPC. @ref IPC. */
+#define RT_IPC_FLAG_PRIO                0x01            /**< PRIOed IPC. @ref IPC. */
+#define RT_IPC_FLAG_SPSC                0x02            /**< single producer and single consumer mailbox. @ref IPC. */
+
+#define RT_IPC_CMD_UNKNOWN              0x00            /**< unknown IPC command */
+#define RT_IPC_CMD_RESET                0x01            /**< reset IPC object */
+
+#define RT_WAITING_FOREVER              -1              /**< Block forever until get resource. */
+#define RT_WAITING_NO                   0               /**< Non-block. */
+
+/*
+ * With RT_USING_IPC_PRIO_QUEUE, every suspended thread queue takes
+ * RT_IPC_QUEUE_LISTS list heads and a word, i.e. 8 * 8 + 4 bytes on 32 bits
+ * by default, and a mailbox has two queues. A thread is inserted from the
+ * tail of its band over the waiters of lower priority in the band, so it's
+ * O(1) with one list for each priority, and fewer lists take less memory.
+ */
+#ifdef RT_USING_IPC_PRIO_QUEUE
+#ifndef RT_IPC_QUEUE_LISTS
+#define RT_IPC_QUEUE_LISTS              8
+#endif
+#if RT_IPC_QUEUE_LISTS > 32 || RT_THREAD_PRIORITY_MAX % RT_IPC_QUEUE_LISTS != 0
+#error "RT_IPC_QUEUE_LISTS shall divide RT_THREAD_PRIORITY_MAX and be 32 at most"
+#endif
+#else
+#define RT_IPC_QUEUE_LISTS              1
+#endif
+
+/**
+ * Suspended thread queue of IPC object. With RT_USING_IPC_PRIO_QUEUE, the
+ * priorities are split into RT_IPC_QUEUE_LISTS bands, the threads of
+ * RT_IPC_FLAG_PRIO are pended on the list of their band in priority order,
+ * and a bitmap of these lists, as the one of ready queue, gives the first
+ * thread in O(1); otherwise all threads are on list[0].
+ */
+struct rt_ipc_queue
+{
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    rt_uint32_t      priority_group;                    /**< bitmap of the pended bands */
+#endif
+
+    rt_list_t        list[RT_IPC_QUEUE_LISTS];          /**< threads pended on each band */
+};
+
+#ifdef RT_USING_IPC_PROFILE
+#ifndef RT_USING_HOOK
+#error "RT_USING_IPC_PROFILE needs RT_USING_HOOK"
+#endif
+
+/**
+ * Contention profile of IPC object, recorded from the object hooks once
+ * rt_ipc_profile_start is called. The times are in OS ticks.
+ */
+struct rt_ipc_profile
+{
+    rt_uint32_t acquire;                                /**< times taken */
+    rt_uint32_t contended;                              /**< times the taker was switched out for it */
+    rt_uint32_t wait_total;                             /**< ticks from trying to taking, in all */
+    rt_uint32_t wait_max;                               /**< ticks from trying to taking, at most */
+    rt_uint32_t hold_max;                               /**< ticks a mutex was held, at most */
+    rt_tick_t   hold_tick;                              /**< the tick a mutex was taken */
+};
+#endif
+
+/**
+ * Base structure of IPC object
+ */
 struct rt_ipc_object
 {
     struct rt_object parent;                            /**< inherit from rt_object */
 
-    rt_list_t        suspend_thread;                    /**< threads pended on this resource */
+    struct rt_ipc_queue suspend_thread;                 /**< threads pended on this resource */
+#ifdef RT_USING_IPC_POLL
+    rt_list_t           poll_list;                      /**< polls of the threads waiting for it */
+#endif
+#ifdef RT_USING_IPC_PROFILE
+    struct rt_ipc_profile profile;                      /**< contention profile */
+#endif
+};
+
+#ifdef RT_USING_IPC_POLL
+/**
+ * An IPC object waited for by rt_ipc_poll, which is a semaphore, mailbox,
+ * message queue or event
+ */
+struct rt_ipc_poll
+{
+    struct rt_ipc_object *object;                       /**< the object waited for */
+    rt_uint32_t           set;                          /**< the bits waited for, of event */
+    rt_uint8_t            option;                       /**< RT_EVENT_FLAG_AND or RT_EVENT_FLAG_OR, of event */
+
+    rt_err_t              result;                       /**< RT_EOK if ready, -RT_ETIMEOUT if not, -RT_ERROR if detached */
+
+    struct rt_thread     *thread;                       /**< the thread polling */
+    rt_list_t             list;                         /**< node of the poll list of object */
 };
+typedef struct rt_ipc_poll *rt_ipc_poll_t;
+#endif
 
 #ifdef RT_USING_SEMAPHORE
 /**
@@ -564,10 +756,15 @@ struct rt_semaphore
 
     rt_uint16_t          value;
 };
-typedef struct rt_semaphore *rt_semaphore_t;
+typedef struct rt_semaphore *rt_sem_t;
 #endif
 
 #ifdef RT_USING_MUTEX
+/* the most owners raised through nested mutexes by one waiter */
+#ifndef RT_MUTEX_INHERIT_DEPTH
+#define RT_MUTEX_INHERIT_DEPTH          8
+#endif
+
 /**
  * Mutual exclusion (mutex) structure
  */
@@ -580,17 +777,44 @@ struct rt_mutex
     rt_uint8_t           original_priority;             /**< priority of last thread hold the mutex */
     rt_uint8_t           hold;                          /**< numbers of thread hold the mutex */
 
-    struct rt_thread    *owner;                         /**< current owner of mutex */
+    rt_uint8_t           ceiling_priority;              /**< priority ceiling, RT_UINT8_MAX for none */
+    rt_uint8_t           priority;                      /**< highest priority of the waiters and the ceiling */
+
+    struct rt_thread    *owner;                         /**< current owner of mutex, swapped atomically with RT_USING_IPC_FAST_PATH */
+    rt_list_t            taken_list;                    /**< node of taken_object_list of the owner */
 };
 typedef struct rt_mutex * rt_mutex_t;
 #endif
 
+#ifdef RT_USING_RWLOCK
+#ifndef RT_USING_MUTEX
+#error "RT_USING_RWLOCK needs RT_USING_MUTEX"
+#endif
+
+/*
+ * rwlock structure
+ *
+ * A writer holds the mutex for the whole section, so the readers and the
+ * writers blocked on it raise the writer as on the owner of a mutex. A
+ * reader only counts itself in while no writer holds the mutex.
+ */
+struct rt_rwlock
+{
+    struct rt_ipc_object parent;                        /**< the writer waiting for the readers to leave */
+
+    struct rt_mutex      lock;                          /**< held by the writer */
+    rt_uint16_t          readers;                       /**< number of readers, changed atomically with RT_USING_IPC_FAST_PATH */
+    rt_uint16_t          reserved;
+};
+typedef struct rt_rwlock *rt_rwlock_t;
+#endif
+
 #ifdef RT_USING_EVENT
 /**
  * flag defintions in event
  */
 #define RT_EVENT_FLAG_AND               0x01
-#define RT_EVENT_FALG_OR                0x02
+#define RT_EVENT_FLAG_OR                0x02
 #define RT_EVENT_FLAG_CLEAR             0x04
 
 /*
@@ -601,6 +825,12 @@ struct rt_event
     struct rt_ipc_object parent;
 
     rt_uint32_t          set;                           /**< event set */
+
+#ifdef RT_USING_EVENT_INDEX
+    rt_list_t            bit_thread[32];                /**< threads waiting for each bit */
+    rt_list_t            or_thread;                     /**< threads waiting for any of several bits */
+    rt_uint32_t          or_set;                        /**< bits waited for by or_thread */
+#endif
 };
 typedef struct rt_event *rt_event_t;
 #endif
@@ -621,7 +851,7 @@ struct rt_mailbox
     rt_uint16_t          in_offset;                     /**< input offset of the message buffer */
     rt_uint16_t          out_offset;                    /**< output offset of the message buffer */
 
-    rt_list_t            suspend_sender_thread;         /**< sender thread suspended on this mailbox */
+    struct rt_ipc_queue  suspend_sender_thread;         /**< sender thread suspended on this mailbox */
 };
 typedef struct rt_mailbox *rt_mailbox_t;
 #endif
@@ -645,7 +875,7 @@ struct rt_messagequeue
     void                *msg_queue_tail;                /**< list tail */
     void                *msg_queue_free;                /**< pointer indicated the free node of queue */
 };
-typedef struct rt_messagequeue *rt_messagequeue;
+typedef struct rt_messagequeue *rt_mq_t;
 #endif
 
 /*@}*/
@@ -660,7 +890,24 @@ typedef struct rt_messagequeue *rt_messagequeue;
  * memory management
  * heap & partition
  */
+#if defined(RT_USING_HEAP) || defined(RT_USING_MEMHEAP)
+/**
+ * Counters of the ways realloc resized the blocks
+ */
+struct rt_realloc_stat
+{
+    rt_uint32_t             shrink;                     /**< shrunk or kept in place */
+    rt_uint32_t             grow_next;                  /**< grown into the next free block */
+    rt_uint32_t             grow_prev;                  /**< grown into the previous free block, moved */
+    rt_uint32_t             copy;                       /**< allocated anew, copied and freed */
+};
+#endif
+
 #ifdef RT_USING_MEMHEAP
+#ifndef RT_MEMHEAP_BIN_NR
+#define RT_MEMHEAP_BIN_NR               24              /**< size classes of free blocks, 32 at most */
+#endif
+
 /**
  * memory item on the heap
  */
@@ -683,7 +930,7 @@ struct rt_memheap
 {
     struct rt_object        parent;
 
-    void                   *strat_addr;                 /**< pool start address and size */
+    void                   *start_addr;                 /**< pool start address and size */
 
     rt_uint32_t             pool_size;
     rt_uint32_t             available_size;
@@ -691,14 +938,74 @@ struct rt_memheap
 
     struct rt_memheap_item *block_list;
 
-    struct rt_memheap_item *free_list;
-    struct rt_memheap_item *free_header;
+    struct rt_memheap_item *free_bin[RT_MEMHEAP_BIN_NR];    /**< free blocks by power of two size */
+    rt_uint32_t             free_bitmap;                    /**< bitmap of the bins not empty */
+
+    struct rt_realloc_stat  realloc_stat;               /**< ways realloc resized the blocks */
 
     struct rt_semaphore     lock;
 };
+
+/**
+ * Usage information of memory heap, got by rt_memheap_info_get
+ */
+struct rt_memheap_info
+{
+    rt_uint32_t             total;                      /**< size of memory heap */
+    rt_uint32_t             available;
+    rt_uint32_t             max_used;                   /**< maximum allocated size */
+
+    rt_uint32_t             free_blocks;                /**< numbers of free blocks */
+    rt_uint32_t             largest_free;               /**< size of the largest free block */
+    rt_uint16_t             fragmentation;              /**< per mille of free size not in the largest block */
+
+    struct rt_realloc_stat  realloc_stat;               /**< ways realloc resized the blocks */
+};
 #endif
 
 #ifdef RT_USING_MEMPOOL
+/* a single cpu takes the free blocks as fast as a magazine, and without
+ * disabling interrupt with RT_USING_MEMPOOL_LOCKFREE */
+#if defined(RT_USING_MEMPOOL_MAGAZINE) && !defined(RT_USING_SMP)
+#undef RT_USING_MEMPOOL_MAGAZINE
+#endif
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+#ifndef RT_MP_MAGAZINE_SIZE
+#define RT_MP_MAGAZINE_SIZE             8               /**< blocks cached by a magazine */
+#endif
+#define RT_MP_MAGAZINE_NR               RT_CPUS_NR      /**< one magazine for each cpu */
+
+/**
+ * Magazine of memory pool, the free blocks cached by a cpu
+ */
+struct rt_mp_magazine
+{
+#ifdef RT_USING_SMP
+    rt_ubase_t       lock;                              /**< taken by its cpu, or a reclaim */
+#endif
+    rt_ubase_t       count;                             /**< numbers of cached blocks */
+    rt_uint8_t      *block[RT_MP_MAGAZINE_SIZE];        /**< cached blocks, the last one is freed last */
+
+    rt_uint32_t      alloc_hit;                         /**< allocations from the magazine */
+    rt_uint32_t      alloc_miss;
+    rt_uint32_t      free_hit;                          /**< releases to the magazine */
+    rt_uint32_t      free_miss;
+};
+
+/**
+ * Hit counters of the magazines of memory pool, got by rt_mp_magazine_get
+ */
+struct rt_mp_magazine_info
+{
+    rt_uint32_t      alloc_hit;
+    rt_uint32_t      alloc_miss;
+    rt_uint32_t      free_hit;
+    rt_uint32_t      free_miss;
+    rt_uint32_t      cached;                            /**< numbers of cached blocks */
+};
+#endif
+
 /**
  * Base structure of Memory pool object
  */
@@ -710,7 +1017,11 @@ struct rt_mempool
     rt_size_t        size;                              /**< size of memory pool */
 
     rt_size_t        block_size;                        /**< size of memory blocks */
+#ifdef RT_USING_MEMPOOL_LOCKFREE
+    rt_ubase_t       block_head;                        /**< tagged index of the first free block */
+#else
     rt_uint8_t      *block_list;                        /**< memory blocks list */
+#endif
 
     rt_size_t        block_total_count;                 /**< numbers of memory block */
     rt_size_t        block_free_count;
@@ -718,8 +1029,11 @@ struct rt_mempool
     rt_list_t        suspend_thread;                    /**< threads pended on this resource */
     rt_size_t        suspend_thread_count;              /**< numbers of thread pended on this resource */
 
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    struct rt_mp_magazine magazine[RT_MP_MAGAZINE_NR];  /**< free blocks cached by the cpus */
+#endif
 };
-typedef struct rt_mempool *rt_mempool_t;
+typedef struct rt_mempool *rt_mp_t;
 #endif
 
 #ifdef RT_USING_DEVICE
@@ -0,0 +1,175 @@
+#ifndef __RT_HW_H__
+#define __RT_HW_H__
+
+#include <rtthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Some macros define
+ */
+#ifndef HWREG32
+#define HWREG32(x)          (*((volatile rt_uint32_t *)(x)))
+#endif
+#ifndef HWREG16
+#define HWREG16(x)          (*((volatile rt_uint16_t *)(x)))
+#endif
+#ifndef HWREG8
+#define HWREG8(x)           (*((volatile rt_uint8_t *)(x)))
+#endif
+
+/*
+ * CPU interfaces
+ */
+void rt_hw_cpu_reset(void);
+void rt_hw_cpu_shutdown(void);
+
+rt_uint8_t *rt_hw_stack_init(void       *entry,
+                             void       *parameter,
+                             rt_uint8_t *stack_addr,
+                             void       *exit);
+
+/*
+ * Interrupt handler definition
+ */
+typedef void (*rt_isr_handler_t)(int vector, void *param);
+
+struct rt_irq_desc
+{
+    rt_isr_handler_t handler;
+    void            *param;
+
+#ifdef RT_USING_INTERRUPT_INFO
+    char             name[RT_NAME_MAX];
+    rt_uint32_t      counter;
+#endif
+};
+
+/*
+ * Interrupt interfaces
+ */
+void rt_hw_interrupt_init(void);
+void rt_hw_interrupt_mask(int vector);
+void rt_hw_interrupt_umask(int vector);
+rt_isr_handler_t rt_hw_interrupt_install(int              vector,
+                                         rt_isr_handler_t handler,
+                                         void            *param,
+                                         const char      *name);
+
+#ifdef RT_USING_SMP
+/* the interrupt disabled section of the kernel is also locked among cpus */
+#define rt_hw_interrupt_disable rt_cpus_lock
+#define rt_hw_interrupt_enable  rt_cpus_unlock
+#else
+rt_base_t rt_hw_interrupt_disable(void);
+void rt_hw_interrupt_enable(rt_base_t level);
+#endif
+
+/* disable/enable the interrupt of the running cpu only */
+rt_base_t rt_hw_local_irq_disable(void);
+void rt_hw_local_irq_enable(rt_base_t level);
+
+/*
+ * Atomic interfaces of the lock-free paths of the kernel. They are the
+ * builtins of GCC and clang, a port for another compiler defines them and
+ * RT_HW_ATOMIC in its rtconfig.h or cpuport.h.
+ */
+#if !defined(RT_HW_ATOMIC) && defined(__GNUC__)
+#define RT_HW_ATOMIC
+
+#define rt_hw_atomic_load(ptr)          __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define rt_hw_atomic_store(ptr, val)    __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define rt_hw_atomic_add(ptr, val)      __atomic_fetch_add((ptr), (val), __ATOMIC_SEQ_CST)
+#define rt_hw_atomic_sub(ptr, val)      __atomic_fetch_sub((ptr), (val), __ATOMIC_SEQ_CST)
+/* a full barrier, true if *ptr was old and is new now */
+#define rt_hw_atomic_cas(ptr, old, new) __sync_bool_compare_and_swap((ptr), (old), (new))
+#ifdef RT_USING_SMP
+#define rt_hw_atomic_fence()            __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+/* one cpu sees its own stores in order, the interrupts included */
+#define rt_hw_atomic_fence()            __atomic_signal_fence(__ATOMIC_SEQ_CST)
+#endif
+#endif
+
+/*
+ * Context interfaces
+ */
+#ifdef RT_USING_SMP
+void rt_hw_context_switch(rt_uint32_t from, rt_uint32_t to, struct rt_thread *to_thread);
+void rt_hw_context_switch_to(rt_uint32_t to, struct rt_thread *to_thread);
+void rt_hw_context_switch_interrupt(void *context,
+                                    rt_uint32_t from,
+                                    rt_uint32_t to,
+                                    struct rt_thread *to_thread);
+#else
+void rt_hw_context_switch(rt_uint32_t from, rt_uint32_t to);
+void rt_hw_context_switch_to(rt_uint32_t to);
+void rt_hw_context_switch_interrupt(rt_uint32_t from, rt_uint32_t to);
+#endif
+
+void rt_hw_console_output(const char *str);
+
+#ifdef RT_USING_TICKLESS
+/*
+ * Tickless interfaces, used by the idle thread with interrupt disabled
+ */
+void rt_hw_tick_suspend(rt_tick_t timeout);
+rt_tick_t rt_hw_tick_resume(void);
+#endif
+#if defined(RT_USING_TICKLESS) || defined(RT_USING_SMP)
+void rt_hw_cpu_sleep(void);
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+/*
+ * Cycle counter interfaces, a free-running counter of the run-time accounting
+ */
+rt_uint64_t rt_hw_cycle_get(void);
+rt_uint64_t rt_hw_cycle_freq(void);
+#endif
+
+#ifdef RT_USING_SMP
+/*
+ * SMP interfaces
+ */
+typedef union
+{
+    unsigned long slock;
+    struct __arch_tickets
+    {
+        unsigned short owner;
+        unsigned short next;
+    } tickets;
+} rt_hw_spinlock_t;
+
+#define RT_DEFINE_SPINLOCK(x)   rt_hw_spinlock_t x = {0}
+
+void rt_hw_spin_lock(rt_hw_spinlock_t *lock);
+void rt_hw_spin_unlock(rt_hw_spinlock_t *lock);
+
+extern rt_hw_spinlock_t _cpus_lock;
+
+int rt_hw_cpu_id(void);
+
+/* send the ipi to the cpus in 'cpu_mask' */
+void rt_hw_ipi_send(int ipi_vector, unsigned int cpu_mask);
+
+/* boot the secondary cpus, each one runs secondary_cpu_c_start() of the bsp */
+void rt_hw_secondary_cpu_up(void);
+#endif
+
+void rt_hw_backtrace(rt_uint32_t *fp, rt_uint32_t thread_entry);
+void rt_hw_show_memory(rt_uint32_t addr, rt_uint32_t size);
+
+/*
+ * Exception interfaces
+ */
+void rt_hw_exception_install(rt_err_t (*exception_handle)(void *context));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef __RTLIBC_H__
+#define __RTLIBC_H__
+
+/* definitions for libc if toolchain has no these definitions */
+#include "libc/libc_signal.h"
+
+#if defined(__CC_ARM) || defined(__CLANG_ARM) || defined(__IAR_SYSTEMS_ICC__)
+typedef signed long off_t;
+typedef int mode_t;
+#endif
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef __RTM_H__
+#define __RTM_H__
+
+#include <rtdef.h>
+
+#ifdef RT_USING_MODULE
+struct rt_module_symtab
+{
+    void       *addr;
+    const char *name;
+};
+
+#define RTM_EXPORT(symbol)                                                    \
+const char __rtmsym_##symbol##_name[] SECTION(".rodata.name") = #symbol;     \
+const struct rt_module_symtab __rtmsym_##symbol SECTION("RTMSymTab") =       \
+{                                                                             \
+    (void *)&symbol,                                                          \
+    __rtmsym_##symbol##_name                                                  \
+};
+
+#else
+
+#define RTM_EXPORT(symbol)
+
+#endif
+
+#endif
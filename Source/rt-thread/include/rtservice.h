@@ -21,7 +21,7 @@ extern "C" {
 /**
  * @brief initialize a list object
  */
-#define RT_LIST_OBJECT_INIT(objec) { &(object), &(object)}
+#define RT_LIST_OBJECT_INIT(object) { &(object), &(object)}
 
 /**
  * @brief initialize a list
@@ -79,7 +79,7 @@ rt_inline void rt_list_remove(rt_list_t *n)
  * @brief tests whether a list is empty
  * @param l the list to test.
  */
-rt_inline int rt_list_empty(const rt_list_t *l)
+rt_inline int rt_list_isempty(const rt_list_t *l)
 {
     return l->next == l;
 }
@@ -150,8 +150,8 @@ rt_inline unsigned int rt_list_len(const rt_list_t *l)
 #define rt_list_for_each_entry_safe(pos, n, head, member) \
     for (pos = rt_list_entry((head)->next,     typeof(*pos), member), \
          n   = rt_list_entry(pos->member.next, typeof(*pos), member); \
-         &pos->member != (head);
-         pos = n, n = rt_list_entry(n->member->next, typeof(*n), member))
+         &pos->member != (head); \
+         pos = n, n = rt_list_entry(n->member.next, typeof(*n), member))
 
 /**
  * rt_list_first_entry - get the first element from a list
@@ -179,7 +179,7 @@ rt_inline void rt_slist_init(rt_slist_t *l)
 
 rt_inline void rt_slist_append(rt_slist_t *l, rt_slist_t *n)
 {
-    struct rt_slist_t *node;
+    struct rt_slist_node *node;
 
     node = l;
     while(node->next) node = node->next;
@@ -189,7 +189,7 @@ rt_inline void rt_slist_append(rt_slist_t *l, rt_slist_t *n)
     n->next = RT_NULL;
 }
 
-rt_inline rt_slist_insert(rt_slist_t *l, rt_slist_t *n)
+rt_inline void rt_slist_insert(rt_slist_t *l, rt_slist_t *n)
 {
     n->next = l->next;
     l->next = n;
@@ -212,7 +212,7 @@ rt_inline unsigned int rt_slist_len(const rt_slist_t *l)
 rt_inline rt_slist_t *rt_slist_remove(rt_slist_t *l, rt_slist_t *n)
 {
     /* remove slist head */
-    struct rt_slist_t *node = l;
+    struct rt_slist_node *node = l;
     while (node->next && node->next != n) node = node->next;
 
     /* remove node */
@@ -231,9 +231,9 @@ rt_inline rt_slist_t *rt_slist_next(rt_slist_t *n)
     return n->next;
 }
 
-rt_inline rt_slist_isempty(rt_slist_t *l)
+rt_inline int rt_slist_isempty(rt_slist_t *l)
 {
-    return l->next == RT_NULL；
+    return l->next == RT_NULL;
 }
 
 /**
@@ -261,7 +261,7 @@ rt_inline rt_slist_isempty(rt_slist_t *l)
  */
 #define rt_slist_for_each_entry(pos, head, member) \
     for (pos = rt_slist_entry((head)->next, typeof(*pos), member); \
-         &pos->member != (RT_NULL)；
+         &pos->member != (RT_NULL); \
          pos = rt_slist_entry(pos->member.next, typeof(*pos), member))
 
 /**
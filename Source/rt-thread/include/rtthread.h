@@ -55,10 +55,13 @@ void rt_system_tick_init(void);
 rt_tick_t rt_tick_get(void);
 void rt_tick_set(rt_tick_t tick);
 void rt_tick_increase(void);
+#ifdef RT_USING_TICKLESS
+void rt_tick_increase_n(rt_tick_t ticks);
+#endif
 int rt_tick_from_millisecond(rt_int32_t ms);
 
 void rt_system_timer_init(void);
-void rt_system_timer_thread_int(void);
+void rt_system_timer_thread_init(void);
 
 void rt_timer_init(rt_timer_t  timer,
                    const char *name,
@@ -118,7 +121,7 @@ rt_thread_t rt_thread_find(char *name);
 rt_err_t rt_thread_startup(rt_thread_t thread);
 rt_err_t rt_thread_delete(rt_thread_t thread);
 
-rt_err_t rt_thread_yield(rt_thread_t thread);
+rt_err_t rt_thread_yield(void);
 rt_err_t rt_thread_delay(rt_tick_t tick);
 rt_err_t rt_thread_mdelay(rt_uint32_t ms);
 rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg);
@@ -132,10 +135,15 @@ void rt_thread_free_sig(rt_thread_t tid);
 void rt_thread_kill(rt_thread_t tid, int sig);
 #endif
 
+#ifdef RT_USING_CPU_USAGE
+void rt_thread_usage_get(rt_thread_t thread, struct rt_thread_info *info);
+void rt_cpu_usage_dump(void);
+#endif
+
 #ifdef RT_USING_HOOK
 void rt_thread_suspend_sethook(void (*hook)(rt_thread_t thread));
 void rt_thread_resume_sethook (void (*hook)(rt_thread_t thread));
-void rt_thread_init_sethook   (void (*hook)(rt_thread_t thread));
+void rt_thread_inited_sethook (void (*hook)(rt_thread_t thread));
 #endif
 
 /*
@@ -148,6 +156,9 @@ rt_err_t rt_thread_idle_delhook(void (*hook)(void));
 #endif
 void rt_thread_idle_excute(void);
 rt_thread_t rt_thread_idle_gethandler(void);
+#ifdef RT_USING_CPU_USAGE
+rt_uint16_t rt_cpu_load_get(void);
+#endif
 
 /*
  * schedule service
@@ -167,6 +178,21 @@ rt_uint16_t rt_critical_level(void);
 void rt_scheduler_sethook(void (*hook)(rt_thread_t from, rt_thread_t to));
 #endif
 
+#ifdef RT_USING_SMP
+void rt_scheduler_ipi_handler(int vector, void *param);
+void rt_scheduler_do_irq_switch(void *context);
+
+/*
+ * cpu interface
+ */
+struct rt_cpu *rt_cpu_self(void);
+struct rt_cpu *rt_cpu_index(int index);
+
+rt_base_t rt_cpus_lock(void);
+void rt_cpus_unlock(rt_base_t level);
+void rt_cpus_lock_status_restore(struct rt_thread *thread);
+#endif
+
 /**@}*/
 
 /**
@@ -202,7 +228,7 @@ rt_err_t rt_mp_init(struct rt_mempool *mp,
                     rt_size_t          size,
                     rt_size_t          block_size);
 rt_err_t rt_mp_detach(struct rt_mempool *mp);
-rt_mp_t rt_mp_create(cosnt char *name,
+rt_mp_t rt_mp_create(const char *name,
                      rt_size_t   block_count,
                      rt_size_t   block_size);
 rt_err_t rt_mp_delete(rt_mp_t mp);
@@ -210,6 +236,11 @@ rt_err_t rt_mp_delete(rt_mp_t mp);
 void *rt_mp_alloc(rt_mp_t mp, rt_int32_t time);
 void rt_mp_free(void *block);
 
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+void rt_mp_magazine_flush(rt_mp_t mp);
+void rt_mp_magazine_get(rt_mp_t mp, struct rt_mp_magazine_info *info);
+#endif
+
 #ifdef RT_USING_HOOK
 void rt_mp_alloc_sethook(void (*hook)(struct rt_mempool *mp, void *block));
 void rt_mp_free_sethook(void (*hook)(struct rt_mempool *mp, void *block));
@@ -233,6 +264,9 @@ void rt_free_align(void *ptr);
 void rt_memory_info(rt_uint32_t *total,
                     rt_uint32_t *used,
                     rt_uint32_t *max_used);
+#if defined(RT_USING_SMALL_MEM) || defined(RT_USING_MEMHEAP_AS_HEAP)
+void rt_memory_realloc_stat(struct rt_realloc_stat *stat);
+#endif
 
 #ifdef RT_USING_SLAB
 void *rt_page_alloc(rt_size_t npages);
@@ -255,9 +289,11 @@ rt_err_t rt_memheap_init(struct rt_memheap *memheap,
                          void              *start_addr,
                          rt_uint32_t        size);
 rt_err_t rt_memheap_detach(struct rt_memheap *heap);
-void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size);
+void *rt_memheap_alloc(struct rt_memheap *heap, rt_uint32_t size);
+void *rt_memheap_alloc_align(struct rt_memheap *heap, rt_size_t size, rt_size_t align);
 void *rt_memheap_realloc(struct rt_memheap *heap, void *ptr, rt_size_t newsize);
 void rt_memheap_free(void *ptr);
+void rt_memheap_info_get(struct rt_memheap *heap, struct rt_memheap_info *info);
 #endif
 
 /**@}*/
@@ -267,6 +303,24 @@ void rt_memheap_free(void *ptr);
  */
 
 /**@{*/
+#ifdef RT_USING_IPC_POLL
+/*
+ * ipc poll interface
+ */
+int rt_ipc_poll(struct rt_ipc_poll *polls, rt_uint32_t count, rt_int32_t time);
+#endif
+
+#ifdef RT_USING_IPC_PROFILE
+/*
+ * ipc profile interface
+ */
+void rt_ipc_profile_start(void);
+void rt_ipc_profile_stop(void);
+void rt_ipc_profile_reset(void);
+rt_err_t rt_ipc_profile_get(struct rt_object *object, struct rt_ipc_profile *profile);
+void rt_ipc_profile_dump(void);
+#endif
+
 #ifdef RT_USING_SEMAPHORE
 /*
  * semaphore interface
@@ -291,11 +345,27 @@ rt_err_t rt_sem_control(rt_sem_t sem, int cmd, void *arg);
 rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag);
 rt_err_t rt_mutex_detach(rt_mutex_t mutex);
 rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag);
-rt_err_t rt_mutex_delete(rt_mutex_ mutex);
+rt_err_t rt_mutex_delete(rt_mutex_t mutex);
 
 rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time);
 rt_err_t rt_mutex_release(rt_mutex_t mutex);
 rt_err_t rt_mutex_control(rt_mutex_t mutex, int cmd, void *arg);
+rt_uint8_t rt_mutex_setprioceiling(rt_mutex_t mutex, rt_uint8_t priority);
+rt_uint8_t rt_mutex_getprioceiling(rt_mutex_t mutex);
+#endif
+
+#ifdef RT_USING_RWLOCK
+/*
+ * rwlock interface
+ */
+rt_err_t rt_rwlock_init(rt_rwlock_t rwlock, const char *name, rt_uint8_t flag);
+rt_err_t rt_rwlock_detach(rt_rwlock_t rwlock);
+rt_rwlock_t rt_rwlock_create(const char *name, rt_uint8_t flag);
+rt_err_t rt_rwlock_delete(rt_rwlock_t rwlock);
+
+rt_err_t rt_rwlock_take_read(rt_rwlock_t rwlock, rt_int32_t time);
+rt_err_t rt_rwlock_take_write(rt_rwlock_t rwlock, rt_int32_t time);
+rt_err_t rt_rwlock_release(rt_rwlock_t rwlock);
 #endif
 
 #ifdef RT_USING_EVENT
@@ -307,7 +377,7 @@ rt_err_t rt_event_detach(rt_event_t event);
 rt_event_t rt_event_create(const char *name, rt_uint8_t flag);
 rt_err_t rt_event_delete(rt_event_t event);
 
-rt_err_t rt_event_send(rt_event_t event, rt_int32_t set);
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set);
 rt_err_t rt_event_recv(rt_event_t   event,
                        rt_uint32_t  set,
                        rt_uint8_t   opt,
@@ -330,10 +400,18 @@ rt_mailbox_t rt_mb_create(const char *name, rt_size_t size, rt_uint8_t flag);
 rt_err_t rt_mb_delete(rt_mailbox_t mb);
 
 rt_err_t rt_mb_send(rt_mailbox_t mb, rt_uint32_t value);
-rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
+rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
                          rt_uint32_t  value,
                          rt_int32_t   timeout);
 rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout);
+rt_size_t rt_mb_send_wait_n(rt_mailbox_t       mb,
+                            const rt_uint32_t *value,
+                            rt_size_t          count,
+                            rt_int32_t         timeout);
+rt_size_t rt_mb_recv_n(rt_mailbox_t mb,
+                       rt_uint32_t *value,
+                       rt_size_t    count,
+                       rt_int32_t   timeout);
 rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, rt_int32_t *arg);
 #endif
 
@@ -360,7 +438,18 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
                     void      *buffer,
                     rt_size_t  size,
                     rt_int32_t timeout);
+rt_size_t rt_mq_send_n(rt_mq_t mq, const void *buffer, rt_size_t size, rt_size_t count);
+rt_size_t rt_mq_recv_n(rt_mq_t    mq,
+                       void      *buffer,
+                       rt_size_t  size,
+                       rt_size_t  count,
+                       rt_int32_t timeout);
 rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg);
+
+void *rt_mq_loan(rt_mq_t mq);
+rt_err_t rt_mq_commit(rt_mq_t mq, void *buffer);
+rt_err_t rt_mq_recv_loan(rt_mq_t mq, void **buffer, rt_int32_t timeout);
+void rt_mq_release(rt_mq_t mq, void *buffer);
 #endif
 
 /**@}*/
@@ -448,6 +537,12 @@ void rt_components_board_init(void);
 #else
 void rt_kprintf(const char *fmt, ...);
 void rt_kputs(const char *str);
+#ifdef RT_USING_KPRINTF_ASYNC
+void rt_kprintf_thread_init(void);
+void rt_kprintf_wakeup(void);
+void rt_kprintf_flush(void);
+rt_uint32_t rt_kprintf_drop_get(void);
+#endif
 #endif
 rt_int32_t rt_vsprintf(char *dest, const char *format, va_list arg_ptr);
 rt_int32_t rt_vsnprintf(char *buf, rt_size_t size, const char *fmt, va_list args);
@@ -486,7 +581,7 @@ char *rt_strstr(const char *str1, const char *str2);
 rt_int32_t rt_sscanf(const char *buf, const char *fmt, ...);
 char *rt_strncpy(char *dest, const char *src, rt_ubase_t n);
 void *rt_memmove(void *dest, const void *src, rt_ubase_t n);
-rt_int32_t rt_memcpy(const void *cs, const void *ct, rt_ubase_t count);
+rt_int32_t rt_memcmp(const void *cs, const void *ct, rt_ubase_t count);
 rt_uint32_t rt_strcasecmp(const char *a, const char *b);
 
 void rt_show_version(void);
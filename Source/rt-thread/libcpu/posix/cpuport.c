@@ -0,0 +1,660 @@
+/*
+ * CPU port for running RT-Thread as a single process on a POSIX host.
+ *
+ * Every RT-Thread thread runs on its own ucontext, all of them inside one
+ * host thread, so the kernel still sees exactly one CPU. Host signals play
+ * the role of interrupt lines: rt_hw_interrupt_install() binds a handler to a
+ * signal number and the signal handler dispatches it between
+ * rt_interrupt_enter()/rt_interrupt_leave(), e.g. SIGALRM from setitimer()
+ * drives rt_tick_increase() in the hosted board support.
+ *
+ * Interrupt disable/enable do not touch the host signal mask. They only flip
+ * a flag; a signal arriving while the flag is set is latched as pending and
+ * replayed by rt_hw_interrupt_enable(). This keeps the kernel critical
+ * sections free of system calls, so what is measured on the host is the
+ * kernel itself and not sigprocmask().
+ *
+ * With RT_USING_SMP every cpu is a host thread (pthread), which runs the
+ * ucontexts of the RT-Thread threads scheduled on it, so a thread may be
+ * switched out on one host thread and switched in on another. Each cpu has
+ * its own interrupt flag and pending interrupts, the host signals are sent to
+ * a cpu by pthread_kill() for the IPI or by a per-thread timer for the tick.
+ *
+ * Notes:
+ * - the signal handlers run on the stack of the interrupted thread, thread
+ *   stacks shall be at least RT_HW_STACK_MIN bytes;
+ * - the cpu index is thread local to the host thread, it's read again by
+ *   rt_hw_cpu_id() after anything which may switch the context;
+ * - rt_uint32_t is 'unsigned long' in rtdef.h, so the sp addresses passed to
+ *   the context switch functions are not truncated on LP64 hosts.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucontext.h>
+
+#include <rthw.h>
+#include <rtthread.h>
+
+/* checked by _rt_thread_init of thread.c, so it's set in rtconfig.h */
+#ifndef RT_HW_STACK_MIN
+#error "RT_HW_STACK_MIN shall be defined in rtconfig.h"
+#endif
+
+/* host signals 1 ~ 31 are used as interrupt vectors */
+#define MAX_HANDLERS                32
+
+#define _compiler_barrier()         __asm__ volatile("" ::: "memory")
+
+struct rt_hw_context
+{
+    ucontext_t uc;
+
+    void (*entry)(void *parameter);
+    void  *parameter;
+    void (*exit)(void);
+};
+
+/* the interrupt state of a cpu */
+struct rt_hw_cpu_state
+{
+    volatile sig_atomic_t interrupt_disabled;
+    volatile rt_uint32_t  interrupt_pending;
+
+#ifdef RT_USING_SMP
+    pthread_t             thread;                       /* host thread of the cpu */
+    volatile int          started;
+    struct rt_thread     *switch_to;                    /* the thread being switched in */
+#endif
+};
+
+static struct rt_irq_desc isr_table[MAX_HANDLERS];
+
+/* interrupt is disabled until the first thread runs */
+static struct rt_hw_cpu_state cpu_state[RT_CPUS_NR] =
+{
+    [0 ... RT_CPUS_NR - 1] = { .interrupt_disabled = 1 }
+};
+static volatile rt_uint32_t interrupt_masked;
+
+#ifdef RT_USING_SMP
+static __thread int cpu_index;
+
+#define _cpu()                      (&cpu_state[rt_hw_cpu_id()])
+#else
+#define _cpu()                      (&cpu_state[0])
+
+/* context switch in interrupt, same as the Cortex-M port */
+rt_uint32_t rt_interrupt_from_thread;
+rt_uint32_t rt_interrupt_to_thread;
+rt_uint32_t rt_thread_switch_interrupt_flag;
+#endif
+
+#ifdef RT_USING_SMP
+/**
+ * This function will return the index of the running cpu. It's never
+ * inlined, so the thread local index is read again after a context switch.
+ */
+__attribute__((noinline)) int rt_hw_cpu_id(void)
+{
+    _compiler_barrier();
+
+    return cpu_index;
+}
+#endif
+
+static void _thread_startup(unsigned int high, unsigned int low)
+{
+    struct rt_hw_context *ctx;
+
+    ctx = (struct rt_hw_context *)(rt_ubase_t)(((unsigned long long)high << 32) | low);
+
+#ifdef RT_USING_SMP
+    /* release the kernel lock handed over by the context switch */
+    rt_cpus_lock_status_restore(_cpu()->switch_to);
+#endif
+
+    /* a new thread always starts with interrupt enabled */
+    rt_hw_local_irq_enable(0);
+
+    ctx->entry(ctx->parameter);
+
+    /* rt_thread_exit never returns */
+    ctx->exit();
+}
+
+/**
+ * This function will initialize thread stack
+ *
+ * The context block is put on the top of the thread stack and the thread sp
+ * points to it for the whole life of the thread. The stack is at least
+ * RT_HW_STACK_MIN bytes, as asserted by _rt_thread_init.
+ *
+ * @param tentry the entry of thread
+ * @param parameter the parameter of entry
+ * @param stack_addr the beginning stack address
+ * @param texit the function will be called when thread exit
+ *
+ * @return stack address
+ */
+rt_uint8_t *rt_hw_stack_init(void       *tentry,
+                             void       *parameter,
+                             rt_uint8_t *stack_addr,
+                             void       *texit)
+{
+    rt_uint8_t *stk;
+    struct rt_hw_context *ctx;
+    unsigned long long addr;
+
+    stk  = stack_addr + sizeof(rt_uint32_t);
+    stk  = (rt_uint8_t *)RT_ALIGN_DOWN((rt_ubase_t)stk, 16);
+    stk -= RT_ALIGN(sizeof(struct rt_hw_context), 16);
+
+    ctx = (struct rt_hw_context *)stk;
+    rt_memset(ctx, 0, sizeof(struct rt_hw_context));
+
+    ctx->entry     = (void (*)(void *))tentry;
+    ctx->parameter = parameter;
+    ctx->exit      = (void (*)(void))texit;
+
+    getcontext(&(ctx->uc));
+    ctx->uc.uc_link = RT_NULL;
+    /* makecontext() starts the thread at ss_sp + ss_size, which is right
+     * below the context block; the real lower bound is thread->stack_addr. */
+    ctx->uc.uc_stack.ss_sp   = stk - RT_HW_STACK_MIN / 2;
+    ctx->uc.uc_stack.ss_size = RT_HW_STACK_MIN / 2;
+    sigemptyset(&(ctx->uc.uc_sigmask));
+
+    addr = (unsigned long long)(rt_ubase_t)ctx;
+    makecontext(&(ctx->uc), (void (*)(void))_thread_startup, 2,
+                (unsigned int)(addr >> 32), (unsigned int)(addr & 0xffffffffu));
+
+    return stk;
+}
+
+static void _interrupt_dispatch(int vector)
+{
+    rt_interrupt_enter();
+
+    if (isr_table[vector].handler != RT_NULL)
+    {
+#ifdef RT_USING_INTERRUPT_INFO
+        isr_table[vector].counter ++;
+#endif
+        isr_table[vector].handler(vector, isr_table[vector].param);
+    }
+
+    rt_interrupt_leave();
+}
+
+#ifdef RT_USING_SMP
+#define _switch_pending()           0
+#else
+#define _switch_pending()           (rt_thread_switch_interrupt_flag)
+#endif
+
+/*
+ * Run all pending interrupts and the deferred context switch. It's invoked
+ * with interrupt disabled, and returns with interrupt disabled, maybe in the
+ * context of another thread much later, and maybe on another cpu.
+ */
+static void _interrupt_exit(void)
+{
+    rt_uint32_t pending;
+#ifndef RT_USING_SMP
+    struct rt_hw_context *from, *to;
+#endif
+
+    do
+    {
+        while ((pending = __atomic_fetch_and(&_cpu()->interrupt_pending, interrupt_masked,
+                                             __ATOMIC_SEQ_CST) & ~interrupt_masked) != 0)
+        {
+            int vector;
+
+            for (vector = 1; vector < MAX_HANDLERS; vector ++)
+            {
+                if (pending & (1u << vector))
+                    _interrupt_dispatch(vector);
+            }
+        }
+
+#ifdef RT_USING_SMP
+        rt_scheduler_do_irq_switch(RT_NULL);
+#else
+        if (rt_thread_switch_interrupt_flag)
+        {
+            rt_thread_switch_interrupt_flag = 0;
+
+            from = *(struct rt_hw_context **)rt_interrupt_from_thread;
+            to   = *(struct rt_hw_context **)rt_interrupt_to_thread;
+
+            swapcontext(&(from->uc), &(to->uc));
+        }
+#endif
+
+        /* the interrupts latched while switching */
+    } while (_cpu()->interrupt_pending & ~interrupt_masked);
+}
+
+static void _signal_handler(int signo)
+{
+    if (_cpu()->interrupt_disabled || (interrupt_masked & (1u << signo)))
+    {
+        /* latch it, rt_hw_local_irq_enable or umask will replay it */
+        __atomic_fetch_or(&_cpu()->interrupt_pending, 1u << signo, __ATOMIC_SEQ_CST);
+
+        return;
+    }
+
+    _cpu()->interrupt_disabled = 1;
+    _compiler_barrier();
+
+    _interrupt_dispatch(signo);
+    _interrupt_exit();
+
+    _compiler_barrier();
+    _cpu()->interrupt_disabled = 0;
+}
+
+/**
+ * This function will disable the interrupt (all host signals installed by
+ * rt_hw_interrupt_install) of the running cpu and return the previous status.
+ */
+rt_base_t rt_hw_local_irq_disable(void)
+{
+    rt_base_t level;
+    struct rt_hw_cpu_state *cpu;
+
+    cpu = _cpu();
+    level = cpu->interrupt_disabled;
+    cpu->interrupt_disabled = 1;
+    _compiler_barrier();
+
+    return level;
+}
+
+/**
+ * This function will restore the interrupt status of the running cpu and
+ * replay the interrupts that arrived while it was disabled.
+ */
+void rt_hw_local_irq_enable(rt_base_t level)
+{
+    _compiler_barrier();
+    _cpu()->interrupt_disabled = (sig_atomic_t)level;
+    _compiler_barrier();
+
+    /* the interrupt latched before the flag was cleared is replayed here */
+    while (level == 0 &&
+           ((_cpu()->interrupt_pending & ~interrupt_masked) || _switch_pending()))
+    {
+        _cpu()->interrupt_disabled = 1;
+        _compiler_barrier();
+
+        _interrupt_exit();
+
+        _compiler_barrier();
+        _cpu()->interrupt_disabled = 0;
+        _compiler_barrier();
+    }
+}
+
+#ifndef RT_USING_SMP
+/**
+ * This function will disable the interrupt and return the previous status,
+ * on one cpu it's the interrupt of the running cpu.
+ */
+rt_base_t rt_hw_interrupt_disable(void)
+{
+    return rt_hw_local_irq_disable();
+}
+
+/**
+ * This function will restore the interrupt status.
+ */
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+    rt_hw_local_irq_enable(level);
+}
+#endif
+
+/**
+ * This function will initialize the hardware interrupt, that is the table of
+ * host signal handlers.
+ */
+void rt_hw_interrupt_init(void)
+{
+    int cpu;
+
+    rt_memset(isr_table, 0, sizeof(isr_table));
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu ++)
+        cpu_state[cpu].interrupt_pending = 0;
+    interrupt_masked = 0;
+
+#ifndef RT_USING_SMP
+    rt_interrupt_from_thread        = 0;
+    rt_interrupt_to_thread          = 0;
+    rt_thread_switch_interrupt_flag = 0;
+#endif
+}
+
+/**
+ * This function will mask a interrupt.
+ * @param vector the host signal number
+ */
+void rt_hw_interrupt_mask(int vector)
+{
+    if (vector <= 0 || vector >= MAX_HANDLERS)
+        return;
+
+    __atomic_fetch_or(&interrupt_masked, 1u << vector, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * This function will un-mask a interrupt.
+ * @param vector the host signal number
+ */
+void rt_hw_interrupt_umask(int vector)
+{
+    rt_base_t level;
+
+    if (vector <= 0 || vector >= MAX_HANDLERS)
+        return;
+
+    level = rt_hw_local_irq_disable();
+    __atomic_fetch_and(&interrupt_masked, ~(1u << vector), __ATOMIC_SEQ_CST);
+    rt_hw_local_irq_enable(level);
+}
+
+/**
+ * This function will install a interrupt service routine to a interrupt.
+ *
+ * @param vector the host signal number, e.g. SIGALRM
+ * @param handler the interrupt service routine
+ * @param param the parameter of the routine
+ * @param name the name of interrupt
+ *
+ * @return the old handler
+ */
+rt_isr_handler_t rt_hw_interrupt_install(int              vector,
+                                         rt_isr_handler_t handler,
+                                         void            *param,
+                                         const char      *name)
+{
+    rt_isr_handler_t old_handler = RT_NULL;
+    struct sigaction act;
+
+    if (vector <= 0 || vector >= MAX_HANDLERS)
+        return RT_NULL;
+
+    old_handler = isr_table[vector].handler;
+
+#ifdef RT_USING_INTERRUPT_INFO
+    rt_strncpy(isr_table[vector].name, name, RT_NAME_MAX);
+#endif
+    isr_table[vector].handler = handler;
+    isr_table[vector].param   = param;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = _signal_handler;
+    act.sa_flags   = SA_RESTART;
+    sigfillset(&act.sa_mask);
+    sigaction(vector, &act, RT_NULL);
+
+    return old_handler;
+}
+
+#ifdef RT_USING_SMP
+/*
+ * void rt_hw_context_switch(rt_uint32 from, rt_uint32 to, struct rt_thread *to_thread);
+ * from: the address of sp of the 'from' thread
+ * to: the address of sp of the 'to' thread
+ * to_thread: the 'to' thread, which gets the kernel lock
+ */
+void rt_hw_context_switch(rt_uint32_t from, rt_uint32_t to, struct rt_thread *to_thread)
+{
+    struct rt_hw_context *from_ctx, *to_ctx;
+
+    from_ctx = *(struct rt_hw_context **)from;
+    to_ctx   = *(struct rt_hw_context **)to;
+
+    _cpu()->switch_to = to_thread;
+    swapcontext(&(from_ctx->uc), &(to_ctx->uc));
+
+    /* switched in, maybe on another cpu */
+    rt_cpus_lock_status_restore(_cpu()->switch_to);
+}
+
+/*
+ * void rt_hw_context_switch_interrupt(void *context, rt_uint32 from, rt_uint32 to,
+ *                                     struct rt_thread *to_thread);
+ * It's invoked at the end of the interrupt, the switch is done at once.
+ */
+void rt_hw_context_switch_interrupt(void *context,
+                                    rt_uint32_t from,
+                                    rt_uint32_t to,
+                                    struct rt_thread *to_thread)
+{
+    rt_hw_context_switch(from, to, to_thread);
+}
+
+/*
+ * void rt_hw_context_switch_to(rt_uint32 to, struct rt_thread *to_thread);
+ * to: the address of sp of the 'to' thread
+ */
+void rt_hw_context_switch_to(rt_uint32_t to, struct rt_thread *to_thread)
+{
+    struct rt_hw_context *to_ctx;
+
+    to_ctx = *(struct rt_hw_context **)to;
+
+    _cpu()->switch_to = to_thread;
+    setcontext(&(to_ctx->uc));
+
+    /* never come back */
+    abort();
+}
+
+/**
+ * This function will take a spinlock. The waiting host thread yields the
+ * host cpu, the holder may be a host thread which is not running.
+ */
+void rt_hw_spin_lock(rt_hw_spinlock_t *lock)
+{
+    int spin;
+
+    while (__atomic_exchange_n(&lock->slock, 1, __ATOMIC_ACQUIRE) != 0)
+    {
+        for (spin = 0; __atomic_load_n(&lock->slock, __ATOMIC_RELAXED) != 0; spin ++)
+        {
+            if (spin >= 100)
+                sched_yield();
+        }
+    }
+}
+
+/**
+ * This function will release a spinlock.
+ */
+void rt_hw_spin_unlock(rt_hw_spinlock_t *lock)
+{
+    __atomic_store_n(&lock->slock, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * This function will send an IPI, that is the host signal 'ipi_vector', to
+ * the cpus in 'cpu_mask' which are started.
+ */
+void rt_hw_ipi_send(int ipi_vector, unsigned int cpu_mask)
+{
+    int cpu;
+
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu ++)
+    {
+        if ((cpu_mask & (1u << cpu)) && cpu_state[cpu].started)
+            pthread_kill(cpu_state[cpu].thread, ipi_vector);
+    }
+}
+
+extern void secondary_cpu_c_start(void);
+
+static void *_secondary_cpu_entry(void *parameter)
+{
+    sigset_t set;
+
+    cpu_index = (int)(rt_ubase_t)parameter;
+
+    /* the signals are blocked until the cpu index is set */
+    sigemptyset(&set);
+    pthread_sigmask(SIG_SETMASK, &set, RT_NULL);
+
+    secondary_cpu_c_start();
+
+    /* never come back */
+    abort();
+
+    return RT_NULL;
+}
+
+/**
+ * This function will start the host threads of the secondary cpus, the
+ * calling host thread is the first cpu.
+ */
+void rt_hw_secondary_cpu_up(void)
+{
+    sigset_t block, old;
+    int cpu;
+
+    cpu_state[0].thread  = pthread_self();
+    cpu_state[0].started = 1;
+
+    sigfillset(&block);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+
+    for (cpu = 1; cpu < RT_CPUS_NR; cpu ++)
+    {
+        if (pthread_create(&cpu_state[cpu].thread, RT_NULL,
+                           _secondary_cpu_entry, (void *)(rt_ubase_t)cpu) != 0)
+        {
+            rt_kprintf("cpu%d: failed to start\n", cpu);
+            break;
+        }
+
+        cpu_state[cpu].started = 1;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, RT_NULL);
+}
+#else
+/*
+ * void rt_hw_context_switch(rt_uint32 from, rt_uint32 to);
+ * from: the address of sp of the 'from' thread
+ * to: the address of sp of the 'to' thread
+ */
+void rt_hw_context_switch(rt_uint32_t from, rt_uint32_t to)
+{
+    struct rt_hw_context *from_ctx, *to_ctx;
+
+    from_ctx = *(struct rt_hw_context **)from;
+    to_ctx   = *(struct rt_hw_context **)to;
+
+    swapcontext(&(from_ctx->uc), &(to_ctx->uc));
+}
+
+/*
+ * void rt_hw_context_switch_interrupt(rt_uint32 from, rt_uint32 to);
+ * The switch is deferred to the end of the interrupt.
+ */
+void rt_hw_context_switch_interrupt(rt_uint32_t from, rt_uint32_t to)
+{
+    if (rt_thread_switch_interrupt_flag == 0)
+    {
+        rt_thread_switch_interrupt_flag = 1;
+        rt_interrupt_from_thread = from;
+    }
+
+    rt_interrupt_to_thread = to;
+}
+
+/*
+ * void rt_hw_context_switch_to(rt_uint32 to);
+ * to: the address of sp of the 'to' thread
+ */
+void rt_hw_context_switch_to(rt_uint32_t to)
+{
+    struct rt_hw_context *to_ctx;
+
+    to_ctx = *(struct rt_hw_context **)to;
+
+    setcontext(&(to_ctx->uc));
+
+    /* never come back */
+    abort();
+}
+#endif
+
+/**
+ * This function will output the console string to the host stdout.
+ */
+void rt_hw_console_output(const char *str)
+{
+    rt_size_t length;
+    ssize_t result;
+
+    length = rt_strlen(str);
+    while (length > 0)
+    {
+        result = write(STDOUT_FILENO, str, length);
+        if (result <= 0)
+            break;
+
+        str    += result;
+        length -= result;
+    }
+}
+
+#if defined(RT_USING_TICKLESS) || defined(RT_USING_SMP)
+/**
+ * This function will put the CPU to sleep until an interrupt is pending. It's
+ * invoked with interrupt disabled, like a WFI with PRIMASK set, and the
+ * interrupt is serviced after rt_hw_local_irq_enable.
+ */
+void rt_hw_cpu_sleep(void)
+{
+    sigset_t block, old;
+
+    /* no signal shall slip in between the check and the suspend */
+    sigfillset(&block);
+    sigprocmask(SIG_BLOCK, &block, &old);
+
+    if ((_cpu()->interrupt_pending & ~interrupt_masked) == 0)
+        sigsuspend(&old);
+
+    sigprocmask(SIG_SETMASK, &old, RT_NULL);
+}
+#endif
+
+/**
+ * shutdown CPU
+ */
+void rt_hw_cpu_shutdown(void)
+{
+    rt_hw_local_irq_disable();
+
+    exit(0);
+}
+
+/**
+ * reset CPU
+ */
+void rt_hw_cpu_reset(void)
+{
+    rt_hw_local_irq_disable();
+
+    exit(1);
+}
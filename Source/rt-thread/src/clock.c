@@ -4,6 +4,9 @@
 static rt_tick_t rt_tick = 0;
 
 extern void rt_timer_check(void);
+#ifdef RT_USING_CPU_USAGE
+extern void rt_cpu_usage_update(void);
+#endif
 
 /**
  * This function will init system tick and set it to zero.
@@ -51,12 +54,19 @@ void rt_tick_set(rt_tick_t tick)
  * This function will notify kernel there is one tick passed. Normally,
  * this function is invoked by clock ISR.
  */
-void rt_tick_incread(void)
+void rt_tick_increase(void)
 {
     struct rt_thread *thread;
 
+#ifdef RT_USING_SMP
+    /* every cpu has a tick for the time slice, the global tick and the
+     * timers are of the first cpu */
+    if (rt_hw_cpu_id() == 0)
+        ++ rt_tick;
+#else
     /* increase the global tick */
     ++ rt_tick;
+#endif
 
     /* check time slice */
     thread = rt_thread_self();
@@ -71,9 +81,73 @@ void rt_tick_incread(void)
         rt_thread_yield();
     }
 
+#ifdef RT_USING_SMP
+    if (rt_hw_cpu_id() != 0)
+        return;
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+    /* close the usage period of threads */
+    rt_cpu_usage_update();
+#endif
+
+    /* check timer */
+    rt_timer_check();
+}
+
+#ifdef RT_USING_TICKLESS
+/**
+ * This function will notify kernel there are some ticks passed at once,
+ * e.g. the ticks elapsed while the periodic tick was suspended by the
+ * tickless idle. The elapsed ticks are charged to the time slice of the
+ * current thread, and all the timers expired in the meantime are invoked.
+ * A periodic timer due several times is invoked once, and its next timeout
+ * is still on its period, see rt_timer_check.
+ *
+ * @param ticks the number of passed ticks
+ */
+void rt_tick_increase_n(rt_tick_t ticks)
+{
+    struct rt_thread *thread;
+    register rt_base_t level;
+
+    if (ticks == 0)
+        return;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    /* increase the global tick */
+    rt_tick += ticks;
+
+    /* check time slice */
+    thread = rt_thread_self();
+
+    if (thread->remaining_tick > ticks)
+    {
+        thread->remaining_tick -= ticks;
+    }
+    else
+    {
+        /* change to initialized tick */
+        thread->remaining_tick = thread->init_tick;
+
+        /* yield */
+        rt_thread_yield();
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+#ifdef RT_USING_CPU_USAGE
+    /* close the usage period of threads */
+    rt_cpu_usage_update();
+#endif
+
     /* check timer */
     rt_timer_check();
 }
+#endif
 
 /**
  * This function will calculate the tick from millisecond.
@@ -224,6 +224,11 @@ int rtthread_startup(void)
     /* timer thread initialization */
     rt_system_timer_thread_init();
 
+#if defined(RT_USING_CONSOLE) && defined(RT_USING_KPRINTF_ASYNC)
+    /* log thread initialization */
+    rt_kprintf_thread_init();
+#endif
+
     /* idle thread initialization */
     rt_thread_idle_init();
 
@@ -0,0 +1,120 @@
+/*
+ * CPU structures and the kernel lock of SMP.
+ *
+ * Every cpu has its own running thread, interrupt nest and ready queue, see
+ * scheduler.c. The kernel data shared among cpus is protected by one
+ * recursive lock, _cpus_lock: rt_hw_interrupt_disable() is rt_cpus_lock() in
+ * SMP, so each interrupt disabled section of the kernel is also a section
+ * locked among the cpus, and the kernel code is the same as on one cpu.
+ *
+ * The nest of the lock belongs to the thread, not to the cpu: a thread which
+ * is switched out with the lock held gets it back when it's switched in, on
+ * whatever cpu. The lock is held across every context switch and handed to
+ * the next thread, which releases it by rt_cpus_lock_status_restore() if it
+ * was not holding the lock when it was switched out.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_SMP
+
+static struct rt_cpu rt_cpus[RT_CPUS_NR];
+rt_hw_spinlock_t _cpus_lock;
+
+/**
+ * This function will return the structure of the running cpu.
+ */
+struct rt_cpu *rt_cpu_self(void)
+{
+    return &rt_cpus[rt_hw_cpu_id()];
+}
+
+/**
+ * This function will return the structure of the cpu 'index'.
+ */
+struct rt_cpu *rt_cpu_index(int index)
+{
+    return &rt_cpus[index];
+}
+
+/**
+ * This function will disable the interrupt of the running cpu and take the
+ * kernel lock.
+ *
+ * @return the previous interrupt status of the running cpu
+ */
+rt_base_t rt_cpus_lock(void)
+{
+    rt_base_t level;
+    struct rt_cpu *pcpu;
+
+    level = rt_hw_local_irq_disable();
+
+    pcpu = rt_cpu_self();
+    /* nothing to lock before the scheduler is started on this cpu */
+    if (pcpu->current_thread != RT_NULL)
+    {
+        register rt_uint16_t lock_nest = pcpu->current_thread->cpus_lock_nest;
+
+        pcpu->current_thread->cpus_lock_nest ++;
+        if (lock_nest == 0)
+        {
+            /* no thread switch on this cpu while the lock is held */
+            pcpu->current_thread->scheduler_lock_nest ++;
+            rt_hw_spin_lock(&_cpus_lock);
+        }
+    }
+
+    return level;
+}
+RTM_EXPORT(rt_cpus_lock);
+
+/**
+ * This function will release the kernel lock and restore the interrupt
+ * status of the running cpu.
+ *
+ * @param level the interrupt status returned by rt_cpus_lock
+ */
+void rt_cpus_unlock(rt_base_t level)
+{
+    struct rt_cpu *pcpu;
+
+    pcpu = rt_cpu_self();
+    if (pcpu->current_thread != RT_NULL)
+    {
+        RT_ASSERT(pcpu->current_thread->cpus_lock_nest > 0);
+
+        pcpu->current_thread->cpus_lock_nest --;
+        if (pcpu->current_thread->cpus_lock_nest == 0)
+        {
+            pcpu->current_thread->scheduler_lock_nest --;
+            rt_hw_spin_unlock(&_cpus_lock);
+        }
+    }
+
+    rt_hw_local_irq_enable(level);
+}
+RTM_EXPORT(rt_cpus_unlock);
+
+/**
+ * This function will be invoked by the cpu port when 'thread' is switched in.
+ * The lock held by the previous thread is released if 'thread' was not
+ * holding it when it was switched out.
+ *
+ * @param thread the thread switched in
+ */
+void rt_cpus_lock_status_restore(struct rt_thread *thread)
+{
+    struct rt_cpu *pcpu;
+
+    pcpu = rt_cpu_self();
+    pcpu->current_thread = thread;
+
+    if (thread->cpus_lock_nest == 0)
+    {
+        rt_hw_spin_unlock(&_cpus_lock);
+    }
+}
+
+#endif
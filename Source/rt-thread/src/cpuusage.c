@@ -0,0 +1,176 @@
+/*
+ * Run-time accounting of threads.
+ *
+ * The scheduler charges the cycles from switching a thread in to switching
+ * it out to the thread, on the free-running cycle counter of the cpu port,
+ * and counts the times it's switched in. The tick of cpu 0 closes a usage
+ * period every RT_CPU_USAGE_PERIOD ticks: the cycles each thread ran in the
+ * period become its usage, and the usage of the idle threads the cpu load.
+ * The time in interrupts is charged to the interrupted thread.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_CPU_USAGE
+
+#ifndef RT_CPU_USAGE_PERIOD
+#define RT_CPU_USAGE_PERIOD     RT_TICK_PER_SECOND
+#endif
+
+#ifndef RT_USING_SMP
+extern struct rt_thread *rt_current_thread;
+#endif
+
+/* the cycle counter and the tick at the start of the usage period */
+static rt_uint64_t usage_cycle;
+static rt_tick_t usage_tick;
+
+/* the cycles a thread ran, with the ones since switched in if it's running */
+static rt_uint64_t rt_cpu_usage_cycle(struct rt_thread *thread, rt_uint64_t cycle)
+{
+#ifdef RT_USING_SMP
+    if (thread->oncpu != RT_CPU_DETACHED)
+#else
+    if (thread == rt_current_thread)
+#endif
+        return thread->cycle + (cycle - thread->cycle_stamp);
+
+    return thread->cycle;
+}
+
+/**
+ * This function will close the usage period once RT_CPU_USAGE_PERIOD ticks
+ * passed, and work out the usage of all threads in it. It's invoked by the
+ * tick of cpu 0.
+ */
+void rt_cpu_usage_update(void)
+{
+    struct rt_object_information *information;
+    struct rt_thread *thread;
+    struct rt_list_node *node;
+    register rt_base_t level;
+    rt_uint64_t cycle, period, ran;
+
+    if (rt_tick_get() - usage_tick < RT_CPU_USAGE_PERIOD)
+        return;
+
+    information = rt_object_get_information(RT_Object_Class_Thread);
+    RT_ASSERT(information != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    cycle  = rt_hw_cycle_get();
+    period = cycle - usage_cycle;
+
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        thread = rt_list_entry(node, struct rt_thread, list);
+
+        ran = rt_cpu_usage_cycle(thread, cycle);
+        /* the first period starts at the first update */
+        if (usage_cycle != 0 && period != 0)
+        {
+            thread->usage = (rt_uint16_t)((ran - thread->cycle_period) * 1000 / period);
+            if (thread->usage > 1000)
+                thread->usage = 1000;
+        }
+        thread->cycle_period = ran;
+    }
+
+    usage_cycle = cycle;
+    usage_tick  = rt_tick_get();
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will get the run-time information of a thread.
+ *
+ * @param thread the thread
+ * @param info the information will be saved in
+ */
+void rt_thread_usage_get(rt_thread_t thread, struct rt_thread_info *info)
+{
+    register rt_base_t level;
+
+    /* parameter check */
+    RT_ASSERT(thread != RT_NULL);
+    RT_ASSERT(info != RT_NULL);
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    info->cycle    = rt_cpu_usage_cycle(thread, rt_hw_cycle_get());
+    info->switches = thread->switches;
+    info->usage    = thread->usage;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+RTM_EXPORT(rt_thread_usage_get);
+
+/**
+ * This function will print the cpu load and the run-time information of all
+ * threads, the usage is of the last period.
+ */
+void rt_cpu_usage_dump(void)
+{
+    struct rt_object_information *information;
+    struct rt_thread_info info;
+    struct rt_thread *thread;
+    struct rt_list_node *node;
+    rt_uint64_t freq;
+    rt_uint16_t load;
+
+    information = rt_object_get_information(RT_Object_Class_Thread);
+    RT_ASSERT(information != RT_NULL);
+
+    freq = rt_hw_cycle_freq();
+    load = rt_cpu_load_get();
+    rt_kprintf("cpu load: %d.%d%%\n", load / 10, load % 10);
+
+    rt_kprintf("%-*.*s pri usage  switches   time(ms)\n",
+               RT_NAME_MAX, RT_NAME_MAX, "thread");
+    rt_kprintf("%-*.*s --- ------ ---------- ----------\n",
+               RT_NAME_MAX, RT_NAME_MAX, "--------------------------------");
+
+    /* no thread is deleted or detached while the list is walked */
+    rt_enter_critical();
+
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        thread = rt_list_entry(node, struct rt_thread, list);
+        rt_thread_usage_get(thread, &info);
+
+        rt_kprintf("%-*.*s %3d %3d.%d%% %-10lu %lu\n",
+                   RT_NAME_MAX, RT_NAME_MAX, thread->name,
+                   thread->current_priority,
+                   info.usage / 10, info.usage % 10,
+                   (unsigned long)info.switches,
+                   (unsigned long)(info.cycle * 1000 / freq));
+    }
+
+    rt_exit_critical();
+}
+RTM_EXPORT(rt_cpu_usage_dump);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int top(int argc, char **argv)
+{
+    rt_cpu_usage_dump();
+
+    return 0;
+}
+MSH_CMD_EXPORT(top, list the cpu usage of threads);
+#endif
+
+#endif /* end of RT_USING_CPU_USAGE */
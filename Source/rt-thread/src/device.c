@@ -37,7 +37,7 @@ rt_err_t rt_device_register(rt_device_t dev,
     if (dev == RT_NULL)
         return -RT_ERROR;
 
-    if (rt_device_fine(name) != RT_NULL)
+    if (rt_device_find(name) != RT_NULL)
         return -RT_ERROR;
 
     rt_object_init(&(dev->parent), RT_Object_Class_Device, name);
@@ -93,40 +93,9 @@ rt_err_t rt_device_init_all(void)
  *
  * @return the registered device driver on successful, or RT_NULL on failure.
  */
- rt_device_t rt_device_find(const char *name)
+rt_device_t rt_device_find(const char *name)
 {
-    struct rt_object *object;
-    struct rt_list_node *node;
-    struct rt_object_information *information;
-
-    /* enter critical */
-    if (rt_thread_self() != RT_NULL)
-        rt_enter_critical();
-
-    /* try to find device object */
-    information = rt_object_get_information(RT_Object_Class_Device);
-    RT_ASSERT(information != RT_NULL);
-    for (node  = information->object_list.next;
-         node != &(information->object_list);
-         node  =  node->next)
-    {
-        object = rt_list_entry(node, struct rt_object, list);
-        if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
-        {
-            /* leave critical */
-            if (rt_thread_self() != NULL)
-                rt_exit_critical();
-
-            return (rt_device_t)object;
-        }
-    }
-
-    /* leave critical */
-    if (rt_thread_self() != RT_NULL)
-        rt_exit_critical();
-
-    /* not found */
-    return RT_NULL;
+    return (rt_device_t)rt_object_find(name, RT_Object_Class_Device);
 }
 RTM_EXPORT(rt_device_find);
 
@@ -144,7 +113,7 @@ rt_device_t rt_device_create(int type, int attach_size)
     int size;
     rt_device_t device;
 
-    size = RT_ALIGN(sizeof(struct rt_device), RT_ALIGN_SIZE)；
+    size = RT_ALIGN(sizeof(struct rt_device), RT_ALIGN_SIZE);
     attach_size = RT_ALIGN(attach_size, RT_ALIGN_SIZE);
     /* use the totoal size */
     size += attach_size;
@@ -406,7 +375,7 @@ RTM_EXPORT(rt_device_write);
 rt_err_t rt_device_control(rt_device_t dev, int cmd, void *arg)
 {
     RT_ASSERT(dev != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&dev-parent) == RT_Object_Class_Device);
+    RT_ASSERT(rt_object_get_type(&dev->parent) == RT_Object_Class_Device);
 
     /* call device write interface */
     if (device_control != RT_NULL)
@@ -434,7 +403,7 @@ rt_device_set_rx_indicate(rt_device_t dev,
     RT_ASSERT(dev != RT_NULL);
     RT_ASSERT(rt_object_get_type(&dev->parent) == RT_Object_Class_Device);
 
-    dev->rx_indicate = rt_ind;
+    dev->rx_indicate = rx_ind;
 
     return RT_EOK;
 }
@@ -19,9 +19,21 @@
 #endif
 #endif
 
-staic struct rt_thread idle;
+#if defined(RT_USING_TICKLESS) && defined(RT_USING_SMP)
+#error "RT_USING_TICKLESS can't be used with RT_USING_SMP"
+#endif
+
+#ifdef RT_USING_TICKLESS
+/* the sleep shorter than this is not worth stopping the periodic tick */
+#ifndef RT_TICKLESS_THRESHOLD
+#define RT_TICKLESS_THRESHOLD    2
+#endif
+#endif
+
+/* one idle thread for each cpu */
+static struct rt_thread idle[RT_CPUS_NR];
 ALIGN(RT_ALIGN_SIZE)
-static rt_uint8_t rt_thread_stack[IDLE_THREAD_STACK_SIZE];
+static rt_uint8_t rt_thread_stack[RT_CPUS_NR][IDLE_THREAD_STACK_SIZE];
 
 extern rt_list_t rt_thread_defunct;
 
@@ -133,7 +145,7 @@ void rt_thread_idle_excute(void)
         rt_base_t lock;
         rt_thread_t thread;
 #ifdef RT_USING_MODULE
-        struct rt_dlmodule *module = RT_NULL；
+        struct rt_dlmodule *module = RT_NULL;
 #endif
         RT_DEBUG_NOT_IN_INTERRUPT;
 
@@ -147,6 +159,15 @@ void rt_thread_idle_excute(void)
             thread = rt_list_entry(rt_thread_defunct.next,
                                    struct rt_thread,
                                    tlist);
+#ifdef RT_USING_SMP
+            /* it's deleted while running on another cpu, which is switching out */
+            if (thread->oncpu != RT_CPU_DETACHED)
+            {
+                rt_hw_interrupt_enable(lock);
+
+                return;
+            }
+#endif
 #ifdef RT_USING_MODULE
             module = (struct rt_dlmodule *)thread->module_id;
             if (module)
@@ -204,6 +225,97 @@ void rt_thread_idle_excute(void)
     }
 }
 
+#ifdef RT_USING_TICKLESS
+/*
+ * Suspend the periodic tick until the next timer expires, and sleep. The
+ * soft timers need no special care: the timer thread waits for the first
+ * of them with its thread timer, which is a hard timer.
+ */
+static void rt_thread_idle_tickless(void)
+{
+    rt_base_t level;
+    rt_tick_t timeout, elapsed;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    /* there is another ready thread at idle priority, keep on ticking */
+    if (idle[0].tlist.next != idle[0].tlist.prev)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+
+    timeout = rt_timer_next_timeout_tick();
+    if (timeout != RT_TICK_MAX)
+    {
+        timeout = timeout - rt_tick_get();
+
+        /* the timer is already expired */
+        if (timeout >= RT_TICK_MAX / 2)
+            timeout = 0;
+    }
+
+    if (timeout < RT_TICKLESS_THRESHOLD)
+    {
+        rt_hw_interrupt_enable(level);
+
+        return;
+    }
+
+    /* lock scheduler, all the expired timers are invoked before switching */
+    rt_enter_critical();
+
+    rt_hw_tick_suspend(timeout);
+    /* wake up by the programmed timer or any other interrupt */
+    rt_hw_cpu_sleep();
+    elapsed = rt_hw_tick_resume();
+
+    rt_tick_increase_n(elapsed);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    rt_exit_critical();
+}
+#endif
+
+#ifdef RT_USING_SMP
+/*
+ * Sleep until an interrupt if there is no ready thread for this cpu, the
+ * scheduling IPI wakes it up when a thread is queued on it. The ready queues
+ * are only peeked without the lock: a thread queued after the check sends
+ * the IPI, which is pending and ends the sleep at once.
+ */
+static void rt_thread_idle_wait(void)
+{
+    rt_base_t level;
+    struct rt_cpu *pcpu;
+    int index;
+
+    level = rt_hw_local_irq_disable();
+
+    pcpu = rt_cpu_self();
+    if (pcpu->priority_group == 0)
+    {
+        /* nothing to steal from the other cpus either */
+        for (index = 0; index < RT_CPUS_NR; index ++)
+        {
+            if (rt_cpu_index(index)->steal_group != 0)
+                break;
+        }
+
+        if (index == RT_CPUS_NR)
+            rt_hw_cpu_sleep();
+    }
+
+    rt_hw_local_irq_enable(level);
+
+    rt_schedule();
+}
+#endif
+
 static void rt_thread_idle_entry(void *parameter)
 {
 #ifdef RT_USING_IDLE_HOOK
@@ -212,7 +324,7 @@ static void rt_thread_idle_entry(void *parameter)
 
     while(1)
     {
-#ifdef
+#ifdef RT_USING_IDLE_HOOK
         for (i = 0; i < RT_IDLE_HOOK_LIST_SIZE; i++)
         {
             if (idle_hook_list[i] != RT_NULL)
@@ -222,7 +334,20 @@ static void rt_thread_idle_entry(void *parameter)
         }
 #endif
 
+#if defined(RT_USING_CONSOLE) && defined(RT_USING_KPRINTF_ASYNC)
+        /* the log thread writes out the messages when the cpu is idle */
+        rt_kprintf_wakeup();
+#endif
+
         rt_thread_idle_excute();
+
+#ifdef RT_USING_TICKLESS
+        rt_thread_idle_tickless();
+#endif
+
+#ifdef RT_USING_SMP
+        rt_thread_idle_wait();
+#endif
     }
 }
 
@@ -235,18 +360,37 @@ static void rt_thread_idle_entry(void *parameter)
  */
 void rt_thread_idle_init(void)
 {
-    /* initialize thread */
-    rt_thread_init(&idle
-                   "tidle",
-                   rt_thread_idle_entry,
-                   RT_NULL,
-                   &rt_thread_stack[0],
-                   sizeof(rt_thread_stack),
-                   RT_THREAD_PRIORITY_MAX - 1,
-                   32);
-
-    /* startup */
-    rt_thread_startup(&idle);
+    rt_ubase_t i;
+#ifdef RT_USING_SMP
+    char tidle_name[RT_NAME_MAX];
+#endif
+
+    for (i = 0; i < RT_CPUS_NR; i ++)
+    {
+        /* initialize thread */
+#ifdef RT_USING_SMP
+        rt_snprintf(tidle_name, sizeof(tidle_name), "tidle%d", i);
+        rt_thread_init(&idle[i],
+                       tidle_name,
+#else
+        rt_thread_init(&idle[i],
+                       "tidle",
+#endif
+                       rt_thread_idle_entry,
+                       RT_NULL,
+                       &rt_thread_stack[i][0],
+                       sizeof(rt_thread_stack[i]),
+                       RT_THREAD_PRIORITY_MAX - 1,
+                       32);
+
+#ifdef RT_USING_SMP
+        /* the idle thread never leaves its cpu */
+        rt_thread_control(&idle[i], RT_THREAD_CTRL_BIND_CPU, (void *)i);
+#endif
+
+        /* startup */
+        rt_thread_startup(&idle[i]);
+    }
 }
 
 /**
@@ -257,5 +401,40 @@ void rt_thread_idle_init(void)
  */
 rt_thread_t rt_thread_idle_gethandler(void)
 {
-    return (rt_thread_t)(&idle);
+#ifdef RT_USING_SMP
+    register int id = rt_hw_cpu_id();
+#else
+    register int id = 0;
+#endif
+
+    return (rt_thread_t)(&idle[id]);
+}
+
+#ifdef RT_USING_CPU_USAGE
+/**
+ * @ingroup Thread
+ *
+ * This function will get the cpu load of the last usage period, which is the
+ * time the idle threads didn't run.
+ *
+ * @return the load in per mille of all cpus
+ */
+rt_uint16_t rt_cpu_load_get(void)
+{
+    rt_uint32_t usage;
+    int i;
+
+    /* without RT_USING_SMP all the idle threads share the only cpu */
+    usage = 0;
+    for (i = 0; i < RT_CPUS_NR; i++)
+        usage += idle[i].usage;
+#ifdef RT_USING_SMP
+    usage /= RT_CPUS_NR;
+#endif
+    if (usage > 1000)
+        usage = 1000;
+
+    return (rt_uint16_t)(1000 - usage);
 }
+RTM_EXPORT(rt_cpu_load_get);
+#endif
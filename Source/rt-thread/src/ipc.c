@@ -7,12 +7,115 @@ extern void (*rt_object_take_hook)(struct rt_object *object);
 extern void (*rt_object_put_hook)(struct rt_object *object);
 #endif
 
+/* an IPC object inside another one, which isn't on the object list */
+#define RT_IPC_FLAG_INNER               0x80
+
+/* the hooks see the mutex of a rwlock as the rwlock, not as a mutex */
+#define RT_MUTEX_HOOK_CALL(mutex, func, argv)                           \
+    do                                                                  \
+    {                                                                   \
+        if (!((mutex)->parent.parent.flag & RT_IPC_FLAG_INNER))         \
+            RT_OBJECT_HOOK_CALL(func, argv);                            \
+    } while (0)
+
 /**
  * @addtogroup IPC
  */
 
 /**@{*/
 
+/**
+ * This function will initialize an IPC suspended thread queue
+ *
+ * @param queue the suspended thread queue
+ */
+rt_inline void rt_ipc_queue_init(struct rt_ipc_queue *queue)
+{
+    register rt_ubase_t index;
+
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    queue->priority_group = 0;
+#endif
+
+    for (index = 0; index < RT_IPC_QUEUE_LISTS; index ++)
+        rt_list_init(&(queue->list[index]));
+}
+
+/**
+ * This function will get the first thread of an IPC suspended thread queue,
+ * which shall be invoked with interrupt disabled.
+ *
+ * A thread leaves the queue by rt_thread_resume, which doesn't know the
+ * queue, so the bit of a band whose list becomes empty is cleared here
+ * when it's found.
+ *
+ * @param queue the suspended thread queue
+ *
+ * @return the first thread, RT_NULL if the queue is empty
+ */
+rt_inline struct rt_thread *rt_ipc_queue_first(struct rt_ipc_queue *queue)
+{
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    register rt_ubase_t band;
+
+    while (queue->priority_group != 0)
+    {
+        band = __rt_ffs(queue->priority_group) - 1;
+
+        if (!rt_list_isempty(&(queue->list[band])))
+            return rt_list_entry(queue->list[band].next, struct rt_thread, tlist);
+
+        /* no thread on this band anymore */
+        queue->priority_group &= ~(1L << band);
+    }
+
+    return RT_NULL;
+#else
+    if (rt_list_isempty(&(queue->list[0])))
+        return RT_NULL;
+
+    return rt_list_entry(queue->list[0].next, struct rt_thread, tlist);
+#endif
+}
+
+/**
+ * This function will check whether an IPC suspended thread queue is empty,
+ * which shall be invoked with interrupt disabled.
+ *
+ * @param queue the suspended thread queue
+ *
+ * @return RT_TRUE if there is no thread in the queue
+ */
+rt_inline rt_bool_t rt_ipc_queue_isempty(struct rt_ipc_queue *queue)
+{
+    return rt_ipc_queue_first(queue) == RT_NULL;
+}
+
+#ifdef RT_USING_IPC_FAST_PATH
+#ifndef RT_HW_ATOMIC
+#error "RT_USING_IPC_FAST_PATH needs the atomic interfaces of rthw.h"
+#endif
+
+/**
+ * This function will check whether an IPC suspended thread queue is empty
+ * without disabling interrupt. A thread being suspended or resumed may be
+ * seen or not, so only an empty queue is sure.
+ *
+ * @param queue the suspended thread queue
+ *
+ * @return RT_TRUE if there is no thread in the queue
+ */
+rt_inline rt_bool_t rt_ipc_queue_peek_empty(struct rt_ipc_queue *queue)
+{
+#ifdef RT_USING_IPC_PRIO_QUEUE
+    /* the bits are cleared lazily, a set one doesn't mean a thread */
+    return rt_hw_atomic_load(&(queue->priority_group)) == 0;
+#else
+    return rt_hw_atomic_load(&(queue->list[0].next)) == &(queue->list[0]);
+#endif
+}
+#endif
+
 /**
  * This function will initialize an IPC object
  *
@@ -23,41 +126,65 @@ extern void (*rt_object_put_hook)(struct rt_object *object);
 rt_inline rt_err_t rt_ipc_object_init(struct rt_ipc_object *ipc)
 {
     /* init ipc object */
-    rt_list_init(&(ipc->suspend_thread));
+    rt_ipc_queue_init(&(ipc->suspend_thread));
+#ifdef RT_USING_IPC_POLL
+    rt_list_init(&(ipc->poll_list));
+#endif
+#ifdef RT_USING_IPC_PROFILE
+    rt_memset(&(ipc->profile), 0, sizeof(ipc->profile));
+#endif
 
     return RT_EOK;
 }
 
 /**
- * This function will suspend a thread to a specified list. IPC object or some
- * double-queue object (mailbox etc.) contains this kind of list.
+ * This function will put a suspended thread into a queue by the IPC flag.
  *
- * @param list the IPC suspended thread list
- * @param thread the thread object to be suspended
+ * @param queue the IPC suspended thread queue
+ * @param thread the suspended thread, which is in no list
  * @param flag the IPC object flag,
  *        which shall be RT_IPC_FLAG_FIFO/RT_IPC_FLAG_PRIO.
- *
- * @return the operation status, RT_EOK on successful
  */
-rt_inline rt_err_t rt_ipc_list_suspend(rt_list_t        *list,
-                                       struct rt_thread *thread,
-                                       rt_uint8_t        flag)
+rt_inline void rt_ipc_queue_insert(struct rt_ipc_queue *queue,
+                                   struct rt_thread    *thread,
+                                   rt_uint8_t           flag)
 {
-    /* suspend thread */
-    rt_thread_suspend(thread);
+    if (!(flag & RT_IPC_FLAG_PRIO))
+    {
+        rt_list_insert_before(&(queue->list[0]), &(thread->tlist));
+#ifdef RT_USING_IPC_PRIO_QUEUE
+        /* all threads are on the list of band 0 */
+        queue->priority_group |= 1;
+#endif
+
+        return;
+    }
 
-    switch (flag)
+#ifdef RT_USING_IPC_PRIO_QUEUE
     {
-    case RT_IPC_FLAG_FIFO:
-        rt_list_insert_before(list, &(thread->tlist));
-        break;
+        struct rt_list_node *list, *n;
+        rt_ubase_t band;
 
-    case RT_IPC_FLAG_PRIORITY:
+        band = thread->current_priority / (RT_THREAD_PRIORITY_MAX / RT_IPC_QUEUE_LISTS);
+        list = &(queue->list[band]);
+
+        /* the band is sorted, go back from the tail over the lower priorities */
+        for (n = list->prev; n != list; n = n->prev)
+        {
+            if (rt_list_entry(n, struct rt_thread, tlist)->current_priority <=
+                thread->current_priority)
+                break;
+        }
+        rt_list_insert_after(n, &(thread->tlist));
+        queue->priority_group |= 1L << band;
+    }
+#else
+    {
         struct rt_list_node *n;
         struct rt_thread *sthread;
 
         /* find a suitable position */
-        for (n = list->next; n != list; n = n->next)
+        for (n = queue->list[0].next; n != &(queue->list[0]); n = n->next)
         {
             sthread = rt_list_entry(n, struct rt_thread, tlist);
 
@@ -65,7 +192,7 @@ rt_inline rt_err_t rt_ipc_list_suspend(rt_list_t        *list,
             if (thread->current_priority < sthread->current_priority)
             {
                 /* insert this thread before the sthread */
-                rt_list_insert_before(&(sthrad->tlist), &(thread->tlist));
+                rt_list_insert_before(&(sthread->tlist), &(thread->tlist));
                 break;
             }
         }
@@ -74,30 +201,51 @@ rt_inline rt_err_t rt_ipc_list_suspend(rt_list_t        *list,
          * not found a suitable position,
          * append to the end of suspend_thread list
          */
-        if (n == list)
-            rt_list_insert_before(list, &(thread->tlist));
-
-        break;
+        if (n == &(queue->list[0]))
+            rt_list_insert_before(&(queue->list[0]), &(thread->tlist));
     }
+#endif
+}
+
+/**
+ * This function will suspend a thread to a specified queue. IPC object or some
+ * double-queue object (mailbox etc.) contains this kind of queue.
+ *
+ * @param queue the IPC suspended thread queue
+ * @param thread the thread object to be suspended
+ * @param flag the IPC object flag,
+ *        which shall be RT_IPC_FLAG_FIFO/RT_IPC_FLAG_PRIO.
+ *
+ * @return the operation status, RT_EOK on successful
+ */
+rt_inline rt_err_t rt_ipc_list_suspend(struct rt_ipc_queue *queue,
+                                       struct rt_thread    *thread,
+                                       rt_uint8_t           flag)
+{
+    /* suspend thread */
+    rt_thread_suspend(thread);
+
+    rt_ipc_queue_insert(queue, thread, flag);
 
     return RT_EOK;
 }
 
 /**
- * This function will resume the first thread in the list of a IPC object:
+ * This function will resume the first thread in the queue of a IPC object:
  * - remove the thread from suspend queue of IPC object
  * - put the thread into system ready queue
  *
- * @param list the thread list
+ * @param queue the thread queue, which shall not be empty
  *
  * @return the operation status, RT_EOK on successful
  */
-rt_inline rt_err_t rt_ipc_list_resume(rt_list_t *list)
+rt_inline rt_err_t rt_ipc_list_resume(struct rt_ipc_queue *queue)
 {
-    struct thread *thread;
+    struct rt_thread *thread;
 
     /* get thread entry */
-    thread = rt_list_entry(list->next, struct rt_thread, tlist);
+    thread = rt_ipc_queue_first(queue);
+    RT_ASSERT(thread != RT_NULL);
 
     RT_DEBUG_LOG(RT_DEBUG_IPC, ("resume thread %s\n", thread->name));
 
@@ -108,26 +256,43 @@ rt_inline rt_err_t rt_ipc_list_resume(rt_list_t *list)
 }
 
 /**
- * This function will resume all suspended threads in a list, including
- * suspend list of IPC object and private list of mailbox etc.
+ * This function will resume up to count threads of a queue, one for each item
+ * put to or taken from an IPC object by a batch.
+ *
+ * @param queue the thread queue
+ * @param count the number of items
+ *
+ * @return the number of threads resumed
+ */
+rt_inline rt_size_t rt_ipc_list_resume_n(struct rt_ipc_queue *queue, rt_size_t count)
+{
+    rt_size_t resumed;
+
+    for (resumed = 0; resumed < count && !rt_ipc_queue_isempty(queue); resumed ++)
+        rt_ipc_list_resume(queue);
+
+    return resumed;
+}
+
+/**
+ * This function will resume all suspended threads in a queue, including
+ * suspend queue of IPC object and private queue of mailbox etc.
  *
- * @param list of the threads to resume
+ * @param queue of the threads to resume
  *
  * @return the operation status, RT_EOK on successful
  */
-rt_inline rt_err_t rt_ipc_list_resume_all(rt_list_t *list)
+rt_inline rt_err_t rt_ipc_list_resume_all(struct rt_ipc_queue *queue)
 {
     struct rt_thread *thread;
-    register rt_ubasse_t temp;
+    register rt_ubase_t temp;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
 
     /* wakeup all suspend threads */
-    while (!rt_list_isempty(list))
+    while ((thread = rt_ipc_queue_first(queue)) != RT_NULL)
     {
-        /* disable interrupt */
-        temp = rt_hw_interrupt_disabled();
-
-        /* get next suspend thread */
-        thread = rt_list_entry(list->next, struct rt_thread, tlist);
         /* set error code to RT_ERROR */
         thread->error = -RT_ERROR;
 
@@ -139,12 +304,121 @@ rt_inline rt_err_t rt_ipc_list_resume_all(rt_list_t *list)
         rt_thread_resume(thread);
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
     }
-    
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
     return RT_EOK;
 }
 
+#if defined(RT_USING_IPC_POLL) && defined(RT_USING_EVENT)
+/* whether the bits of an event are the ones a poll waits for */
+rt_inline rt_bool_t rt_ipc_poll_match(struct rt_ipc_poll *poll, rt_uint32_t set)
+{
+    if (poll->option & RT_EVENT_FLAG_AND)
+        return (set & poll->set) == poll->set;
+
+    return (set & poll->set) != 0;
+}
+#endif
+
+/**
+ * This function will resume the threads polling an IPC object, which has
+ * become ready. It shall be invoked with interrupt disabled.
+ *
+ * @param ipc the IPC object
+ * @param set the bits of an event, only the polls waiting for them are
+ *        resumed; 0 for the other objects
+ *
+ * @return RT_TRUE if a thread is resumed
+ */
+rt_inline rt_bool_t rt_ipc_poll_resume(struct rt_ipc_object *ipc, rt_uint32_t set)
+{
+#ifdef RT_USING_IPC_POLL
+    struct rt_ipc_poll *poll;
+    rt_list_t *node;
+    rt_bool_t resumed;
+
+    resumed = RT_FALSE;
+    rt_list_for_each(node, &(ipc->poll_list))
+    {
+        poll = rt_list_entry(node, struct rt_ipc_poll, list);
+
+#ifdef RT_USING_EVENT
+        if (set != 0 && !rt_ipc_poll_match(poll, set))
+            continue;
+#endif
+
+        /* the thread checks all its objects again */
+        if ((poll->thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_SUSPEND)
+        {
+            rt_thread_resume(poll->thread);
+            resumed = RT_TRUE;
+        }
+    }
+
+    return resumed;
+#else
+    return RT_FALSE;
+#endif
+}
+
+/**
+ * This function will resume the threads polling an IPC object which is
+ * being detached, their polls of it get -RT_ERROR.
+ *
+ * @param ipc the IPC object
+ */
+rt_inline void rt_ipc_poll_detach(struct rt_ipc_object *ipc)
+{
+#ifdef RT_USING_IPC_POLL
+    struct rt_ipc_poll *poll;
+    register rt_ubase_t temp;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    while (!rt_list_isempty(&(ipc->poll_list)))
+    {
+        poll = rt_list_entry(ipc->poll_list.next, struct rt_ipc_poll, list);
+
+        /* the object is not touched by the poll any more */
+        rt_list_remove(&(poll->list));
+        poll->result = -RT_ERROR;
+
+        if ((poll->thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_SUSPEND)
+            rt_thread_resume(poll->thread);
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+#endif
+}
+
+#ifdef RT_HW_ATOMIC
+/**
+ * This function will check whether no thread polls an IPC object without
+ * disabling interrupt, as rt_ipc_queue_peek_empty does for the queue.
+ *
+ * @param ipc the IPC object
+ *
+ * @return RT_TRUE if no thread polls it
+ */
+rt_inline rt_bool_t rt_ipc_poll_peek_empty(struct rt_ipc_object *ipc)
+{
+#ifdef RT_USING_IPC_POLL
+    return rt_hw_atomic_load(&(ipc->poll_list.next)) == &(ipc->poll_list);
+#else
+    return RT_TRUE;
+#endif
+}
+#endif
+
 #ifdef RT_USING_SEMAPHORE
 /**
  * This function will initialize a semaphore and put it under control of
@@ -198,6 +472,7 @@ rt_err_t rt_sem_detach(rt_sem_t sem)
 
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(sem->parent.suspend_thread));
+    rt_ipc_poll_detach(&(sem->parent));
 
     /* detach semaphore object */
     rt_object_detach(&(sem->parent.parent));
@@ -262,6 +537,7 @@ rt_err_t rt_sem_delete(rt_sem_t sem)
 
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(sem->parent.suspend_thread));
+    rt_ipc_poll_detach(&(sem->parent));
 
     /* delete semaphore object */
     rt_object_delete(&(sem->parent.parent));
@@ -271,6 +547,32 @@ rt_err_t rt_sem_delete(rt_sem_t sem)
 RTM_EXPORT(rt_sem_delete);
 #endif /* end of RT_USING_HEAP */
 
+#ifdef RT_USING_IPC_FAST_PATH
+/**
+ * This function will decrease the value of a semaphore by compare-and-swap
+ * if it's available, interrupt may be enabled.
+ *
+ * @param sem the semaphore object
+ *
+ * @return RT_TRUE if the semaphore is taken
+ */
+rt_inline rt_bool_t _rt_sem_trydec(rt_sem_t sem)
+{
+    rt_uint16_t value;
+
+    value = rt_hw_atomic_load(&(sem->value));
+    while (value > 0)
+    {
+        if (rt_hw_atomic_cas(&(sem->value), value, value - 1))
+            return RT_TRUE;
+
+        value = rt_hw_atomic_load(&(sem->value));
+    }
+
+    return RT_FALSE;
+}
+#endif
+
 /**
  * This function will take a semaphore, if the semaphore is unavailable, the
  * thread shall wait for a specified time.
@@ -291,28 +593,43 @@ rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
 
     RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(sem->parent.parent)));
 
+#ifdef RT_USING_IPC_FAST_PATH
+    /* an available semaphore is taken without disabling interrupt */
+    if (_rt_sem_trydec(sem))
+    {
+        RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(sem->parent.parent)));
+
+        return RT_EOK;
+    }
+#endif
+
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    temp = rt_hw_interrupt_disable();
 
     RT_DEBUG_LOG(RT_DEBUG_IPC, ("thread %s take sem %s, which value is: %d\n",
                                 rt_thread_self()->name,
                                 ((struct rt_object *)sem)->name,
                                 sem->value));
 
+#ifdef RT_USING_IPC_FAST_PATH
+    if (_rt_sem_trydec(sem))
+    {
+#else
     if (sem->value > 0)
     {
         /* semaphore is available */
         sem->value --;
+#endif
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
     }
     else
     {
         /* no waiting, return with timeout */
         if (time == 0)
         {
-            rt_hw_interrupt_enabled(temp);
+            rt_hw_interrupt_enable(temp);
 
             return -RT_ETIMEOUT;
         }
@@ -335,6 +652,26 @@ rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
                                 thread,
                                 sem->parent.parent.flag);
 
+#ifdef RT_USING_IPC_FAST_PATH
+            /*
+             * a release without lock may have missed the thread, it checks
+             * the queue after the value and this checks the value again.
+             */
+            rt_hw_atomic_fence();
+            if (_rt_sem_trydec(sem))
+            {
+                /* take back the suspension */
+                rt_thread_resume(thread);
+
+                /* enable interrupt */
+                rt_hw_interrupt_enable(temp);
+
+                RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(sem->parent.parent)));
+
+                return RT_EOK;
+            }
+#endif
+
             /* has waiting time, start thread timer */
             if (time > 0)
             {
@@ -349,7 +686,7 @@ rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
             }
 
             /* enable interrupt */
-            rt_hw_interrupt_enabled(temp);
+            rt_hw_interrupt_enable(temp);
 
             /* do schedule */
             rt_schedule();
@@ -401,15 +738,50 @@ rt_err_t rt_sem_release(rt_sem_t sem)
 
     need_schedule = RT_FALSE;
 
+#ifdef RT_USING_IPC_FAST_PATH
+    if (rt_ipc_queue_peek_empty(&(sem->parent.suspend_thread)) &&
+        rt_ipc_poll_peek_empty(&(sem->parent)))
+    {
+        /* no thread waits, increase value without disabling interrupt */
+        rt_hw_atomic_add(&(sem->value), 1);
+
+        /* pairs with the fence of a thread being suspended in rt_sem_take,
+         * or starting to poll in rt_ipc_poll */
+        rt_hw_atomic_fence();
+        if (rt_ipc_queue_peek_empty(&(sem->parent.suspend_thread)) &&
+            rt_ipc_poll_peek_empty(&(sem->parent)))
+            return RT_EOK;
+
+        /* a thread was suspended meanwhile, pass the value to it */
+        temp = rt_hw_interrupt_disable();
+
+        if (!rt_ipc_queue_isempty(&(sem->parent.suspend_thread)) &&
+            _rt_sem_trydec(sem))
+        {
+            rt_ipc_list_resume(&(sem->parent.suspend_thread));
+            need_schedule = RT_TRUE;
+        }
+        else if (sem->value > 0 && rt_ipc_poll_resume(&(sem->parent), 0))
+            need_schedule = RT_TRUE;
+
+        rt_hw_interrupt_enable(temp);
+
+        if (need_schedule == RT_TRUE)
+            rt_schedule();
+
+        return RT_EOK;
+    }
+#endif
+
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    temp = rt_hw_interrupt_disable();
 
     RT_DEBUG_LOG(RT_DEBUG_IPC, ("thread %s release sem: %s, which value is: %d\n",
                                 rt_thread_self()->name,
                                 ((struct rt_object *)sem)->name,
                                 sem->value));
 
-    if (!rt_list_isempty(&(sem->parent.suspend_thread)))
+    if (!rt_ipc_queue_isempty(&(sem->parent.suspend_thread)))
     {
         /* resume the suspended thread */
         rt_ipc_list_resume(&(sem->parent.suspend_thread));
@@ -418,11 +790,19 @@ rt_err_t rt_sem_release(rt_sem_t sem)
     else
     {
         /* increase value */
+#ifdef RT_USING_IPC_FAST_PATH
+        rt_hw_atomic_add(&(sem->value), 1);
+#else
         sem->value ++;
+#endif
+
+        /* resume the threads polling it */
+        if (rt_ipc_poll_resume(&(sem->parent), 0))
+            need_schedule = RT_TRUE;
     }
 
     /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    rt_hw_interrupt_enable(temp);
 
     /* resume a thread, re-schedule */
     if (need_schedule == RT_TRUE)
@@ -457,16 +837,22 @@ rt_err_t rt_sem_control(rt_sem_t sem, int cmd, void *arg)
         value = (rt_uint32_t)arg;
 
         /* disable interrupt */
-        level = rt_hw_interrupt_disabled();
+        level = rt_hw_interrupt_disable();
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&sem->parent.suspend_thread);
 
         /* set new value */
+#ifdef RT_USING_IPC_FAST_PATH
+        rt_hw_atomic_store(&(sem->value), (rt_uint16_t)value);
+#else
         sem->value = (rt_uint16_t)value;
+#endif
+        if (value > 0)
+            rt_ipc_poll_resume(&(sem->parent), 0);
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(level);
+        rt_hw_interrupt_enable(level);
 
         rt_schedule();
 
@@ -479,60 +865,266 @@ RTM_EXPORT(rt_sem_control);
 #endif /* end of RT_USING_SEMAPHORE */
 
 #ifdef RT_USING_MUTEX
+/*
+ * Priority inheritance and priority ceiling. A mutex whose waiters or
+ * ceiling raise its owner is on the taken_object_list of the owner, and
+ * mutex->priority is the highest priority of them. These mutexes keep the
+ * priority of the owner without them in original_priority, and it runs at
+ * the highest one of it and the mutexes on its list. When the priority of a
+ * thread blocked on a mutex changes, the owner of that mutex is updated in
+ * turn, at most RT_MUTEX_INHERIT_DEPTH of them.
+ *
+ * The lists and mutex->priority are only changed with interrupt disabled.
+ * With RT_USING_IPC_FAST_PATH, a mutex on no list may be released without
+ * lock, and one which a waiter links to it meanwhile is taken off by the
+ * fix-up of rt_mutex_release.
+ */
+
 /**
- * This function will initialize a mutex and put it under control of resource
- * management.
+ * This function will get the highest priority of the waiters and the
+ * ceiling of a mutex.
  *
  * @param mutex the mutex object
- * @param name the name of mutex
- * @param flag the flag of mutex
  *
- * @return the operation status, RT_EOK on successful
+ * @return the priority, RT_UINT8_MAX if no one raises the owner
  */
-rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+static rt_uint8_t _rt_mutex_priority(rt_mutex_t mutex)
 {
-    /* parameter check */
-    RT_ASSERT(mutex != RT_NULL);
+    struct rt_thread *thread;
+    struct rt_list_node *node;
+    rt_uint8_t priority;
 
-    /* init object */
-    rt_object_init(&(mutex->parent.parent), RT_Object_Class_Mutex, name);
+    priority = mutex->ceiling_priority;
 
-    /* init ipc object */
-    rt_ipc_object_init(&(mutex->parent));
+    if (mutex->parent.parent.flag & RT_IPC_FLAG_PRIO)
+    {
+        /* the first one is of the highest priority */
+        thread = rt_ipc_queue_first(&(mutex->parent.suspend_thread));
+        if (thread != RT_NULL && thread->current_priority < priority)
+            priority = thread->current_priority;
+    }
+    else
+    {
+        rt_list_for_each(node, &(mutex->parent.suspend_thread.list[0]))
+        {
+            thread = rt_list_entry(node, struct rt_thread, tlist);
+            if (thread->current_priority < priority)
+                priority = thread->current_priority;
+        }
+    }
 
-    mutex->value = 1;
-    mutex->owner = RT_NULL;
-    mutex->original_priority = 0xFF;
-    mutex->hold  = 0;
+    return priority;
+}
 
-    /* set flag */
-    mutex->parent.parent.flag = flag;
+/**
+ * This function will change the priority of a thread, and its place in the
+ * queue of the mutex it's blocked on.
+ *
+ * @param thread the thread
+ * @param priority the new priority
+ */
+static void _rt_thread_set_priority(struct rt_thread *thread, rt_uint8_t priority)
+{
+    rt_mutex_t mutex;
 
-    return RT_EOK;
+    rt_thread_control(thread, RT_THREAD_CTRL_CHANGE_PRIORITY, &priority);
+
+    mutex = (rt_mutex_t)thread->pending_object;
+    if (mutex != RT_NULL &&
+        (thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_SUSPEND &&
+        (mutex->parent.parent.flag & RT_IPC_FLAG_PRIO))
+    {
+        rt_list_remove(&(thread->tlist));
+        rt_ipc_queue_insert(&(mutex->parent.suspend_thread),
+                            thread,
+                            mutex->parent.parent.flag);
+    }
 }
-RTM_EXPORT(rt_mutex_init);
 
 /**
- * This function will detach a mutex from resource management
- *
- * @param mutex the mutex object
+ * This function will update the priority of a thread by the mutexes on its
+ * taken_object_list.
  *
- * @return the operation status, RT_EOK on successful
+ * @param thread the thread
+ * @param mutex a mutex to take off the list first, or RT_NULL
  *
- * @see rt_mutex_delete
+ * @return RT_TRUE if the priority is changed
  */
-rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+static rt_bool_t _rt_thread_update_priority(struct rt_thread *thread, rt_mutex_t mutex)
 {
-    /* parameter check */
-    RT_ASSERT(mutex != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mutex->parent.parent) == RT_Object_Class_Mutex);
-    RT_ASSERT(rt_object_is_systemobject(&mutex->parent.parent));
+    struct rt_list_node *node, *next;
+    rt_mutex_t taken;
+    rt_uint8_t priority;
 
-    /* wakeup all suspend threads */
-    rt_ipc_list_resume_all(&(mutex->parent.suspend_thread));
+    /* not raised by any mutex */
+    if (rt_list_isempty(&(thread->taken_object_list)))
+        return RT_FALSE;
 
-    /* detach semaphore object */
-    rt_object_detach(&(mutex->parent.parent));
+    taken = rt_list_first_entry(&(thread->taken_object_list), struct rt_mutex, taken_list);
+    priority = taken->original_priority;
+
+    for (node = thread->taken_object_list.next;
+         node != &(thread->taken_object_list);
+         node = next)
+    {
+        next  = node->next;
+        taken = rt_list_entry(node, struct rt_mutex, taken_list);
+
+        if (taken == mutex)
+            rt_list_remove(node);
+        else if (taken->priority < priority)
+            priority = taken->priority;
+    }
+
+    if (priority == thread->current_priority)
+        return RT_FALSE;
+
+    _rt_thread_set_priority(thread, priority);
+
+    return RT_TRUE;
+}
+
+/**
+ * This function will update the priority of a mutex after its waiters, its
+ * ceiling or its owner changed, then the owner and the owners along the
+ * chain of mutexes they are blocked on. It shall be invoked with interrupt
+ * disabled.
+ *
+ * @param mutex the mutex object
+ */
+static void _rt_mutex_update(rt_mutex_t mutex)
+{
+    struct rt_thread *owner;
+    rt_mutex_t taken;
+    int depth;
+
+    for (depth = 0; depth < RT_MUTEX_INHERIT_DEPTH; depth ++)
+    {
+        mutex->priority = _rt_mutex_priority(mutex);
+
+        owner = mutex->owner;
+        if (owner == RT_NULL)
+            break;
+
+        if (mutex->priority == RT_UINT8_MAX)
+        {
+            /* it raises the owner no more */
+            if (!_rt_thread_update_priority(owner, mutex))
+                break;
+        }
+        else
+        {
+            if (rt_list_isempty(&(mutex->taken_list)))
+            {
+                /* keep the priority of the owner without mutexes */
+                if (rt_list_isempty(&(owner->taken_object_list)))
+                {
+                    mutex->original_priority = owner->current_priority;
+                }
+                else
+                {
+                    taken = rt_list_first_entry(&(owner->taken_object_list),
+                                                struct rt_mutex, taken_list);
+                    mutex->original_priority = taken->original_priority;
+                }
+
+                rt_list_insert_before(&(owner->taken_object_list), &(mutex->taken_list));
+            }
+
+            if (!_rt_thread_update_priority(owner, RT_NULL))
+                break;
+        }
+
+        /* the owner is blocked on another mutex, go on with that one */
+        if ((owner->stat & RT_THREAD_STAT_MASK) != RT_THREAD_SUSPEND ||
+            owner->pending_object == RT_NULL)
+            break;
+
+        mutex = (rt_mutex_t)owner->pending_object;
+    }
+}
+
+/**
+ * This function will take a mutex off the list of its owner before it's
+ * detached or deleted.
+ *
+ * @param mutex the mutex object
+ */
+static void _rt_mutex_forget(rt_mutex_t mutex)
+{
+    register rt_base_t temp;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    if (mutex->owner != RT_NULL)
+        _rt_thread_update_priority(mutex->owner, mutex);
+    rt_list_remove(&(mutex->taken_list));
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+}
+
+/**
+ * This function will initialize a mutex and put it under control of resource
+ * management.
+ *
+ * @param mutex the mutex object
+ * @param name the name of mutex
+ * @param flag the flag of mutex
+ *
+ * @return the operation status, RT_EOK on successful
+ */
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+    /* parameter check */
+    RT_ASSERT(mutex != RT_NULL);
+
+    /* init object */
+    rt_object_init(&(mutex->parent.parent), RT_Object_Class_Mutex, name);
+
+    /* init ipc object */
+    rt_ipc_object_init(&(mutex->parent));
+
+    mutex->value = 1;
+    mutex->owner = RT_NULL;
+    mutex->original_priority = 0xFF;
+    mutex->hold  = 0;
+    mutex->ceiling_priority = RT_UINT8_MAX;
+    mutex->priority = RT_UINT8_MAX;
+    rt_list_init(&(mutex->taken_list));
+
+    /* set flag */
+    mutex->parent.parent.flag = flag;
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mutex_init);
+
+/**
+ * This function will detach a mutex from resource management
+ *
+ * @param mutex the mutex object
+ *
+ * @return the operation status, RT_EOK on successful
+ *
+ * @see rt_mutex_delete
+ */
+rt_err_t rt_mutex_detach(rt_mutex_t mutex)
+{
+    /* parameter check */
+    RT_ASSERT(mutex != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mutex->parent.parent) == RT_Object_Class_Mutex);
+    RT_ASSERT(rt_object_is_systemobject(&mutex->parent.parent));
+
+    /* the owner is raised by it no more */
+    _rt_mutex_forget(mutex);
+
+    /* wakeup all suspend threads */
+    rt_ipc_list_resume_all(&(mutex->parent.suspend_thread));
+
+    /* detach semaphore object */
+    rt_object_detach(&(mutex->parent.parent));
 
     return RT_EOK;
 }
@@ -567,6 +1159,9 @@ rt_mutex_t rt_mutex_create(const char *name, rt_uint8_t flag)
     mutex->owner             = RT_NULL;
     mutex->original_priority = 0xFF;
     mutex->hold              = 0;
+    mutex->ceiling_priority  = RT_UINT8_MAX;
+    mutex->priority          = RT_UINT8_MAX;
+    rt_list_init(&(mutex->taken_list));
 
     /* set flag */
     mutex->parent.parent.flag = flag;
@@ -584,7 +1179,7 @@ RTM_EXPORT(rt_mutex_create);
  *
  * @see rt_mutex_detach
  */
-rt_err_t rt_mutex_delete(rt_mutex_ mutex)
+rt_err_t rt_mutex_delete(rt_mutex_t mutex)
 {
     RT_DEBUG_NOT_IN_INTERRUPT;
 
@@ -593,6 +1188,9 @@ rt_err_t rt_mutex_delete(rt_mutex_ mutex)
     RT_ASSERT(rt_object_get_type(&mutex->parent.parent) == RT_Object_Class_Mutex);
     RT_ASSERT(rt_object_is_systemobject(&mutex->parent.parent) == RT_FALSE);
 
+    /* the owner is raised by it no more */
+    _rt_mutex_forget(mutex);
+
     /* wakeup all suspend threads */
     rt_ipc_list_resume_all(&(mutex->parent.suspend_thread));
 
@@ -604,6 +1202,43 @@ rt_err_t rt_mutex_delete(rt_mutex_ mutex)
 RTM_EXPORT(rt_mutex_delete);
 #endif
 
+/**
+ * This function will set a thread as the owner of a mutex if it's free. With
+ * RT_USING_IPC_FAST_PATH the owner is swapped in atomically and interrupt
+ * may be enabled, otherwise it shall be invoked with interrupt disabled.
+ *
+ * The original priority is not set here: a waiter may link the mutex to the
+ * new owner as soon as it's published, and that records the priority of the
+ * owner under lock. Only the owner changes hold.
+ *
+ * @param mutex the mutex object
+ * @param thread the new owner
+ *
+ * @return RT_TRUE if the mutex is taken
+ */
+rt_inline rt_bool_t _rt_mutex_take_free(rt_mutex_t mutex, struct rt_thread *thread)
+{
+#ifdef RT_USING_IPC_FAST_PATH
+    if (!rt_hw_atomic_cas(&(mutex->owner), RT_NULL, thread))
+        return RT_FALSE;
+
+    mutex->value = 0;
+#else
+    /* The value of mutex is 1 in initial status. Therefore, if the
+     * value is great than 0, it indicates the mutex is avaible.
+     */
+    if (mutex->value == 0)
+        return RT_FALSE;
+
+    mutex->value --;
+    mutex->owner = thread;
+#endif
+
+    mutex->hold ++;
+
+    return RT_TRUE;
+}
+
 /**
  * This function will take a mutex, if the mutex is unavailable, the
  * thread shall wait for a specified time.
@@ -628,18 +1263,37 @@ rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
     /* get current thread */
     thread = rt_thread_self();
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    RT_MUTEX_HOOK_CALL(mutex, rt_object_trytake_hook, (&(mutex->parent.parent)));
+
+    /* reset thread error */
+    thread->error = RT_EOK;
+
+#ifdef RT_USING_IPC_FAST_PATH
+    /* a held or free mutex is taken without disabling interrupt */
+    if (mutex->owner == thread)
+    {
+        mutex->hold ++;
 
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mutex->parent.parent)));
+        RT_MUTEX_HOOK_CALL(mutex, rt_object_take_hook, (&(mutex->parent.parent)));
+
+        return RT_EOK;
+    }
+    if (mutex->ceiling_priority == RT_UINT8_MAX &&
+        _rt_mutex_take_free(mutex, thread))
+    {
+        RT_MUTEX_HOOK_CALL(mutex, rt_object_take_hook, (&(mutex->parent.parent)));
+
+        return RT_EOK;
+    }
+#endif
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
 
     RT_DEBUG_LOG(RT_DEBUG_IPC,
                  ("mutex take: current thread: %s, mutex value: %d, hold: %d\n",
                  thread->name, mutex->value, mutex->hold));
 
-    /* reset thread error */
-    thread->error = RT_EOK;
-
     if (mutex->owner == thread)
     {
         /* it's the same thread */
@@ -648,18 +1302,13 @@ rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
     else
     {
 __again:
-        /* The value of mutex is 1 in initial status. Therefore, if the
-         * value is great than 0, it indicates the mutex is avaible.
-         */
-        if (mutex->value > 0)
+        if (_rt_mutex_take_free(mutex, thread))
         {
-            /* mutex is available */
-            mutex->value --;
-
-            /* set mutex owner and original priority */
-            mutex->owner            = thread;
-            mutex->original_priority = thread->current_priority;
-            mutex->hold ++;
+            /* raised by the ceiling, or by the threads a release without
+             * lock has left */
+            if (mutex->ceiling_priority != RT_UINT8_MAX ||
+                !rt_ipc_queue_isempty(&(mutex->parent.suspend_thread)))
+                _rt_mutex_update(mutex);
         }
         else
         {
@@ -670,7 +1319,7 @@ __again:
                 thread->error = -RT_ETIMEOUT;
 
                 /* enable interrupt */
-                rt_hw_interrupt_enabled(temp);
+                rt_hw_interrupt_enable(temp);
 
                 return -RT_ETIMEOUT;
             }
@@ -680,26 +1329,47 @@ __again:
                 RT_DEBUG_LOG(RT_DEBUG_IPC, ("mutex_take: suspend thread: %s\n",
                                             thread->name));
 
-                /* change the owner thread priority of mutex */
-                if (thread->current_priority < mutex->ower->current_priority)
-                {
-                    /* change the owner thread priority */
-                    rt_thread_control(mutex->owner,
-                                      RT_THREAD_CTRL_CHANGE_PRORITY,
-                                      &thread->current_priority);
-                }
-
                 /* suspend current thread */
                 rt_ipc_list_suspend(&(mutex->parent.suspend_thread),
                                     thread,
                                     mutex->parent.parent.flag);
 
+#ifdef RT_USING_IPC_FAST_PATH
+                /*
+                 * a release without lock may have missed the thread, it
+                 * checks the queue after freeing the mutex and this tries
+                 * the mutex again.
+                 */
+                rt_hw_atomic_fence();
+                if (_rt_mutex_take_free(mutex, thread))
+                {
+                    /* take back the suspension */
+                    rt_thread_resume(thread);
+                    _rt_mutex_update(mutex);
+
+                    /* enable interrupt */
+                    rt_hw_interrupt_enable(temp);
+
+                    RT_MUTEX_HOOK_CALL(mutex, rt_object_take_hook, (&(mutex->parent.parent)));
+
+                    return RT_EOK;
+                }
+#endif
+
+                /*
+                 * raise the owner, and the owners of the mutexes it's blocked
+                 * on. An owner which frees it without lock meanwhile is fixed
+                 * up in rt_mutex_release.
+                 */
+                thread->pending_object = mutex;
+                _rt_mutex_update(mutex);
+
                 /* has waiting time, start thread timer */
                 if (time > 0)
                 {
                     RT_DEBUG_LOG(RT_DEBUG_IPC,
-                                 "mutex_take: start the timer of thread: %s\n",
-                                 thread->name);
+                                 ("mutex_take: start the timer of thread: %s\n",
+                                  thread->name));
 
                     /* reset the timeout of thread timer and start it */
                     rt_timer_control(&(thread->thread_timer),
@@ -709,16 +1379,27 @@ __again:
                 }
 
                 /* enable interrupt */
-                rt_hw_interrupt_enabled(temp);
+                rt_hw_interrupt_enable(temp);
 
                 /* do schedule */
                 rt_schedule();
 
                 if (thread->error != RT_EOK)
                 {
+                    /* disable interrupt */
+                    temp = rt_hw_interrupt_disable();
+
+                    /* it raises the owners no more, unless the mutex is gone */
+                    thread->pending_object = RT_NULL;
+                    if (thread->error != -RT_ERROR)
+                        _rt_mutex_update(mutex);
+
                     /* interrupt by signal, try it again */
                     if (thread->error == -RT_EINTR) goto __again;
 
+                    /* enable interrupt */
+                    rt_hw_interrupt_enable(temp);
+
                     /* return error */
                     return thread->error;
                 }
@@ -726,16 +1407,16 @@ __again:
                 {
                     /* the mutex is taken successfully. */
                     /* disable interrupt */
-                    temp = rt_hw_interrupt_disabled();
+                    temp = rt_hw_interrupt_disable();
                 }
             }
         }
     }
 
     /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    rt_hw_interrupt_enable(temp);
 
-    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mutex->parent.parent)));
+    RT_MUTEX_HOOK_CALL(mutex, rt_object_take_hook, (&(mutex->parent.parent)));
 
     return RT_EOK;
 }
@@ -767,59 +1448,111 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
     /* get current thread */
     thread = rt_thread_self();
 
+    RT_MUTEX_HOOK_CALL(mutex, rt_object_put_hook, (&(mutex->parent.parent)));
+
+#ifdef RT_USING_IPC_FAST_PATH
+    if (thread == mutex->owner && mutex->hold > 1)
+    {
+        /* only the owner changes hold */
+        mutex->hold --;
+
+        return RT_EOK;
+    }
+
+    if (thread == mutex->owner &&
+        rt_list_isempty(&(mutex->taken_list)) &&
+        rt_ipc_queue_peek_empty(&(mutex->parent.suspend_thread)))
+    {
+        /* it raises nobody and no thread waits, free it without disabling
+         * interrupt */
+        mutex->hold  = 0;
+        mutex->value = 1;
+        rt_hw_atomic_store(&(mutex->owner), RT_NULL);
+
+        /* pairs with the fence of a thread being suspended in rt_mutex_take */
+        rt_hw_atomic_fence();
+        if (rt_ipc_queue_peek_empty(&(mutex->parent.suspend_thread)))
+            return RT_EOK;
+
+        /* a thread was suspended meanwhile, which may have raised it */
+        temp = rt_hw_interrupt_disable();
+
+        if (_rt_thread_update_priority(thread, mutex))
+            need_schedule = RT_TRUE;
+
+        /* pass the mutex to the first one unless another thread has taken it */
+        thread = rt_ipc_queue_first(&(mutex->parent.suspend_thread));
+        if (thread != RT_NULL && _rt_mutex_take_free(mutex, thread))
+        {
+            thread->pending_object = RT_NULL;
+            rt_ipc_list_resume(&(mutex->parent.suspend_thread));
+            need_schedule = RT_TRUE;
+        }
+
+        /* the owner is raised by the threads left */
+        _rt_mutex_update(mutex);
+
+        rt_hw_interrupt_enable(temp);
+
+        if (need_schedule == RT_TRUE)
+            rt_schedule();
+
+        return RT_EOK;
+    }
+#endif
+
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    temp = rt_hw_interrupt_disable();
 
     RT_DEBUG_LOG(RT_DEBUG_IPC,
                  ("mutex_release: current thread %s, mutex value: %d, hold: %d\n",
                   thread->name, mutex->value, mutex->hold));
 
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mutex->parent.parent)));
-
     /* mutex only can be released by owner */
     if (thread != mutex->owner)
     {
         thread->error = -RT_ERROR;
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
         return -RT_ERROR;
     }
 
     /* decrease hold */
-    if (thread->hold > 0) thread->hold --;
+    mutex->hold --;
     /* if no hold */
     if (mutex->hold == 0)
     {
-        /* change the owner thread to original priority */
-        if (mutex->original_priority != mutex->current_priority)
-        {
-            rt_thread_control(mutex->owner,
-                              RT_THREAD_CTRL_CHANGE_PRORITY,
-                              &(mutex->original_priority));
-        }
+        /* change the owner thread to the priority without this mutex */
+        if (!rt_list_isempty(&(mutex->taken_list)) &&
+            _rt_thread_update_priority(thread, mutex))
+            need_schedule = RT_TRUE;
 
         /* wakeup suspended thread */
-        if (!rt_list_isempty(&mutex->parent.suspend_thread))
+        thread = rt_ipc_queue_first(&(mutex->parent.suspend_thread));
+        if (thread != RT_NULL)
         {
-            /* get suspended thread */
-            thread = rt_list_entry(mutex->parent.suspend_thread.next,
-                                   struct rt_thread,
-                                   tlist);
-
             RT_DEBUG_LOG(RT_DEBUG_IPC, ("mutex_release: resume thread: %s\n",
                                         thread->name));
 
             /* set new owner and priority */
+#ifdef RT_USING_IPC_FAST_PATH
+            rt_hw_atomic_store(&(mutex->owner), thread);
+#else
             mutex->owner             = thread;
+#endif
             mutex->original_priority = thread->current_priority;
             mutex->hold ++;
 
             /* resume thread */
+            thread->pending_object = RT_NULL;
             rt_ipc_list_resume(&(mutex->parent.suspend_thread));
 
-           need_schedule = RT_TRUE; 
+            /* the new owner is raised by the threads left */
+            _rt_mutex_update(mutex);
+
+            need_schedule = RT_TRUE;
         }
         else
         {
@@ -827,16 +1560,20 @@ rt_err_t rt_mutex_release(rt_mutex_t mutex)
             mutex->value ++;
 
             /* clear owner */
-            mutex->owner = RT_NULL;
             mutex->original_priority = 0xff;
+#ifdef RT_USING_IPC_FAST_PATH
+            rt_hw_atomic_store(&(mutex->owner), RT_NULL);
+#else
+            mutex->owner = RT_NULL;
+#endif
         }
     }
 
     /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    rt_hw_interrupt_enable(temp);
 
     /* perform a schedule */
-    if (need_schedule = RT_TRUE)
+    if (need_schedule == RT_TRUE)
         rt_schedule();
 
     return RT_EOK;
@@ -861,72 +1598,786 @@ rt_err_t rt_mutex_control(rt_mutex_t mutex, int cmd, void *arg)
     return -RT_ERROR;
 }
 RTM_EXPORT(rt_mutex_control);
-#endif /* end of RT_USING_MUTEX */
 
-#ifdef RT_USING_EVENT
 /**
- * This function will initialize an event and put it under control of resource
- * management.
+ * This function will set the priority ceiling of a mutex. The owner runs at
+ * the ceiling at least, so a thread which only takes the mutex at a
+ * priority not higher than the ceiling won't be blocked by a thread of
+ * priority between them.
  *
- * @param event the event object
- * @param name the name of event
- * @param flag the flag of event
+ * @param mutex the mutex object
+ * @param priority the priority ceiling, RT_UINT8_MAX for none
  *
- * @return the operation status, RT_EOK on successful
+ * @return the old priority ceiling
  */
-rt_err_t rt_event_init(rt_event_t event, const char *name, rt_uint8_t flag)
+rt_uint8_t rt_mutex_setprioceiling(rt_mutex_t mutex, rt_uint8_t priority)
 {
+    register rt_base_t temp;
+    rt_uint8_t old_priority;
+
     /* parameter check */
-    RT_ASSERT(event != RT_NULL);
+    RT_ASSERT(mutex != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mutex->parent.parent) == RT_Object_Class_Mutex);
+    RT_ASSERT(priority < RT_THREAD_PRIORITY_MAX || priority == RT_UINT8_MAX);
 
-    /* init object */
-    rt_object_init(&(event->parent.parent), RT_Object_Class_Event);
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
 
-    /* set parent flag */
-    event->parent.parent.flag = flag;
+    old_priority = mutex->ceiling_priority;
+    mutex->ceiling_priority = priority;
 
-    /* init ipc object */
-    rt_ipc_object_init(&(event.parent));
+    /* raise or lower the owner */
+    _rt_mutex_update(mutex);
 
-    /* init event */
-    event->set = 0;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
 
-    return RT_EOK;
+    rt_schedule();
+
+    return old_priority;
 }
-RTM_EXPORT(rt_event_init);
+RTM_EXPORT(rt_mutex_setprioceiling);
 
 /**
- * This function will detach an event object from resource management
+ * This function will get the priority ceiling of a mutex.
  *
- * @param event the event object
+ * @param mutex the mutex object
  *
- * @return the operation status, RT_EOK on successful
+ * @return the priority ceiling, RT_UINT8_MAX for none
  */
-rt_err_t rt_event_detach(rt_event_t event)
+rt_uint8_t rt_mutex_getprioceiling(rt_mutex_t mutex)
 {
     /* parameter check */
-    RT_ASSERT(event != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&event->parent.parent) == RT_Object_Class_Event);
-    RT_ASSERT(rt_object_is_systemobject(&event->parent.parent));
+    RT_ASSERT(mutex != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mutex->parent.parent) == RT_Object_Class_Mutex);
 
-    /* resume all suspended thread */
-    rt_ipc_list_resume_all(&(event->parent.suspend_thread));
+    return mutex->ceiling_priority;
+}
+RTM_EXPORT(rt_mutex_getprioceiling);
+#endif /* end of RT_USING_MUTEX */
 
-    /* detach event object */
-    rt_object_detach(&(event->parent.parent));
+#ifdef RT_USING_RWLOCK
+/*
+ * initialize the mutex of the writer, which is a part of the rwlock and not
+ * an object of its own, so it's not found by name nor listed
+ */
+static void _rt_rwlock_mutex_init(rt_mutex_t mutex, const char *name, rt_uint8_t flag)
+{
+    /* the object is kept off the object list */
+    mutex->parent.parent.type = RT_Object_Class_Mutex | RT_Object_Class_Static;
+    mutex->parent.parent.flag = flag | RT_IPC_FLAG_INNER;
+    rt_strncpy(mutex->parent.parent.name, name, RT_NAME_MAX);
+    rt_list_init(&(mutex->parent.parent.list));
 
-    return RT_EOK;
+    /* init ipc object */
+    rt_ipc_object_init(&(mutex->parent));
+
+    mutex->value = 1;
+    mutex->owner = RT_NULL;
+    mutex->original_priority = 0xFF;
+    mutex->hold  = 0;
+    mutex->ceiling_priority = RT_UINT8_MAX;
+    mutex->priority = RT_UINT8_MAX;
+    rt_list_init(&(mutex->taken_list));
+}
+
+/* detach the mutex of the writer with the rwlock */
+static void _rt_rwlock_mutex_detach(rt_mutex_t mutex)
+{
+    /* the owner is raised by it no more */
+    _rt_mutex_forget(mutex);
+
+    /* wakeup all suspend threads */
+    rt_ipc_list_resume_all(&(mutex->parent.suspend_thread));
+
+    mutex->parent.parent.type = 0;
 }
-RTM_EXPORT(rt_event_detach);
 
-#ifdef RT_USING_HEAP
 /**
- * This function will create an event object from system resource
+ * This function will initialize a rwlock and put it under control of
+ * resource management.
  *
- * @param name the name of event
- * @param flag the flag of event
+ * @param rwlock the rwlock object
+ * @param name the name of rwlock
+ * @param flag the flag of rwlock, the order of the blocked readers and writers
  *
- * @return the created event, RT_NULL on error happen
+ * @return the operation status, RT_EOK on successful
+ */
+rt_err_t rt_rwlock_init(rt_rwlock_t rwlock, const char *name, rt_uint8_t flag)
+{
+    /* parameter check */
+    RT_ASSERT(rwlock != RT_NULL);
+
+    /* init object */
+    rt_object_init(&(rwlock->parent.parent), RT_Object_Class_RWLock, name);
+
+    /* init ipc object */
+    rt_ipc_object_init(&(rwlock->parent));
+
+    /* init the mutex of the writer */
+    _rt_rwlock_mutex_init(&(rwlock->lock), name, flag);
+
+    rwlock->readers  = 0;
+    rwlock->reserved = 0;
+
+    /* set flag */
+    rwlock->parent.parent.flag = flag;
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_rwlock_init);
+
+/**
+ * This function will detach a rwlock from resource management
+ *
+ * @param rwlock the rwlock object
+ *
+ * @return the operation status, RT_EOK on successful
+ *
+ * @see rt_rwlock_delete
+ */
+rt_err_t rt_rwlock_detach(rt_rwlock_t rwlock)
+{
+    /* parameter check */
+    RT_ASSERT(rwlock != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&rwlock->parent.parent) == RT_Object_Class_RWLock);
+    RT_ASSERT(rt_object_is_systemobject(&rwlock->parent.parent));
+
+    /* wakeup the writer waiting for the readers, and the blocked threads */
+    rt_ipc_list_resume_all(&(rwlock->parent.suspend_thread));
+    _rt_rwlock_mutex_detach(&(rwlock->lock));
+
+    /* detach rwlock object */
+    rt_object_detach(&(rwlock->parent.parent));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_rwlock_detach);
+
+#ifdef RT_USING_HEAP
+/**
+ * This function will create a rwlock from system resource
+ *
+ * @param name the name of rwlock
+ * @param flag the flag of rwlock
+ *
+ * @return the created rwlock, RT_NULL on error happen
+ *
+ * @see rt_rwlock_init
+ */
+rt_rwlock_t rt_rwlock_create(const char *name, rt_uint8_t flag)
+{
+    struct rt_rwlock *rwlock;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    /* allocate object */
+    rwlock = (rt_rwlock_t)rt_object_allocate(RT_Object_Class_RWLock, name);
+    if (rwlock == RT_NULL)
+        return rwlock;
+
+    /* init ipc object */
+    rt_ipc_object_init(&(rwlock->parent));
+
+    /* init the mutex of the writer */
+    _rt_rwlock_mutex_init(&(rwlock->lock), name, flag);
+
+    rwlock->readers  = 0;
+    rwlock->reserved = 0;
+
+    /* set flag */
+    rwlock->parent.parent.flag = flag;
+
+    return rwlock;
+}
+RTM_EXPORT(rt_rwlock_create);
+
+/**
+ * This function will delete a rwlock object and release the memory
+ *
+ * @param rwlock the rwlock object
+ *
+ * @return the error code
+ *
+ * @see rt_rwlock_detach
+ */
+rt_err_t rt_rwlock_delete(rt_rwlock_t rwlock)
+{
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    /* parameter check */
+    RT_ASSERT(rwlock != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&rwlock->parent.parent) == RT_Object_Class_RWLock);
+    RT_ASSERT(rt_object_is_systemobject(&rwlock->parent.parent) == RT_FALSE);
+
+    /* wakeup the writer waiting for the readers, and the blocked threads */
+    rt_ipc_list_resume_all(&(rwlock->parent.suspend_thread));
+    _rt_rwlock_mutex_detach(&(rwlock->lock));
+
+    /* delete rwlock object */
+    rt_object_delete(&(rwlock->parent.parent));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_rwlock_delete);
+#endif
+
+rt_inline rt_uint16_t _rt_rwlock_readers(rt_rwlock_t rwlock)
+{
+#ifdef RT_USING_IPC_FAST_PATH
+    return rt_hw_atomic_load(&(rwlock->readers));
+#else
+    return rwlock->readers;
+#endif
+}
+
+/**
+ * This function will count a reader out of a rwlock, the last one lets the
+ * writer waiting in.
+ *
+ * @param rwlock the rwlock object
+ */
+static void _rt_rwlock_read_leave(rt_rwlock_t rwlock)
+{
+    register rt_base_t temp;
+    rt_bool_t need_schedule;
+
+    need_schedule = RT_FALSE;
+
+#ifdef RT_USING_IPC_FAST_PATH
+    if (rt_hw_atomic_sub(&(rwlock->readers), 1) != 1)
+        return;
+
+    /* pairs with the fence of the writer being suspended in
+     * rt_rwlock_take_write */
+    rt_hw_atomic_fence();
+    if (rt_ipc_queue_peek_empty(&(rwlock->parent.suspend_thread)))
+        return;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+#else
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    rwlock->readers --;
+#endif
+
+    if (_rt_rwlock_readers(rwlock) == 0 &&
+        !rt_ipc_queue_isempty(&(rwlock->parent.suspend_thread)))
+    {
+        rt_ipc_list_resume(&(rwlock->parent.suspend_thread));
+        need_schedule = RT_TRUE;
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    if (need_schedule == RT_TRUE)
+        rt_schedule();
+}
+
+/**
+ * This function will count a reader into a rwlock if no writer holds the
+ * mutex. With RT_USING_IPC_FAST_PATH no interrupt is disabled.
+ *
+ * @param rwlock the rwlock object
+ *
+ * @return RT_TRUE if the reader is in
+ */
+static rt_bool_t _rt_rwlock_read_enter(rt_rwlock_t rwlock)
+{
+#ifdef RT_USING_IPC_FAST_PATH
+    rt_hw_atomic_add(&(rwlock->readers), 1);
+
+    /* pairs with the fence of a writer, which takes the mutex and then
+     * checks the readers */
+    rt_hw_atomic_fence();
+    if (rt_hw_atomic_load(&(rwlock->lock.owner)) == RT_NULL)
+        return RT_TRUE;
+
+    /* a writer has come, and may be waiting for this one */
+    _rt_rwlock_read_leave(rwlock);
+
+    return RT_FALSE;
+#else
+    register rt_base_t temp;
+    rt_bool_t entered;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    entered = (rwlock->lock.owner == RT_NULL);
+    if (entered)
+        rwlock->readers ++;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    return entered;
+#endif
+}
+
+/**
+ * This function will take a rwlock for read. The readers get it together
+ * while no writer holds it or waits for the readers to leave, otherwise a
+ * reader is blocked on the mutex of the writer and raises the writer.
+ *
+ * @param rwlock the rwlock object
+ * @param time the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_rwlock_take_read(rt_rwlock_t rwlock, rt_int32_t time)
+{
+#ifndef RT_USING_IPC_FAST_PATH
+    register rt_base_t temp;
+#endif
+    rt_err_t result;
+
+    /* this function must not be used in interrupt even if time = 0 */
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    /* parameter check */
+    RT_ASSERT(rwlock != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&rwlock->parent.parent) == RT_Object_Class_RWLock);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(rwlock->parent.parent)));
+
+    if (_rt_rwlock_read_enter(rwlock) == RT_FALSE)
+    {
+        /* wait for the writer, the readers get the mutex in turn */
+        result = rt_mutex_take(&(rwlock->lock), time);
+        if (result != RT_EOK)
+            return result;
+
+        /* the writer itself takes it again as a writer */
+        if (rwlock->lock.hold == 1)
+        {
+#ifdef RT_USING_IPC_FAST_PATH
+            rt_hw_atomic_add(&(rwlock->readers), 1);
+#else
+            temp = rt_hw_interrupt_disable();
+            rwlock->readers ++;
+            rt_hw_interrupt_enable(temp);
+#endif
+            rt_mutex_release(&(rwlock->lock));
+        }
+    }
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(rwlock->parent.parent)));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_rwlock_take_read);
+
+/**
+ * This function will take a rwlock for write. The writer takes the mutex,
+ * which keeps the new readers out, and then waits for the readers in to
+ * leave. The readers and writers blocked on the mutex raise the writer as
+ * on the owner of a mutex, the readers in are not raised.
+ *
+ * @param rwlock the rwlock object
+ * @param time the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_rwlock_take_write(rt_rwlock_t rwlock, rt_int32_t time)
+{
+    register rt_base_t temp;
+    struct rt_thread *thread;
+    rt_tick_t tick;
+    rt_err_t result;
+
+    /* this function must not be used in interrupt even if time = 0 */
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    /* parameter check */
+    RT_ASSERT(rwlock != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&rwlock->parent.parent) == RT_Object_Class_RWLock);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(rwlock->parent.parent)));
+
+    tick = rt_tick_get();
+    result = rt_mutex_take(&(rwlock->lock), time);
+    if (result != RT_EOK)
+        return result;
+
+    /* get current thread */
+    thread = rt_thread_self();
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+#ifdef RT_USING_IPC_FAST_PATH
+    /* pairs with the fence of a reader counting itself in */
+    rt_hw_atomic_fence();
+#endif
+    while (_rt_rwlock_readers(rwlock) != 0)
+    {
+        /* the time left after the mutex */
+        if (time > 0)
+        {
+            time -= (rt_int32_t)(rt_tick_get() - tick);
+            tick  = rt_tick_get();
+            if (time <= 0)
+                time = 0;
+        }
+
+        /* no waiting, return with timeout */
+        if (time == 0)
+        {
+            thread->error = -RT_ETIMEOUT;
+
+            /* enable interrupt */
+            rt_hw_interrupt_enable(temp);
+
+            rt_mutex_release(&(rwlock->lock));
+
+            return -RT_ETIMEOUT;
+        }
+
+        /* only the writer holding the mutex waits here */
+        thread->error = RT_EOK;
+        rt_ipc_list_suspend(&(rwlock->parent.suspend_thread),
+                            thread,
+                            RT_IPC_FLAG_FIFO);
+
+#ifdef RT_USING_IPC_FAST_PATH
+        /* the last reader leaving without lock may have missed the writer */
+        rt_hw_atomic_fence();
+        if (rt_hw_atomic_load(&(rwlock->readers)) == 0)
+        {
+            /* take back the suspension */
+            rt_thread_resume(thread);
+
+            break;
+        }
+#endif
+
+        /* has waiting time, start thread timer */
+        if (time > 0)
+        {
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &time);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        /* do schedule */
+        rt_schedule();
+
+        /* the rwlock is gone, and the mutex with it */
+        if (thread->error == -RT_ERROR)
+            return -RT_ERROR;
+
+        /* woken by the last reader or by signal, check the readers again */
+        if (thread->error != RT_EOK && thread->error != -RT_EINTR)
+        {
+            result = thread->error;
+            rt_mutex_release(&(rwlock->lock));
+
+            return result;
+        }
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(rwlock->parent.parent)));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_rwlock_take_write);
+
+/**
+ * This function will release a rwlock taken for read or for write. The last
+ * reader lets the writer waiting in, and a writer passes the mutex on to the
+ * readers and writers blocked on it.
+ *
+ * @param rwlock the rwlock object
+ *
+ * @return the error code
+ */
+rt_err_t rt_rwlock_release(rt_rwlock_t rwlock)
+{
+    /* only thread could release rwlock because we need test the ownership */
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    /* parameter check */
+    RT_ASSERT(rwlock != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&rwlock->parent.parent) == RT_Object_Class_RWLock);
+
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(rwlock->parent.parent)));
+
+    /* the writer holds the mutex */
+    if (rwlock->lock.owner == rt_thread_self())
+        return rt_mutex_release(&(rwlock->lock));
+
+    /* not taken */
+    if (_rt_rwlock_readers(rwlock) == 0)
+        return -RT_ERROR;
+
+    _rt_rwlock_read_leave(rwlock);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_rwlock_release);
+#endif /* end of RT_USING_RWLOCK */
+
+#ifdef RT_USING_EVENT
+#ifdef RT_USING_EVENT_INDEX
+/*
+ * The threads waiting on an event are indexed by the bits they wait for, so
+ * rt_event_send only visits the threads which the bits sent may satisfy:
+ * - a RT_EVENT_FLAG_AND thread, or a RT_EVENT_FLAG_OR thread of one bit, is
+ *   on the list of a bit it waits for and which is not set. It can't be
+ *   satisfied before this bit is sent, then it's resumed or moved to the
+ *   list of another bit still missing;
+ * - a RT_EVENT_FLAG_OR thread of several bits is on the or_thread list, which
+ *   is visited when the bits sent are in or_set.
+ * The threads satisfied are taken off first and then resumed in the order of
+ * the event, the priority order for RT_IPC_FLAG_PRIO, so a thread clearing
+ * the bits takes them from the lower priority ones as without the index.
+ */
+static void _rt_event_list_insert(rt_list_t *list, struct rt_thread *thread, rt_uint8_t flag)
+{
+    struct rt_list_node *n;
+    struct rt_thread *sthread;
+
+    if (flag & RT_IPC_FLAG_PRIO)
+    {
+        /* find a suitable position */
+        for (n = list->next; n != list; n = n->next)
+        {
+            sthread = rt_list_entry(n, struct rt_thread, tlist);
+
+            if (thread->current_priority < sthread->current_priority)
+                break;
+        }
+
+        /* insert this thread before the sthread, or at the end of list */
+        rt_list_insert_before(n, &(thread->tlist));
+    }
+    else
+    {
+        rt_list_insert_before(list, &(thread->tlist));
+    }
+}
+
+/* whether the event set satisfies a thread, which is not resumed */
+static rt_bool_t _rt_event_satisfied(rt_event_t event, struct rt_thread *thread)
+{
+    if (thread->event_info & RT_EVENT_FLAG_AND)
+        return (thread->event_set & event->set) == thread->event_set;
+
+    if (thread->event_info & RT_EVENT_FLAG_OR)
+        return (thread->event_set & event->set) != 0;
+
+    return RT_FALSE;
+}
+
+static void _rt_event_index(rt_event_t event, struct rt_thread *thread)
+{
+    rt_uint32_t missing;
+
+    if (!(thread->event_info & RT_EVENT_FLAG_AND) &&
+        (thread->event_set & (thread->event_set - 1)) != 0)
+    {
+        event->or_set |= thread->event_set;
+        _rt_event_list_insert(&(event->or_thread), thread, event->parent.parent.flag);
+    }
+    else
+    {
+        missing = thread->event_set & ~event->set;
+        RT_ASSERT(missing != 0);
+
+        _rt_event_list_insert(&(event->bit_thread[__rt_ffs(missing) - 1]),
+                              thread, event->parent.parent.flag);
+    }
+}
+#endif
+
+/* initialize the suspended threads of event */
+static void _rt_event_wait_init(rt_event_t event)
+{
+#ifdef RT_USING_EVENT_INDEX
+    rt_ubase_t index;
+
+    for (index = 0; index < 32; index ++)
+        rt_list_init(&(event->bit_thread[index]));
+    rt_list_init(&(event->or_thread));
+    event->or_set = 0;
+#endif
+}
+
+/* suspend the current thread on event, with event_set and event_info filled */
+static void _rt_event_wait(rt_event_t event, struct rt_thread *thread)
+{
+#ifdef RT_USING_EVENT_INDEX
+    rt_thread_suspend(thread);
+    _rt_event_index(event, thread);
+#else
+    rt_ipc_list_suspend(&(event->parent.suspend_thread),
+                        thread,
+                        event->parent.parent.flag);
+#endif
+}
+
+/* resume all suspended threads of event */
+static void _rt_event_wait_resume_all(rt_event_t event)
+{
+#ifdef RT_USING_EVENT_INDEX
+    register rt_ubase_t temp;
+    struct rt_thread *thread;
+    rt_list_t *list;
+    rt_ubase_t index;
+
+    for (index = 0; index <= 32; index ++)
+    {
+        list = index < 32 ? &(event->bit_thread[index]) : &(event->or_thread);
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        while (!rt_list_isempty(list))
+        {
+            thread = rt_list_entry(list->next, struct rt_thread, tlist);
+            /* set error code to RT_ERROR */
+            thread->error = -RT_ERROR;
+
+            rt_thread_resume(thread);
+
+            /* enable interrupt */
+            rt_hw_interrupt_enable(temp);
+
+            /* disable interrupt */
+            temp = rt_hw_interrupt_disable();
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+    }
+#else
+    rt_ipc_list_resume_all(&(event->parent.suspend_thread));
+#endif
+}
+
+/*
+ * This function will resume a thread suspended on event if the event set
+ * satisfies it, which shall be invoked with interrupt disabled.
+ *
+ * @return RT_TRUE if the thread is resumed
+ */
+static rt_bool_t _rt_event_resume(rt_event_t event, struct rt_thread *thread)
+{
+    register rt_base_t status;
+
+    status = -RT_ERROR;
+    if (thread->event_info & RT_EVENT_FLAG_AND)
+    {
+        if ((thread->event_set & event->set) == thread->event_set)
+        {
+            /* received an AND event */
+            status = RT_EOK;
+        }
+    }
+    else if (thread->event_info & RT_EVENT_FLAG_OR)
+    {
+        if (thread->event_set & event->set)
+        {
+            /* save recieved event set */
+            thread->event_set = thread->event_set & event->set;
+
+            /* received an OR event */
+            status = RT_EOK;
+        }
+    }
+
+    if (status != RT_EOK)
+        return RT_FALSE;
+
+    /* clear event */
+    if (thread->event_info & RT_EVENT_FLAG_CLEAR)
+        event->set &= ~thread->event_set;
+
+    /* resume thread, and thread list breaks out */
+    rt_thread_resume(thread);
+
+    return RT_TRUE;
+}
+
+/**
+ * This function will initialize an event and put it under control of resource
+ * management.
+ *
+ * @param event the event object
+ * @param name the name of event
+ * @param flag the flag of event
+ *
+ * @return the operation status, RT_EOK on successful
+ */
+rt_err_t rt_event_init(rt_event_t event, const char *name, rt_uint8_t flag)
+{
+    /* parameter check */
+    RT_ASSERT(event != RT_NULL);
+
+    /* init object */
+    rt_object_init(&(event->parent.parent), RT_Object_Class_Event, name);
+
+    /* set parent flag */
+    event->parent.parent.flag = flag;
+
+    /* init ipc object */
+    rt_ipc_object_init(&(event->parent));
+    _rt_event_wait_init(event);
+
+    /* init event */
+    event->set = 0;
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_event_init);
+
+/**
+ * This function will detach an event object from resource management
+ *
+ * @param event the event object
+ *
+ * @return the operation status, RT_EOK on successful
+ */
+rt_err_t rt_event_detach(rt_event_t event)
+{
+    /* parameter check */
+    RT_ASSERT(event != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&event->parent.parent) == RT_Object_Class_Event);
+    RT_ASSERT(rt_object_is_systemobject(&event->parent.parent));
+
+    /* resume all suspended thread */
+    _rt_event_wait_resume_all(event);
+    rt_ipc_poll_detach(&(event->parent));
+
+    /* detach event object */
+    rt_object_detach(&(event->parent.parent));
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_event_detach);
+
+#ifdef RT_USING_HEAP
+/**
+ * This function will create an event object from system resource
+ *
+ * @param name the name of event
+ * @param flag the flag of event
+ *
+ * @return the created event, RT_NULL on error happen
  */
 rt_event_t rt_event_create(const char *name, rt_uint8_t flag)
 {
@@ -940,10 +2391,11 @@ rt_event_t rt_event_create(const char *name, rt_uint8_t flag)
         return event;
 
     /* set parent */
-    event.parent.parent.flag = flag;
+    event->parent.parent.flag = flag;
 
     /* init ipc object */
     rt_ipc_object_init(&(event->parent));
+    _rt_event_wait_init(event);
 
     /* init event */
     event->set = 0;
@@ -969,10 +2421,11 @@ rt_err_t rt_event_delete(rt_event_t event)
     RT_DEBUG_NOT_IN_INTERRUPT;
 
     /* resume all suspended thread */
-    rt_ipc_list_resume_all(&(event.parent.suspend_thread));
+    _rt_event_wait_resume_all(event);
+    rt_ipc_poll_detach(&(event->parent));
 
     /* delete event object */
-    rt_object_delete(&(event.parent.parent));
+    rt_object_delete(&(event->parent.parent));
 
     return RT_EOK;
 }
@@ -988,12 +2441,19 @@ RTM_EXPORT(rt_event_delete);
  *
  * @return the error code
  */
-rt_err_t rt_event_send(rt_event_t event, rt_int32_t set)
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set)
 {
     struct rt_list_node *n;
+    rt_list_t *list;
     struct rt_thread *thread;
     register rt_ubase_t level;
-    register rt_base_t status;
+#ifdef RT_USING_EVENT_INDEX
+    rt_uint32_t bits, or_set, missing;
+    rt_ubase_t bit;
+    rt_list_t ready;
+#else
+    rt_ubase_t index;
+#endif
     rt_bool_t need_schedule;
 
     /* parameter check */
@@ -1006,64 +2466,129 @@ rt_err_t rt_event_send(rt_event_t event, rt_int32_t set)
     need_schedule = RT_FALSE;
 
     /* disable interrupt */
-    level = rt_hw_interrupt_disabled();
+    level = rt_hw_interrupt_disable();
 
     /* set event */
     event->set |= set;
 
     RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(event->parent.parent)));
 
-    if (!rt_list_isempty(&event->parent.suspend_thread))
+#ifdef RT_USING_EVENT_INDEX
+    rt_list_init(&ready);
+
+    /* visit the threads waiting for the bits sent, bit by bit */
+    for (bits = set; bits != 0; bits &= ~(1UL << bit))
     {
-        /* search thread list to resume thread */
-        n = event->parent.suspend_thread.next;
-        while(n != &(event->parent.suspend_thread))
+        bit  = __rt_ffs(bits) - 1;
+        list = &(event->bit_thread[bit]);
+
+        n = list->next;
+        while (n != list)
         {
             /* get thread */
             thread = rt_list_entry(n, struct rt_thread, tlist);
 
-            status = -RT_ERROR;
-            if (thread->event_info & RT_EVENT_FLAG_AND)
+            /* move node to the next */
+            n = n->next;
+
+            if (_rt_event_satisfied(event, thread) == RT_TRUE)
             {
-                if ((thread->event_set & event->set) == thread->event_set)
-                {
-                    /* received an AND event */
-                    status = RT_EOK;
-                }
+                rt_list_remove(&(thread->tlist));
+                _rt_event_list_insert(&ready, thread, event->parent.parent.flag);
+                continue;
             }
-            else if (thread->event_info & RT_EVENT_FLAG_OR)
-            {
-                if (thread->event_set & event->set)
-                {
-                    /* save recieved event set */
-                    thread->event_set = thread->event_set & event->set;
 
-                    /* received an OR event */
-                    status = RT_EOK;
-                }
+            /* still missing some bits, wait for the first one of them */
+            missing = thread->event_set & ~event->set;
+            if (__rt_ffs(missing) - 1 != bit)
+            {
+                rt_list_remove(&(thread->tlist));
+                _rt_event_list_insert(&(event->bit_thread[__rt_ffs(missing) - 1]),
+                                      thread, event->parent.parent.flag);
             }
+        }
+    }
+
+    if (set & event->or_set)
+    {
+        /* the bits of the threads left */
+        or_set = 0;
+
+        list = &(event->or_thread);
+        n = list->next;
+        while (n != list)
+        {
+            /* get thread */
+            thread = rt_list_entry(n, struct rt_thread, tlist);
 
             /* move node to the next */
             n = n->next;
 
-            /* condition is satisfied, resume thread */
-            if (status == RT_EOK)
+            if (_rt_event_satisfied(event, thread) == RT_TRUE)
             {
-                /* clear event */
-                if (thread->event_info & RT_EVENT_FLAG_CLEAR)
-                    event->set &= ~thread->event_set;
+                rt_list_remove(&(thread->tlist));
+                _rt_event_list_insert(&ready, thread, event->parent.parent.flag);
+            }
+            else
+            {
+                or_set |= thread->event_set;
+            }
+        }
 
-                /* resume thread, and thread list breaks out */
-                rt_thread_resume(thread);
+        event->or_set = or_set;
+    }
+
+    /* resume them in order, a thread whose bits are cleared by one before
+     * waits again */
+    while (!rt_list_isempty(&ready))
+    {
+        thread = rt_list_entry(ready.next, struct rt_thread, tlist);
+
+        if (_rt_event_resume(event, thread) == RT_TRUE)
+        {
+            /* need do a scheduling */
+            need_schedule = RT_TRUE;
+        }
+        else
+        {
+            rt_list_remove(&(thread->tlist));
+            _rt_event_index(event, thread);
+        }
+    }
+#else
+    if (!rt_ipc_queue_isempty(&(event->parent.suspend_thread)))
+    {
+        /* search thread lists to resume thread, the first priority first */
+        for (index = 0; index < RT_IPC_QUEUE_LISTS; index ++)
+        {
+            list = &(event->parent.suspend_thread.list[index]);
+
+            n = list->next;
+            while (n != list)
+            {
+                /* get thread */
+                thread = rt_list_entry(n, struct rt_thread, tlist);
 
-                /* need do a scheduling */
-                need_schedule = RT_TRUE;
+                /* move node to the next */
+                n = n->next;
+
+                /* condition is satisfied, resume thread */
+                if (_rt_event_resume(event, thread) == RT_TRUE)
+                {
+                    /* need do a scheduling */
+                    need_schedule = RT_TRUE;
+                }
             }
         }
     }
+#endif
+
+    /* resume the threads polling the bits left */
+    if (event->set != 0 && rt_ipc_poll_resume(&(event->parent), event->set))
+        need_schedule = RT_TRUE;
     
     /* enable interrupt */
-    rt_hw_interrupt_enabled(level);
+    rt_hw_interrupt_enable(level);
 
     /* do a schedule */
     if (need_schedule == RT_TRUE)
@@ -1088,7 +2613,7 @@ RTM_EXPORT(rt_event_send);
  */
 rt_err_t rt_event_recv(rt_event_t   event,
                        rt_uint32_t  set,
-                       rt_uint8_t   opt,
+                       rt_uint8_t   option,
                        rt_int32_t   timeout,
                        rt_uint32_t *recved)
 {
@@ -1100,7 +2625,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
 
     /* parameter check */
     RT_ASSERT(event != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&event.parent.parent) == RT_Object_Class_Event);
+    RT_ASSERT(rt_object_get_type(&event->parent.parent) == RT_Object_Class_Event);
 
     if (set == 0)
         return -RT_ERROR;
@@ -1114,10 +2639,10 @@ rt_err_t rt_event_recv(rt_event_t   event,
     /* reset thread error */
     thread->error = RT_EOK;
 
-    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&event.parent.parent));
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(event->parent.parent)));
 
     /* disable interrupt */
-    level = rt_hw_interrupt_disabled();
+    level = rt_hw_interrupt_disable();
 
     /* check event set */
     if (option & RT_EVENT_FLAG_AND)
@@ -1136,7 +2661,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
         RT_ASSERT(0);
     }
 
-    if (status = RT_EOK)
+    if (status == RT_EOK)
     {
         /* set received event */
         if (recved)
@@ -1158,9 +2683,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
         thread->event_info = option;
 
         /* put thread to suspended thread list */
-        rt_ipc_list_suspend(&(event->parent.suspend_thread),
-                            thread,
-                            event->parent.parent.flag);
+        _rt_event_wait(event, thread);
 
         /* if there is a waiting timeout, active thread timer */
         if (timeout > 0)
@@ -1173,7 +2696,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
         }
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(level);
+        rt_hw_interrupt_enable(level);
 
         /* do a schedule */
         rt_schedule();
@@ -1185,7 +2708,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
         }
 
         /* received an event, disable interrupt to protect */
-        level = rt_hw_interrupt_disabled();
+        level = rt_hw_interrupt_disable();
 
         /* set received event */
         if (recved)
@@ -1193,7 +2716,7 @@ rt_err_t rt_event_recv(rt_event_t   event,
     }
 
     /* enable interrupt */
-    rt_hw_interrupt_enabled(level);
+    rt_hw_interrupt_enable(level);
 
     RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(event->parent.parent)));
 
@@ -1221,16 +2744,16 @@ rt_err_t rt_event_control(rt_event_t event, int cmd, void *arg)
     if (cmd == RT_IPC_CMD_RESET)
     {
         /* disable interrupt */
-        level = rt_hw_interrupt_disabled();
+        level = rt_hw_interrupt_disable();
 
         /* resume all waiting thread */
-        rt_ipc_list_resume_all(&(event.parent.suspend_thread));
+        _rt_event_wait_resume_all(event);
 
         /* init event set */
         event->set = 0;
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(level);
+        rt_hw_interrupt_enable(level);
 
         rt_schedule();
 
@@ -1251,7 +2774,8 @@ RTM_EXPORT(rt_event_control);
  * @param name the name of mailbox
  * @param msgpool the begin address of buffer to save received mail
  * @param size the size of mailbox
- * @param flag the flag of mailbox
+ * @param flag the flag of mailbox, RT_IPC_FLAG_FIFO or RT_IPC_FLAG_PRIO, or
+ *        RT_IPC_FLAG_SPSC for one producer and one consumer without lock
  *
  * @return the operation status, RT_EOK on successful
  */
@@ -1266,18 +2790,29 @@ rt_err_t rt_mb_init(rt_mailbox_t mb,
     /* init object */
     rt_object_init(&(mb->parent.parent), RT_Object_Class_MailBox, name);
 
+#ifdef RT_USING_MAILBOX_SPSC
+    /* the offsets of the lock-free ring run over twice the size */
+    RT_ASSERT(!(flag & RT_IPC_FLAG_SPSC) || size <= RT_UINT16_MAX / 2);
+#else
+    /* the mailbox with lock is also right for one producer and one consumer */
+    flag &= ~RT_IPC_FLAG_SPSC;
+#endif
+
     /* set parent flag */
     mb->parent.parent.flag = flag;
 
+    /* init ipc object */
+    rt_ipc_object_init(&(mb->parent));
+
     /* init mailbox */
-    mb->msgpool    = msgpool;
+    mb->msg_pool   = msgpool;
     mb->size       = size;
     mb->entry      = 0;
     mb->in_offset  = 0;
     mb->out_offset = 0;
 
     /* init an additional list of sender suspend thread */
-    rt_list_init(&(mb->parent.suspend_thread));
+    rt_ipc_queue_init(&(mb->suspend_sender_thread));
 
     return RT_EOK;
 }
@@ -1301,6 +2836,7 @@ rt_err_t rt_mb_detach(rt_mailbox_t mb)
     rt_ipc_list_resume_all(&(mb->parent.suspend_thread));
     /* also resume all mailbox private suspended thread */
     rt_ipc_list_resume_all(&(mb->suspend_sender_thread));
+    rt_ipc_poll_detach(&(mb->parent));
 
     /* detach mailbox object */
     rt_object_detach(&(mb->parent.parent));
@@ -1315,7 +2851,8 @@ RTM_EXPORT(rt_mb_detach);
  *
  * @param name the name of mailbox
  * @param size the size of mailbox
- * @param flag the flag of mailbox
+ * @param flag the flag of mailbox, RT_IPC_FLAG_FIFO or RT_IPC_FLAG_PRIO, or
+ *        RT_IPC_FLAG_SPSC for one producer and one consumer without lock
  *
  * @return the created mailbox, RT_NULL on error happen
  */
@@ -1330,6 +2867,14 @@ rt_mailbox_t rt_mb_create(const char *name, rt_size_t size, rt_uint8_t flag)
     if (mb == RT_NULL)
         return mb;
 
+#ifdef RT_USING_MAILBOX_SPSC
+    /* the offsets of the lock-free ring run over twice the size */
+    RT_ASSERT(!(flag & RT_IPC_FLAG_SPSC) || size <= RT_UINT16_MAX / 2);
+#else
+    /* the mailbox with lock is also right for one producer and one consumer */
+    flag &= ~RT_IPC_FLAG_SPSC;
+#endif
+
     /* set parent */
     mb->parent.parent.flag = flag;
 
@@ -1351,7 +2896,7 @@ rt_mailbox_t rt_mb_create(const char *name, rt_size_t size, rt_uint8_t flag)
     mb->out_offset = 0;
 
     /* init an additional list of sender suspend thread */
-    rt_list_init(&(mb->suspend_sender_thread));
+    rt_ipc_queue_init(&(mb->suspend_sender_thread));
 
     return mb;
 }
@@ -1377,6 +2922,7 @@ rt_err_t rt_mb_delete(rt_mailbox_t mb)
     rt_ipc_list_resume_all(&(mb->parent.suspend_thread));
     /* also resume all mailbox private suspended thread */
     rt_ipc_list_resume_all(&(mb->suspend_sender_thread));
+    rt_ipc_poll_detach(&(mb->parent));
 
     /* free mailbox pool */
     RT_KERNEL_FREE(mb->msg_pool);
@@ -1389,27 +2935,296 @@ rt_err_t rt_mb_delete(rt_mailbox_t mb)
 RTM_EXPORT(rt_mb_delete);
 #endif
 
-/**
- * This function will send a mail to mailbox object. If the mailbox is full,
- * current thread will be suspended until timeout.
- *
- * @param mb the mailbox object
- * @param value the mail
- * @param timeout the waiting time
+#ifdef RT_USING_MAILBOX_SPSC
+#ifndef RT_HW_ATOMIC
+#error "RT_USING_MAILBOX_SPSC needs the atomic interfaces of rthw.h"
+#endif
+
+/*
+ * A mailbox with RT_IPC_FLAG_SPSC has one producer, a thread or an interrupt
+ * service routine, and one consumer thread. The in_offset is only written by
+ * the producer and the out_offset only by the consumer, so a mail is put and
+ * got without disabling interrupt and without atomic read-modify-write. The
+ * offsets run over twice the size to tell a full ring from an empty one, the
+ * entry of mailbox is not used. The interrupt is only disabled to suspend a
+ * thread on a full or an empty mailbox, and to resume it.
+ */
+
+/* the number of mails in the ring */
+rt_inline rt_uint16_t _rt_mb_spsc_entry(rt_mailbox_t mb)
+{
+    rt_uint16_t in, out;
+
+    in  = rt_hw_atomic_load(&(mb->in_offset));
+    out = rt_hw_atomic_load(&(mb->out_offset));
+
+    return in >= out ? in - out : in + 2 * mb->size - out;
+}
+
+/* put up to count mails to the ring, by the producer; return the number put */
+rt_inline rt_size_t _rt_mb_spsc_put(rt_mailbox_t       mb,
+                                    const rt_uint32_t *value,
+                                    rt_size_t          count)
+{
+    rt_uint16_t in;
+    rt_size_t put, room;
+
+    room = mb->size - _rt_mb_spsc_entry(mb);
+    if (count > room)
+        count = room;
+    if (count == 0)
+        return 0;
+
+    in = mb->in_offset;
+    for (put = 0; put < count; put ++)
+    {
+        mb->msg_pool[in < mb->size ? in : in - mb->size] = value[put];
+        if (++ in >= 2 * mb->size)
+            in = 0;
+    }
+
+    /* publish the mails to the consumer */
+    rt_hw_atomic_store(&(mb->in_offset), in);
+
+    return count;
+}
+
+/* get up to count mails from the ring, by the consumer; return the number got */
+rt_inline rt_size_t _rt_mb_spsc_get(rt_mailbox_t mb, rt_uint32_t *value, rt_size_t count)
+{
+    rt_uint16_t out;
+    rt_size_t got, entry;
+
+    entry = _rt_mb_spsc_entry(mb);
+    if (count > entry)
+        count = entry;
+    if (count == 0)
+        return 0;
+
+    out = mb->out_offset;
+    for (got = 0; got < count; got ++)
+    {
+        value[got] = mb->msg_pool[out < mb->size ? out : out - mb->size];
+        if (++ out >= 2 * mb->size)
+            out = 0;
+    }
+
+    /* give the slots back to the producer */
+    rt_hw_atomic_store(&(mb->out_offset), out);
+
+    return count;
+}
+
+/*
+ * This function will resume the thread waiting on the other side of the
+ * ring, if there is one. The waiter is pended as RT_IPC_FLAG_FIFO, i.e. on
+ * list[0] of the queue, which is peeked without disabling interrupt; the
+ * fence pairs with the one of _rt_mb_spsc_wait: either the waiter sees the
+ * new entry, or the waiter is seen here.
+ */
+static void _rt_mb_spsc_wakeup(struct rt_ipc_queue *queue)
+{
+    register rt_ubase_t temp;
+
+    rt_hw_atomic_fence();
+    if (rt_list_isempty(&(queue->list[0])))
+        return;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    if (!rt_ipc_queue_isempty(queue))
+    {
+        rt_ipc_list_resume(queue);
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        rt_schedule();
+
+        return;
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+}
+
+/*
+ * This function will suspend the current thread on a queue of mailbox while
+ * the entry of mailbox is 'entry', i.e. full for the producer or empty for
+ * the consumer.
  *
- * @return the error code
+ * @return RT_EOK to try the ring again, or the error of waiting
  */
-rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
-                         rt_uint32_t  value,
-                         rt_int32_t   timeout)
+static rt_err_t _rt_mb_spsc_wait(rt_mailbox_t         mb,
+                                 struct rt_ipc_queue *queue,
+                                 rt_uint16_t          entry,
+                                 rt_int32_t          *timeout)
 {
     struct rt_thread *thread;
     register rt_ubase_t temp;
     rt_uint32_t tick_delta;
 
-    /* parameter check */
-    RT_ASSERT(mb != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    /* get current thread */
+    thread = rt_thread_self();
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    /* reset error number in thread */
+    thread->error = RT_EOK;
+
+    RT_DEBUG_IN_THREAD_CONTEXT;
+    /* suspend current thread, it's the only one on this side */
+    rt_ipc_list_suspend(queue, thread, RT_IPC_FLAG_FIFO);
+
+    /* the other side changed the ring before it could see this thread */
+    rt_hw_atomic_fence();
+    if (_rt_mb_spsc_entry(mb) != entry)
+    {
+        rt_thread_resume(thread);
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        return RT_EOK;
+    }
+
+    /* has waiting time, start thread timer */
+    tick_delta = 0;
+    if (*timeout > 0)
+    {
+        /* get the start tick of timer */
+        tick_delta = rt_tick_get();
+
+        /* reset the timeout of thread timer and start it */
+        rt_timer_control(&(thread->thread_timer),
+                         RT_TIMER_CTRL_SET_TIME,
+                         timeout);
+        rt_timer_start(&(thread->thread_timer));
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    /* re-schedule */
+    rt_schedule();
+
+    /* resume from suspend state */
+    if (thread->error != RT_EOK)
+        return thread->error;
+
+    /* if it's not waiting forever and then re-calculate timeout tick */
+    if (*timeout > 0)
+    {
+        tick_delta = rt_tick_get() - tick_delta;
+        *timeout -= tick_delta;
+        if (*timeout < 0)
+            *timeout = 0;
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t _rt_mb_spsc_send_wait(rt_mailbox_t       mb,
+                                      const rt_uint32_t *value,
+                                      rt_size_t         *count,
+                                      rt_int32_t         timeout)
+{
+    register rt_ubase_t temp;
+    rt_bool_t need_schedule;
+    rt_size_t sent;
+    rt_err_t result;
+
+    while ((sent = _rt_mb_spsc_put(mb, value, *count)) == 0)
+    {
+        /* no waiting, return full */
+        if (timeout == 0)
+            return -RT_EFULL;
+
+        result = _rt_mb_spsc_wait(mb, &(mb->suspend_sender_thread), mb->size, &timeout);
+        if (result != RT_EOK)
+            return result;
+    }
+    *count = sent;
+
+    /* resume the receiver */
+    _rt_mb_spsc_wakeup(&(mb->parent.suspend_thread));
+
+    /* and the threads polling it, after the fence of the wakeup */
+    if (!rt_ipc_poll_peek_empty(&(mb->parent)))
+    {
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+        need_schedule = rt_ipc_poll_resume(&(mb->parent), 0);
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        if (need_schedule == RT_TRUE)
+            rt_schedule();
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t _rt_mb_spsc_recv(rt_mailbox_t mb,
+                                 rt_uint32_t *value,
+                                 rt_size_t   *count,
+                                 rt_int32_t   timeout)
+{
+    rt_err_t result;
+    rt_size_t got;
+    rt_bool_t waited = RT_FALSE;
+
+    while ((got = _rt_mb_spsc_get(mb, value, *count)) == 0)
+    {
+        /* same errors as the mailbox with lock */
+        if (timeout == 0)
+        {
+            if (!waited)
+                return -RT_EFULL;
+
+            rt_thread_self()->error = -RT_ETIMEOUT;
+
+            return -RT_ETIMEOUT;
+        }
+
+        waited = RT_TRUE;
+        result = _rt_mb_spsc_wait(mb, &(mb->parent.suspend_thread), 0, &timeout);
+        if (result != RT_EOK)
+            return result;
+    }
+    *count = got;
+
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
+
+    /* resume the sender */
+    _rt_mb_spsc_wakeup(&(mb->suspend_sender_thread));
+
+    return RT_EOK;
+}
+#endif
+
+/*
+ * This function will put up to *count mails to mailbox, waiting while it's
+ * full; *count is set to the number of mails put, as many as there are free
+ * slots for. A suspended receiver is resumed for each mail.
+ */
+static rt_err_t _rt_mb_send_wait(rt_mailbox_t       mb,
+                                 const rt_uint32_t *value,
+                                 rt_size_t         *count,
+                                 rt_int32_t         timeout)
+{
+    struct rt_thread *thread;
+    register rt_ubase_t temp;
+    rt_uint32_t tick_delta;
+    rt_size_t sent, resumed;
+    rt_bool_t need_schedule;
+
+#ifdef RT_USING_MAILBOX_SPSC
+    if (mb->parent.parent.flag & RT_IPC_FLAG_SPSC)
+        return _rt_mb_spsc_send_wait(mb, value, count, timeout);
+#endif
 
     /* initialize delta tick */
     tick_delta = 0;
@@ -1417,12 +3232,12 @@ rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
     thread = rt_thread_self();
 
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    temp = rt_hw_interrupt_disable();
 
     /* for non-blocking call */
     if (mb->entry == mb->size && timeout == 0)
     {
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
         return -RT_EFULL;
     }
@@ -1437,7 +3252,7 @@ rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
         if (timeout == 0)
         {
             /* enable interrupt */
-            rt_hw_interrupt_enabled(temp);
+            rt_hw_interrupt_enable(temp);
 
             return -RT_EFULL;
         }
@@ -1465,7 +3280,7 @@ rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
         }
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
         /* re-schedule */
         rt_schedule();
@@ -1478,7 +3293,7 @@ rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
         }
 
         /* disable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        temp = rt_hw_interrupt_disable();
 
         /* if it's not waiting forever and then re-calculate timeout tick */
         if (timeout > 0)
@@ -1490,35 +3305,94 @@ rt_err_t rt_mn_send_wait(rt_mailbox_t mb,
         }
     }
 
-    /* set ptr */
-    mb->msg_pool[mb->in_offset] = value;
+    if (*count > (rt_size_t)(mb->size - mb->entry))
+        *count = mb->size - mb->entry;
+    for (sent = 0; sent < *count; sent ++)
+    {
+        /* set ptr */
+        mb->msg_pool[mb->in_offset] = value[sent];
 
-    /* increase input offset */
-    ++ mb->in_offset;
-    if (mb_in_offset >= mb_size)
-        mb_in_offset = 0;
+        /* increase input offset */
+        ++ mb->in_offset;
+        if (mb->in_offset >= mb->size)
+            mb->in_offset = 0;
+    }
     /* increase message entry */
-    mb->entry ++;
+    mb->entry += *count;
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&(mb->parent.suspend_thread)))
-    {
-        rt_ipc_list_resume(&(mb->parent.suspend_thread));
+    /* resume suspended threads, and the threads polling it for the rest */
+    resumed = rt_ipc_list_resume_n(&(mb->parent.suspend_thread), *count);
+    need_schedule = resumed > 0 ? RT_TRUE : RT_FALSE;
+    if (resumed < *count && rt_ipc_poll_resume(&(mb->parent), 0))
+        need_schedule = RT_TRUE;
 
-        /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
 
+    if (need_schedule == RT_TRUE)
         rt_schedule();
 
-        return RT_EOK;
-    }
+    return RT_EOK;
+}
 
-    /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+/**
+ * This function will send a mail to mailbox object. If the mailbox is full,
+ * current thread will be suspended until timeout.
+ *
+ * @param mb the mailbox object
+ * @param value the mail
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_send_wait(rt_mailbox_t mb,
+                         rt_uint32_t  value,
+                         rt_int32_t   timeout)
+{
+    rt_size_t count;
 
-    return RT_EOK;
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+
+    count = 1;
+
+    return _rt_mb_send_wait(mb, &value, &count, timeout);
+}
+RTM_EXPORT(rt_mb_send_wait);
+
+/**
+ * This function will send up to count mails to mailbox object at once, as
+ * many as there are free slots for, with one critical section and one
+ * re-schedule for all of them. If the mailbox is full, current thread will be
+ * suspended until timeout.
+ *
+ * @param mb the mailbox object
+ * @param value the array of mails
+ * @param count the number of mails in the array
+ * @param timeout the waiting time
+ *
+ * @return the number of mails sent, 0 on timeout or error
+ */
+rt_size_t rt_mb_send_wait_n(rt_mailbox_t       mb,
+                            const rt_uint32_t *value,
+                            rt_size_t          count,
+                            rt_int32_t         timeout)
+{
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(value != RT_NULL);
+
+    if (count == 0)
+        return 0;
+
+    if (_rt_mb_send_wait(mb, value, &count, timeout) != RT_EOK)
+        return 0;
+
+    return count;
 }
-RTM_EXPORT(rt_mn_send_wait);
+RTM_EXPORT(rt_mb_send_wait_n);
 
 /**
  * This function will send a mail to mailbox object, if there are threads
@@ -1536,25 +3410,20 @@ rt_err_t rt_mb_send(rt_mailbox_t mb, rt_uint32_t value)
 }
 RTM_EXPORT(rt_mb_send);
 
-/**
- * This function will receive a mail from mailbox object, if there is no mail
- * in mailbox object, the thread shall wait for a specified time.
- *
- * @param mb the mailbox object
- * @param value the received mail will be saved in
- * @param timeout the waiting time
- *
- * @return the error code
+/*
+ * This function will get up to *count mails from mailbox, waiting while it's
+ * empty; *count is set to the number of mails got, as many as there are in
+ * it. A suspended sender is resumed for each mail.
  */
-rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
+static rt_err_t _rt_mb_recv(rt_mailbox_t mb,
+                            rt_uint32_t *value,
+                            rt_size_t   *count,
+                            rt_int32_t   timeout)
 {
     struct rt_thread *thread;
     register rt_ubase_t temp;
     rt_uint32_t tick_delta;
-
-    /* parameter check */
-    RT_ASSERT(mb != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    rt_size_t got;
 
     /* initialize delta tick */
     tick_delta = 0;
@@ -1563,13 +3432,18 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
 
     RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mb->parent.parent)));
 
+#ifdef RT_USING_MAILBOX_SPSC
+    if (mb->parent.parent.flag & RT_IPC_FLAG_SPSC)
+        return _rt_mb_spsc_recv(mb, value, count, timeout);
+#endif
+
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    temp = rt_hw_interrupt_disable();
 
     /* for non-blocking call */
     if (mb->entry == 0 && timeout == 0)
     {
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
         return -RT_EFULL;
     }
@@ -1584,7 +3458,7 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
         if (timeout == 0)
         {
             /* enable interrupt */
-            rt_hw_interrupt_enabled(temp);
+            rt_hw_interrupt_enable(temp);
 
             thread->error = -RT_ETIMEOUT;
 
@@ -1614,7 +3488,7 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
         }
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
         /* re-schedule */
         rt_schedule();
@@ -1627,7 +3501,7 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
         }
 
         /* disable interrupt */
-        temp = rt_hw_interrupt_disabled();
+        temp = rt_hw_interrupt_disable();
 
         /* if it's not waiting forever and then re-calculate timeout tick */
         if (timeout > 0)
@@ -1639,23 +3513,26 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
         }
     }
 
-    /* fill ptr */
-    *value = mb->msg_pool[mb->out_offset];
+    if (*count > mb->entry)
+        *count = mb->entry;
+    for (got = 0; got < *count; got ++)
+    {
+        /* fill ptr */
+        value[got] = mb->msg_pool[mb->out_offset];
 
-    /* increase output offset */
-    ++ mb->out_offset;
-    if (mb->out_offset >= mb->size)
-        mb->out_offset = 0;
+        /* increase output offset */
+        ++ mb->out_offset;
+        if (mb->out_offset >= mb->size)
+            mb->out_offset = 0;
+    }
     /* decrease message entry */
-    mb->entry--;
+    mb->entry -= *count;
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&(mb->suspend_sender_thread)))
+    /* resume suspended threads */
+    if (rt_ipc_list_resume_n(&(mb->suspend_sender_thread), *count) > 0)
     {
-        rt_ipc_list_resume(&(mb->suspend_sender_thread));
-
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
         RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
 
@@ -1665,14 +3542,70 @@ rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
     }
 
     /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    rt_hw_interrupt_enable(temp);
 
     RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mb->parent.parent)));
 
     return RT_EOK;
 }
+
+/**
+ * This function will receive a mail from mailbox object, if there is no mail
+ * in mailbox object, the thread shall wait for a specified time.
+ *
+ * @param mb the mailbox object
+ * @param value the received mail will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mb_recv(rt_mailbox_t mb, rt_uint32_t *value, rt_int32_t timeout)
+{
+    rt_size_t count;
+
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+
+    count = 1;
+
+    return _rt_mb_recv(mb, value, &count, timeout);
+}
 RTM_EXPORT(rt_mb_recv);
 
+/**
+ * This function will receive up to count mails from mailbox object at once,
+ * as many as there are in it, with one critical section and one re-schedule
+ * for all of them. If there is no mail in mailbox object, the thread shall
+ * wait for a specified time.
+ *
+ * @param mb the mailbox object
+ * @param value the array the received mails will be saved in
+ * @param count the number of mails the array holds
+ * @param timeout the waiting time
+ *
+ * @return the number of mails received, 0 on timeout or error
+ */
+rt_size_t rt_mb_recv_n(rt_mailbox_t mb,
+                       rt_uint32_t *value,
+                       rt_size_t    count,
+                       rt_int32_t   timeout)
+{
+    /* parameter check */
+    RT_ASSERT(mb != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&mb->parent.parent) == RT_Object_Class_MailBox);
+    RT_ASSERT(value != RT_NULL);
+
+    if (count == 0)
+        return 0;
+
+    if (_rt_mb_recv(mb, value, &count, timeout) != RT_EOK)
+        return 0;
+
+    return count;
+}
+RTM_EXPORT(rt_mb_recv_n);
+
 /**
  * This function can get or set some extra attributions of a mailbox object.
  *
@@ -1693,7 +3626,7 @@ rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, rt_int32_t *arg)
     if (cmd == RT_IPC_CMD_RESET)
     {
         /* disable interrupt */
-        level = rt_hw_interrupt_disabled();
+        level = rt_hw_interrupt_disable();
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&(mb->parent.suspend_thread));
@@ -1706,7 +3639,7 @@ rt_err_t rt_mb_control(rt_mailbox_t mb, int cmd, rt_int32_t *arg)
         mb->out_offset = 0;
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(level);
+        rt_hw_interrupt_enable(level);
 
         rt_schedule();
 
@@ -1803,6 +3736,7 @@ rt_err_t rt_mq_detach(rt_mq_t mq)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(mq->parent.suspend_thread));
+    rt_ipc_poll_detach(&(mq->parent));
 
     /* detach message queue object */
     rt_object_detach(&(mq->parent.parent));
@@ -1867,8 +3801,10 @@ rt_mq_t rt_mq_create(const char *name,
     mq->msg_queue_free = RT_NULL;
     for (temp = 0; temp < mq->max_msgs; temp ++)
     {
-        head = (struct rt_mq_message *)((rt_uint8_t)mq->msg_pool + 
+        head = (struct rt_mq_message *)((rt_uint8_t *)mq->msg_pool +
                                         temp * (mq->msg_size + sizeof(struct rt_mq_message)));
+        head->next = mq->msg_queue_free;
+        mq->msg_queue_free = head;
     }
 
     /* the initial entry is zero */
@@ -1896,6 +3832,7 @@ rt_err_t rt_mq_delete(rt_mq_t mq)
 
     /* resume all suspended thread */
     rt_ipc_list_resume_all(&(mq->parent.suspend_thread));
+    rt_ipc_poll_detach(&(mq->parent));
 
     /* free message queue pool */
     RT_KERNEL_FREE(mq->msg_pool);
@@ -1908,100 +3845,265 @@ rt_err_t rt_mq_delete(rt_mq_t mq)
 RTM_EXPORT(rt_mq_delete);
 #endif
 
-/**
- * This function will send a message to message queue object, if there are
- * threads suspended on message queue object, it will be waked up.
- *
- * @param mq the message queue object
- * @param buffer the message
- * @param size the size of buffer
- *
- * @return the error code
+/*
+ * The message nodes move among three lists: the free list, the queue and the
+ * hand of a thread. rt_mq_send/rt_mq_recv hold a node only while copying the
+ * message in or out; the loan functions hand it to the caller, so a large
+ * message is filled and read in place without any copy.
  */
-rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
+
+/*
+ * take up to count nodes from the free list, linked by next and ended by
+ * RT_NULL; RT_NULL if the queue is full
+ */
+static struct rt_mq_message *_rt_mq_message_alloc(rt_mq_t mq, rt_size_t count)
 {
     register rt_ubase_t temp;
-    struct rt_mq_message *msg;
-
-    /* parameter check */
-    RT_ASSERT(mq != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
-    RT_ASSERT(buffer != RT_NULL);
-    RT_ASSERT(size != 0);
-
-    /* greater than one message size */
-    if (size > mq->msg_size)
-        return -RT_ERROR;
-
-    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
+    struct rt_mq_message *msg, *last;
 
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    temp = rt_hw_interrupt_disable();
 
     /* get a free list, there must be an empty item */
     msg = (struct rt_mq_message *)mq->msg_queue_free;
-    /* message queue is full */
-    if (msg == RT_NULL)
+    if (msg != RT_NULL)
     {
-        /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        /* cut the first count nodes off */
+        for (last = msg; last->next != RT_NULL && count > 1; count --)
+            last = last->next;
 
-        return -RT_EFULL;
+        /* move free list pointer */
+        mq->msg_queue_free = last->next;
+        last->next = RT_NULL;
     }
-    /* move free list pointer */
-    mq->msg_queue_free = msg->next;
 
     /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    rt_hw_interrupt_enable(temp);
 
-    /* the msg is the new tailer of list, the next shall be NULL */
-    msg->next = RT_NULL;
-    /* copy buffer */
-    rt_memcpy(msg + 1, buffer, size);
+    return msg;
+}
+
+/* put the nodes from first to last back to the free list */
+static void _rt_mq_message_free(rt_mq_t               mq,
+                                struct rt_mq_message *first,
+                                struct rt_mq_message *last)
+{
+    register rt_ubase_t temp;
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+    /* put message to free list */
+    last->next = (struct rt_mq_message *)mq->msg_queue_free;
+    mq->msg_queue_free = first;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+}
+
+/*
+ * link count filled nodes, from first to last, to the tail, or the head if
+ * urgent, and wake a receiver for each of them
+ */
+static rt_err_t _rt_mq_message_link(rt_mq_t               mq,
+                                    struct rt_mq_message *first,
+                                    struct rt_mq_message *last,
+                                    rt_size_t             count,
+                                    rt_bool_t             urgent)
+{
+    register rt_ubase_t temp;
+    rt_size_t resumed;
+    rt_bool_t need_schedule;
 
     /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
-    /* link msg to message queue */
-    if (mq->msg_queue_tail != RT_NULL)
+    temp = rt_hw_interrupt_disable();
+
+    if (urgent)
     {
-        /* if the tail exists, */
-        ((struct rt_mq_message *)mq->msg_queue_tail)->next = msg;
+        /* link msg to the beginning of message queue */
+        last->next = mq->msg_queue_head;
+        mq->msg_queue_head = first;
+
+        /* if there is no tail */
+        if (mq->msg_queue_tail == RT_NULL)
+            mq->msg_queue_tail = last;
     }
+    else
+    {
+        /* the msg is the new tailer of list, the next shall be NULL */
+        last->next = RT_NULL;
 
-    /* set new tail */
-    mq->msg_queue_tail = msg;
+        /* link msg to message queue */
+        if (mq->msg_queue_tail != RT_NULL)
+        {
+            /* if the tail exists, */
+            ((struct rt_mq_message *)mq->msg_queue_tail)->next = first;
+        }
 
-    /* if the head is empty, set head */
-    if (mq->msg_queue_head == RT_NULL)
-        mq->msg_queue_head = msg;
+        /* set new tail */
+        mq->msg_queue_tail = last;
+
+        /* if the head is empty, set head */
+        if (mq->msg_queue_head == RT_NULL)
+            mq->msg_queue_head = first;
+    }
 
     /* increase message entry */
-    mq->entry ++;
+    mq->entry += count;
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&mq->parent.suspend_thread))
+    /* resume suspended threads, and the threads polling it for the rest */
+    resumed = rt_ipc_list_resume_n(&(mq->parent.suspend_thread), count);
+    need_schedule = resumed > 0 ? RT_TRUE : RT_FALSE;
+    if (resumed < count && rt_ipc_poll_resume(&(mq->parent), 0))
+        need_schedule = RT_TRUE;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    if (need_schedule == RT_TRUE)
+        rt_schedule();
+
+    return RT_EOK;
+}
+
+/*
+ * wait for a message and unlink up to count nodes from the head of the queue,
+ * linked by next and ended by RT_NULL
+ */
+static rt_err_t _rt_mq_message_take(rt_mq_t                mq,
+                                    struct rt_mq_message **msg,
+                                    rt_size_t              count,
+                                    rt_int32_t             timeout)
+{
+    struct rt_thread *thread;
+    register rt_ubase_t temp;
+    rt_uint32_t tick_delta;
+    struct rt_mq_message *last;
+
+    /* initialize delta tick */
+    tick_delta = 0;
+    /* get current thread */
+    thread = rt_thread_self();
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    /* for non-blocking call */
+    if (mq->entry == 0 && timeout == 0)
+    {
+        rt_hw_interrupt_enable(temp);
+
+        return -RT_ETIMEOUT;
+    }
+
+    /* message queue is empty */
+    while (mq->entry == 0)
     {
-        rt_ipc_list_resume(&(mq->parent.suspend_thread));
+        RT_DEBUG_IN_THREAD_CONTEXT;
+
+        /* reset error number in thread */
+        thread->error = RT_EOK;
+
+        /* no waiting, return timeout */
+        if (timeout == 0)
+        {
+            /* enable interrupt */
+            rt_hw_interrupt_enable(temp);
+
+            thread->error = -RT_ETIMEOUT;
+
+            return -RT_ETIMEOUT;
+        }
+
+        /* suspend current thread */
+        rt_ipc_list_suspend(&(mq->parent.suspend_thread),
+                            thread,
+                            mq->parent.parent.flag);
+
+        /* has waiting time, start thread timer */
+        if (timeout > 0)
+        {
+            tick_delta = rt_tick_get();
+
+            RT_DEBUG_LOG(RT_DEBUG_IPC, ("Set thread: %s to timer list\n",
+                                        thread->name));
+
+            /* reset the timeout of thread timer and start it */
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &timeout);
+            rt_timer_start(&(thread->thread_timer));
+        }
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+        rt_hw_interrupt_enable(temp);
 
+        /* re-schedule */
         rt_schedule();
 
-        return RT_EOK;
+        /* recv message */
+        if (thread->error != RT_EOK)
+        {
+            /* return error */
+            return thread->error;
+        }
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        /* if it's not waiting forever and then re-calculate timeout tick */
+        if (timeout > 0)
+        {
+            tick_delta = rt_tick_get() - tick_delta;
+            timeout -= tick_delta;
+            if (timeout < 0)
+                timeout = 0;
+        }
     }
 
+    /* get message from queue */
+    *msg = (struct rt_mq_message *)mq->msg_queue_head;
+
+    if (count > mq->entry)
+        count = mq->entry;
+    /* decrease message entry */
+    mq->entry -= count;
+
+    /* cut the first count nodes off */
+    for (last = *msg; count > 1; count --)
+        last = last->next;
+
+    /* move message queue head */
+    mq->msg_queue_head = last->next;
+    /* reach queue tail, set to NULL */
+    if (mq->msg_queue_tail == last)
+        mq->msg_queue_tail = RT_NULL;
+    last->next = RT_NULL;
+
     /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    rt_hw_interrupt_enable(temp);
 
     return RT_EOK;
 }
-RTM_EXPORT(rt_mq_send);
+
+/* get the node of a loaned buffer */
+static struct rt_mq_message *_rt_mq_loan_message(rt_mq_t mq, void *buffer)
+{
+    struct rt_mq_message *msg;
+
+    msg = (struct rt_mq_message *)buffer - 1;
+
+    /* the buffer must be a message of this queue */
+    RT_ASSERT((rt_uint8_t *)msg >= (rt_uint8_t *)mq->msg_pool);
+    RT_ASSERT((rt_uint8_t *)msg < (rt_uint8_t *)mq->msg_pool +
+              mq->max_msgs * (mq->msg_size + sizeof(struct rt_mq_message)));
+    RT_ASSERT(((rt_uint8_t *)msg - (rt_uint8_t *)mq->msg_pool) %
+              (mq->msg_size + sizeof(struct rt_mq_message)) == 0);
+
+    return msg;
+}
 
 /**
- * This function will send an urgent message to message queue object, which
- * means the message will be inserted to the head of message queue. If there
- * are threads suspended on message queue object, it will be waked up.
+ * This function will send a message to message queue object, if there are
+ * threads suspended on message queue object, it will be waked up.
  *
  * @param mq the message queue object
  * @param buffer the message
@@ -2009,9 +4111,8 @@ RTM_EXPORT(rt_mq_send);
  *
  * @return the error code
  */
-rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
+rt_err_t rt_mq_send(rt_mq_t mq, void *buffer, rt_size_t size)
 {
-    register rt_ubase_t temp;
     struct rt_mq_message *msg;
 
     /* parameter check */
@@ -2020,64 +4121,112 @@ rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
     RT_ASSERT(buffer != RT_NULL);
     RT_ASSERT(size != 0);
 
+    /* greater than one message size */
     if (size > mq->msg_size)
         return -RT_ERROR;
 
     RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
-
-    /* get a free list, there must be an empty item */
-    msg = (struct rt_mq_message *)mq->msg_queue_free;
+    msg = _rt_mq_message_alloc(mq, 1);
     /* message queue is full */
     if (msg == RT_NULL)
-    {
-        /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
-
         return -RT_EFULL;
-    }
-    /* move free list pointer */
-    mq->msg_queue_free = msg->next;
-
-    /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
 
     /* copy buffer */
     rt_memcpy(msg + 1, buffer, size);
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    return _rt_mq_message_link(mq, msg, msg, 1, RT_FALSE);
+}
+RTM_EXPORT(rt_mq_send);
+
+/**
+ * This function will send up to count messages to message queue object at
+ * once, as many as there are free nodes for. The nodes are taken and linked
+ * with one critical section each and one re-schedule for all of them, the
+ * messages are copied in between.
+ *
+ * @param mq the message queue object
+ * @param buffer the messages, one every size bytes
+ * @param size the size of each message
+ * @param count the number of messages in buffer
+ *
+ * @return the number of messages sent, 0 if message queue is full or on error
+ */
+rt_size_t rt_mq_send_n(rt_mq_t mq, const void *buffer, rt_size_t size, rt_size_t count)
+{
+    struct rt_mq_message *first, *last, *msg;
+    rt_size_t sent;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
 
-    /* link msg to the beginning of message queue */
-    msg->next = mq->msg_queue_head;
-    mq->msg_queue_head = msg;
+    /* greater than one message size */
+    if (size > mq->msg_size || count == 0)
+        return 0;
 
-    /* if there is no tail */
-    if (mq->msg_queue_tail == RT_NULL)
-        mq->msg_queue_tail = msg;
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-    /* increase message entry */
-    mq->entry ++;
+    first = _rt_mq_message_alloc(mq, count);
+    /* message queue is full */
+    if (first == RT_NULL)
+        return 0;
+
+    /* copy buffers */
+    sent = 0;
+    msg  = first;
+    do
+    {
+        rt_memcpy(msg + 1, (const rt_uint8_t *)buffer + sent * size, size);
+        sent ++;
+
+        last = msg;
+        msg  = msg->next;
+    } while (msg != RT_NULL);
+
+    _rt_mq_message_link(mq, first, last, sent, RT_FALSE);
+
+    return sent;
+}
+RTM_EXPORT(rt_mq_send_n);
+
+/**
+ * This function will send an urgent message to message queue object, which
+ * means the message will be inserted to the head of message queue. If there
+ * are threads suspended on message queue object, it will be waked up.
+ *
+ * @param mq the message queue object
+ * @param buffer the message
+ * @param size the size of buffer
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_urgent(rt_mq_t mq, void *buffer, rt_size_t size)
+{
+    struct rt_mq_message *msg;
 
-    /* resume suspended thread */
-    if (!rt_list_isempty(&(mq->parent.suspend_thread)))
-    {
-        rt_ipc_list_resume(&(mq->parent.suspend_thread));
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
 
-        /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+    if (size > mq->msg_size)
+        return -RT_ERROR;
 
-        rt_schedule();
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-        return RT_EOK;
-    }
+    msg = _rt_mq_message_alloc(mq, 1);
+    /* message queue is full */
+    if (msg == RT_NULL)
+        return -RT_EFULL;
 
-    /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    /* copy buffer */
+    rt_memcpy(msg + 1, buffer, size);
 
-    return RT_EOK;
+    return _rt_mq_message_link(mq, msg, msg, 1, RT_TRUE);
 }
 RTM_EXPORT(rt_mq_urgent);
 
@@ -2098,10 +4247,8 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
                     rt_size_t  size,
                     rt_int32_t timeout)
 {
-    struct rt_thread *thread;
-    register rt_ubase_t temp;
     struct rt_mq_message *msg;
-    rt_uint32_t tick_delta;
+    rt_err_t result;
 
     /* parameter check */
     RT_ASSERT(mq != RT_NULL);
@@ -2109,119 +4256,192 @@ rt_err_t rt_mq_recv(rt_mq_t    mq,
     RT_ASSERT(buffer != RT_NULL);
     RT_ASSERT(size != 0);
 
-    /* initialize delta tick */
-    tick_delta = 0;
-    /* get current thread */
-    thread = rt_thread_self();
     RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
+    result = _rt_mq_message_take(mq, &msg, 1, timeout);
+    if (result != RT_EOK)
+        return result;
 
-    /* for non-blocking call */
-    if (mq->entry == 0 && timeout == 0)
-    {
-        rt_hw_interrupt_enabled(temp);
+    /* copy message */
+    rt_memcpy(buffer, msg + 1, size > mq->msg_size ? mq->msg_size : size);
 
-        return -RT_ETIMEOUT;
-    }
+    _rt_mq_message_free(mq, msg, msg);
 
-    /* message queue is empty */
-    while (mq->entry == 0)
-    {
-        RT_DEBUG_IN_THREAD_CONTEXT;
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
+    
+    return RT_EOK;
+}
+RTM_EXPORT(rt_mq_recv);
 
-        /* reset error number in thread */
-        thread->error = RT_EOK;
+/**
+ * This function will receive up to count messages from message queue object
+ * at once, as many as there are in it. The nodes are unlinked and freed with
+ * one critical section each for all of them, the messages are copied in
+ * between. If there is no message in message queue object, the thread shall
+ * wait for a specified time.
+ *
+ * @param mq the message queue object
+ * @param buffer the received messages will be saved in, one every size bytes
+ * @param size the size of each message in buffer
+ * @param count the number of messages buffer holds
+ * @param timeout the waiting time
+ *
+ * @return the number of messages received, 0 on timeout or error
+ */
+rt_size_t rt_mq_recv_n(rt_mq_t    mq,
+                       void      *buffer,
+                       rt_size_t  size,
+                       rt_size_t  count,
+                       rt_int32_t timeout)
+{
+    struct rt_mq_message *first, *last, *msg;
+    rt_size_t received;
 
-        /* no waiting, return timeout */
-        if (timeout == 0)
-        {
-            /* enable interrupt */
-            rt_hw_interrupt_enabled(temp);
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+    RT_ASSERT(size != 0);
 
-            thread->error = -RT_ETIMEOUT;
+    if (count == 0)
+        return 0;
 
-            return -RT_ETIMEOUT;
-        }
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
 
-        /* suspend current thread */
-        rt_ipc_list_suspend(&(mq->parent.suspend_thread),
-                            thread,
-                            mq->parent.parent.flag);
+    if (_rt_mq_message_take(mq, &first, count, timeout) != RT_EOK)
+        return 0;
 
-        /* has waiting time, start thread timer */
-        if (timeout > 0)
-        {
-            tick_delta = rt_tick_get();
+    /* copy messages */
+    received = 0;
+    msg      = first;
+    do
+    {
+        rt_memcpy((rt_uint8_t *)buffer + received * size, msg + 1,
+                  size > mq->msg_size ? mq->msg_size : size);
+        received ++;
 
-            RT_DEBUG_LOG(RT_DEBUG_IPC, ("Set thread: %s to timer list\n",
-                                        thread->name));
+        last = msg;
+        msg  = msg->next;
+    } while (msg != RT_NULL);
 
-            /* reset the timeout of thread timer and start it */
-            rt_timer_control(&(thread->thread_timer),
-                             RT_TIMER_CTRL_SET_TIME,
-                             &timeout);
-            rt_timer_start(&(thread->thread_timer));
-        }
+    _rt_mq_message_free(mq, first, last);
 
-        /* enable interrupt */
-        rt_hw_interrupt_enabled(temp);
+    RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
 
-        /* re-schedule */
-        rt_schedule();
+    return received;
+}
+RTM_EXPORT(rt_mq_recv_n);
 
-        /* recv message */
-        if (thread->error != RT_EOK)
-        {
-            /* return error */
-            return thread->error;
-        }
+/**
+ * This function will loan a free message buffer of message queue object to
+ * the sender, which fills the message in place and sends it by rt_mq_commit,
+ * or gives it back by rt_mq_release. The buffer is of msg_size bytes.
+ *
+ * @param mq the message queue object
+ *
+ * @return the message buffer, RT_NULL if message queue is full
+ */
+void *rt_mq_loan(rt_mq_t mq)
+{
+    struct rt_mq_message *msg;
 
-        /* disable interrupt */
-        temp = rt_hw_interrupt_disabled();
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
 
-        /* if it's not waiting forever and then re-calculate timeout tick */
-        if (timeout > 0)
-        {
-            tick_delta = rt_tick_get() - tick_delta;
-            timeout -= tick_delta;
-            if (timeout < 0)
-                timeout = 0;
-        }
-    }
+    msg = _rt_mq_message_alloc(mq, 1);
+    if (msg == RT_NULL)
+        return RT_NULL;
 
-    /* get message from queue */
-    msg = (struct rt_mq_message *)mq->msg_queue_head;
+    return msg + 1;
+}
+RTM_EXPORT(rt_mq_loan);
 
-    /* move message queue head */
-    mq->msg_queue_head = msg->next;
-    /* reach queue tail, set to NULL */
-    if (mq->msg_queue_tail == msg)
-        mq->msg_queue_tail = RT_NULL;
+/**
+ * This function will send a message filled in a buffer loaned by rt_mq_loan,
+ * the buffer belongs to message queue object again. If there are threads
+ * suspended on message queue object, it will be waked up.
+ *
+ * @param mq the message queue object
+ * @param buffer the buffer returned by rt_mq_loan
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_commit(rt_mq_t mq, void *buffer)
+{
+    struct rt_mq_message *msg;
 
-    /* decrease message entry */
-    mq->entry --;
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
 
-    /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    RT_OBJECT_HOOK_CALL(rt_object_put_hook, (&(mq->parent.parent)));
 
-    /* copy message */
-    rt_memcpy(buffer, msg + 1, size > mq->msg_size ? mq->msg_size : size);
+    msg = _rt_mq_loan_message(mq, buffer);
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disabled();
-    /* put message to free list */
-    msg->next = (struct rt_mq_message *)mq->msg_queue_free->next;
-    mq->msg_queue_free = msg;
-    /* enable interrupt */
-    rt_hw_interrupt_enabled(temp);
+    return _rt_mq_message_link(mq, msg, msg, 1, RT_FALSE);
+}
+RTM_EXPORT(rt_mq_commit);
+
+/**
+ * This function will receive a message from message queue object without
+ * copying it: the buffer of the message is loaned to the receiver, which
+ * reads it in place and gives it back by rt_mq_release. If there is no
+ * message in message queue object, the thread shall wait for a specified
+ * time.
+ *
+ * @param mq the message queue object
+ * @param buffer the buffer of the received message will be saved in
+ * @param timeout the waiting time
+ *
+ * @return the error code
+ */
+rt_err_t rt_mq_recv_loan(rt_mq_t mq, void **buffer, rt_int32_t timeout)
+{
+    struct rt_mq_message *msg;
+    rt_err_t result;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    RT_OBJECT_HOOK_CALL(rt_object_trytake_hook, (&(mq->parent.parent)));
+
+    result = _rt_mq_message_take(mq, &msg, 1, timeout);
+    if (result != RT_EOK)
+        return result;
+
+    *buffer = msg + 1;
 
     RT_OBJECT_HOOK_CALL(rt_object_take_hook, (&(mq->parent.parent)));
-    
+
     return RT_EOK;
 }
-RTM_EXPORT(rt_mq_recv);
+RTM_EXPORT(rt_mq_recv_loan);
+
+/**
+ * This function will give a loaned buffer back to the free list of message
+ * queue object, either a message done with by the receiver of rt_mq_recv_loan
+ * or a buffer of rt_mq_loan not sent.
+ *
+ * @param mq the message queue object
+ * @param buffer the loaned buffer
+ */
+void rt_mq_release(rt_mq_t mq, void *buffer)
+{
+    struct rt_mq_message *msg;
+
+    /* parameter check */
+    RT_ASSERT(mq != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&(mq->parent.parent)) == RT_Object_Class_MessageQueue);
+    RT_ASSERT(buffer != RT_NULL);
+
+    msg = _rt_mq_loan_message(mq, buffer);
+    _rt_mq_message_free(mq, msg, msg);
+}
+RTM_EXPORT(rt_mq_release);
 
 /**
  * This function can get or set some extra attributions of a message queue
@@ -2245,7 +4465,7 @@ rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg)
     if (cmd == RT_IPC_CMD_RESET)
     {
         /* disable interrupt */
-        level = rt_hw_interrupt_disabled();
+        level = rt_hw_interrupt_disable();
 
         /* resume all waiting thread */
         rt_ipc_list_resume_all(&(mq->parent.suspend_thread));
@@ -2271,7 +4491,7 @@ rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg)
         mq->entry = 0;
 
         /* enable interrupt */
-        rt_hw_interrupt_enabled(level);
+        rt_hw_interrupt_enable(level);
 
         rt_schedule();
 
@@ -2283,4 +4503,152 @@ rt_err_t rt_mq_control(rt_mq_t mq, int cmd, void *arg)
 RTM_EXPORT(rt_mq_control);
 #endif /* end of RT_USING_MESSAGEQUEUE */
 
+#ifdef RT_USING_IPC_POLL
+/* whether an object polled is ready, with interrupt disabled */
+static rt_bool_t _rt_ipc_poll_ready(struct rt_ipc_poll *poll)
+{
+    switch (rt_object_get_type(&(poll->object->parent)))
+    {
+#ifdef RT_USING_SEMAPHORE
+    case RT_Object_Class_Semaphore:
+        return ((rt_sem_t)poll->object)->value > 0;
+#endif
+
+#ifdef RT_USING_EVENT
+    case RT_Object_Class_Event:
+        return rt_ipc_poll_match(poll, ((rt_event_t)poll->object)->set);
+#endif
+
+#ifdef RT_USING_MAILBOX
+    case RT_Object_Class_MailBox:
+#ifdef RT_USING_MAILBOX_SPSC
+        if (poll->object->parent.flag & RT_IPC_FLAG_SPSC)
+            return _rt_mb_spsc_entry((rt_mailbox_t)poll->object) > 0;
+#endif
+        return ((rt_mailbox_t)poll->object)->entry > 0;
+#endif
+
+#ifdef RT_USING_MESSAGEQUEUE
+    case RT_Object_Class_MessageQueue:
+        return ((rt_mq_t)poll->object)->entry > 0;
+#endif
+
+    default:
+        /* the object can't be polled */
+        RT_ASSERT(0);
+    }
+
+    return RT_FALSE;
+}
+
+/**
+ * This function will wait for several IPC objects at once, until any of
+ * them is ready or timeout. A semaphore is ready with a value, a mailbox or
+ * a message queue with a message, and an event with the bits of the poll.
+ * Nothing is taken here, the caller takes it from the ready objects without
+ * waiting, which fails if another thread has taken it first.
+ *
+ * @param polls the objects to wait for, the result of each one is set
+ * @param count the number of polls
+ * @param time the waiting time
+ *
+ * @return the number of the objects ready or detached, -RT_ETIMEOUT if none
+ */
+int rt_ipc_poll(struct rt_ipc_poll *polls, rt_uint32_t count, rt_int32_t time)
+{
+    struct rt_thread *thread;
+    register rt_ubase_t temp;
+    rt_uint32_t index;
+    rt_tick_t tick;
+    int ready;
+
+    /* this function must not be used in interrupt even if time = 0 */
+    RT_DEBUG_IN_THREAD_CONTEXT;
+
+    /* parameter check */
+    RT_ASSERT(polls != RT_NULL);
+    RT_ASSERT(count > 0);
+
+    /* get current thread */
+    thread = rt_thread_self();
+    tick   = rt_tick_get();
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    /* a sender sees the polls from now on */
+    for (index = 0; index < count; index ++)
+    {
+        RT_ASSERT(polls[index].object != RT_NULL);
+
+        polls[index].thread = thread;
+        polls[index].result = -RT_ETIMEOUT;
+        rt_list_insert_before(&(polls[index].object->poll_list), &(polls[index].list));
+    }
+
+#ifdef RT_HW_ATOMIC
+    /* pairs with the fence of an object made ready without lock */
+    rt_hw_atomic_fence();
+#endif
+
+    while (1)
+    {
+        ready = 0;
+        for (index = 0; index < count; index ++)
+        {
+            if (polls[index].result != -RT_ERROR)
+                polls[index].result = _rt_ipc_poll_ready(&polls[index]) ? RT_EOK : -RT_ETIMEOUT;
+            if (polls[index].result != -RT_ETIMEOUT)
+                ready ++;
+        }
+        if (ready > 0 || time == 0)
+            break;
+
+        /* the time left */
+        if (time > 0)
+        {
+            time -= (rt_int32_t)(rt_tick_get() - tick);
+            tick  = rt_tick_get();
+            if (time <= 0)
+                break;
+        }
+
+        /* suspend current thread until an object resumes it */
+        thread->error = RT_EOK;
+        rt_thread_suspend(thread);
+
+        /* has waiting time, start thread timer */
+        if (time > 0)
+        {
+            rt_timer_control(&(thread->thread_timer),
+                             RT_TIMER_CTRL_SET_TIME,
+                             &time);
+            rt_timer_start(&(thread->thread_timer));
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
+        /* do schedule */
+        rt_schedule();
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        /* check the objects for the last time */
+        if (thread->error == -RT_ETIMEOUT)
+            time = 0;
+    }
+
+    for (index = 0; index < count; index ++)
+        rt_list_remove(&(polls[index].list));
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    return ready > 0 ? ready : -RT_ETIMEOUT;
+}
+RTM_EXPORT(rt_ipc_poll);
+#endif /* end of RT_USING_IPC_POLL */
+
 /**@}*/
@@ -0,0 +1,309 @@
+/*
+ * Contention profile of IPC objects.
+ *
+ * The profiler takes over the object hooks and the scheduler hook: a thread
+ * notes the object and the tick as it tries to take it, the scheduler marks
+ * it as switched out if it's suspended or preempted before it takes the
+ * object, and the take counts the object as contended then, with the ticks
+ * waited. The hold time of a mutex is from its first take to its last
+ * release. The counters are in each IPC object, so they cost no search and
+ * go away with the object.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#ifdef RT_USING_IPC_PROFILE
+
+static const struct
+{
+    enum rt_object_class_type type;
+    const char *name;
+} rt_ipc_profile_class[] =
+{
+#ifdef RT_USING_SEMAPHORE
+    {RT_Object_Class_Semaphore,     "sem"},
+#endif
+#ifdef RT_USING_MUTEX
+    {RT_Object_Class_Mutex,         "mutex"},
+#endif
+#ifdef RT_USING_RWLOCK
+    {RT_Object_Class_RWLock,        "rwlock"},
+#endif
+#ifdef RT_USING_EVENT
+    {RT_Object_Class_Event,         "event"},
+#endif
+#ifdef RT_USING_MAILBOX
+    {RT_Object_Class_MailBox,       "mailbox"},
+#endif
+#ifdef RT_USING_MESSAGEQUEUE
+    {RT_Object_Class_MessageQueue,  "msgqueue"},
+#endif
+};
+
+#define RT_IPC_PROFILE_CLASSES  (sizeof(rt_ipc_profile_class) / sizeof(rt_ipc_profile_class[0]))
+
+/* the class name of an IPC object, RT_NULL for the other objects */
+static const char *rt_ipc_profile_class_name(struct rt_object *object)
+{
+    rt_uint32_t index;
+    rt_uint8_t type;
+
+    type = rt_object_get_type(object);
+    for (index = 0; index < RT_IPC_PROFILE_CLASSES; index ++)
+    {
+        if (rt_ipc_profile_class[index].type == type)
+            return rt_ipc_profile_class[index].name;
+    }
+
+    return RT_NULL;
+}
+
+static void rt_ipc_profile_trytake(struct rt_object *object)
+{
+    struct rt_thread *thread;
+
+    /* a try in interrupt is not the one of the interrupted thread */
+    thread = rt_thread_self();
+    if (thread == RT_NULL || rt_interrupt_get_nest() != 0 ||
+        rt_ipc_profile_class_name(object) == RT_NULL)
+        return;
+
+    thread->profile_object   = object;
+    thread->profile_tick     = rt_tick_get();
+    thread->profile_switched = RT_FALSE;
+}
+
+static void rt_ipc_profile_take(struct rt_object *object)
+{
+    struct rt_ipc_profile *profile;
+    struct rt_thread *thread;
+    register rt_base_t level;
+    rt_tick_t tick, wait;
+
+    if (rt_ipc_profile_class_name(object) == RT_NULL)
+        return;
+
+    profile = &(((struct rt_ipc_object *)object)->profile);
+    thread  = rt_thread_self();
+    tick    = rt_tick_get();
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    profile->acquire ++;
+    if (thread != RT_NULL && rt_interrupt_get_nest() == 0 &&
+        thread->profile_object == object)
+    {
+        wait = tick - thread->profile_tick;
+        if (thread->profile_switched)
+            profile->contended ++;
+        profile->wait_total += wait;
+        if (wait > profile->wait_max)
+            profile->wait_max = wait;
+
+        thread->profile_object = RT_NULL;
+    }
+
+#ifdef RT_USING_MUTEX
+    /* the first take of a mutex starts the hold */
+    if (rt_object_get_type(object) == RT_Object_Class_Mutex &&
+        ((rt_mutex_t)object)->hold == 1)
+        profile->hold_tick = tick;
+#endif
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+
+static void rt_ipc_profile_put(struct rt_object *object)
+{
+#ifdef RT_USING_MUTEX
+    struct rt_mutex *mutex;
+    register rt_base_t level;
+    rt_tick_t hold;
+
+    if (rt_object_get_type(object) != RT_Object_Class_Mutex)
+        return;
+
+    /* the last release of the owner ends the hold */
+    mutex = (struct rt_mutex *)object;
+    if (mutex->owner != rt_thread_self() || mutex->hold != 1)
+        return;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    hold = rt_tick_get() - mutex->parent.profile.hold_tick;
+    if (hold > mutex->parent.profile.hold_max)
+        mutex->parent.profile.hold_max = hold;
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+#endif
+}
+
+static void rt_ipc_profile_switch(struct rt_thread *from, struct rt_thread *to)
+{
+    /* the thread trying an object waits for it, or is preempted */
+    if (from->profile_object != RT_NULL)
+        from->profile_switched = RT_TRUE;
+}
+
+/**
+ * This function will start the contention profile of IPC objects. It sets
+ * the trytake, take and put hooks of object and the hook of scheduler,
+ * replacing the ones set before.
+ */
+void rt_ipc_profile_start(void)
+{
+    rt_object_trytake_sethook(rt_ipc_profile_trytake);
+    rt_object_take_sethook(rt_ipc_profile_take);
+    rt_object_put_sethook(rt_ipc_profile_put);
+    rt_scheduler_sethook(rt_ipc_profile_switch);
+}
+RTM_EXPORT(rt_ipc_profile_start);
+
+/**
+ * This function will stop the contention profile of IPC objects and clear
+ * the hooks it set. The profiles recorded are kept.
+ */
+void rt_ipc_profile_stop(void)
+{
+    rt_object_trytake_sethook(RT_NULL);
+    rt_object_take_sethook(RT_NULL);
+    rt_object_put_sethook(RT_NULL);
+    rt_scheduler_sethook(RT_NULL);
+}
+RTM_EXPORT(rt_ipc_profile_stop);
+
+/**
+ * This function will clear the profiles of all IPC objects.
+ */
+void rt_ipc_profile_reset(void)
+{
+    struct rt_object_information *information;
+    struct rt_ipc_object *ipc;
+    struct rt_list_node *node;
+    register rt_base_t level;
+    rt_uint32_t index;
+
+    for (index = 0; index < RT_IPC_PROFILE_CLASSES; index ++)
+    {
+        information = rt_object_get_information(rt_ipc_profile_class[index].type);
+        RT_ASSERT(information != RT_NULL);
+
+        /* disable interrupt */
+        level = rt_hw_interrupt_disable();
+
+        for (node = information->object_list.next;
+             node != &(information->object_list);
+             node = node->next)
+        {
+            ipc = (struct rt_ipc_object *)rt_list_entry(node, struct rt_object, list);
+            rt_memset(&(ipc->profile), 0, sizeof(ipc->profile));
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(level);
+    }
+}
+RTM_EXPORT(rt_ipc_profile_reset);
+
+/**
+ * This function will get the profile of an IPC object.
+ *
+ * @param object the IPC object
+ * @param profile the profile will be saved in
+ *
+ * @return RT_EOK, or -RT_ERROR if it's not an IPC object
+ */
+rt_err_t rt_ipc_profile_get(struct rt_object *object, struct rt_ipc_profile *profile)
+{
+    register rt_base_t level;
+
+    /* parameter check */
+    RT_ASSERT(object != RT_NULL);
+    RT_ASSERT(profile != RT_NULL);
+
+    if (rt_ipc_profile_class_name(object) == RT_NULL)
+        return -RT_ERROR;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+    *profile = ((struct rt_ipc_object *)object)->profile;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+RTM_EXPORT(rt_ipc_profile_get);
+
+/**
+ * This function will print the profiles of the IPC objects taken at least
+ * once, in ticks.
+ */
+void rt_ipc_profile_dump(void)
+{
+    struct rt_object_information *information;
+    struct rt_ipc_profile profile;
+    struct rt_object *object;
+    struct rt_list_node *node;
+    rt_uint32_t index;
+
+    rt_kprintf("%-*.*s type     acquire    contended  wait_total wait_max   hold_max\n",
+               RT_NAME_MAX, RT_NAME_MAX, "object");
+    rt_kprintf("%-*.*s -------- ---------- ---------- ---------- ---------- ----------\n",
+               RT_NAME_MAX, RT_NAME_MAX, "--------------------------------");
+
+    /* no object is deleted or detached while the lists are walked */
+    rt_enter_critical();
+
+    for (index = 0; index < RT_IPC_PROFILE_CLASSES; index ++)
+    {
+        information = rt_object_get_information(rt_ipc_profile_class[index].type);
+        RT_ASSERT(information != RT_NULL);
+
+        for (node = information->object_list.next;
+             node != &(information->object_list);
+             node = node->next)
+        {
+            object = rt_list_entry(node, struct rt_object, list);
+            if (rt_ipc_profile_get(object, &profile) != RT_EOK || profile.acquire == 0)
+                continue;
+
+            rt_kprintf("%-*.*s %-8s %-10lu %-10lu %-10lu %-10lu %lu\n",
+                       RT_NAME_MAX, RT_NAME_MAX, object->name,
+                       rt_ipc_profile_class[index].name,
+                       (unsigned long)profile.acquire,
+                       (unsigned long)profile.contended,
+                       (unsigned long)profile.wait_total,
+                       (unsigned long)profile.wait_max,
+                       (unsigned long)profile.hold_max);
+        }
+    }
+
+    rt_exit_critical();
+}
+RTM_EXPORT(rt_ipc_profile_dump);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+static int ipcprof(int argc, char **argv)
+{
+    if (argc > 1 && rt_strcmp(argv[1], "start") == 0)
+        rt_ipc_profile_start();
+    else if (argc > 1 && rt_strcmp(argv[1], "stop") == 0)
+        rt_ipc_profile_stop();
+    else if (argc > 1 && rt_strcmp(argv[1], "reset") == 0)
+        rt_ipc_profile_reset();
+    else
+        rt_ipc_profile_dump();
+
+    return 0;
+}
+MSH_CMD_EXPORT(ipcprof, IPC contention profile: ipcprof [start|stop|reset]);
+#endif
+
+#endif /* end of RT_USING_IPC_PROFILE */
@@ -37,7 +37,9 @@ void rt_interrupt_leave_sethook(void (*hook)(void))
 
 /**@{*/
 
+#ifndef RT_USING_SMP
 volatile rt_uint8_t rt_interrupt_nest;
+#endif
 
 /**
  * This function will be invoked by BSP, when enter interrupt service routine
@@ -50,6 +52,13 @@ void rt_interrupt_enter(void)
 {
     rt_base_t level;
 
+#ifdef RT_USING_SMP
+    /* the nest is of the running cpu, no lock among cpus */
+    level = rt_hw_local_irq_disable();
+    rt_cpu_self()->irq_nest ++;
+    RT_OBJECT_HOOK_CALL(rt_interrupt_enter_hook, ());
+    rt_hw_local_irq_enable(level);
+#else
     RT_DEBUG_LOG(RT_DEBUG_IRQ, ("irq coming..., irq nest:%d\n", 
                                 rt_interrupt_nest));
 
@@ -57,6 +66,7 @@ void rt_interrupt_enter(void)
     rt_interrupt_nest ++;
     RT_OBJECT_HOOK_CALL(rt_interrupt_enter_hook, ());
     rt_hw_interrupt_enable(level);
+#endif
 }
 RTM_EXPORT(rt_interrupt_enter);
 
@@ -71,6 +81,12 @@ void rt_interrupt_leave(void)
 {
     rt_base_t level;
 
+#ifdef RT_USING_SMP
+    level = rt_hw_local_irq_disable();
+    rt_cpu_self()->irq_nest --;
+    RT_OBJECT_HOOK_CALL(rt_interrupt_leave_hook, ());
+    rt_hw_local_irq_enable(level);
+#else
     RT_DEBUG_LOG(RT_DEBUG_IRQ, ("irq leave, irq nest:%d\n",
                                 rt_interrupt_nest));
 
@@ -78,6 +94,7 @@ void rt_interrupt_leave(void)
     rt_interrupt_nest --;
     RT_OBJECT_HOOK_CALL(rt_interrupt_leave_hook, ());
     rt_hw_interrupt_enable(level);
+#endif
 }
 RTM_EXPORT(rt_interrupt_leave);
 
@@ -91,7 +108,18 @@ RTM_EXPORT(rt_interrupt_leave);
  */
 rt_uint8_t rt_interrupt_get_nest(void)
 {
+#ifdef RT_USING_SMP
+    rt_base_t level;
+    rt_uint8_t nest;
+
+    level = rt_hw_local_irq_disable();
+    nest = rt_cpu_self()->irq_nest;
+    rt_hw_local_irq_enable(level);
+
+    return nest;
+#else
     return rt_interrupt_nest;
+#endif
 }
 RTM_EXPORT(rt_interrupt_get_nest);
 
@@ -17,7 +17,7 @@
 /* global errno in RT-Thread */
 static volatile int __rt_errno;
 
-#if defined(RT_USING_DEVIDE) && defined(RT_USING_CONSOLE)
+#if defined(RT_USING_DEVICE) && defined(RT_USING_CONSOLE)
 static rt_device_t _console_device = RT_NULL;
 #endif
 
@@ -122,7 +122,7 @@ void *rt_memset(void *s, int c, rt_ubase_t count)
     rt_uint32_t *aligned_addr;
     rt_uint32_t d = c & 0xff;
 
-    if (!TOO_SAMLL(count) && !UNALIGNED(s))
+    if (!TOO_SMALL(count) && !UNALIGNED(s))
     {
         /* If we get this far, we know that n is large and m is word-aligned. */
         aligned_addr = (rt_uint32_t *)s;
@@ -170,7 +170,7 @@ void *rt_memset(void *s, int c, rt_ubase_t count)
 
 #undef LBLOCKSIZE
 #undef UNALIGNED
-#undef TOO_SAMLL
+#undef TOO_SMALL
 #endif
 }
 RTM_EXPORT(rt_memset);
@@ -413,10 +413,11 @@ rt_int32_t rt_strncmp(const char *cs, const char *ct, rt_ubase_t count)
 {
     register unsigned char __res = 0;
 
-    while (count--)
+    while (count)
     {
-        if ((__res = *cs - *cs++) != 0 || !cs++)
+        if ((__res = *cs - *ct++) != 0 || !*cs++)
             break;
+        count --;
     }
 
     return __res;
@@ -528,22 +529,24 @@ rt_inline rt_int32_t divide(rt_int32_t *n, rt_int32_t base)
     if (base == 10)
     {
         res = ((rt_uint32_t) * n) % 10U;
-        *n = ((rt_uint32_t) * n) / 10U；
+        *n = ((rt_uint32_t) * n) / 10U;
     }
     else
     {
-        res = ((rt_uint32_t) * n) % 16U；
+        res = ((rt_uint32_t) * n) % 16U;
         *n = ((rt_uint32_t) * n) / 16U;
     }
 
     return res;
 }
 
+#define isdigit(c)  ((unsigned)((c) - '0') < 10)
+
 rt_inline int skip_atoi(const char **s)
 {
     register int i = 0;
     while (isdigit(**s))
-        i = i * 10 + *(*s++) - '0';
+        i = i * 10 + *((*s)++) - '0';
 
     return i;
 }
@@ -769,17 +772,17 @@ rt_int32_t rt_vsnprintf(char       *buf,
         {
             /* skips the first '%' also */
             ++ fmt;
-            if (*fmt == '-') flag |= LEFT;
-            else if (*fmt == '+') flag |= PLUS;
-            else if (*fmt == ' ') flag |= SPACE;
-            else if (*fmt == '#') flag |= SPECIAL;
-            else if (*fmt == '0') flag |= ZEROPAD;
+            if (*fmt == '-') flags |= LEFT;
+            else if (*fmt == '+') flags |= PLUS;
+            else if (*fmt == ' ') flags |= SPACE;
+            else if (*fmt == '#') flags |= SPECIAL;
+            else if (*fmt == '0') flags |= ZEROPAD;
             else break;
         }
 
         /* get field width */
         field_width = -1;
-        if (isdigit(*fmt)) filed_width = skip_atoi(&fmt);
+        if (isdigit(*fmt)) field_width = skip_atoi(&fmt);
         else if (*fmt == '*')
         {
             ++ fmt;
@@ -788,7 +791,7 @@ rt_int32_t rt_vsnprintf(char       *buf,
             if (field_width < 0)
             {
                 field_width = -field_width;
-                flag |= LEFT;
+                flags |= LEFT;
             }
         }
 
@@ -816,12 +819,12 @@ rt_int32_t rt_vsnprintf(char       *buf,
         if (*fmt == 'h' || *fmt == 'l')
 #endif
         {
-            qulifier == *fmt;
+            qualifier = *fmt;
             ++ fmt;
 #ifdef RT_PRINTF_LONGLONG
-            if (qulifier == 'l' && *fmt == 'l')
+            if (qualifier == 'l' && *fmt == 'l')
             {
-                qulifier = 'L';
+                qualifier = 'L';
                 ++ fmt;
             }
 #endif
@@ -833,11 +836,11 @@ rt_int32_t rt_vsnprintf(char       *buf,
         switch (*fmt)
         {
         case 'c':
-            if (!(flag & LEFT))
+            if (!(flags & LEFT))
             {
-                while (--filed_width > 0)
+                while (--field_width > 0)
                 {
-                    if (str < = end) *str = ' ';
+                    if (str <= end) *str = ' ';
                     ++ str;
                 }
             }
@@ -848,7 +851,7 @@ rt_int32_t rt_vsnprintf(char       *buf,
             ++ str;
 
             /* put width */
-            while (--filed_width > 0)
+            while (--field_width > 0)
             {
                 if (str <= end) *str = ' ';
                 ++ str;
@@ -864,7 +867,7 @@ rt_int32_t rt_vsnprintf(char       *buf,
             if (precision > 0 && len > precision) len = precision;
 #endif
 
-            if (!(flag & LEFT))
+            if (!(flags & LEFT))
             {
                 while (len < field_width--)
                 {
@@ -875,7 +878,7 @@ rt_int32_t rt_vsnprintf(char       *buf,
 
             for (i = 0; i < len; ++i)
             {
-                if (str <= len) *str = *s;
+                if (str <= end) *str = *s;
                 ++ str;
                 ++ s;
             }
@@ -891,7 +894,7 @@ rt_int32_t rt_vsnprintf(char       *buf,
             if (field_width == -1)
             {
                 field_width = sizeof(void *) << 1;
-                flag |= ZEROPAD;
+                flags |= ZEROPAD;
             }
 #ifdef RT_PRINTF_PRECISION
             str = print_number(str, end,
@@ -946,21 +949,22 @@ rt_int32_t rt_vsnprintf(char       *buf,
         if (qualifier == 'L') num = va_arg(args, long long);
         else if (qualifier == 'l')
 #else
-        if (qulifier == 'l')
+        if (qualifier == 'l')
 #endif
         {
             num = va_arg(args, rt_uint32_t);
-            if (flag & SIGN) num = (rt_int32_t)num;
+            if (flags & SIGN) num = (rt_int32_t)num;
         }
-        else if (qulifier == 'h')
+        else if (qualifier == 'h')
         {
             num = (rt_uint16_t) va_arg(args, rt_int32_t);
             if (flags & SIGN) num = (rt_int16_t)num;
         }
         else
         {
-            num = va_arg(args, rt_uint32_t);
-            if (flags & SIGN) num = (rt_int32_t)num;
+            /* int is narrower than rt_uint32_t on LP64 hosts */
+            num = va_arg(args, unsigned int);
+            if (flags & SIGN) num = (int)num;
         }
 #ifdef RT_PRINTF_PRECISION
         str = print_number(str, end, num, base, field_width, precision, flags);
@@ -1087,17 +1091,11 @@ RT_WEAK void rt_hw_console_output(const char *str)
 }
 RTM_EXPORT(rt_hw_console_output);
 
-/**
- * This function will put string to the console.
- *
- * @param str the string output to the console.
- */
-void rt_kputs(const char *str)
+/* write a string of 'length' characters, terminated by a null, to console */
+static void rt_console_write(const char *str, rt_size_t length)
 {
-    if (!str) return;
-
 #ifdef RT_USING_DEVICE
-    if (_console_device != RT_NULL)
+    if (_console_device == RT_NULL)
     {
         rt_hw_console_output(str);
     }
@@ -1106,7 +1104,7 @@ void rt_kputs(const char *str)
         rt_uint16_t old_flag = _console_device->open_flag;
 
         _console_device->open_flag |= RT_DEVICE_FLAG_STREAM;
-        rt_device_write(_console_device, 0, str, rt_strlen(str));
+        rt_device_write(_console_device, 0, str, length);
         _console_device->open_flag = old_flag;
     }
 #else
@@ -1114,18 +1112,322 @@ void rt_kputs(const char *str)
 #endif
 }
 
+#ifdef RT_USING_KPRINTF_ASYNC
+#ifndef RT_HW_ATOMIC
+#error "RT_USING_KPRINTF_ASYNC needs the atomic interfaces of rthw.h"
+#endif
+
+#ifndef RT_KPRINTF_ASYNC_SLOTS
+#define RT_KPRINTF_ASYNC_SLOTS          16
+#endif
+#if (RT_KPRINTF_ASYNC_SLOTS & (RT_KPRINTF_ASYNC_SLOTS - 1)) != 0
+#error "RT_KPRINTF_ASYNC_SLOTS must be a power of 2"
+#endif
+#ifndef RT_KPRINTF_THREAD_STACK_SIZE
+#define RT_KPRINTF_THREAD_STACK_SIZE    1024
+#endif
+#ifndef RT_KPRINTF_THREAD_PRIORITY
+#define RT_KPRINTF_THREAD_PRIORITY      (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
+#define RT_LOG_MASK                     (RT_KPRINTF_ASYNC_SLOTS - 1)
+
+/*
+ * The log ring of rt_kprintf and rt_kputs. The message of sequence 'pos' is
+ * in the slot 'pos & RT_LOG_MASK', and the round of the slot 'pos & ~mask'
+ * tells its state by 'seq': the round, free for the writer; the round + 1,
+ * the message is published; the round before + 1, the message of the last
+ * round isn't written out yet, so the ring is full. A writer claims 'pos' by
+ * a CAS on log_in, formats in the slot and publishes it, so the writers in
+ * threads and interrupts of all cpus never wait for each other or for the
+ * console. The log thread writes the messages out in order and frees the
+ * slots for the next round.
+ */
+struct rt_log_slot
+{
+    rt_ubase_t  seq;
+    rt_size_t   length;
+    char        buf[RT_CONSOLEBUF_SIZE];
+};
+
+static struct rt_log_slot log_ring[RT_KPRINTF_ASYNC_SLOTS];
+static rt_ubase_t log_in;                   /* the next sequence to claim */
+static rt_ubase_t log_out;                  /* the next sequence to write out */
+static rt_uint32_t log_drop;                /* the messages dropped as the ring is full */
+static rt_uint32_t log_drop_out;            /* the drops written out */
+static rt_bool_t log_sleep;                 /* the log thread is waiting for messages */
+
+static struct rt_thread log_thread;
+ALIGN(RT_ALIGN_SIZE)
+static rt_uint8_t log_thread_stack[RT_KPRINTF_THREAD_STACK_SIZE];
+
+/* claim a slot, RT_NULL and the message is dropped if the ring is full */
+static struct rt_log_slot *rt_log_claim(rt_ubase_t *round)
+{
+    struct rt_log_slot *slot;
+    rt_ubase_t pos, seq;
+
+    pos = rt_hw_atomic_load(&log_in);
+    while (1)
+    {
+        slot   = &log_ring[pos & RT_LOG_MASK];
+        *round = pos & ~(rt_ubase_t)RT_LOG_MASK;
+        seq    = rt_hw_atomic_load(&(slot->seq));
+
+        if (seq == *round)
+        {
+            if (rt_hw_atomic_cas(&log_in, pos, pos + 1))
+                return slot;
+        }
+        else if ((rt_base_t)(seq - *round) < 0)
+        {
+            rt_hw_atomic_add(&log_drop, 1);
+
+            return RT_NULL;
+        }
+
+        /* claimed by another writer */
+        pos = rt_hw_atomic_load(&log_in);
+    }
+}
+
+/* the next message is published, or the drops aren't written out */
+rt_inline rt_bool_t rt_log_pending(void)
+{
+    rt_ubase_t round;
+
+    round = log_out & ~(rt_ubase_t)RT_LOG_MASK;
+    return rt_hw_atomic_load(&(log_ring[log_out & RT_LOG_MASK].seq)) == round + 1 ||
+           rt_hw_atomic_load(&log_drop) != log_drop_out;
+}
+
+/* write out the published messages in order, and the drops */
+static void rt_log_drain(void)
+{
+    struct rt_log_slot *slot;
+    rt_ubase_t round;
+    rt_uint32_t drop;
+    char note[32];
+
+    while (1)
+    {
+        slot  = &log_ring[log_out & RT_LOG_MASK];
+        round = log_out & ~(rt_ubase_t)RT_LOG_MASK;
+        if (rt_hw_atomic_load(&(slot->seq)) != round + 1)
+            break;
+
+        rt_console_write(slot->buf, slot->length);
+
+        /* free the slot for the next round */
+        rt_hw_atomic_store(&(slot->seq), round + RT_KPRINTF_ASYNC_SLOTS);
+        log_out ++;
+    }
+
+    drop = rt_hw_atomic_load(&log_drop);
+    if (drop != log_drop_out)
+    {
+        rt_console_write(note, rt_snprintf(note, sizeof(note),
+                                           "[%lu messages dropped]\n",
+                                           (unsigned long)(drop - log_drop_out)));
+        log_drop_out = drop;
+    }
+}
+
+static void rt_log_thread_entry(void *parameter)
+{
+    register rt_base_t level;
+
+    while (1)
+    {
+        rt_log_drain();
+
+        /* disable interrupt */
+        level = rt_hw_interrupt_disable();
+
+        if (rt_log_pending())
+        {
+            /* enable interrupt */
+            rt_hw_interrupt_enable(level);
+            continue;
+        }
+
+        /* wait for the idle thread to wake it up */
+        log_sleep = RT_TRUE;
+        rt_thread_suspend(&log_thread);
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(level);
+
+        rt_schedule();
+    }
+}
+
+/**
+ * @ingroup SystemInit
+ *
+ * This function will initialize the log thread, which writes the messages
+ * of rt_kprintf and rt_kputs to console.
+ */
+void rt_kprintf_thread_init(void)
+{
+    rt_thread_init(&log_thread,
+                   "tlog",
+                   rt_log_thread_entry,
+                   RT_NULL,
+                   &log_thread_stack[0],
+                   sizeof(log_thread_stack),
+                   RT_KPRINTF_THREAD_PRIORITY,
+                   10);
+
+    rt_thread_startup(&log_thread);
+}
+
+/**
+ * This function will wake up the log thread if there are messages to write
+ * out, it's invoked by the idle thread.
+ */
+void rt_kprintf_wakeup(void)
+{
+    register rt_base_t level;
+
+    if (!log_sleep || !rt_log_pending())
+        return;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    if (log_sleep)
+    {
+        log_sleep = RT_FALSE;
+        rt_thread_resume(&log_thread);
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(level);
+
+        rt_schedule();
+        return;
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will wait until the messages printed before are written out
+ * to console. It's invoked in thread.
+ */
+void rt_kprintf_flush(void)
+{
+    rt_ubase_t pos;
+
+    /* no log thread, write them out here */
+    if ((log_thread.stat & RT_THREAD_STAT_MASK) == RT_THREAD_INIT)
+    {
+        rt_log_drain();
+        return;
+    }
+
+    pos = rt_hw_atomic_load(&log_in);
+    while ((rt_base_t)(rt_hw_atomic_load(&log_out) - pos) < 0 ||
+           rt_hw_atomic_load(&log_drop) != log_drop_out)
+    {
+        /* the log thread runs when the cpu is idle */
+        rt_thread_delay(1);
+    }
+}
+RTM_EXPORT(rt_kprintf_flush);
+
+/**
+ * This function will return the number of messages dropped as the log ring
+ * is full.
+ *
+ * @return the dropped messages
+ */
+rt_uint32_t rt_kprintf_drop_get(void)
+{
+    return rt_hw_atomic_load(&log_drop);
+}
+RTM_EXPORT(rt_kprintf_drop_get);
+#endif
+
+/**
+ * This function will put string to the console.
+ *
+ * @param str the string output to the console.
+ */
+void rt_kputs(const char *str)
+{
+#ifdef RT_USING_KPRINTF_ASYNC
+    struct rt_log_slot *slot;
+    rt_ubase_t round;
+    rt_size_t length;
+#endif
+
+    if (!str) return;
+
+#ifdef RT_USING_KPRINTF_ASYNC
+    /* the string before the scheduler starts is written out at once */
+    while (*str != '\0' && rt_thread_self() != RT_NULL)
+    {
+        slot = rt_log_claim(&round);
+        if (slot == RT_NULL)
+            return;
+
+        /* a long string takes several slots */
+        for (length = 0; length < RT_CONSOLEBUF_SIZE - 1 && str[length] != '\0'; length ++)
+            slot->buf[length] = str[length];
+        slot->buf[length] = '\0';
+        slot->length = length;
+        str += length;
+
+        /* publish it */
+        rt_hw_atomic_store(&(slot->seq), round + 1);
+    }
+    if (*str == '\0')
+        return;
+#endif
+
+    rt_console_write(str, rt_strlen(str));
+}
+
 /**
- * This function will print a formatted string on system console
+ * This function will print a formatted string on system console. With
+ * RT_USING_KPRINTF_ASYNC it's put in the log ring once the scheduler starts,
+ * and the log thread writes it out.
  *
  * @param fmt the format
  */
 void rt_kprintf(const char *fmt, ...)
 {
     va_list args;
-    rt_size_t length,
+    rt_size_t length;
     static char rt_log_buf[RT_CONSOLEBUF_SIZE];
+#ifdef RT_USING_KPRINTF_ASYNC
+    struct rt_log_slot *slot;
+    rt_ubase_t round;
+#endif
+
+    va_start(args, fmt);
+#ifdef RT_USING_KPRINTF_ASYNC
+    if (rt_thread_self() != RT_NULL)
+    {
+        slot = rt_log_claim(&round);
+        if (slot != RT_NULL)
+        {
+            length = rt_vsnprintf(slot->buf, sizeof(slot->buf) - 1, fmt, args);
+            if (length > RT_CONSOLEBUF_SIZE - 1)
+                length = RT_CONSOLEBUF_SIZE - 1;
+            slot->length = length;
+
+            /* publish it */
+            rt_hw_atomic_store(&(slot->seq), round + 1);
+        }
+        va_end(args);
+
+        return;
+    }
+#endif
 
-    va_strat(args, fmt);
     /* the return value of vsnprintf is the number of bytes that would be
      * written to buffer had if the size of the buffer been sufficiently
      * large excluding the terminating null byte. If the output string
@@ -1134,31 +1436,17 @@ void rt_kprintf(const char *fmt, ...)
     length = rt_vsnprintf(rt_log_buf, sizeof(rt_log_buf) - 1, fmt, args);
     if (length > RT_CONSOLEBUF_SIZE - 1)
         length = RT_CONSOLEBUF_SIZE - 1;
-#ifdef RT_USING_DEVICE
-    if (_console_device == RT_NULL)
-    {
-        rt_hw_console_output(rt_log_buff);
-    }
-    else
-    {
-        rt_uint16_t old_flag = _console_device->open_flag;
-
-        _console_device->open_flag |= RT_DEVICE_FLAG_STREAM;
-        rt_device_write(_console_device, 0, rt_log_buf, length);
-        _console_device->open_flag = old_flag;
-    }
-#else
-    rt_hw_console_output(rt_log_buf);
-#endif
+    rt_console_write(rt_log_buf, length);
     va_end(args);
 }
 RTM_EXPORT(rt_kprintf);
 #endif
 
-#ifdef RT_USING_HEAP
+#if defined(RT_USING_HEAP) && !defined(RT_USING_SMALL_MEM) && !defined(RT_USING_MEMHEAP_AS_HEAP)
 /**
  * This function allocates a memory block, which address is aligned to the
- * specified alignment size.
+ * specified alignment size. It's for the heaps which can't allocate aligned
+ * blocks themselves, the small memory and memheap heaps have their own.
  *
  * @param size the allocated memory block size
  * @param align the alignment size
@@ -1171,27 +1459,27 @@ void *rt_malloc_align(rt_size_t size, rt_size_t align)
     void *ptr;
     rt_size_t align_size;
 
-    /* align the alignment size to 4 byte */
-    align = ((align + 0x03) & ~0x03);
+    /* align the alignment size to pointer size */
+    align = RT_ALIGN(align, sizeof(void *));
 
     /* get total aligned size */
-    align_size = ((size + 0x03) & ~0x03) + align;
+    align_size = RT_ALIGN(size, sizeof(void *)) + align;
     /* allocate memory block from heap */
     ptr = rt_malloc(align_size);
     if(ptr != RT_NULL)
     {
         /* the allocated memory block is aligned */
-        if (((rt_uint32_t)ptr & (align - 1)) == 0)
+        if (((rt_ubase_t)ptr & (align - 1)) == 0)
         {
-            align_ptr = (void *)((rt_uint32_t)ptr + align);
+            align_ptr = (void *)((rt_ubase_t)ptr + align);
         }
         else
         {
-            align_ptr = (void *)(((rt_uint32_t)ptr + align - 1) & ~(align - 1));
+            align_ptr = (void *)(((rt_ubase_t)ptr + align - 1) & ~(align - 1));
         }
 
         /* set the pointer before alignment pointer to the real pointer */
-        *((rt_uint32_t *)((rt_uint32_t)align_ptr - sizeof(void *))) = (rt_uint32_t)ptr;
+        *((void **)((rt_ubase_t)align_ptr - sizeof(void *))) = ptr;
 
         ptr = align_ptr;
     }
@@ -1210,8 +1498,8 @@ void rt_free_align(void *ptr)
 {
     void *real_ptr;
 
-    real_ptr = (void *) * (rt_uint32_t *)((rt_uint32_t)ptr - sizeof(void *));
-    rt_free(real_align);
+    real_ptr = *(void **)((rt_ubase_t)ptr - sizeof(void *));
+    rt_free(real_ptr);
 }
 RTM_EXPORT(rt_free_align);
 #endif
@@ -1273,7 +1561,7 @@ void (*rt_assert_hook)(const char *ex, const char *func, rt_size_t line);
  *
  * @param hook the hook function
  */
-void rt_assert_set_hook(void (*hook)(const char *ex, const char func, rt_size_t line))
+void rt_assert_set_hook(void (*hook)(const char *ex, const char *func, rt_size_t line))
 {
     rt_assert_hook = hook;
 }
@@ -1302,6 +1590,10 @@ void rt_assert_handler(const char *ex_string, const char *func, rt_size_t line)
         {
             rt_kprintf("(%s) assertion failed at functions:%s, line number:%d \n", 
                        ex_string, func, line);
+#if defined(RT_USING_CONSOLE) && defined(RT_USING_KPRINTF_ASYNC)
+            /* the log thread may never run again */
+            rt_log_drain();
+#endif
             while (dummy == 0);
         }
     }
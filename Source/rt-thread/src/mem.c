@@ -73,6 +73,7 @@ static rt_size_t mem_size_aligned;
 
 #ifdef RT_MEM_STATS
 static rt_size_t used_mem, max_mem;
+static struct rt_realloc_stat realloc_stat;
 #endif
 #ifdef RT_USING_MEMTRACE
 rt_inline void rt_mem_setname(struct heap_mem *mem, const char *name)
@@ -110,7 +111,7 @@ static void plug_holes(struct heap_mem *mem)
         /* if mem->next is unused and not end of heap_ptr,
          * combine mem and mem->next
          */
-        if (lfree = nmem)
+        if (lfree == nmem)
         {
             lfree = mem;
         }
@@ -132,6 +133,52 @@ static void plug_holes(struct heap_mem *mem)
     }
 }
 
+/* cut a used block to size bytes if the rest holds a block, and free the rest */
+static void split_block(struct heap_mem *mem, rt_size_t size)
+{
+    rt_size_t ptr, ptr2;
+    struct heap_mem *mem2;
+
+    ptr = (rt_uint8_t *)mem - heap_ptr;
+    if (size + SIZEOF_STRUCT_MEM + MIN_SIZE_ALIGNED > mem->next - ptr - SIZEOF_STRUCT_MEM)
+        return;
+
+    ptr2 = ptr + SIZEOF_STRUCT_MEM + size;
+    mem2 = (struct heap_mem *)&heap_ptr[ptr2];
+    mem2->magic = HEAP_MAGIC;
+    mem2->used  = 0;
+    mem2->next  = mem->next;
+    mem2->prev  = ptr;
+#ifdef RT_USING_MEMTRACE
+    rt_mem_setname(mem2, "    ");
+#endif
+    mem->next = ptr2;
+    if (mem2->next != mem_size_aligned + SIZEOF_STRUCT_MEM)
+    {
+        ((struct heap_mem *)&heap_ptr[mem2->next])->prev = ptr2;
+    }
+
+#ifdef RT_MEM_STATS
+    used_mem -= (mem2->next - ptr2);
+#endif
+
+    if (mem2 < lfree)
+    {
+        /* the split remainder is now the lowest */
+        lfree = mem2;
+    }
+
+    plug_holes(mem2);
+}
+
+/* move lfree, taken in by the used block mem, to the next free block */
+static void lfree_update(struct heap_mem *mem)
+{
+    lfree = mem;
+    while (lfree->used && lfree != heap_end)
+        lfree = (struct heap_mem *)&heap_ptr[lfree->next];
+}
+
 /**
  * @ingroup SystemInit
  *
@@ -143,8 +190,8 @@ static void plug_holes(struct heap_mem *mem)
 void rt_system_heap_init(void *begin_addr, void *end_addr)
 {
     struct heap_mem *mem;
-    rt_uint32_t begin_align = RT_ALIGN((rt_uint32_t)begin_addr, RT_ALIGN_SIZE);
-    rt_uint32_t end_align = RT_ALIGN_DOWN((rt_uint32_t)end_addr, RT_ALIGN_SIZE);
+    rt_ubase_t begin_align = RT_ALIGN((rt_ubase_t)begin_addr, RT_ALIGN_SIZE);
+    rt_ubase_t end_align = RT_ALIGN_DOWN((rt_ubase_t)end_addr, RT_ALIGN_SIZE);
 
     RT_DEBUG_NOT_IN_INTERRUPT;
 
@@ -222,7 +269,7 @@ void *rt_malloc(rt_size_t size)
         RT_DEBUG_LOG(RT_DEBUG_MEM, ("malloc size %d, but align to %d\n",
                                     size, RT_ALIGN(size, RT_ALIGN_SIZE)));
     else
-        RT_DEBUG_LOG(RT_DEBUG_EM, ("malloc size %d\n", size));
+        RT_DEBUG_LOG(RT_DEBUG_MEM, ("malloc size %d\n", size));
 
     /* alignment size */
     size = RT_ALIGN(size, RT_ALIGN_SIZE);
@@ -283,7 +330,7 @@ void *rt_malloc(rt_size_t size)
 
                 if (mem2->next != mem_size_aligned + SIZEOF_STRUCT_MEM)
                 {
-                    ((struct heap_mem *)&heap_ptr[mem2->next]->prev) = ptr2;
+                    ((struct heap_mem *)&heap_ptr[mem2->next])->prev = ptr2;
                 }
 #ifdef RT_MEM_STATS
                 used_mem += (size + SIZEOF_STRUCT_MEM);
@@ -321,15 +368,15 @@ void *rt_malloc(rt_size_t size)
             {
                 /* Find next free block after mem and update lowest free pointer */
                 while (lfree->used && lfree != heap_end)
-                    lfree = (struct heap_mem *)heap_ptr[lfree->next];
+                    lfree = (struct heap_mem *)&heap_ptr[lfree->next];
 
                 RT_ASSERT(((lfree == heap_end) || (!lfree->used)));
             }
 
             rt_sem_release(&heap_sem);
-            RT_ASSERT((rt_uint32_t)mem + SIZEOF_STRUCT_MEM + SIZE <= (rt_uint32_t)heap_end);
-            RT_ASSERT((rt_uint32_t)((rt_uint8_t *)mem + SIZEOF_STRUCT_MEM) % RT_ALIGN_SIZE == 0);
-            RT_ASSERT((((rt_uint32_t)mem) & (RT_ALIGN_SIZE - 1)) == 0);
+            RT_ASSERT((rt_ubase_t)mem + SIZEOF_STRUCT_MEM + size <= (rt_ubase_t)heap_end);
+            RT_ASSERT((rt_ubase_t)((rt_uint8_t *)mem + SIZEOF_STRUCT_MEM) % RT_ALIGN_SIZE == 0);
+            RT_ASSERT((((rt_ubase_t)mem) & (RT_ALIGN_SIZE - 1)) == 0);
 
             RT_DEBUG_LOG(RT_DEBUG_MEM,
                          ("allocate memory at 0x%x, size: %d\n",
@@ -361,9 +408,9 @@ RTM_EXPORT(rt_malloc);
 void *rt_realloc(void *rmem, rt_size_t newsize)
 {
     rt_size_t size;
-    rt_size_t ptr, ptr2;
-    struct heap_mem *mem, *mem2;
-    void *nmem;
+    rt_size_t ptr, end;
+    struct heap_mem *mem, *nmem, *pmem;
+    void *new_rmem;
 
     RT_DEBUG_NOT_IN_INTERRUPT;
 
@@ -402,30 +449,91 @@ void *rt_realloc(void *rmem, rt_size_t newsize)
 
     ptr = (rt_uint8_t *)mem - heap_ptr;
     size = mem->next - ptr - SIZEOF_STRUCT_MEM;
-    if (size == newsize)
+    if (newsize <= size)
+    {
+        /* shrink in place, split the rest if it holds a block */
+        split_block(mem, newsize);
+#ifdef RT_MEM_STATS
+        realloc_stat.shrink ++;
+#endif
+        rt_sem_release(&heap_sem);
+
+        return rmem;
+    }
+
+    /* the end of the block, taking the next block in if it's free */
+    end  = mem->next;
+    nmem = (struct heap_mem *)&heap_ptr[mem->next];
+    if (nmem != heap_end && nmem->used == 0)
+        end = nmem->next;
+
+    if (end - ptr - SIZEOF_STRUCT_MEM >= newsize)
     {
-        /* the size is the same as */
+        /* grow into the next free block */
+#ifdef RT_MEM_STATS
+        used_mem += end - mem->next;
+        realloc_stat.grow_next ++;
+#endif
+        mem->next = end;
+        ((struct heap_mem *)&heap_ptr[end])->prev = ptr;
+        if (lfree == nmem)
+            lfree_update(mem);
+
+        split_block(mem, newsize);
+#ifdef RT_MEM_STATS
+        if (used_mem > max_mem)
+            max_mem = used_mem;
+#endif
         rt_sem_release(&heap_sem);
 
         return rmem;
     }
 
-    if (newsize + SIZEOF_STRUCT_MEM + MIN_SIZE < size)
+    pmem = (struct heap_mem *)&heap_ptr[mem->prev];
+    if (pmem != mem && pmem->used == 0 &&
+        end - mem->prev - SIZEOF_STRUCT_MEM >= newsize)
     {
+        /* grow into the previous free block and move the data down */
+#ifdef RT_MEM_STATS
+        used_mem += (ptr - mem->prev) + (end - mem->next);
+        realloc_stat.grow_prev ++;
+#endif
+#ifdef RT_USING_MEMTRACE
+        rt_memcpy(pmem->thread, mem->thread, sizeof(pmem->thread));
+#endif
+        pmem->used = 1;
+        pmem->next = end;
+        ((struct heap_mem *)&heap_ptr[end])->prev = mem->prev;
+        if (lfree == pmem || lfree == nmem)
+            lfree_update(pmem);
+
+        new_rmem = (rt_uint8_t *)pmem + SIZEOF_STRUCT_MEM;
+        rt_memmove(new_rmem, rmem, size);
+
+        split_block(pmem, newsize);
+#ifdef RT_MEM_STATS
+        if (used_mem > max_mem)
+            max_mem = used_mem;
+#endif
+        rt_sem_release(&heap_sem);
 
+        return new_rmem;
     }
 
+#ifdef RT_MEM_STATS
+    realloc_stat.copy ++;
+#endif
     rt_sem_release(&heap_sem);
 
     /* expand memory */
-    nmem = rt_malloc(newsize);
-    if (nmem != RT_NULL) /* check memory */
+    new_rmem = rt_malloc(newsize);
+    if (new_rmem != RT_NULL) /* check memory */
     {
-        rt_memcpy(nmem, rmem, size < newsize ? size : newsize);
+        rt_memcpy(new_rmem, rmem, size);
         rt_free(rmem);
     }
 
-    return nmem;
+    return new_rmem;
 }
 RTM_EXPORT(rt_realloc);
 
@@ -458,6 +566,134 @@ void *rt_calloc(rt_size_t count, rt_size_t size)
 }
 RTM_EXPORT(rt_calloc);
 
+/**
+ * This function allocates a memory block, which address is aligned to the
+ * specified alignment size. The free block found is split at the alignment
+ * boundary and the part before it is left free, so no more memory than the
+ * block is taken.
+ *
+ * @param size the allocated memory block size
+ * @param align the alignment size, a power of two
+ *
+ * @return the allocated memory block on successful, otherwise returns RT_NULL
+ */
+void *rt_malloc_align(rt_size_t size, rt_size_t align)
+{
+    rt_size_t ptr, ptr2;
+    rt_ubase_t data, align_data;
+    struct heap_mem *mem, *mem2;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+    RT_ASSERT((align & (align - 1)) == 0);
+
+    if (size == 0)
+        return RT_NULL;
+
+    if (align < RT_ALIGN_SIZE)
+        align = RT_ALIGN_SIZE;
+
+    /* alignment size */
+    size = RT_ALIGN(size, RT_ALIGN_SIZE);
+    if (size > mem_size_aligned)
+    {
+        RT_DEBUG_LOG(RT_DEBUG_MEM, ("no memory\n"));
+
+        return RT_NULL;
+    }
+
+    /* every data block must be at least MIN_SIZE_ALIGNED long */
+    if (size < MIN_SIZE_ALIGNED)
+        size = MIN_SIZE_ALIGNED;
+
+    /* take memory semaphore */
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+
+    for (ptr = (rt_uint8_t *)lfree - heap_ptr;
+         ptr < mem_size_aligned;
+         ptr = ((struct heap_mem *)&heap_ptr[ptr])->next)
+    {
+        mem = (struct heap_mem *)&heap_ptr[ptr];
+        if (mem->used)
+            continue;
+
+        /* the aligned data in the block, if it's not at the start, there
+         * shall be room for a free block before it */
+        data = (rt_ubase_t)mem + SIZEOF_STRUCT_MEM;
+        align_data = RT_ALIGN(data, align);
+        while (align_data != data &&
+               align_data - data < SIZEOF_STRUCT_MEM + MIN_SIZE_ALIGNED)
+            align_data += align;
+
+        if (align_data + size > (rt_ubase_t)&heap_ptr[mem->next])
+            continue;
+
+        if (align_data != data)
+        {
+            /* split at the alignment boundary, the leading part is left free */
+            ptr2 = align_data - SIZEOF_STRUCT_MEM - (rt_ubase_t)heap_ptr;
+            mem2 = (struct heap_mem *)&heap_ptr[ptr2];
+            mem2->magic = HEAP_MAGIC;
+            mem2->next  = mem->next;
+            mem2->prev  = ptr;
+
+            mem->next = ptr2;
+            if (mem2->next != mem_size_aligned + SIZEOF_STRUCT_MEM)
+            {
+                ((struct heap_mem *)&heap_ptr[mem2->next])->prev = ptr2;
+            }
+
+            mem = mem2;
+            ptr = ptr2;
+        }
+
+        mem->used = 1;
+#ifdef RT_USING_MEMTRACE
+        if (rt_thread_self())
+            rt_mem_setname(mem, rt_thread_self()->name);
+        else
+            rt_mem_setname(mem, "NONE");
+#endif
+#ifdef RT_MEM_STATS
+        used_mem += mem->next - ptr;
+#endif
+        if (mem == lfree)
+            lfree_update(mem);
+
+        /* the part after the block is left free too */
+        split_block(mem, size);
+#ifdef RT_MEM_STATS
+        if (max_mem < used_mem)
+            max_mem = used_mem;
+#endif
+        rt_sem_release(&heap_sem);
+
+        RT_DEBUG_LOG(RT_DEBUG_MEM,
+                     ("allocate memory at 0x%x aligned to %d, size: %d\n",
+                      align_data, align, size));
+
+        RT_OBJECT_HOOK_CALL(rt_malloc_hook, ((void *)align_data, size));
+
+        return (void *)align_data;
+    }
+
+    rt_sem_release(&heap_sem);
+
+    return RT_NULL;
+}
+RTM_EXPORT(rt_malloc_align);
+
+/**
+ * This function release the memory block, which is allocated by
+ * rt_malloc_align function and address is aligned.
+ *
+ * @param ptr the memory block pointer
+ */
+void rt_free_align(void *ptr)
+{
+    rt_free(ptr);
+}
+RTM_EXPORT(rt_free_align);
+
 /**
  * This function will release the previously allocated memory block by
  * rt_malloc. The released memory block is taken back to system heap.
@@ -476,7 +712,7 @@ void rt_free(void *rmem)
     RT_ASSERT((rt_uint8_t *)rmem >= (rt_uint8_t *)heap_ptr &&
               (rt_uint8_t *)rmem <  (rt_uint8_t *)heap_end);
 
-    RT_OBJECT_HOOK_CALL(rt_free_hook, rmem);
+    RT_OBJECT_HOOK_CALL(rt_free_hook, (rmem));
 
     if ((rt_uint8_t *)rmem < (rt_uint8_t *)heap_ptr || 
         (rt_uint8_t *)rmem >=  (rt_uint8_t *)heap_end)
@@ -502,7 +738,7 @@ void rt_free(void *rmem)
     {
         rt_kprintf("to free a bad data block:\n");
         rt_kprintf("mem: 0x%08x, used flag: %d, magic code: 0x%04x\n",
-                   mem, mem->used, mam->magic);
+                   mem, mem->used, mem->magic);
     }
     RT_ASSERT(mem->used);
     RT_ASSERT(mem->magic == HEAP_MAGIC);
@@ -520,7 +756,7 @@ void rt_free(void *rmem)
     }
 
 #ifdef RT_MEM_STATS
-    used_mem -= (mem->next - ((rt_uint8_t *)mem - heap_ptr))''
+    used_mem -= (mem->next - ((rt_uint8_t *)mem - heap_ptr));
 #endif
 
     /* finally, see if prev or next are free also */
@@ -544,21 +780,41 @@ void rt_memory_info(rt_uint32_t *total,
         *max_used = max_mem;
 }
 
+/**
+ * This function will get the counters of the ways rt_realloc resized the
+ * blocks.
+ *
+ * @param stat the counters will be saved in
+ */
+void rt_memory_realloc_stat(struct rt_realloc_stat *stat)
+{
+    RT_ASSERT(stat != RT_NULL);
+
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+    *stat = realloc_stat;
+    rt_sem_release(&heap_sem);
+}
+
 #ifdef RT_USING_FINSH
 #include <finsh.h>
 
 void list_mem(void)
 {
-    rt_kprintf("total memory: %d\n", mem_size_aligned);
-    rt_kprintf("used memory : %d\n", used_mem);
-    rt_kprintf("maximum allocated memory: %d\n", max_mem);
+    rt_kprintf("total memory: %lu\n", (unsigned long)mem_size_aligned);
+    rt_kprintf("used memory : %lu\n", (unsigned long)used_mem);
+    rt_kprintf("maximum allocated memory: %lu\n", (unsigned long)max_mem);
+    rt_kprintf("realloc shrink/next/prev/copy: %lu/%lu/%lu/%lu\n",
+               (unsigned long)realloc_stat.shrink,
+               (unsigned long)realloc_stat.grow_next,
+               (unsigned long)realloc_stat.grow_prev,
+               (unsigned long)realloc_stat.copy);
 }
 FINSH_FUNCTION_EXPORT(list_mem, list memory usage information)
 
 #ifdef RT_USING_MEMTRACE
 int memcheck(void)
 {
-    int postion;
+    int position;
     rt_uint32_t level;
     struct heap_mem *mem;
 
@@ -567,7 +823,7 @@ int memcheck(void)
          mem != heap_end; 
          mem = (struct heap_mem *)&heap_ptr[mem->next])
     {
-        position = (rt_uint32_t)mem - (rt_uint32_t)heap_ptr;
+        position = (rt_ubase_t)mem - (rt_ubase_t)heap_ptr;
         if (position < 0)                     goto __exit;
         if (position > mem_size_aligned)      goto __exit;
         if (mem->magic != HEAP_MAGIC)         goto __exit;
@@ -602,14 +858,14 @@ int memtrace(int argc, char **argv)
     rt_kprintf("heap_end: 0x%08x\n", heap_end);
 
     rt_kprintf("\n--memory item information --\n");
-    for (mem = (struct heap_mem *)heap_ptr,
+    for (mem = (struct heap_mem *)heap_ptr;
          mem != heap_end;
          mem = (struct heap_mem *)&heap_ptr[mem->next])
     {
-        int position = (rt_uint32_t)mem - (rt_uint32_t)heap_ptr;
+        int position = (rt_ubase_t)mem - (rt_ubase_t)heap_ptr;
         int size;
 
-        rt_kpritnf("[0x%08x - ", mem);
+        rt_kprintf("[0x%08x - ", mem);
 
         size = mem->next - position - SIZEOF_STRUCT_MEM;
         if (size < 1024)
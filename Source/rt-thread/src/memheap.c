@@ -13,7 +13,206 @@
 #define RT_MEMHEAP_MINIALLOC    12
 
 #define RT_MEMHEAP_SIZE         RT_ALIGN(sizeof(struct rt_memheap_item), RT_ALIGN_SIZE)
-#define MEMITEM_SIZE(item)      ((rt_uint32_t)item->next - (rt_uint32_t)item - RT_MEMHEAP_SIZE)
+#define MEMITEM_SIZE(item)      ((rt_ubase_t)item->next - (rt_ubase_t)item - RT_MEMHEAP_SIZE)
+
+#if RT_MEMHEAP_BIN_NR > 32
+#error "the bitmap of memheap bins is 32 bits"
+#endif
+
+/*
+ * The free blocks are kept in bins by size, the bin 'n' has the blocks of
+ * 2^(n + RT_MEMHEAP_BIN_SHIFT) to 2^(n + 1 + RT_MEMHEAP_BIN_SHIFT) bytes,
+ * the first bin the smaller ones too and the last bin the larger ones too.
+ * An allocation looks in the bin of its size for the best fit, then in the
+ * first larger bin not empty, where all blocks fit, for the best fit again.
+ * Only the first RT_MEMHEAP_BIN_SCAN blocks of a bin are looked at while a
+ * larger bin is not empty, so the time is bounded whatever the number of
+ * free blocks is, and an allocation fails only if no block fits.
+ */
+#define RT_MEMHEAP_BIN_SHIFT    4
+
+#ifndef RT_MEMHEAP_BIN_SCAN
+#define RT_MEMHEAP_BIN_SCAN     8
+#endif
+
+/* the index of the most significant bit set, value shall not be zero */
+rt_inline int _memheap_fls(rt_uint32_t value)
+{
+    int bit = 0;
+
+    if (value & 0xffff0000) { value >>= 16; bit += 16; }
+    if (value & 0xff00)     { value >>= 8;  bit += 8;  }
+    if (value & 0xf0)       { value >>= 4;  bit += 4;  }
+    if (value & 0x0c)       { value >>= 2;  bit += 2;  }
+    if (value & 0x02)       { bit += 1; }
+
+    return bit;
+}
+
+/* the bin of a free block of 'size' bytes */
+rt_inline int _memheap_bin(rt_uint32_t size)
+{
+    int bin;
+
+    if (size < (1UL << (RT_MEMHEAP_BIN_SHIFT + 1)))
+        return 0;
+
+    bin = _memheap_fls(size) - RT_MEMHEAP_BIN_SHIFT;
+
+    return bin < RT_MEMHEAP_BIN_NR ? bin : RT_MEMHEAP_BIN_NR - 1;
+}
+
+/* put a free block to the head of its bin */
+static void _memheap_insert_free(struct rt_memheap *heap, struct rt_memheap_item *item)
+{
+    int bin;
+
+    bin = _memheap_bin(MEMITEM_SIZE(item));
+
+    item->prev_free = RT_NULL;
+    item->next_free = heap->free_bin[bin];
+    if (item->next_free != RT_NULL)
+        item->next_free->prev_free = item;
+    heap->free_bin[bin] = item;
+
+    heap->free_bitmap |= (1UL << bin);
+}
+
+/* take a free block off its bin, before its size is changed */
+static void _memheap_remove_free(struct rt_memheap *heap, struct rt_memheap_item *item)
+{
+    int bin;
+
+    bin = _memheap_bin(MEMITEM_SIZE(item));
+
+    if (item->next_free != RT_NULL)
+        item->next_free->prev_free = item->prev_free;
+    if (item->prev_free != RT_NULL)
+        item->prev_free->next_free = item->next_free;
+    else
+        heap->free_bin[bin] = item->next_free;
+
+    if (heap->free_bin[bin] == RT_NULL)
+        heap->free_bitmap &= ~(1UL << bin);
+
+    item->next_free = RT_NULL;
+    item->prev_free = RT_NULL;
+}
+
+/* take the best fit free block of at least 'size' bytes off its bin */
+static struct rt_memheap_item *_memheap_take_free(struct rt_memheap *heap, rt_uint32_t size)
+{
+    struct rt_memheap_item *item, *best;
+    rt_uint32_t map, free_size, best_size;
+    int bin, scan;
+
+    best      = RT_NULL;
+    best_size = 0;
+
+    /* the bins not empty from the one of 'size', which has the smaller
+     * blocks too, all blocks of a larger one fit */
+    map = heap->free_bitmap & (0xffffffffUL << _memheap_bin(size));
+    while (map != 0 && best == RT_NULL)
+    {
+        bin = __rt_ffs((int)map) - 1;
+        map &= ~(1UL << bin);
+
+        /* the whole bin is looked at if no larger one may take over */
+        for (item = heap->free_bin[bin], scan = 0;
+             item != RT_NULL && (scan < RT_MEMHEAP_BIN_SCAN || map == 0);
+             item = item->next_free, scan ++)
+        {
+            free_size = MEMITEM_SIZE(item);
+            if (free_size >= size && (best == RT_NULL || free_size < best_size))
+            {
+                best      = item;
+                best_size = free_size;
+
+                /* no better one */
+                if (free_size == size)
+                    break;
+            }
+        }
+    }
+
+    if (best != RT_NULL)
+        _memheap_remove_free(heap, best);
+
+    return best;
+}
+
+/* take the next block, which is free, into the block */
+static void _memheap_merge_next(struct rt_memheap *heap, struct rt_memheap_item *item)
+{
+    struct rt_memheap_item *next_ptr;
+
+    next_ptr = item->next;
+    RT_ASSERT(!RT_MEMHEAP_IS_USED(next_ptr));
+
+    heap->available_size = heap->available_size - MEMITEM_SIZE(next_ptr);
+    _memheap_remove_free(heap, next_ptr);
+
+    next_ptr->next->prev = item;
+    item->next = next_ptr->next;
+}
+
+/* cut a used block to 'size' bytes if the rest makes a block, and free the rest */
+static void _memheap_split(struct rt_memheap *heap, struct rt_memheap_item *item, rt_uint32_t size)
+{
+    struct rt_memheap_item *new_ptr;
+
+    /* don't split when there is less than one node space left */
+    if (size + RT_MEMHEAP_SIZE + RT_MEMHEAP_MINIALLOC >= MEMITEM_SIZE(item))
+        return;
+
+    new_ptr = (struct rt_memheap_item *)(((rt_uint8_t *)item) + size + RT_MEMHEAP_SIZE);
+
+    RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
+                 ("split: block[0x%08x] nextm[0x%08x] prevm[0x%08x] to new[0x%08x]\n",
+                  item,
+                  item->next,
+                  item->prev,
+                  new_ptr));
+
+    /* mark the new block as a memory block and freed. */
+    new_ptr->magic = RT_MEMHEAP_MAGIC;
+    /* put the pool pointer into the new block. */
+    new_ptr->pool_ptr = heap;
+
+    /* break down the block list */
+    new_ptr->prev    = item;
+    new_ptr->next    = item->next;
+    item->next->prev = new_ptr;
+    item->next       = new_ptr;
+
+    /* merge block with next neighbor if it's free. */
+    if (!RT_MEMHEAP_IS_USED(new_ptr->next))
+        _memheap_merge_next(heap, new_ptr);
+
+    /* insert the split block to free list */
+    _memheap_insert_free(heap, new_ptr);
+
+    /* increment the available byte count.  */
+    heap->available_size = heap->available_size + MEMITEM_SIZE(new_ptr);
+}
+
+/* the aligned address of 'size' bytes in a free block, with room for a free
+ * block before it if it's not at the start, 0 if they don't fit */
+static rt_ubase_t _memheap_fit_align(struct rt_memheap_item *item, rt_size_t size, rt_size_t align)
+{
+    rt_ubase_t data, align_data;
+
+    data = (rt_ubase_t)item + RT_MEMHEAP_SIZE;
+    align_data = RT_ALIGN(data, align);
+    while (align_data != data &&
+           align_data - data < RT_MEMHEAP_SIZE + RT_MEMHEAP_MINIALLOC)
+        align_data += align;
+
+    if (align_data + size > (rt_ubase_t)item->next)
+        return 0;
+
+    return align_data;
+}
 
 /*
  * The initialized memory pool will be:
@@ -43,17 +242,11 @@ rt_err_t rt_memheap_init(struct rt_memheap *memheap,
     memheap->available_size = memheap->pool_size - (2 * RT_MEMHEAP_SIZE);
     memheap->max_used_size  = memheap->pool_size - memheap->available_size;
 
-    /* initialize the free list header */
-    item            = &(memheap->free_header);
-    item->magic     = RT_MEMHEAP_MAGIC;
-    item->pool_ptr  = memheap;
-    item->next      = RT_NULL;
-    item->prev      = RT_NULL;
-    item->next_free = item;
-    item->prev_free = item;
+    /* no free block yet */
+    rt_memset(memheap->free_bin, 0, sizeof(memheap->free_bin));
+    memheap->free_bitmap = 0;
 
-    /* set the free list to free list header */
-    memheap->free_list = item;
+    rt_memset(&(memheap->realloc_stat), 0, sizeof(memheap->realloc_stat));
 
     /* initialize the first big memory block */
     item            = (struct rt_memheap_item *)start_addr;
@@ -61,8 +254,8 @@ rt_err_t rt_memheap_init(struct rt_memheap *memheap,
     item->pool_ptr  = memheap;
     item->next      = RT_NULL;
     item->prev      = RT_NULL;
-    item->next_free = item;
-    item->next_free = item;
+    item->next_free = RT_NULL;
+    item->prev_free = RT_NULL;
 
     item->next = (struct rt_memheap_item *)
                  ((rt_uint8_t *)item + memheap->available_size + RT_MEMHEAP_SIZE);
@@ -72,10 +265,7 @@ rt_err_t rt_memheap_init(struct rt_memheap *memheap,
     memheap->block_list = item;
 
     /* place the big memory block to free list */
-    item->next_free = memheap->free_list->next_free;
-    item->prev_free = memheap->free_list;
-    memheap->free_list->next_free->prev_free = item;
-    memheap->free_list->next_free            = item;
+    _memheap_insert_free(memheap, item);
 
     /* move to the end of memory pool to build a small tailer block,
      * which prevents block merging
@@ -93,8 +283,8 @@ rt_err_t rt_memheap_init(struct rt_memheap *memheap,
     rt_sem_init(&(memheap->lock), name, 1, RT_IPC_FLAG_FIFO);
 
     RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                 ("memory heap: start addr 0x%08x, size %d, free list header 0x%08x\n",
-                  start_addr, size, &(memheap->free_header)));
+                 ("memory heap: start addr 0x%08x, size %d\n",
+                  start_addr, size));
 
     return RT_EOK;
 }
@@ -113,11 +303,11 @@ rt_err_t rt_memheap_detach(struct rt_memheap *heap)
 }
 RTM_EXPORT(rt_memheap_detach);
 
-void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
+void *rt_memheap_alloc(struct rt_memheap *heap, rt_uint32_t size)
 {
     rt_err_t result;
     rt_uint32_t free_size;
-    struct rt_memheap_item *head_ptr;
+    struct rt_memheap_item *header_ptr;
 
     RT_ASSERT(heap != RT_NULL);
     RT_ASSERT(rt_object_get_type(&heap->parent) == RT_Object_Class_MemHeap);
@@ -132,9 +322,6 @@ void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
 
     if (size < heap->available_size)
     {
-        /* search on free list */
-        free_size = 0;
-
         /* lock memheap */
         result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
         if (result != RT_EOK)
@@ -144,23 +331,14 @@ void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
             return RT_NULL;
         }
 
-        /* get the first free memory block */
-        header_ptr = heap->free_list.next_free;
-        while (header_ptr != heap->free_list && free_size < size)
-        {
-            /* get current freed memory block size */
-            free_size = MEMITEM_SIZE(header_ptr);
-            if (free_size < size)
-            {
-                /* move to next free memory block */
-                header_ptr = header_ptr->next_free;
-            }
-        }
+        /* search on the bins, the block is off them */
+        header_ptr = _memheap_take_free(heap, size);
 
         /* determine if the memory is available. */
-        if (free_size >= size)
+        if (header_ptr != RT_NULL)
         {
             /* a block that satisfies the request has been found. */
+            free_size = MEMITEM_SIZE(header_ptr);
 
             /* determine if the block needs to be split. */
             if (free_size > (size + RT_MEMHEAP_SIZE + RT_MEMHEAP_MINIALLOC))
@@ -190,17 +368,8 @@ void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
                 header_ptr->next->prev = new_ptr;
                 header_ptr->next       = new_ptr;
 
-                /* remove header ptr from free list */
-                header_ptr->next_free->prev_free = header_ptr->prev_free;
-                header_ptr->prev_free->next_free = header_ptr->next_free;
-                header_ptr->next_free = RT_NULL;
-                header_ptr->prev_free = RT_NULL;
-
                 /* insert new_ptr to free list */
-                new_ptr->next_free = heap->free_list->next_free;
-                new_ptr->prev_free = heap->free_list;
-                heap->free_list->next_free->prev_free = new_ptr;
-                heap->free_list->next_free = new_ptr;
+                _memheap_insert_free(heap, new_ptr);
                 RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
                              ("new ptr: next_free 0x%08x, prev_free 0x%08x",
                               new_ptr->next_free,
@@ -218,17 +387,8 @@ void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
                 if (heap->pool_size - heap->available_size > heap->max_used_size)
                     heap->max_used_size = heap->pool_size - heap->available_size;
 
-                /* remove header_ptr from free list */
                 RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                             ("one block: block[0x%08x], next_free 0x%08x, prev_free 0x%08x\n",
-                              header_ptr,
-                              header_ptr->next_free,
-                              header_ptr->prev_free));
-
-                header_ptr->next_free->prev_free = header_ptr->prev_free;
-                header_ptr->prev_free->next_free = header_ptr->next_free;
-                header_ptr->next_free = RT_NULL;
-                header_ptr->prev_free = RT_NULL;
+                             ("one block: block[0x%08x]\n", header_ptr));
             }
 
             /* Mark the allocated block as not available. */
@@ -248,7 +408,7 @@ void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
         }
 
         /* release lock */
-        re_sem_release(&(heap->lock));
+        rt_sem_release(&(heap->lock));
     }
 
     RT_DEBUG_LOG(RT_DEBUG_MEMHEAP, ("allocate memory: failed\n"));
@@ -257,12 +417,117 @@ void *rt_memheap_alloc(struct rt_memheap *heap, rt_uin32_t size)
 }
 RTM_EXPORT(rt_memheap_alloc);
 
-void *rt_memheap_realloc(struct rt_memheap *heap, void *ptr, rt_size_t newsize)
+/**
+ * This function allocates a memory block from a memory heap, which address
+ * is aligned to the specified alignment size. The free block found is split
+ * at the alignment boundary and the part before it is left free. As the fit
+ * depends on the address, it's the first fit on the bins of the size and the
+ * larger ones. The block is released by rt_memheap_free.
+ *
+ * @param heap the memory heap object
+ * @param size the allocated memory block size
+ * @param align the alignment size, a power of two
+ *
+ * @return the allocated memory block on successful, otherwise returns RT_NULL
+ */
+void *rt_memheap_alloc_align(struct rt_memheap *heap, rt_size_t size, rt_size_t align)
 {
     rt_err_t result;
-    rt_size_t oldsize;
+    rt_ubase_t align_data;
     struct rt_memheap_item *header_ptr;
     struct rt_memheap_item *new_ptr;
+    int bin;
+
+    RT_ASSERT(heap != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&heap->parent) == RT_Object_Class_MemHeap);
+    RT_ASSERT((align & (align - 1)) == 0);
+
+    if (align < RT_ALIGN_SIZE)
+        align = RT_ALIGN_SIZE;
+
+    /* align allocated size */
+    size = RT_ALIGN(size, RT_ALIGN_SIZE);
+    if (size < RT_MEMHEAP_MINIALLOC)
+        size = RT_MEMHEAP_MINIALLOC;
+
+    if (size >= heap->available_size)
+        return RT_NULL;
+
+    /* lock memheap */
+    result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+    if (result != RT_EOK)
+    {
+        rt_set_errno(result);
+
+        return RT_NULL;
+    }
+
+    align_data = 0;
+    header_ptr = RT_NULL;
+    for (bin = _memheap_bin(size); bin < RT_MEMHEAP_BIN_NR && align_data == 0; bin ++)
+    {
+        for (header_ptr = heap->free_bin[bin];
+             header_ptr != RT_NULL;
+             header_ptr = header_ptr->next_free)
+        {
+            align_data = _memheap_fit_align(header_ptr, size, align);
+            if (align_data != 0)
+                break;
+        }
+    }
+
+    if (align_data != 0)
+    {
+        _memheap_remove_free(heap, header_ptr);
+        heap->available_size = heap->available_size - MEMITEM_SIZE(header_ptr);
+
+        if (align_data != (rt_ubase_t)header_ptr + RT_MEMHEAP_SIZE)
+        {
+            /* split at the alignment boundary, the leading part is left free */
+            new_ptr = (struct rt_memheap_item *)(align_data - RT_MEMHEAP_SIZE);
+            new_ptr->magic     = RT_MEMHEAP_MAGIC;
+            new_ptr->pool_ptr  = heap;
+            new_ptr->next_free = RT_NULL;
+            new_ptr->prev_free = RT_NULL;
+
+            new_ptr->prev          = header_ptr;
+            new_ptr->next          = header_ptr->next;
+            header_ptr->next->prev = new_ptr;
+            header_ptr->next       = new_ptr;
+
+            _memheap_insert_free(heap, header_ptr);
+            heap->available_size = heap->available_size + MEMITEM_SIZE(header_ptr);
+
+            header_ptr = new_ptr;
+        }
+
+        /* Mark the allocated block as not available, the part after it is
+         * left free too. */
+        header_ptr->magic |= RT_MEMHEAP_USED;
+        _memheap_split(heap, header_ptr, size);
+
+        if (heap->pool_size - heap->available_size > heap->max_used_size)
+            heap->max_used_size = heap->pool_size - heap->available_size;
+    }
+
+    /* release lock */
+    rt_sem_release(&(heap->lock));
+
+    RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
+                 ("alloc mem: memory[0x%08x] aligned to %d, heap[0x%08x], size: %d\n",
+                  align_data, align, heap, size));
+
+    return (void *)align_data;
+}
+RTM_EXPORT(rt_memheap_alloc_align);
+
+void *rt_memheap_realloc(struct rt_memheap *heap, void *ptr, rt_size_t newsize)
+{
+    rt_err_t result;
+    rt_size_t oldsize, size;
+    struct rt_memheap_item *header_ptr;
+    struct rt_memheap_item *next_ptr, *prev_ptr;
+    void *new_ptr;
 
     RT_ASSERT(heap != RT_NULL);
     RT_ASSERT(rt_object_get_type(&(heap->parent)) == RT_Object_Class_MemHeap);
@@ -286,188 +551,114 @@ void *rt_memheap_realloc(struct rt_memheap *heap, void *ptr, rt_size_t newsize)
 
     /* get memory block header and get the size of memory block */
     header_ptr = (struct rt_memheap_item *)
-                 ((rt_uint8 *)ptr - RT_MEMHEAP_SIZE);
+                 ((rt_uint8_t *)ptr - RT_MEMHEAP_SIZE);
     oldsize = MEMITEM_SIZE(header_ptr);
 
-    /* re-allocate memory */
-    if (newsize > oldsize)
+    /* lock memheap */
+    result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
+    if (result != RT_EOK)
     {
-        void *new_ptr;
-        struct rt_memheap_item *next_ptr;
-
-        /* lock memheap */
-        result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
-        if (result != RT_EOK)
-        {
-            rt_set_errno(result);
-
-            reutrn RT_NULL;
-        }
-
-        next_ptr = header_ptr->next;
-
-        /* header_ptr should not be the tail */
-        RT_ASSERT(next_ptr > header_ptr);
+        rt_set_errno(result);
 
-        /* check whether the following free space is enough to expand */
-        if (!RT_MEMHEAP_IS_USED(next_ptr))
-        {
-            rt_int32_t nextsize;
-
-            nextsize = MEMITEM_SIZE(next_ptr);
-            RT_ASSERT(next_ptr > 0);
-
-            /* Here is the ASCII art of the situation that we can make use of
-             * the next free node without alloc/memcpy, |*| is the control
-             * block:
-             *
-             *      oldsize           free node
-             * |*|-----------|*|----------------------|*|
-             *         newsize          >= minialloc
-             * |*|----------------|*|-----------------|*|
-             */
-            if (nextsize + oldsize > newsize + RT_MEMHEAP_MINIALLOC)
-            {
-                /* decrement the entire free size from the available bytes count. */
-                heap->available_size = heap->available_size - (newsize - oldsize);
-                if (heap->pool_size - heap->available_size > heap->max_used_size)
-                    heap->max_used_size = heap->pool_size - heap->available_size;
+        return RT_NULL;
+    }
 
-                /* remove next_ptr from free list */
-                RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                             ("remove block: block[0x%08x], next_free[0x%08x], prev_free[0x%08x]\n",
-                              next_ptr,
-                              next_ptr->next_free,
-                              next_ptr->prev_free));
+    if (newsize <= oldsize)
+    {
+        /* shrink in place, the rest is freed if it makes a block */
+        _memheap_split(heap, header_ptr, newsize);
+        heap->realloc_stat.shrink ++;
 
-                next_ptr->next_free->prev_free = next_ptr->prev_free;
-                next_ptr->prev_free->next_free = next_ptr->next_free;
-                next_ptr->next->prev = next_ptr->prev;
-                next_ptr->prev->next = next_ptr->next;
+        /* release lock */
+        rt_sem_release(&(heap->lock));
 
-                /* build a new one on the right place */
-                next_ptr = (struct rt_memheap_item *)((char *)ptr + newsize);
+        return ptr;
+    }
 
-                RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                             ("new free block: block[0x%08x], nextm[0x%08x], prevm[0x%08x]",
-                              next_ptr,
-                              next_ptr->next,
-                              next_ptr->prev));
+    next_ptr = header_ptr->next;
+    prev_ptr = header_ptr->prev;
 
-                /* mark the new block as a memory block and freed. */
-                next_ptr->magic = RT_MEMHEAP_MAGIC;
+    /* header_ptr should not be the tail */
+    RT_ASSERT(next_ptr > header_ptr);
 
-                /* put the pool pointer into the new block. */
-                next_ptr->pool_ptr = heap;
-
-                next_ptr->prev         = header_ptr;
-                next_ptr->next         = header_ptr->next;
-                header_ptr->next->prev = next_ptr;
-                header_ptr->next       = next_ptr;
-
-                /* insert next_ptr to free list */
-                next_ptr->next_free = heap->free_list->next_free;
-                next_ptr->prev_free = heap->free_list;
-                heap->free_list->next_free->prev_free = next_ptr;
-                heap->next_free                       = next_ptr;
-                RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                             ("new ptr: next_free 0x%08x, prev_free 0x%08x",
-                               next_ptr->next_free,
-                               next_ptr->prev_free));
+    /* the size the block may grow to in place, with the next free block */
+    size = oldsize;
+    if (!RT_MEMHEAP_IS_USED(next_ptr))
+        size += RT_MEMHEAP_SIZE + MEMITEM_SIZE(next_ptr);
 
-                /* release lock */
-                rt_sem_release(&(heap->lock));
+    /* Here is the ASCII art of the situation that we can make use of the
+     * next free node without alloc/memcpy, |*| is the control block:
+     *
+     *      oldsize           free node
+     * |*|-----------|*|----------------------|*|
+     *         newsize          rest if any
+     * |*|----------------|*|-----------------|*|
+     */
+    if (size >= newsize)
+    {
+        _memheap_merge_next(heap, header_ptr);
+        _memheap_split(heap, header_ptr, newsize);
+        heap->realloc_stat.grow_next ++;
 
-                return ptr;
-            }
-        }
+        if (heap->pool_size - heap->available_size > heap->max_used_size)
+            heap->max_used_size = heap->pool_size - heap->available_size;
 
         /* release lock */
         rt_sem_release(&(heap->lock));
 
-        /* re-allocate a memory block */
-        new_ptr = (void *)rt_memheap_alloc(heap, new_size);
-        if (new_ptr != RT_NULL)
-        {
-            rt_memcpy(new_ptr, ptr, oldsize < newsize ? oldsize : newsize);
-            rt_memheap_free(ptr);
-        }
-
-        return new_ptr;
-    }
-
-    /* don't split when there is less than one node space left */
-    if (newsize + RT_MEMHEAP_SIZE + RT_MEMHEAP_MINIALLOC >= oldsize)
         return ptr;
-
-    /* lock memheap */
-    result = rt_sem_take(&(heap->lock), RT_WAITING_FOREVER);
-    if (result != RT_EOK)
-    {
-        rt_set_errno(result);
-
-        return RT_NULL;
     }
 
-    /* split the block. */
-    new_ptr = (struct rt_memheap *)
-              (((rt_uint8_t *)header_ptr) + newsize + RT_MEMHEAP_SIZE);
-
-    RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                 ("split: block[0x%08x] nextm[0x%08x] prevm[0x%08x] to new[0x%08x]\n",
-                  header_ptr,
-                  header_ptr->next,
-                  header_ptr->prev,
-                  new_ptr));
+    /* or take the previous free node in too and move the data down, the
+     * previous block of the first one is the tail, which is used:
+     *
+     *     free node         oldsize        free node if any
+     * |*|--------------|*|-----------|*|----------------------|*|
+     *              newsize                      rest if any
+     * |*|-----------------------------|*|---------------------|*|
+     */
+    if (!RT_MEMHEAP_IS_USED(prev_ptr) &&
+        MEMITEM_SIZE(prev_ptr) + RT_MEMHEAP_SIZE + size >= newsize)
+    {
+        if (!RT_MEMHEAP_IS_USED(next_ptr))
+            _memheap_merge_next(heap, header_ptr);
 
-    /* mark the new block as a memory block and freed. */
-    new_ptr->magic = RT_MEMHEAP_MAGIC;
-    /* put the pool pointer into the new block. */
-    new_ptr->pool_ptr = heap;
+        heap->available_size = heap->available_size - MEMITEM_SIZE(prev_ptr);
+        _memheap_remove_free(heap, prev_ptr);
 
-    /* break down the block list */
-    new_ptr->prev          = header_ptr;
-    new_ptr->next          = header_ptr->next;
-    header_ptr->next->prev = new_ptr;
-    header_ptr->next       = new_ptr;
+        prev_ptr->magic |= RT_MEMHEAP_USED;
+        prev_ptr->next = header_ptr->next;
+        header_ptr->next->prev = prev_ptr;
 
-    /* determine if the block can be merged with the next neighbor. */
-    if (!RT_MEMHEAP_IS_USED(new_ptr->next))
-    {
-        struct rt_memheap_item *free_ptr;
+        new_ptr = (void *)((rt_uint8_t *)prev_ptr + RT_MEMHEAP_SIZE);
+        rt_memmove(new_ptr, ptr, oldsize);
 
-        /* merge block with next neighbor. */
-        free_ptr = new_ptr->next;
-        heap->available_size = heap->available_size - MEMITEM_SIZE(free_ptr);
+        _memheap_split(heap, prev_ptr, newsize);
+        heap->realloc_stat.grow_prev ++;
 
-        RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                     ("merge: right node 0x%08x, next_free 0x%08x, prev_free 0x%08x\n",
-                      header_ptr, header_ptr->next_free, header_ptr->prev_free));
+        if (heap->pool_size - heap->available_size > heap->max_used_size)
+            heap->max_used_size = heap->pool_size - heap->available_size;
 
-        free_ptr->next->prev = new_ptr;
-        new_ptr->next = free_ptr->next;
+        /* release lock */
+        rt_sem_release(&(heap->lock));
 
-        /* remove free ptr from free list */
-        free_ptr->next_free->prev_free = free_ptr->prev_free;
-        free_ptr->prev_free->next_free = free_ptr->next_free;
+        return new_ptr;
     }
 
-    /* insert the split block to free list */
-    new_ptr->next_free = heap->free_list->next_free;
-    new_ptr->prev_free = heap->free_list;
-    heap->free_list->next_free->prev_free = new_ptr;
-    heap->free_list->next_free            = new_ptr;
-    RT_DEBUG_LOG(RT_DEBUG_MEMHEAP, ("new free ptr: next_free 0x%08x, prev_free 0x%08x\n",
-                                    new_ptr->next_free,
-                                    new_ptr->prev_free));
-
-    /* increment the available byte count.  */
-    heap->available_size = heap->available_size + MEMITEM_SIZE(new_ptr);
+    heap->realloc_stat.copy ++;
 
     /* release lock */
     rt_sem_release(&(heap->lock));
 
-    return ptr;
+    /* re-allocate a memory block */
+    new_ptr = (void *)rt_memheap_alloc(heap, newsize);
+    if (new_ptr != RT_NULL)
+    {
+        rt_memcpy(new_ptr, ptr, oldsize);
+        rt_memheap_free(ptr);
+    }
+
+    return new_ptr;
 }
 RTM_EXPORT(rt_memheap_realloc);
 
@@ -476,13 +667,10 @@ void rt_memheap_free(void *ptr)
     rt_err_t result;
     struct rt_memheap *heap;
     struct rt_memheap_item *header_ptr, *new_ptr;
-    rt_uint32_t insert_header;
 
     /* NULL check */
     if (ptr == RT_NULL) return;
 
-    /* set initial status as OK */
-    insert_header = 1;
     new_ptr       = RT_NULL;
     header_ptr    = (struct rt_memheap_item *)
                     ((rt_uint8_t *)ptr - RT_MEMHEAP_SIZE);
@@ -492,7 +680,7 @@ void rt_memheap_free(void *ptr)
 
     /* check magic */
     RT_ASSERT((header_ptr->magic & RT_MEMHEAP_MASK) == RT_MEMHEAP_MAGIC);
-    RT_ASSERT(header_ptr & RT_MEMHEAP_USED);
+    RT_ASSERT(header_ptr->magic & RT_MEMHEAP_USED);
     /* check whether this block of memory has been over-written. */
     RT_ASSERT((header_ptr->next->magic & RT_MEMHEAP_MASK) == RT_MEMHEAP_MAGIC);
 
@@ -525,15 +713,15 @@ void rt_memheap_free(void *ptr)
         /* adjust the available number of bytes. */
         heap->available_size = heap->available_size + RT_MEMHEAP_SIZE;
 
+        /* the previous neighbor grows, take it off its bin */
+        _memheap_remove_free(heap, header_ptr->prev);
+
         /* yes, merge block with previous neighbor. */
         header_ptr->prev->next = header_ptr->next;
         header_ptr->next->prev = header_ptr->prev;
 
         /* move header pointer to previous. */
         header_ptr = header_ptr->prev;
-
-        /* don't insert header to free list */
-        insert_header = 0;
     }
 
     /* determine if the block can be merged with the next neighbor. */
@@ -549,31 +737,115 @@ void rt_memheap_free(void *ptr)
                      ("merge: right node 0x%08x, next_free 0x%08x, prev_free 0x%08x\n",
                       new_ptr, new_ptr->next_free, new_ptr->prev_free));
 
+        /* remove new ptr from free list */
+        _memheap_remove_free(heap, new_ptr);
+
         new_ptr->next->prev = header_ptr;
         header_ptr->next    = new_ptr->next;
-
-        /* remove new ptr from free list */
-        new_ptr->next_free->prev_free = new_ptr->prev_free;
-        new_ptr->prev_free->next_free = new_ptr->next_free;
     }
 
-    if (insert_header)
+    /* insert the merged block to the bin of its size */
+    _memheap_insert_free(heap, header_ptr);
+
+    RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
+                 ("insert to free list: next_free 0x%08x, prev_free 0x%08x\n",
+                  header_ptr->next_free, header_ptr->prev_free));
+
+    /* release lock */
+    rt_sem_release(&(heap->lock));
+}
+RTM_EXPORT(rt_memheap_free);
+
+/**
+ * This function will get the usage information of a memory heap. The
+ * fragmentation is the per mille of the available size which is not in the
+ * largest free block, 0 when all of it is in one block.
+ *
+ * @param heap the memory heap object
+ * @param info the information will be saved in
+ */
+void rt_memheap_info_get(struct rt_memheap *heap, struct rt_memheap_info *info)
+{
+    struct rt_memheap_item *item;
+    rt_uint32_t free_size, free_total;
+    int bin;
+
+    RT_ASSERT(heap != RT_NULL);
+    RT_ASSERT(rt_object_get_type(&heap->parent) == RT_Object_Class_MemHeap);
+    RT_ASSERT(info != RT_NULL);
+
+    rt_memset(info, 0, sizeof(struct rt_memheap_info));
+    free_total = 0;
+
+    /* lock memheap */
+    if (rt_sem_take(&(heap->lock), RT_WAITING_FOREVER) != RT_EOK)
+        return;
+
+    info->total     = heap->pool_size;
+    info->available = heap->available_size;
+    info->max_used  = heap->max_used_size;
+
+    info->realloc_stat = heap->realloc_stat;
+
+    for (bin = 0; bin < RT_MEMHEAP_BIN_NR; bin ++)
     {
-        /* no left merge, insert to free list */
-        header_ptr->next_free = heap->free_list->next_free;
-        header_ptr->prev_free = heap->free_list;
-        heap->free_list->next_free->prev_free = header_ptr;
-        heap->free_list->next_free            = header_ptr;
+        for (item = heap->free_bin[bin]; item != RT_NULL; item = item->next_free)
+        {
+            free_size = MEMITEM_SIZE(item);
+            if (free_size > info->largest_free)
+                info->largest_free = free_size;
 
-        RT_DEBUG_LOG(RT_DEBUG_MEMHEAP,
-                     ("insert to free list: next_free 0x%08x, prev_free 0x%08x\n",
-                      header_ptr->next_free, header_ptr->prev_free));
+            free_total += free_size;
+            info->free_blocks ++;
+        }
     }
 
     /* release lock */
     rt_sem_release(&(heap->lock));
+
+    if (free_total != 0)
+        info->fragmentation = (rt_uint16_t)(1000 - (rt_uint64_t)info->largest_free * 1000 / free_total);
 }
-RTM_EXPORT(rt_memheap_free);
+RTM_EXPORT(rt_memheap_info_get);
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+void list_memheap(void)
+{
+    struct rt_object_information *information;
+    struct rt_memheap_info info;
+    struct rt_memheap *heap;
+    struct rt_list_node *node;
+
+    information = rt_object_get_information(RT_Object_Class_MemHeap);
+    RT_ASSERT(information != RT_NULL);
+
+    rt_kprintf("%-*.*s pool size  available  max used   free  largest    frag   realloc next/prev/copy\n",
+               RT_NAME_MAX, RT_NAME_MAX, "memheap");
+    rt_kprintf("%-*.*s ---------- ---------- ---------- ----- ---------- ------ ----------------------\n",
+               RT_NAME_MAX, RT_NAME_MAX, "--------------------------------");
+
+    for (node = information->object_list.next;
+         node != &(information->object_list);
+         node = node->next)
+    {
+        heap = (struct rt_memheap *)rt_list_entry(node, struct rt_object, list);
+        rt_memheap_info_get(heap, &info);
+
+        rt_kprintf("%-*.*s %-10lu %-10lu %-10lu %-5lu %-10lu %3d.%d%% %lu/%lu/%lu\n",
+                   RT_NAME_MAX, RT_NAME_MAX, heap->parent.name,
+                   (unsigned long)info.total, (unsigned long)info.available,
+                   (unsigned long)info.max_used, (unsigned long)info.free_blocks,
+                   (unsigned long)info.largest_free,
+                   info.fragmentation / 10, info.fragmentation % 10,
+                   (unsigned long)info.realloc_stat.grow_next,
+                   (unsigned long)info.realloc_stat.grow_prev,
+                   (unsigned long)info.realloc_stat.copy);
+    }
+}
+FINSH_FUNCTION_EXPORT(list_memheap, list memory heap usage information)
+#endif
 
 #ifdef RT_USING_MEMHEAP_AS_HEAP
 static struct rt_memheap _heap;
@@ -584,10 +856,10 @@ void rt_system_heap_init(void *begin_addr, void *end_addr)
     rt_memheap_init(&_heap,
                     "heap",
                     begin_addr,
-                    (rt_uint32_t)end_addr - (rt_uint32_t)begin_addr);
+                    (rt_ubase_t)end_addr - (rt_ubase_t)begin_addr);
 }
 
-void *rt_malloc(rt_size_t nbytes)
+void *rt_malloc(rt_size_t size)
 {
     void *ptr;
 
@@ -614,10 +886,10 @@ void *rt_malloc(rt_size_t nbytes)
             RT_ASSERT(rt_object_get_type(&(heap->parent)) == RT_Object_Class_MemHeap);
 
             /* not allocate in the default system heap */
-            if (heap == _heap)
+            if (heap == &_heap)
                 continue;
 
-            ptr = rt_memheap_alloc(&heap, size);
+            ptr = rt_memheap_alloc(heap, size);
             if (ptr != RT_NULL)
                 break;
         }
@@ -678,7 +950,7 @@ void *rt_calloc(rt_size_t count, rt_size_t size)
     rt_size_t total_size;
 
     total_size = count * size;
-    ptr = rt_malloc(total_szie);
+    ptr = rt_malloc(total_size);
     if (ptr != RT_NULL)
     {
         /* clean memory */
@@ -689,6 +961,67 @@ void *rt_calloc(rt_size_t count, rt_size_t size)
 }
 RTM_EXPORT(rt_calloc);
 
+void *rt_malloc_align(rt_size_t size, rt_size_t align)
+{
+    void *ptr;
+
+    /* try to allocate in system heap */
+    ptr = rt_memheap_alloc_align(&_heap, size, align);
+    if (ptr == RT_NULL)
+    {
+        struct rt_object *object;
+        struct rt_list_node *node;
+        struct rt_memheap *heap;
+        struct rt_object_information *information;
+
+        /* try to allocate on other memory heap */
+        information = rt_object_get_information(RT_Object_Class_MemHeap);
+        RT_ASSERT(information != RT_NULL);
+        for (node = information->object_list.next;
+             node != &(information->object_list);
+             node = node->next)
+        {
+            object = rt_list_entry(node, struct rt_object, list);
+            heap = (struct rt_memheap *)object;
+
+            RT_ASSERT(heap != RT_NULL);
+            RT_ASSERT(rt_object_get_type(&(heap->parent)) == RT_Object_Class_MemHeap);
+
+            /* not allocate in the default system heap */
+            if (heap == &_heap)
+                continue;
+
+            ptr = rt_memheap_alloc_align(heap, size, align);
+            if (ptr != RT_NULL)
+                break;
+        }
+    }
+
+    return ptr;
+}
+RTM_EXPORT(rt_malloc_align);
+
+void rt_free_align(void *ptr)
+{
+    rt_memheap_free(ptr);
+}
+RTM_EXPORT(rt_free_align);
+
+/**
+ * This function will get the counters of the ways rt_realloc resized the
+ * blocks of the system heap.
+ *
+ * @param stat the counters will be saved in
+ */
+void rt_memory_realloc_stat(struct rt_realloc_stat *stat)
+{
+    RT_ASSERT(stat != RT_NULL);
+
+    rt_sem_take(&(_heap.lock), RT_WAITING_FOREVER);
+    *stat = _heap.realloc_stat;
+    rt_sem_release(&(_heap.lock));
+}
+
 #endif
 
 #endif
@@ -38,6 +38,397 @@ void rt_mp_free_sethook(void (*hook)(struct rt_mempool *mp, void *block))
 /**@}*/
 #endif
 
+#ifdef RT_USING_MEMPOOL_LOCKFREE
+#ifndef RT_HW_ATOMIC
+#error "RT_USING_MEMPOOL_LOCKFREE needs the atomic interfaces of rthw.h"
+#endif
+
+/*
+ * The free blocks are a Treiber stack. The head is the index + 1 of the
+ * first free block in the low half, 0 for none, and a tag in the high half
+ * which every pop and push increases, so a CAS on a head read before the
+ * block was taken and put back fails. A free block keeps the index + 1 of
+ * the next one in its header.
+ */
+#define RT_MP_TAG_SHIFT     (sizeof(rt_ubase_t) * 4)
+#define RT_MP_INDEX_MASK    (((rt_ubase_t)1 << RT_MP_TAG_SHIFT) - 1)
+#define RT_MP_TAG_ONE       ((rt_ubase_t)1 << RT_MP_TAG_SHIFT)
+
+#define RT_MP_BLOCK(mp, index) \
+    ((rt_uint8_t *)(mp)->start_address + ((index) - 1) * ((mp)->block_size + sizeof(rt_uint8_t *)))
+#define RT_MP_INDEX(mp, block_ptr) \
+    ((rt_ubase_t)((rt_uint8_t *)(block_ptr) - (rt_uint8_t *)(mp)->start_address) / \
+     ((mp)->block_size + sizeof(rt_uint8_t *)) + 1)
+
+/* take the first free block without disabling interrupt, RT_NULL if none */
+static rt_uint8_t *_rt_mp_block_pop(struct rt_mempool *mp)
+{
+    rt_ubase_t head, next;
+    rt_uint8_t *block_ptr;
+
+    head = rt_hw_atomic_load(&(mp->block_head));
+    while ((head & RT_MP_INDEX_MASK) != 0)
+    {
+        block_ptr = RT_MP_BLOCK(mp, head & RT_MP_INDEX_MASK);
+
+        /* it's stale if the block is taken meanwhile, and the CAS fails */
+        next = rt_hw_atomic_load((rt_ubase_t *)block_ptr);
+        if (rt_hw_atomic_cas(&(mp->block_head), head,
+                             ((head & ~RT_MP_INDEX_MASK) + RT_MP_TAG_ONE) | (next & RT_MP_INDEX_MASK)))
+        {
+            rt_hw_atomic_sub(&(mp->block_free_count), 1);
+
+            return block_ptr;
+        }
+
+        head = rt_hw_atomic_load(&(mp->block_head));
+    }
+
+    return RT_NULL;
+}
+
+/* put blocks back to the free blocks without disabling interrupt, they are
+ * linked first and pushed by one CAS */
+static void _rt_mp_block_push(struct rt_mempool *mp, rt_uint8_t **blocks, rt_size_t count)
+{
+    rt_ubase_t head, first;
+    rt_size_t index;
+
+    for (index = 0; index + 1 < count; index ++)
+        *(rt_ubase_t *)blocks[index] = RT_MP_INDEX(mp, blocks[index + 1]);
+    first = RT_MP_INDEX(mp, blocks[0]);
+
+    do
+    {
+        head = rt_hw_atomic_load(&(mp->block_head));
+        rt_hw_atomic_store((rt_ubase_t *)blocks[count - 1], head & RT_MP_INDEX_MASK);
+    } while (!rt_hw_atomic_cas(&(mp->block_head), head,
+                               ((head & ~RT_MP_INDEX_MASK) + RT_MP_TAG_ONE) | first));
+
+    rt_hw_atomic_add(&(mp->block_free_count), count);
+}
+#endif
+
+#if defined(RT_USING_MEMPOOL_LOCKFREE) || defined(RT_USING_MEMPOOL_MAGAZINE)
+#ifndef RT_HW_ATOMIC
+#error "RT_USING_MEMPOOL_MAGAZINE needs the atomic interfaces of rthw.h"
+#endif
+
+/*
+ * The waiters are counted with interrupt disabled, but the lock-free free
+ * and the magazines read the count without it, so the count is changed
+ * atomically and a free after a waiter is counted sees it.
+ */
+#define RT_MP_WAITER_INC(mp) \
+    do { rt_hw_atomic_add(&((mp)->suspend_thread_count), 1); rt_hw_atomic_fence(); } while (0)
+#define RT_MP_WAITER_DEC(mp)    rt_hw_atomic_sub(&((mp)->suspend_thread_count), 1)
+#else
+#define RT_MP_WAITER_INC(mp)    ((mp)->suspend_thread_count ++)
+#define RT_MP_WAITER_DEC(mp)    ((mp)->suspend_thread_count --)
+#endif
+
+/* link all blocks of a memory pool to the free block list */
+static void _rt_mp_block_init(struct rt_mempool *mp)
+{
+    rt_uint8_t *block_ptr;
+    register rt_size_t offset;
+
+    block_ptr = (rt_uint8_t *)mp->start_address;
+
+#ifdef RT_USING_MEMPOOL_LOCKFREE
+    RT_ASSERT(mp->block_total_count <= RT_MP_INDEX_MASK);
+
+    /* the block 'offset' is linked to the block 'offset + 1', the index + 1 */
+    for (offset = 0; offset < mp->block_total_count; offset++)
+    {
+        *(rt_ubase_t *)(block_ptr + offset * (mp->block_size + sizeof(rt_uint8_t *))) =
+            offset + 2 <= mp->block_total_count ? offset + 2 : 0;
+    }
+
+    mp->block_head = mp->block_total_count > 0 ? 1 : 0;
+#else
+    for (offset = 0; offset < mp->block_total_count; offset++)
+    {
+        *(rt_uint8_t **)(block_ptr + offset * (mp->block_size + sizeof(rt_uint8_t *))) = 
+            (rt_uint8_t *)(block_ptr + (offset + 1) * (mp->block_size + sizeof(rt_uint8_t *)));
+    }
+
+    *(rt_uint8_t **)(block_ptr + (offset - 1) * (mp->block_size + sizeof(rt_uint8_t *))) = RT_NULL;
+
+    mp->block_list = block_ptr;
+#endif
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    /* no block is cached yet */
+    rt_memset(mp->magazine, 0, sizeof(mp->magazine));
+#endif
+}
+
+/* take 'count' free blocks at most, return the number taken */
+static rt_size_t _rt_mp_block_take(struct rt_mempool *mp, rt_uint8_t **blocks, rt_size_t count)
+{
+    rt_size_t index;
+#ifndef RT_USING_MEMPOOL_LOCKFREE
+    register rt_base_t level;
+#endif
+
+#ifdef RT_USING_MEMPOOL_LOCKFREE
+    for (index = 0; index < count; index ++)
+    {
+        blocks[index] = _rt_mp_block_pop(mp);
+        if (blocks[index] == RT_NULL)
+            break;
+    }
+#else
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    for (index = 0; index < count && mp->block_free_count > 0; index ++)
+    {
+        /* memory block is available. decrease the free block counter */
+        mp->block_free_count --;
+
+        /* get block from block list */
+        blocks[index] = mp->block_list;
+        RT_ASSERT(blocks[index] != RT_NULL);
+
+        /* Setup the next free node. */
+        mp->block_list = *(rt_uint8_t **)blocks[index];
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+#endif
+
+    return index;
+}
+
+/* give 'count' blocks back to the free blocks and wake up as many waiters at
+ * most, return RT_TRUE if a waiter is woken up and a schedule is needed */
+static rt_bool_t _rt_mp_block_give(struct rt_mempool *mp, rt_uint8_t **blocks, rt_size_t count)
+{
+    struct rt_thread *thread;
+    register rt_base_t level;
+    rt_bool_t woken = RT_FALSE;
+#ifndef RT_USING_MEMPOOL_LOCKFREE
+    rt_size_t index;
+#endif
+
+#ifdef RT_USING_MEMPOOL_LOCKFREE
+    _rt_mp_block_push(mp, blocks, count);
+
+    /* a waiter counted before the push is woken up, see _rt_mp_block_wait */
+    rt_hw_atomic_fence();
+    if (rt_hw_atomic_load(&(mp->suspend_thread_count)) == 0)
+        return RT_FALSE;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+#else
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    /* link the blocks into the block list */
+    for (index = 0; index < count; index ++)
+    {
+        *(rt_uint8_t **)blocks[index] = mp->block_list;
+        mp->block_list = blocks[index];
+    }
+
+    /* increase the free block count */
+    mp->block_free_count += count;
+#endif
+
+    /* a waiter timed out is counted until it runs */
+    while (count > 0 && !rt_list_isempty(&(mp->suspend_thread)))
+    {
+        /* get the suspended thread */
+        thread = rt_list_entry(mp->suspend_thread.next,
+                               struct rt_thread,
+                               tlist);
+
+        /* set error */
+        thread->error = RT_EOK;
+
+        /* resume thread */
+        rt_thread_resume(thread);
+
+        /* decrease suspended thread count */
+        RT_MP_WAITER_DEC(mp);
+
+        count --;
+        woken = RT_TRUE;
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return woken;
+}
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+/*
+ * Each cpu caches up to RT_MP_MAGAZINE_SIZE free blocks of a pool in its
+ * magazine. An allocation takes the last cached block and a free caches the
+ * block, with only the interrupt of the cpu disabled and the lock of the
+ * magazine taken, which nothing else takes but a reclaim. An empty magazine
+ * is refilled with half a magazine of free blocks and a full one gives the
+ * older half back, both in one go. The cached blocks are not free blocks of
+ * the pool, so once the free blocks run out, the magazines of all cpus are
+ * reclaimed before an allocation fails or waits. A free doesn't cache the
+ * block while a thread waits for one, and a waiter is counted before it
+ * reclaims the magazines, so no block is stuck in a magazine then.
+ *
+ * The magazines are only on SMP, see rtdef.h.
+ */
+#if RT_MP_MAGAZINE_SIZE < 2
+#error "RT_MP_MAGAZINE_SIZE must be 2 at least"
+#endif
+
+#define RT_MP_MAGAZINE_BATCH    (RT_MP_MAGAZINE_SIZE / 2)
+
+/* lock the magazine 'index', or the one of the running cpu if it's -1 */
+static struct rt_mp_magazine *_rt_mp_magazine_lock(struct rt_mempool *mp, int index, rt_base_t *level)
+{
+    struct rt_mp_magazine *magazine;
+
+    /* no interrupt and no migration while the magazine is locked */
+    *level = rt_hw_local_irq_disable();
+    if (index < 0)
+        index = rt_hw_cpu_id();
+
+    magazine = &(mp->magazine[index]);
+    while (!rt_hw_atomic_cas(&(magazine->lock), 0, 1));
+
+    return magazine;
+}
+
+static void _rt_mp_magazine_unlock(struct rt_mp_magazine *magazine, rt_base_t level)
+{
+    rt_hw_atomic_store(&(magazine->lock), 0);
+    rt_hw_local_irq_enable(level);
+}
+
+/* give the blocks cached by all cpus back to the free blocks, return RT_TRUE
+ * if a waiter is woken up */
+static rt_bool_t _rt_mp_magazine_reclaim(struct rt_mempool *mp)
+{
+    struct rt_mp_magazine *magazine;
+    rt_uint8_t *blocks[RT_MP_MAGAZINE_SIZE];
+    rt_bool_t woken = RT_FALSE;
+    rt_size_t count;
+    rt_base_t level;
+    int index;
+
+    for (index = 0; index < RT_MP_MAGAZINE_NR; index ++)
+    {
+        magazine = _rt_mp_magazine_lock(mp, index, &level);
+        count = magazine->count;
+        rt_memcpy(blocks, magazine->block, count * sizeof(rt_uint8_t *));
+        magazine->count = 0;
+        _rt_mp_magazine_unlock(magazine, level);
+
+        if (count > 0 && _rt_mp_block_give(mp, blocks, count))
+            woken = RT_TRUE;
+    }
+
+    return woken;
+}
+
+/* take a block from the magazine of the running cpu, refilling it if it's
+ * empty, RT_NULL if there is no free block */
+static rt_uint8_t *_rt_mp_magazine_alloc(struct rt_mempool *mp)
+{
+    struct rt_mp_magazine *magazine;
+    rt_uint8_t *blocks[RT_MP_MAGAZINE_BATCH + 1];
+    rt_uint8_t *block_ptr;
+    rt_size_t count, index;
+    rt_base_t level;
+
+    magazine = _rt_mp_magazine_lock(mp, -1, &level);
+    if (magazine->count > 0)
+    {
+        magazine->alloc_hit ++;
+        block_ptr = magazine->block[-- magazine->count];
+        _rt_mp_magazine_unlock(magazine, level);
+
+        return block_ptr;
+    }
+    magazine->alloc_miss ++;
+    _rt_mp_magazine_unlock(magazine, level);
+
+    /* the block and half a magazine, only the block if a thread waits */
+    count = rt_hw_atomic_load(&(mp->suspend_thread_count)) == 0 ? RT_MP_MAGAZINE_BATCH + 1 : 1;
+    count = _rt_mp_block_take(mp, blocks, count);
+    if (count == 0)
+    {
+        /* the last free blocks may be cached by the other cpus */
+        if (_rt_mp_magazine_reclaim(mp))
+            rt_schedule();
+
+        if (_rt_mp_block_take(mp, blocks, 1) == 0)
+            return RT_NULL;
+
+        return blocks[0];
+    }
+
+    /* the cpu may be another one now, and its magazine refilled by a free */
+    magazine = _rt_mp_magazine_lock(mp, -1, &level);
+    for (index = 1; index < count && magazine->count < RT_MP_MAGAZINE_SIZE; index ++)
+        magazine->block[magazine->count ++] = blocks[index];
+    _rt_mp_magazine_unlock(magazine, level);
+
+    if (index < count && _rt_mp_block_give(mp, blocks + index, count - index))
+        rt_schedule();
+
+    return blocks[0];
+}
+
+/* cache a block in the magazine of the running cpu, giving the older half of
+ * a full magazine back, return RT_FALSE if the block isn't cached */
+static rt_bool_t _rt_mp_magazine_free(struct rt_mempool *mp, rt_uint8_t *block_ptr)
+{
+    struct rt_mp_magazine *magazine;
+    rt_uint8_t *blocks[RT_MP_MAGAZINE_BATCH];
+    rt_size_t count = 0;
+    rt_base_t level;
+
+    magazine = _rt_mp_magazine_lock(mp, -1, &level);
+
+    /* the waiter takes the block, see _rt_mp_block_wait */
+    if (rt_hw_atomic_load(&(mp->suspend_thread_count)) != 0)
+    {
+        magazine->free_miss ++;
+        _rt_mp_magazine_unlock(magazine, level);
+
+        return RT_FALSE;
+    }
+
+    if (magazine->count < RT_MP_MAGAZINE_SIZE)
+    {
+        magazine->free_hit ++;
+    }
+    else
+    {
+        magazine->free_miss ++;
+
+        count = RT_MP_MAGAZINE_BATCH;
+        rt_memcpy(blocks, magazine->block, count * sizeof(rt_uint8_t *));
+        rt_memmove(magazine->block, magazine->block + count,
+                   (magazine->count - count) * sizeof(rt_uint8_t *));
+        magazine->count -= count;
+    }
+    magazine->block[magazine->count ++] = block_ptr;
+
+    _rt_mp_magazine_unlock(magazine, level);
+
+    if (count > 0 && _rt_mp_block_give(mp, blocks, count))
+        rt_schedule();
+
+    return RT_TRUE;
+}
+#endif
+
 /**
  * @addtogroup MM
  */
@@ -62,9 +453,6 @@ rt_err_t rt_mp_init(struct rt_mempool *mp,
                     rt_size_t          size,
                     rt_size_t          block_size)
 {
-    rt_uint8_t *block_ptr;
-    register rt_size_t offset;
-
     /* parameter check */
     RT_ASSERT(mp != RT_NULL);
 
@@ -72,7 +460,7 @@ rt_err_t rt_mp_init(struct rt_mempool *mp,
     rt_object_init(&(mp->parent), RT_Object_Class_MemPool, name);
 
     /* initialize memory pool */
-    mp->start_addr = start;
+    mp->start_address = start;
     mp->size = RT_ALIGN_DOWN(size, RT_ALIGN_SIZE);
 
     /* align the block size */
@@ -88,16 +476,7 @@ rt_err_t rt_mp_init(struct rt_mempool *mp,
     mp->suspend_thread_count = 0;
 
     /* initialize free block list */
-    block_ptr = (rt_uint8_t *)mp->start_addr;
-    for (offset = 0; offset < mp->block_total_count; offset++)
-    {
-        *(rt_uint8_t **)(block_ptr + offset * (mp->block_size + sizeof(rt_uint8_t *))) = 
-            (rt_uint8_t *)(block_prt + (offset + 1) * (mp->block_size + sizeof(rt_uint8_t *)));
-    }
-
-    *(rt_uint8_t **)(block_ptr + (offset - 1) * (mp->block_size + sizeof(rt_uint8_t *))) = RT_NULL;
-
-    mp->block_list = block_ptr;    
+    _rt_mp_block_init(mp);
 
     return RT_EOK;
 }
@@ -153,13 +532,11 @@ RTM_EXPORT(rt_mp_detach);
  * @return RT_EOK
  */
 #ifdef RT_USING_HEAP
-rt_mp_t rt_mp_create(cosnt char *name,
+rt_mp_t rt_mp_create(const char *name,
                      rt_size_t   block_count,
                      rt_size_t   block_size)
 {
-    rt_uint8_t *block_ptr;
     struct rt_mempool *mp;
-    register rt_size_t offset;
 
     RT_DEBUG_NOT_IN_INTERRUPT;
 
@@ -192,16 +569,7 @@ rt_mp_t rt_mp_create(cosnt char *name,
     mp->suspend_thread_count = 0;
 
     /* initialize free block list */
-    block_prt = (rt_uint8_t *)mp->start_address;
-    for (offset = 0; offset < mp->block_total_count; offset++)
-    {
-        *(rt_uint8_t **)(block_ptr + offset * (mp->block_size + sizeof(rt_uint8_t *)))
-            = (rt_uint8_t *)(block_ptr + (offset + 1) * (mp->block_size + sizeof(rt_uint8_t *)));      
-    }
-
-    *(rt_uint8_t **)(block_ptr + (offset - 1) * (mp->block_size + sizeof(rt_uint8_t *))) = RT_NULL;
-
-    mp->block_list = block_ptr;
+    _rt_mp_block_init(mp);
 
     return mp;
 }
@@ -252,7 +620,7 @@ rt_err_t rt_mp_delete(rt_mp_t mp)
     }
 
     /* release allocated room */
-    rt_free(&(mp->start_address));
+    rt_free(mp->start_address);
 
     /* delete object */
     rt_object_delete(&(mp->parent));
@@ -262,48 +630,47 @@ rt_err_t rt_mp_delete(rt_mp_t mp)
 RTM_EXPORT(rt_mp_delete);
 #endif
 
-/**
- * This function will allocate a block from memory pool
- *
- * @param mp the memory pool object
- * @param time the waiting time
- *
- * @return the allocated memory block or RT_NULL on allocated failed
- */
-void *rt_mp_alloc(rt_mp_t mp, rt_int32_t time)
+/* wait for a free block in 'time' ticks, RT_NULL on timeout or error */
+static rt_uint8_t *_rt_mp_block_wait(struct rt_mempool *mp, rt_int32_t time)
 {
     rt_uint8_t *block_ptr;
     register rt_base_t level;
-    rt_thread *thread;
+    struct rt_thread *thread;
     rt_uint32_t before_sleep = 0;
 
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
     /* get current thread */
     thread = rt_thread_self();
 
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
-    while (mp->block_free_count == 0)
+    while (1)
     {
-        /* memory block is unavailable. */
-        if (time == 0)
-        {
-            /* enable interrupt */
-            rt_hw_interrupt_enable(level);
+        /* a block freed after the waiter is counted is seen here, or the
+         * free wakes it up */
+        RT_MP_WAITER_INC(mp);
 
-            rt_set_errno(-RT_ETIMEOUT);
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+        /* the woken waiters run at the next schedule */
+        _rt_mp_magazine_reclaim(mp);
+#endif
 
-            return RT_NULL;
-        }
+        if (_rt_mp_block_take(mp, &block_ptr, 1) == 0)
+            block_ptr = RT_NULL;
 
-        RT_DEBUG_NOT_IN_INTERRUPT;
+        if (block_ptr != RT_NULL || time == 0)
+        {
+            RT_MP_WAITER_DEC(mp);
+            break;
+        }
 
         thread->error = RT_EOK;
 
         /* need suspend thread */
         rt_thread_suspend(thread);
         rt_list_insert_after(&(mp->suspend_thread), &(thread->tlist));
-        mp->suspend_thread_count ++;
 
         if (time > 0)
         {
@@ -324,7 +691,18 @@ void *rt_mp_alloc(rt_mp_t mp, rt_int32_t time)
         rt_schedule();
 
         if (thread->error != RT_EOK)
+        {
+            /* only the free and the detach count the waiter off, not the
+             * timer or a signal */
+            if (thread->error != -RT_ERROR)
+            {
+                level = rt_hw_interrupt_disable();
+                RT_MP_WAITER_DEC(mp);
+                rt_hw_interrupt_enable(level);
+            }
+
             return RT_NULL;
+        }
 
         if (time > 0)
         {
@@ -337,22 +715,56 @@ void *rt_mp_alloc(rt_mp_t mp, rt_int32_t time)
         level = rt_hw_interrupt_disable();
     }
 
-    /* memory block is available. decrease the free block counter */
-    mp->block_free_count --;
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
 
-    /* get block from block list */
-    block_ptr = mp->block_list;
-    ASSERT(block_ptr != RT_NULL);
+    if (block_ptr == RT_NULL)
+        rt_set_errno(-RT_ETIMEOUT);
 
-    /* Setup the next free node. */
-    mp->block_list = *(rt_uin8_t **)block_ptr;
+    return block_ptr;
+}
+
+/**
+ * This function will allocate a block from memory pool. With
+ * RT_USING_MEMPOOL_LOCKFREE a free block is taken without disabling
+ * interrupt, so it's lock-free when 'time' is 0, in interrupt too. With
+ * RT_USING_MEMPOOL_MAGAZINE the block is taken from the magazine of the
+ * running cpu first.
+ *
+ * @param mp the memory pool object
+ * @param time the waiting time
+ *
+ * @return the allocated memory block or RT_NULL on allocated failed
+ */
+void *rt_mp_alloc(rt_mp_t mp, rt_int32_t time)
+{
+    rt_uint8_t *block_ptr;
+
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    block_ptr = _rt_mp_magazine_alloc(mp);
+#else
+    if (_rt_mp_block_take(mp, &block_ptr, 1) == 0)
+        block_ptr = RT_NULL;
+#endif
+
+    if (block_ptr == RT_NULL)
+    {
+        /* memory block is unavailable. */
+        if (time == 0)
+        {
+            rt_set_errno(-RT_ETIMEOUT);
+
+            return RT_NULL;
+        }
+
+        block_ptr = _rt_mp_block_wait(mp, time);
+        if (block_ptr == RT_NULL)
+            return RT_NULL;
+    }
 
     /* point to memory pool */
     *(rt_uint8_t **)block_ptr = (rt_uint8_t *)mp;
 
-    /* enable interrupt */
-    rt_hw_interrupt_enable(level);
-
     RT_OBJECT_HOOK_CALL(rt_mp_alloc_hook, 
                         (mp, (rt_uint8_t *)(block_ptr + sizeof(rt_uint8_t *))));
 
@@ -361,62 +773,86 @@ void *rt_mp_alloc(rt_mp_t mp, rt_int32_t time)
 RTM_EXPORT(rt_mp_alloc);
 
 /**
- * This function will release a memory block
+ * This function will release a memory block. With RT_USING_MEMPOOL_LOCKFREE
+ * it disables interrupt only to wake up a waiting thread. With
+ * RT_USING_MEMPOOL_MAGAZINE the block is cached by the running cpu if no
+ * thread waits for one.
  *
  * @param block the address of memory block to be released
  */
 void rt_mp_free(void *block)
 {
-    rt_uint8_t **block_ptr;
+    rt_uint8_t *block_ptr;
     struct rt_mempool *mp;
-    struct rt_thread *thread;
-    register rt_base_t level;
 
     /* get the control block of pool which the block belongs to */
-    block_ptr = (rt_uint8_t **)((rt_uint8_t *)block - sizeof(rt_uint8_t *));
-    mp        = (struct rt_mempool *)*block_ptr;
+    block_ptr = (rt_uint8_t *)block - sizeof(rt_uint8_t *);
+    mp        = (struct rt_mempool *)*(rt_uint8_t **)block_ptr;
 
     RT_OBJECT_HOOK_CALL(rt_mp_free_hook, (mp, block));
 
-    /* disable interrupt */
-    level = rt_hw_interrupt_disable();
-
-    /* increase the free block count */
-    mp->block_free_count ++;
-
-    /* link the block into the block list */
-    *block_ptr = mp->block_list;
-    mp->block_list = (rt_uint8_t *)block_ptr;
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+    if (_rt_mp_magazine_free(mp, block_ptr))
+        return;
+#endif
 
-    if (mp->suspend_thread_count > 0)
+    if (_rt_mp_block_give(mp, &block_ptr, 1))
     {
-        /* get the suspended thread */
-        thread = rt_list_entry(mp->suspend_thread.next,
-                               struct rt_thread,
-                               tlist);
-
-        /* set error */
-        thread->error = RT_EOK;
+        /* do a schedule */
+        rt_schedule();
+    }
+}
+RTM_EXPORT(rt_mp_free);
 
-        /* resume thread */
-        rt_thread_resume(thread);
+#ifdef RT_USING_MEMPOOL_MAGAZINE
+/**
+ * This function will give the blocks cached by the magazines of all cpus
+ * back to the free blocks of a memory pool, so block_free_count counts all
+ * blocks not allocated.
+ *
+ * @param mp the memory pool object
+ */
+void rt_mp_magazine_flush(rt_mp_t mp)
+{
+    /* parameter check */
+    RT_ASSERT(mp != RT_NULL);
 
-        /* decrease suspended thread count */
-        mp->suspend_thread_count --;
+    if (_rt_mp_magazine_reclaim(mp))
+        rt_schedule();
+}
+RTM_EXPORT(rt_mp_magazine_flush);
 
-        /* enable interrupt */
-        rt_hw_interrupt_enable(level);
+/**
+ * This function will get the hit counters of the magazines of a memory pool,
+ * summed over all cpus.
+ *
+ * @param mp the memory pool object
+ * @param info the counters will be saved in
+ */
+void rt_mp_magazine_get(rt_mp_t mp, struct rt_mp_magazine_info *info)
+{
+    struct rt_mp_magazine *magazine;
+    rt_base_t level;
+    int index;
 
-        /* do a schedule */
-        rt_schedule();
+    /* parameter check */
+    RT_ASSERT(mp != RT_NULL);
+    RT_ASSERT(info != RT_NULL);
 
-        return;
+    rt_memset(info, 0, sizeof(struct rt_mp_magazine_info));
+    for (index = 0; index < RT_MP_MAGAZINE_NR; index ++)
+    {
+        magazine = _rt_mp_magazine_lock(mp, index, &level);
+        info->alloc_hit  += magazine->alloc_hit;
+        info->alloc_miss += magazine->alloc_miss;
+        info->free_hit   += magazine->free_hit;
+        info->free_miss  += magazine->free_miss;
+        info->cached     += magazine->count;
+        _rt_mp_magazine_unlock(magazine, level);
     }
-
-    /* enable interrupt */
-    rt_hw_interrupt_enable(level);
 }
-RTM_EXPORT(rt_mp_free);
+RTM_EXPORT(rt_mp_magazine_get);
+#endif
 
 /**@}*/
 
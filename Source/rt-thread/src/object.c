@@ -11,7 +11,7 @@
 enum rt_object_info_type
 {
     RT_Object_Info_Thread = 0,
-#ifdef RT_UISNG_SEMAPHORE
+#ifdef RT_USING_SEMAPHORE
     RT_Object_Info_Semaphore,
 #endif
 #ifdef RT_USING_MUTEX
@@ -38,6 +38,9 @@ enum rt_object_info_type
     RT_Object_Info_Timer,
 #ifdef RT_USING_MODULE
     RT_Object_Info_Module,
+#endif
+#ifdef RT_USING_RWLOCK
+    RT_Object_Info_RWLock,
 #endif
     RT_Object_Info_Unknown,
 };
@@ -48,7 +51,7 @@ enum rt_object_info_type
 static struct rt_object_information rt_object_container[RT_Object_Info_Unknown] = 
 {
     {RT_Object_Class_Thread, _OBJ_CONTAINER_LIST_INIT(RT_Object_Info_Thread), sizeof(struct rt_thread)},
-#ifdef RT_UISNG_SEMAPHORE
+#ifdef RT_USING_SEMAPHORE
     {RT_Object_Class_Semaphore, _OBJ_CONTAINER_LIST_INIT(RT_Object_Info_Semaphore), sizeof(struct rt_semaphore)},
 #endif
 #ifdef RT_USING_MUTEX
@@ -76,8 +79,205 @@ static struct rt_object_information rt_object_container[RT_Object_Info_Unknown]
 #ifdef RT_USING_MODULE
     {RT_Object_Class_Module, _OBJ_CONTAINER_LIST_INIT(RT_Object_Info_Module), sizeof(struct rt_module)},
 #endif
+#ifdef RT_USING_RWLOCK
+    {RT_Object_Class_RWLock, _OBJ_CONTAINER_LIST_INIT(RT_Object_Info_RWLock), sizeof(struct rt_rwlock)},
+#endif
+};
+
+/*
+ * the index of rt_object_container for every object class, -1 for the class
+ * not configured. It's in the order of enum rt_object_class_type.
+ */
+static const rt_int8_t rt_object_info_index[RT_Object_Class_Unknown] =
+{
+    RT_Object_Info_Thread,
+#ifdef RT_USING_SEMAPHORE
+    RT_Object_Info_Semaphore,
+#else
+    -1,
+#endif
+#ifdef RT_USING_MUTEX
+    RT_Object_Info_Mutex,
+#else
+    -1,
+#endif
+#ifdef RT_USING_EVENT
+    RT_Object_Info_Event,
+#else
+    -1,
+#endif
+#ifdef RT_USING_MAILBOX
+    RT_Object_Info_MailBox,
+#else
+    -1,
+#endif
+#ifdef RT_USING_MESSAGEQUEUE
+    RT_Object_Info_MessageQueue,
+#else
+    -1,
+#endif
+#ifdef RT_USING_MEMHEAP
+    RT_Object_Info_MemHeap,
+#else
+    -1,
+#endif
+#ifdef RT_USING_MEMPOOL
+    RT_Object_Info_MemPool,
+#else
+    -1,
+#endif
+#ifdef RT_USING_DEVICE
+    RT_Object_Info_Device,
+#else
+    -1,
+#endif
+    RT_Object_Info_Timer,
+#ifdef RT_USING_MODULE
+    RT_Object_Info_Module,
+#else
+    -1,
+#endif
+#ifdef RT_USING_RWLOCK
+    RT_Object_Info_RWLock,
+#else
+    -1,
+#endif
 };
 
+#ifdef RT_USING_OBJECT_HASH
+/*
+ * The objects of the object containers are also in a hash table of their
+ * name and class, so rt_object_find doesn't walk the whole object list.
+ *
+ * The table starts with RT_OBJECT_HASH_SIZE buckets and, with a heap, is
+ * doubled up to RT_OBJECT_HASH_SIZE_MAX buckets once there are more than
+ * two objects a bucket, so a lookup stays short as the objects add up.
+ */
+#ifndef RT_OBJECT_HASH_SIZE
+#define RT_OBJECT_HASH_SIZE         32
+#endif
+
+#ifndef RT_OBJECT_HASH_SIZE_MAX
+#define RT_OBJECT_HASH_SIZE_MAX     4096
+#endif
+
+#if (RT_OBJECT_HASH_SIZE & (RT_OBJECT_HASH_SIZE - 1)) != 0
+#error "RT_OBJECT_HASH_SIZE shall be a power of 2"
+#endif
+
+static struct rt_object *rt_object_hash_table[RT_OBJECT_HASH_SIZE];
+static struct rt_object **rt_object_hash = rt_object_hash_table;
+static rt_uint32_t rt_object_hash_size = RT_OBJECT_HASH_SIZE;
+static rt_uint32_t rt_object_hash_count;
+
+static rt_uint32_t _rt_object_hash_value(const char *name, rt_uint8_t type)
+{
+    rt_uint32_t hash = type;
+    int index;
+
+    /* only the first RT_NAME_MAX characters are kept in the object */
+    for (index = 0; index < RT_NAME_MAX && name[index] != '\0'; index ++)
+        hash = hash * 31 + (rt_uint8_t)name[index];
+
+    return hash;
+}
+
+static struct rt_object **_rt_object_hash_bucket(const char *name, rt_uint8_t type)
+{
+    return &rt_object_hash[_rt_object_hash_value(name, type) & (rt_object_hash_size - 1)];
+}
+
+/* shall be invoked with interrupt disabled */
+static void _rt_object_hash_insert(struct rt_object *object, rt_uint8_t type)
+{
+    struct rt_object **bucket;
+
+    bucket = _rt_object_hash_bucket(object->name, type);
+    object->hash_next = *bucket;
+    *bucket = object;
+
+    rt_object_hash_count ++;
+}
+
+/* shall be invoked with interrupt disabled */
+static void _rt_object_hash_remove(struct rt_object *object, rt_uint8_t type)
+{
+    struct rt_object **prev;
+
+    for (prev = _rt_object_hash_bucket(object->name, type);
+         *prev != RT_NULL;
+         prev = &((*prev)->hash_next))
+    {
+        if (*prev == object)
+        {
+            *prev = object->hash_next;
+            object->hash_next = RT_NULL;
+            rt_object_hash_count --;
+            break;
+        }
+    }
+}
+
+#ifdef RT_USING_HEAP
+/*
+ * double the table if there are more than two objects a bucket, shall be
+ * invoked in thread with interrupt enabled, before the object is inserted
+ */
+static void _rt_object_hash_grow(void)
+{
+    struct rt_object **table, **old, *object;
+    rt_uint32_t size, index, hash;
+    register rt_base_t temp;
+
+    size = rt_object_hash_size;
+    if (rt_object_hash_count < size * 2 || size >= RT_OBJECT_HASH_SIZE_MAX)
+        return;
+
+    table = (struct rt_object **)RT_KERNEL_MALLOC(size * 2 * sizeof(struct rt_object *));
+    if (table == RT_NULL)
+        return;
+    rt_memset(table, 0, size * 2 * sizeof(struct rt_object *));
+
+    /* lock interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    /* another thread has grown it */
+    if (rt_object_hash_size != size)
+    {
+        rt_hw_interrupt_enable(temp);
+        RT_KERNEL_FREE(table);
+
+        return;
+    }
+
+    /* move the objects to their buckets in the new table */
+    old = rt_object_hash;
+    for (index = 0; index < size; index ++)
+    {
+        while (old[index] != RT_NULL)
+        {
+            object = old[index];
+            old[index] = object->hash_next;
+
+            hash = _rt_object_hash_value(object->name,
+                                         object->type & ~RT_Object_Class_Static);
+            object->hash_next = table[hash & (size * 2 - 1)];
+            table[hash & (size * 2 - 1)] = object;
+        }
+    }
+
+    rt_object_hash = table;
+    rt_object_hash_size = size * 2;
+
+    /* unlock interrupt */
+    rt_hw_interrupt_enable(temp);
+
+    if (old != rt_object_hash_table)
+        RT_KERNEL_FREE(old);
+}
+#endif
+#endif
+
 #ifdef RT_USING_HOOK
 static void (*rt_object_attach_hook)(struct rt_object *object);
 static void (*rt_object_detach_hook)(struct rt_object *object);
@@ -126,7 +326,7 @@ void rt_object_detach_sethook(void (*hook)(struct rt_object *object))
  *
  * @param hook the hook function
  */
-void rt_object_trytake_sethook(void (*hook)(struct rt_object *object));
+void rt_object_trytake_sethook(void (*hook)(struct rt_object *object))
 {
     rt_object_trytake_hook = hook;
 }
@@ -145,7 +345,7 @@ void rt_object_trytake_sethook(void (*hook)(struct rt_object *object));
  *
  * @param hook the hook function
  */
-void rt_object_take_sethook(void (*hook)(struct rt_object *object));
+void rt_object_take_sethook(void (*hook)(struct rt_object *object))
 {
     rt_object_take_hook = hook;
 }
@@ -190,15 +390,11 @@ void rt_system_object_init(void)
  */
 struct rt_object_information *rt_object_get_information(enum rt_object_class_type type)
 {
-    int index;
-
-    for (index = 0; index < RT_Object_Info_Unknown; index ++)
-    {
-        if (rt_object_container[index].type == type)
-            return &rt_object_container[index];
-    }
+    if ((rt_uint32_t)type >= RT_Object_Class_Unknown ||
+        rt_object_info_index[type] < 0)
+        return RT_NULL;
 
-    return RT_NULL;
+    return &rt_object_container[rt_object_info_index[type]];
 }
 RTM_EXPORT(rt_object_get_information);
 
@@ -237,6 +433,12 @@ void rt_object_init(struct rt_object         *object,
 
     RT_OBJECT_HOOK_CALL(rt_object_attach_hook, (object));
 
+#if defined(RT_USING_OBJECT_HASH) && defined(RT_USING_HEAP)
+    /* a static object may be initialized before the heap or in interrupt */
+    if (rt_thread_self() != RT_NULL && rt_interrupt_get_nest() == 0)
+        _rt_object_hash_grow();
+#endif
+
     /* lock interrupt */
     temp = rt_hw_interrupt_disable();
 
@@ -251,6 +453,9 @@ void rt_object_init(struct rt_object         *object,
     {
         /* insert object into information object list */
         rt_list_insert_after(&(information->object_list), &(object->list));
+#ifdef RT_USING_OBJECT_HASH
+        _rt_object_hash_insert(object, type);
+#endif
     }
 
     /* unlock interrupt */
@@ -266,12 +471,19 @@ void rt_object_init(struct rt_object         *object,
 void rt_object_detach(rt_object_t object)
 {
     register rt_base_t temp;
+#ifdef RT_USING_OBJECT_HASH
+    rt_uint8_t type;
+#endif
 
     /* object check */
     RT_ASSERT(object != RT_NULL);
 
     RT_OBJECT_HOOK_CALL(rt_object_detach_hook, (object));
 
+#ifdef RT_USING_OBJECT_HASH
+    type = object->type & ~RT_Object_Class_Static;
+#endif
+
     /* reset object type */
     object->type = 0;
 
@@ -280,12 +492,15 @@ void rt_object_detach(rt_object_t object)
 
     /* remove from old list */
     rt_list_remove(&(object->list));
+#ifdef RT_USING_OBJECT_HASH
+    _rt_object_hash_remove(object, type);
+#endif
 
     /* unlock interrupt */
     rt_hw_interrupt_enable(temp);
 }
 
-#ifdef RT_USING_HEAD
+#ifdef RT_USING_HEAP
 /**
  * This function will allocate an object from object system
  *
@@ -325,11 +540,15 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
     object->type = type;
 
     /* set object flag */
-    object->flag = flag;
+    object->flag = 0;
 
     /* copy name */
     rt_strncpy(object->name, name, RT_NAME_MAX);
 
+#ifdef RT_USING_OBJECT_HASH
+    _rt_object_hash_grow();
+#endif
+
     /* lock interrupt */
     temp = rt_hw_interrupt_disable();
 
@@ -344,6 +563,9 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
     {
         /* insert object into information object list */
         rt_list_insert_after(&(information->object_list), &(object->list));
+#ifdef RT_USING_OBJECT_HASH
+        _rt_object_hash_insert(object, type);
+#endif
     }
 
     /* unlock interrupt */
@@ -361,11 +583,18 @@ rt_object_t rt_object_allocate(enum rt_object_class_type type, const char *name)
 void rt_object_delete(rt_object_t object)
 {
     register rt_base_t temp;
+#ifdef RT_USING_OBJECT_HASH
+    rt_uint8_t type;
+#endif
 
     /* object check */
     RT_ASSERT(object != RT_NULL);
     RT_ASSERT(!(object->type & RT_Object_Class_Static));
 
+#ifdef RT_USING_OBJECT_HASH
+    type = object->type;
+#endif
+
     /* reset object type */
     object->type = 0;
 
@@ -374,6 +603,9 @@ void rt_object_delete(rt_object_t object)
 
     /* remove from old list */
     rt_list_remove(&(object->list));
+#ifdef RT_USING_OBJECT_HASH
+    _rt_object_hash_remove(object, type);
+#endif
 
     /* unlock interrupt */
     rt_hw_interrupt_enable(temp);
@@ -434,44 +666,56 @@ rt_uint8_t rt_object_get_type(rt_object_t object)
 rt_object_t rt_object_find(const char *name, rt_uint8_t type)
 {
     struct rt_object *object = RT_NULL;
+#ifndef RT_USING_OBJECT_HASH
     struct rt_list_node *node = RT_NULL;
     struct rt_object_information *information = RT_NULL;
+#endif
 
     /* parameter check */
-    if ((name == RT_NULL) || (type > RT_Object_Class_Unknown))
+    if ((name == RT_NULL) || (type >= RT_Object_Class_Unknown))
         return RT_NULL;
 
     /* which is invoke in interrupt status */
     RT_DEBUG_NOT_IN_INTERRUPT;
 
-    /* enter critical */
-    rt_enter_critical();
+    /* enter critical, the scheduler may be not started yet */
+    if (rt_thread_self() != RT_NULL)
+        rt_enter_critical();
 
-    /* try to find object */
-    if (information == RT_NULL)
+#ifdef RT_USING_OBJECT_HASH
+    /* try to find object in its hash bucket */
+    for (object = *_rt_object_hash_bucket(name, type);
+         object != RT_NULL;
+         object = object->hash_next)
     {
-        information = rt_object_get_information((enum rt_object_class_type)type);
-        RT_ASSERT(information != RT_NULL);
+        if ((object->type & ~RT_Object_Class_Static) == type &&
+            rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
+            break;
     }
-
-    for (node = information->object_list.next;
-         node != &(information->object_list);
-         node = node->next)
+#else
+    /* try to find object */
+    information = rt_object_get_information((enum rt_object_class_type)type);
+    if (information != RT_NULL)
     {
-        object = rt_list_entry(node, struct rt_object, list);
-        if (strncmp(object->name, name, RT_NAME_MAX) == 0)
+        for (node = information->object_list.next;
+             node != &(information->object_list);
+             node = node->next)
         {
-            /* leave critical */
-            rt_exit_critical();
-
-            return object;
+            object = rt_list_entry(node, struct rt_object, list);
+            if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
+                break;
         }
+
+        if (node == &(information->object_list))
+            object = RT_NULL;
     }
-    
+#endif
+
     /* leave critical */
-    rt_exit_critical();
+    if (rt_thread_self() != RT_NULL)
+        rt_exit_critical();
 
-    return RT_NULL;
+    return object;
 }
 
 /**@}*/
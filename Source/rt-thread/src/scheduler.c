@@ -1,11 +1,28 @@
+/*
+ * The scheduler of RT-Thread.
+ *
+ * With RT_USING_SMP every cpu has its own ready queue, see struct rt_cpu. A
+ * thread bound to a cpu by RT_THREAD_CTRL_BIND_CPU is always queued there;
+ * another thread is queued on the cpu it ran on last time, or on the cpu
+ * running the lowest priority thread if it can preempt that one and not the
+ * thread on its last cpu. The cpu is told to reschedule by an IPI.
+ *
+ * When a cpu schedules, it also looks at the ready threads not bound to a cpu
+ * in the other queues, and steals one if it's of a higher priority than its
+ * own ready threads, e.g. an idle cpu steals the threads waiting behind a
+ * busy one. The running thread is not in any ready queue, so a thread never
+ * runs on two cpus at once.
+ */
+
 #include <rtthread.h>
 #include <rthw.h>
 
+#ifndef RT_USING_SMP
 static rt_int16_t rt_scheduler_lock_nest;
 extern volatile rt_uint8_t rt_interrupt_nest;
 
 rt_list_t rt_thread_priority_table[RT_THREAD_PRIORITY_MAX];
-static rt_thread *rt_current_thread;
+struct rt_thread *rt_current_thread;
 
 rt_uint8_t rt_current_priority;
 
@@ -17,6 +34,7 @@ rt_uint8_t rt_thread_ready_table[32];
 /* Maximum priority level, 32 */
 rt_uint32_t rt_thread_ready_priority_group;
 #endif
+#endif
 
 rt_list_t rt_thread_defunct;
 
@@ -43,10 +61,24 @@ void rt_scheduler_sethook(void (*hook)(struct rt_thread *from, struct rt_thread
 /**@}*/
 #endif
 
+#ifdef RT_USING_CPU_USAGE
+/* charge the cycles ran to the thread switched out, and stamp the one in */
+rt_inline void _rt_scheduler_cycle_switch(struct rt_thread *from, struct rt_thread *to)
+{
+    rt_uint64_t cycle;
+
+    cycle = rt_hw_cycle_get();
+    if (from != RT_NULL)
+        from->cycle += cycle - from->cycle_stamp;
+    to->cycle_stamp = cycle;
+    to->switches ++;
+}
+#endif
+
 #ifdef RT_USING_OVERFLOW_CHECK
 static void _rt_scheduler_stack_check(struct rt_thread *thread)
 {
-    RT_ASSERT(thread != RT_NULL)；
+    RT_ASSERT(thread != RT_NULL);
 
     if (*((rt_uint8_t *)thread->stack_addr) != '#' || 
         (rt_uint32_t)thread->sp <= (rt_uint32_t)thread->stack_addr ||
@@ -73,6 +105,284 @@ static void _rt_scheduler_stack_check(struct rt_thread *thread)
 }
 #endif
 
+#ifdef RT_USING_SMP
+/* a steal group is one priority, or 8 priorities with 256 priority levels */
+#if RT_THREAD_PRIORITY_MAX > 32
+#define _STEAL_GROUP_SHIFT          3
+#define _STEAL_GROUP(thread)        ((thread)->number)
+#else
+#define _STEAL_GROUP_SHIFT          0
+#define _STEAL_GROUP(thread)        ((thread)->current_priority)
+#endif
+
+rt_inline rt_ubase_t _rt_cpu_highest_priority(struct rt_cpu *pcpu)
+{
+#if RT_THREAD_PRIORITY_MAX > 32
+    register rt_ubase_t number;
+
+    number = __rt_ffs(pcpu->priority_group) - 1;
+
+    return (number << 3) + __rt_ffs(pcpu->ready_table[number]) - 1;
+#else
+    return __rt_ffs(pcpu->priority_group) - 1;
+#endif
+}
+
+/*
+ * Select the cpu to queue a ready thread on: the cpu it's bound to, or the
+ * cpu it ran on last time, unless it doesn't preempt the thread running there
+ * and it preempts the lowest priority thread running on another cpu.
+ */
+static int _rt_scheduler_select_cpu(struct rt_thread *thread)
+{
+    int index, cpu_id;
+    rt_uint8_t lowest_priority;
+
+    if (thread->bind_cpu != RT_CPUS_NR)
+        return thread->bind_cpu;
+
+    cpu_id = thread->last_cpu;
+    lowest_priority = rt_cpu_index(cpu_id)->current_priority;
+    if (thread->current_priority < lowest_priority)
+        return cpu_id;
+
+    for (index = 0; index < RT_CPUS_NR; index ++)
+    {
+        if (rt_cpu_index(index)->current_priority > lowest_priority)
+        {
+            lowest_priority = rt_cpu_index(index)->current_priority;
+            cpu_id = index;
+        }
+    }
+
+    if (thread->current_priority < lowest_priority)
+        return cpu_id;
+
+    return thread->last_cpu;
+}
+
+/* insert a thread to a ready queue, with the kernel lock held */
+static void _rt_schedule_insert(struct rt_thread *thread)
+{
+    struct rt_cpu *pcpu;
+    int cpu_id;
+
+    /* it's resumed before it has switched out, just keep on running */
+    if (thread->oncpu != RT_CPU_DETACHED)
+    {
+        thread->stat = RT_THREAD_RUNNING | (thread->stat & ~RT_THREAD_STAT_MASK);
+
+        return;
+    }
+
+    /* change stat */
+    thread->stat = RT_THREAD_READY | (thread->stat & ~RT_THREAD_STAT_MASK);
+
+    cpu_id = _rt_scheduler_select_cpu(thread);
+    pcpu   = rt_cpu_index(cpu_id);
+    thread->ready_cpu = cpu_id;
+
+    /* insert thread to ready list */
+    rt_list_insert_before(&(pcpu->priority_table[thread->current_priority]),
+                          &(thread->tlist));
+
+#if RT_THREAD_PRIORITY_MAX > 32
+    pcpu->ready_table[thread->number] |= thread->high_mask;
+#endif
+    pcpu->priority_group |= thread->number_mask;
+
+    if (thread->bind_cpu == RT_CPUS_NR)
+    {
+        if (pcpu->steal_count[_STEAL_GROUP(thread)] ++ == 0)
+            pcpu->steal_group |= thread->number_mask;
+    }
+
+    /* the thread preempts the one running on another cpu */
+    if (cpu_id != rt_hw_cpu_id() && thread->current_priority < pcpu->current_priority)
+        rt_hw_ipi_send(RT_SCHEDULE_IPI, 1 << cpu_id);
+}
+
+/* remove a thread from its ready queue, with the kernel lock held */
+static void _rt_schedule_remove(struct rt_thread *thread)
+{
+    struct rt_cpu *pcpu;
+
+    /* not in a ready queue, e.g. the running thread */
+    if (thread->ready_cpu == RT_CPU_DETACHED)
+    {
+        rt_list_remove(&(thread->tlist));
+
+        return;
+    }
+
+    pcpu = rt_cpu_index(thread->ready_cpu);
+    thread->ready_cpu = RT_CPU_DETACHED;
+
+    /* remove thread from ready list */
+    rt_list_remove(&(thread->tlist));
+    if (rt_list_isempty(&(pcpu->priority_table[thread->current_priority])))
+    {
+#if RT_THREAD_PRIORITY_MAX > 32
+        pcpu->ready_table[thread->number] &= ~thread->high_mask;
+        if (pcpu->ready_table[thread->number] == 0)
+        {
+            pcpu->priority_group &= ~thread->number_mask;
+        }
+#else
+        pcpu->priority_group &= ~thread->number_mask;
+#endif
+    }
+
+    if (thread->bind_cpu == RT_CPUS_NR)
+    {
+        if (-- pcpu->steal_count[_STEAL_GROUP(thread)] == 0)
+            pcpu->steal_group &= ~thread->number_mask;
+    }
+}
+
+/* find a thread not bound to a cpu in a steal group of a cpu */
+static struct rt_thread *_rt_scheduler_steal_thread(struct rt_cpu *pcpu, rt_ubase_t group)
+{
+    struct rt_thread *thread;
+    rt_ubase_t priority;
+    rt_list_t *node;
+
+    for (priority = group << _STEAL_GROUP_SHIFT;
+         priority < (group + 1) << _STEAL_GROUP_SHIFT;
+         priority ++)
+    {
+        for (node = pcpu->priority_table[priority].next;
+             node != &(pcpu->priority_table[priority]);
+             node = node->next)
+        {
+            thread = rt_list_entry(node, struct rt_thread, tlist);
+            if (thread->bind_cpu == RT_CPUS_NR)
+                return thread;
+        }
+    }
+
+    return RT_NULL;
+}
+
+/*
+ * Get the highest priority ready thread for the cpu 'cpu_id': the first one
+ * in its ready queue, or one stolen from the queue of another cpu if that
+ * one has a higher priority. The thread is not removed from its queue.
+ */
+static struct rt_thread *_rt_scheduler_get_highest_priority_thread(int         cpu_id,
+                                                                   rt_ubase_t *highest_prio)
+{
+    struct rt_cpu *pcpu;
+    struct rt_thread *thread, *stolen;
+    rt_ubase_t highest_ready_priority, group, steal_group;
+    int index, victim;
+
+    pcpu   = rt_cpu_index(cpu_id);
+    thread = RT_NULL;
+    highest_ready_priority = RT_THREAD_PRIORITY_MAX;
+
+    if (pcpu->priority_group != 0)
+    {
+        highest_ready_priority = _rt_cpu_highest_priority(pcpu);
+        thread = rt_list_entry(pcpu->priority_table[highest_ready_priority].next,
+                               struct rt_thread,
+                               tlist);
+    }
+
+    /* look for a higher steal group in the queues of the other cpus */
+    victim = -1;
+    group  = highest_ready_priority >> _STEAL_GROUP_SHIFT;
+    for (index = 0; index < RT_CPUS_NR; index ++)
+    {
+        if (index == cpu_id || rt_cpu_index(index)->steal_group == 0)
+            continue;
+
+        steal_group = __rt_ffs(rt_cpu_index(index)->steal_group) - 1;
+        if (steal_group < group)
+        {
+            group  = steal_group;
+            victim = index;
+        }
+    }
+
+    if (victim >= 0)
+    {
+        stolen = _rt_scheduler_steal_thread(rt_cpu_index(victim), group);
+        if (stolen != RT_NULL)
+        {
+            thread = stolen;
+            highest_ready_priority = stolen->current_priority;
+        }
+    }
+
+    *highest_prio = highest_ready_priority;
+
+    return thread;
+}
+
+/* make a ready thread the running thread of a cpu */
+static void _rt_scheduler_take_thread(struct rt_cpu *pcpu, int cpu_id, struct rt_thread *thread)
+{
+    _rt_schedule_remove(thread);
+
+    thread->oncpu    = cpu_id;
+    thread->last_cpu = cpu_id;
+    thread->stat     = RT_THREAD_RUNNING | (thread->stat & ~RT_THREAD_STAT_MASK);
+
+    pcpu->current_priority = thread->current_priority;
+}
+
+/*
+ * Get the thread to run on the cpu 'cpu_id' after the current thread, with
+ * the kernel lock held. The current thread keeps the cpu if it's still running
+ * here and there is no ready thread of a higher priority, or of the same
+ * priority when it yields; otherwise it's put back to a ready queue.
+ *
+ * RT_NULL is returned if the current thread is suspended and there is no
+ * ready thread for this cpu, which happens when its idle thread waits, e.g.
+ * for the heap while deleting a thread.
+ */
+static struct rt_thread *_rt_scheduler_get_switch_thread(struct rt_cpu *pcpu, int cpu_id)
+{
+    struct rt_thread *current_thread, *to_thread;
+    rt_ubase_t highest_ready_priority;
+
+    current_thread = pcpu->current_thread;
+    to_thread = _rt_scheduler_get_highest_priority_thread(cpu_id, &highest_ready_priority);
+
+    if ((current_thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING)
+    {
+        if ((current_thread->bind_cpu == RT_CPUS_NR || current_thread->bind_cpu == cpu_id) &&
+            (to_thread == RT_NULL ||
+             current_thread->current_priority < highest_ready_priority ||
+             (current_thread->current_priority == highest_ready_priority &&
+              (current_thread->stat & RT_THREAD_STAT_YIELD_MASK) == 0)))
+        {
+            current_thread->stat &= ~RT_THREAD_STAT_YIELD_MASK;
+            pcpu->current_priority = current_thread->current_priority;
+
+            return current_thread;
+        }
+
+        current_thread->stat &= ~RT_THREAD_STAT_YIELD_MASK;
+        current_thread->oncpu = RT_CPU_DETACHED;
+        _rt_schedule_insert(current_thread);
+    }
+    else
+    {
+        /* it stays on this cpu until there is another thread to run */
+        if (to_thread == RT_NULL)
+            return RT_NULL;
+
+        current_thread->oncpu = RT_CPU_DETACHED;
+    }
+
+    _rt_scheduler_take_thread(pcpu, cpu_id, to_thread);
+
+    return to_thread;
+}
+#endif
+
 /**
  * @ingroup SystemInit
  * This function will initialize the system scheduler
@@ -80,12 +390,33 @@ static void _rt_scheduler_stack_check(struct rt_thread *thread)
 void rt_system_scheduler_init(void)
 {
     register rt_base_t offset;
+#ifdef RT_USING_SMP
+    int cpu;
+    struct rt_cpu *pcpu;
+#endif
 
+#ifndef RT_USING_SMP
     rt_scheduler_lock_nest = 0;
+#endif
 
     RT_DEBUG_LOG(RT_DEBUG_SCHEDULER, ("start scheduler: max priority 0x%02x\n",
                                       RT_THREAD_PRIORITY_MAX));
 
+#ifdef RT_USING_SMP
+    for (cpu = 0; cpu < RT_CPUS_NR; cpu ++)
+    {
+        pcpu = rt_cpu_index(cpu);
+        rt_memset(pcpu, 0, sizeof(struct rt_cpu));
+
+        for (offset = 0; offset < RT_THREAD_PRIORITY_MAX; offset ++)
+        {
+            rt_list_init(&pcpu->priority_table[offset]);
+        }
+
+        pcpu->current_priority = RT_THREAD_PRIORITY_MAX - 1;
+        pcpu->current_thread   = RT_NULL;
+    }
+#else
     for (offset = 0; offset < RT_THREAD_PRIORITY_MAX; offset ++)
     {
         rt_list_init(&rt_thread_priority_table[offset]);
@@ -100,6 +431,7 @@ void rt_system_scheduler_init(void)
 #if RT_THREAD_PRIORITY_MAX > 32
     /* initialize ready table */
     rt_memset(rt_thread_ready_table, 0, sizeof(rt_thread_ready_table));
+#endif
 #endif
 
     /* initialize thread defunct */
@@ -114,6 +446,25 @@ void rt_system_scheduler_init(void)
 void rt_system_scheduler_start(void)
 {
     register struct rt_thread *to_thread;
+#ifdef RT_USING_SMP
+    rt_ubase_t highest_ready_priority;
+    int cpu_id;
+
+    /* the lock is handed to the first thread, see rt_cpus_lock_status_restore */
+    rt_hw_local_irq_disable();
+    rt_hw_spin_lock(&_cpus_lock);
+
+    cpu_id = rt_hw_cpu_id();
+    to_thread = _rt_scheduler_get_highest_priority_thread(cpu_id, &highest_ready_priority);
+    _rt_scheduler_take_thread(rt_cpu_index(cpu_id), cpu_id, to_thread);
+
+#ifdef RT_USING_CPU_USAGE
+    _rt_scheduler_cycle_switch(RT_NULL, to_thread);
+#endif
+
+    /* switch to new thread */
+    rt_hw_context_switch_to((rt_uint32_t)&to_thread->sp, to_thread);
+#else
     register rt_ubase_t highest_ready_priority;
 
 #if RT_THREAD_PRIORITY_MAX > 32
@@ -132,8 +483,13 @@ void rt_system_scheduler_start(void)
 
     rt_current_thread = to_thread;
 
+#ifdef RT_USING_CPU_USAGE
+    _rt_scheduler_cycle_switch(RT_NULL, to_thread);
+#endif
+
     /* switch to new thread */
-    rt_hw_context_switch_to((rt_uint32_t)&to_thread);
+    rt_hw_context_switch_to((rt_uint32_t)&to_thread->sp);
+#endif
 
     /* never come back */
 }
@@ -144,6 +500,317 @@ void rt_system_scheduler_start(void)
 
 /**@{*/
 
+#ifdef RT_USING_SMP
+/**
+ * This function will perform one schedule on the running cpu. It will select
+ * one thread with the highest priority level, then switch to it.
+ */
+void rt_schedule(void)
+{
+    rt_base_t level;
+    struct rt_thread *to_thread;
+    struct rt_thread *current_thread;
+    struct rt_cpu *pcpu;
+    int cpu_id;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    cpu_id = rt_hw_cpu_id();
+    pcpu   = rt_cpu_index(cpu_id);
+    current_thread = pcpu->current_thread;
+
+    if (current_thread == RT_NULL)
+    {
+        /* the scheduler is not started on this cpu */
+    }
+    else if (pcpu->irq_nest)
+    {
+        /* switch at the end of interrupt, see rt_scheduler_do_irq_switch */
+        pcpu->irq_switch_flag = 1;
+    }
+    else if (current_thread->scheduler_lock_nest == 1)
+    {
+        /* check the scheduler is enabled or not, the lock above counts one */
+        pcpu->irq_switch_flag = 0;
+
+        while ((to_thread = _rt_scheduler_get_switch_thread(pcpu, cpu_id)) == RT_NULL)
+        {
+            /*
+             * nothing to run on this cpu: let the other cpus get the lock
+             * until a thread, or the current one, is ready here
+             */
+            rt_hw_spin_unlock(&_cpus_lock);
+            rt_hw_spin_lock(&_cpus_lock);
+        }
+
+        if (to_thread != current_thread)
+        {
+            RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (current_thread, to_thread));
+#ifdef RT_USING_CPU_USAGE
+            _rt_scheduler_cycle_switch(current_thread, to_thread);
+#endif
+
+            /* switch to new thread */
+            RT_DEBUG_LOG(RT_DEBUG_SCHEDULER,
+                         ("[%d]switch to priority#%d "
+                          "thread:%.*s(sp: 0x%p), "
+                          "from thread:%.*s(sp: 0x%p\n)",
+                          cpu_id, to_thread->current_priority,
+                          RT_NAME_MAX, to_thread->name, to_thread->sp,
+                          RT_NAME_MAX, current_thread->name, current_thread->sp));
+
+#ifdef RT_USING_OVERFLOW_CHECK
+            _rt_scheduler_stack_check(to_thread);
+#endif
+
+            rt_hw_context_switch((rt_uint32_t)&current_thread->sp,
+                                 (rt_uint32_t)&to_thread->sp, to_thread);
+
+            /* switched back, maybe on another cpu */
+#ifdef RT_USING_SIGNALS
+            {
+                extern void rt_thread_handle_sig(rt_bool_t clean_state);
+
+                /* enable interrupt */
+                rt_hw_interrupt_enable(level);
+
+                /* check signal status */
+                rt_thread_handle_sig(RT_TRUE);
+
+                return;
+            }
+#endif
+        }
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function will perform the schedule requested in interrupt, it's
+ * invoked by the cpu port when the outermost interrupt returns.
+ *
+ * @param context the interrupted context, which is defined by the cpu port
+ */
+void rt_scheduler_do_irq_switch(void *context)
+{
+    rt_base_t level;
+    struct rt_thread *to_thread;
+    struct rt_thread *current_thread;
+    struct rt_cpu *pcpu;
+    int cpu_id;
+
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
+
+    cpu_id = rt_hw_cpu_id();
+    pcpu   = rt_cpu_index(cpu_id);
+    current_thread = pcpu->current_thread;
+
+    if (pcpu->irq_switch_flag && current_thread != RT_NULL &&
+        current_thread->scheduler_lock_nest == 1 && pcpu->irq_nest == 0)
+    {
+        pcpu->irq_switch_flag = 0;
+
+        /* a suspending thread is interrupted, it switches by rt_schedule */
+        to_thread = _rt_scheduler_get_switch_thread(pcpu, cpu_id);
+        if (to_thread != RT_NULL && to_thread != current_thread)
+        {
+            RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (current_thread, to_thread));
+#ifdef RT_USING_CPU_USAGE
+            _rt_scheduler_cycle_switch(current_thread, to_thread);
+#endif
+
+            RT_DEBUG_LOG(RT_DEBUG_SCHEDULER, ("switch in interrupt\n"));
+
+#ifdef RT_USING_OVERFLOW_CHECK
+            _rt_scheduler_stack_check(to_thread);
+#endif
+
+            /*
+             * The interrupted thread didn't hold the lock, the one taken above
+             * is handed to the new thread, and released when the interrupted
+             * thread is switched in again.
+             */
+            current_thread->cpus_lock_nest --;
+            current_thread->scheduler_lock_nest --;
+
+            rt_hw_context_switch_interrupt(context,
+                                           (rt_uint32_t)&current_thread->sp,
+                                           (rt_uint32_t)&to_thread->sp,
+                                           to_thread);
+
+            rt_hw_local_irq_enable(level);
+
+            return;
+        }
+    }
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+}
+
+/**
+ * This function is the handler of the scheduling IPI, which is sent to a
+ * cpu when a thread preempting its running thread is put in its ready queue.
+ */
+void rt_scheduler_ipi_handler(int vector, void *param)
+{
+    rt_schedule();
+}
+
+/*
+ * This function will insert a thread to the ready queue of a cpu. The state
+ * of thread will be set as READY and remove from suspend queue.
+ *
+ * @param thread the thread to be inserted
+ * @note Please do not invoke this function in user application.
+ */
+void rt_schedule_insert_thread(struct rt_thread *thread)
+{
+    register rt_base_t temp;
+
+    RT_ASSERT(thread != RT_NULL);
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    RT_DEBUG_LOG(RT_DEBUG_SCHEDULER, ("insert thread[%.*s], the priority: %d\n",
+                                      RT_NAME_MAX, thread->name, thread->current_priority));
+
+    _rt_schedule_insert(thread);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+}
+
+/*
+ * This function will remove a thread from the ready queue of its cpu.
+ *
+ * @param thread the thread to be removed
+ *
+ * @note Please do not invoke this function in user application.
+ */
+void rt_schedule_remove_thread(struct rt_thread *thread)
+{
+    register rt_base_t temp;
+
+    RT_ASSERT(thread != RT_NULL);
+
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
+    RT_DEBUG_LOG(RT_DEBUG_SCHEDULER, ("remove thread[%.*s], the priority: %d\n",
+                                      RT_NAME_MAX, thread->name,
+                                      thread->current_priority));
+
+    _rt_schedule_remove(thread);
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+}
+
+/**
+ * This function will lock the thread scheduler of the running cpu. The
+ * kernel lock is held until rt_exit_critical, so the critical section is
+ * also exclusive among the cpus.
+ */
+void rt_enter_critical(void)
+{
+    register rt_base_t level;
+    struct rt_thread *current_thread;
+
+    /* disable interrupt */
+    level = rt_hw_local_irq_disable();
+
+    current_thread = rt_cpu_self()->current_thread;
+    if (current_thread == RT_NULL)
+    {
+        rt_hw_local_irq_enable(level);
+
+        return;
+    }
+
+    /* hold the kernel lock */
+    if (current_thread->cpus_lock_nest ++ == 0)
+    {
+        current_thread->scheduler_lock_nest ++;
+        rt_hw_spin_lock(&_cpus_lock);
+    }
+
+    /*
+     * the maximal number of nest is RT_UINT16_MAX, which is big
+     * enough and does not check here
+     */
+    current_thread->critical_lock_nest ++;
+    current_thread->scheduler_lock_nest ++;
+
+    /* enable interrupt */
+    rt_hw_local_irq_enable(level);
+}
+RTM_EXPORT(rt_enter_critical);
+
+void rt_exit_critical(void)
+{
+    register rt_base_t level;
+    struct rt_thread *current_thread;
+
+    /* disable interrupt */
+    level = rt_hw_local_irq_disable();
+
+    current_thread = rt_cpu_self()->current_thread;
+    if (current_thread == RT_NULL)
+    {
+        rt_hw_local_irq_enable(level);
+
+        return;
+    }
+
+    current_thread->critical_lock_nest --;
+    current_thread->scheduler_lock_nest --;
+
+    /* release the kernel lock */
+    if (-- current_thread->cpus_lock_nest == 0)
+    {
+        current_thread->scheduler_lock_nest --;
+        rt_hw_spin_unlock(&_cpus_lock);
+    }
+
+    if (current_thread->scheduler_lock_nest == 0)
+    {
+        /* enable interrupt */
+        rt_hw_local_irq_enable(level);
+
+        rt_schedule();
+    }
+    else
+    {
+        /* enable interrupt */
+        rt_hw_local_irq_enable(level);
+    }
+}
+RTM_EXPORT(rt_exit_critical);
+
+rt_uint16_t rt_critical_level(void)
+{
+    rt_base_t level;
+    rt_uint16_t critical_lvl = 0;
+    struct rt_thread *current_thread;
+
+    level = rt_hw_local_irq_disable();
+
+    current_thread = rt_cpu_self()->current_thread;
+    if (current_thread != RT_NULL)
+        critical_lvl = current_thread->critical_lock_nest;
+
+    rt_hw_local_irq_enable(level);
+
+    return critical_lvl;
+}
+RTM_EXPORT(rt_critical_level);
+#else
 /**
  * This function will perform one schedule. It will select one thread
  * with the highest priority level, then switch to it.
@@ -184,6 +851,9 @@ void rt_schedule(void)
             rt_current_thread   = to_thread;
 
             RT_OBJECT_HOOK_CALL(rt_scheduler_hook, (from_thread, to_thread));
+#ifdef RT_USING_CPU_USAGE
+            _rt_scheduler_cycle_switch(from_thread, to_thread);
+#endif
 
             /* switch to new thread */
             RT_DEBUG_LOG(RT_DEBUG_SCHEDULER,
@@ -203,7 +873,7 @@ void rt_schedule(void)
                 extern void rt_thread_handle_sig(rt_bool_t clean_state);
 
                 rt_hw_context_switch((rt_uint32_t)&from_thread->sp,
-                                     (rt_uint32_t)%to_thread->sp);
+                                     (rt_uint32_t)&to_thread->sp);
 
                 /* enable interrupt */
                 rt_hw_interrupt_enable(level);
@@ -363,7 +1033,7 @@ void rt_exit_critical(void)
         /* enable interrupt */
         rt_hw_interrupt_enable(level);
 
-        rt_scheduler();
+        rt_schedule();
     }
     else
     {
@@ -378,5 +1048,6 @@ rt_uint16_t rt_critical_level(void)
     return rt_scheduler_lock_nest;
 }
 RTM_EXPORT(rt_critical_level);
+#endif
 
 /**@}*/
@@ -1,8 +1,10 @@
 #include <rtthread.h>
 #include <rthw.h>
 
+#ifndef RT_USING_SMP
 extern rt_list_t rt_thread_priority_table[RT_THREAD_PRIORITY_MAX];
 extern struct rt_thread *rt_current_thread;
+#endif
 extern rt_list_t rt_thread_defunct;
 
 #ifdef RT_USING_HOOK
@@ -50,13 +52,22 @@ void rt_thread_inited_sethook(void (*hook)(rt_thread_t thread))
 
 #endif
 
+#ifdef RT_USING_SMP
+/* make the cpu running the thread reschedule, with the kernel lock held */
+static void _rt_thread_kick(struct rt_thread *thread)
+{
+    if (thread->oncpu != RT_CPU_DETACHED && thread->oncpu != rt_hw_cpu_id())
+        rt_hw_ipi_send(RT_SCHEDULE_IPI, 1 << thread->oncpu);
+}
+#endif
+
 void rt_thread_exit(void)
 {
     struct rt_thread *thread;
     register rt_base_t level;
 
     /* get current thread */
-    thread = rt_current_thread;
+    thread = rt_thread_self();
 
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
@@ -81,11 +92,14 @@ void rt_thread_exit(void)
         rt_list_insert_after(&rt_thread_defunct, &(thread->tlist));
     }
 
+    /*
+     * switch to next task, the interrupt is still disabled so the idle
+     * thread of another cpu doesn't release the stack under our feet
+     */
+    rt_schedule();
+
     /* enable interrupt */
     rt_hw_interrupt_enable(level);
-
-    /* switch to next task */
-    rt_schedule();
 }
 
 static rt_err_t _rt_thread_init(struct rt_thread *thread,
@@ -104,6 +118,10 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->parameter = parameter;
 
     /* stack init */
+#ifdef RT_HW_STACK_MIN
+    /* the port needs so much stack, e.g. for the signal handlers of posix */
+    RT_ASSERT(stack_size >= RT_HW_STACK_MIN);
+#endif
     thread->stack_addr = stack_start;
     thread->stack_size = stack_size;
 
@@ -125,6 +143,26 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->high_mask   = 0;
 #endif
 
+#ifdef RT_USING_MUTEX
+    /* no mutex held or waited */
+    thread->pending_object = RT_NULL;
+    rt_list_init(&(thread->taken_object_list));
+#endif
+
+#ifdef RT_USING_IPC_PROFILE
+    /* trying no IPC object */
+    thread->profile_object = RT_NULL;
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+    /* never ran */
+    thread->cycle        = 0;
+    thread->cycle_stamp  = 0;
+    thread->cycle_period = 0;
+    thread->switches     = 0;
+    thread->usage        = 0;
+#endif
+
     /* tick init */
     thread->init_tick      = tick;
     thread->remaining_tick = tick;
@@ -137,6 +175,18 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
     thread->cleanup   = 0;
     thread->user_data = 0;
 
+#ifdef RT_USING_SMP
+    /* not bound to any cpu, and queued on the creating cpu first */
+    thread->bind_cpu  = RT_CPUS_NR;
+    thread->oncpu     = RT_CPU_DETACHED;
+    thread->ready_cpu = RT_CPU_DETACHED;
+    thread->last_cpu  = rt_hw_cpu_id();
+
+    thread->scheduler_lock_nest = 0;
+    thread->cpus_lock_nest      = 0;
+    thread->critical_lock_nest  = 0;
+#endif
+
     /* init thread timer */
     rt_timer_init(&(thread->thread_timer),
                   thread->name,
@@ -156,7 +206,7 @@ static rt_err_t _rt_thread_init(struct rt_thread *thread,
 #endif
 
 #ifdef RT_USING_LWP
-    thread->lwp = RT_NULL；
+    thread->lwp = RT_NULL;
 #endif
 
     RT_OBJECT_HOOK_CALL(rt_thread_inited_hook, (thread));
@@ -191,7 +241,7 @@ rt_err_t rt_thread_init(struct rt_thread *thread,
                         void             *parameter,
                         void             *stack_start,
                         rt_uint32_t       stack_size,
-                        rt_uint32_t       priority,
+                        rt_uint8_t        priority,
                         rt_uint32_t       tick)
 {
     /* thread check */
@@ -219,7 +269,19 @@ RTM_EXPORT(rt_thread_init);
  */
 rt_thread_t rt_thread_self(void)
 {
+#ifdef RT_USING_SMP
+    rt_base_t lock;
+    rt_thread_t self;
+
+    /* no migration between getting the cpu and its thread */
+    lock = rt_hw_local_irq_disable();
+    self = rt_cpu_self()->current_thread;
+    rt_hw_local_irq_enable(lock);
+
+    return self;
+#else
     return rt_current_thread;
+#endif
 }
 RTM_EXPORT(rt_thread_self);
 
@@ -262,7 +324,7 @@ rt_err_t rt_thread_startup(rt_thread_t thread)
         rt_schedule();
     }
     
-    return RT_EOK；
+    return RT_EOK;
 }
 RTM_EXPORT(rt_thread_startup);
 
@@ -283,6 +345,9 @@ rt_err_t rt_thread_detach(rt_thread_t thread)
     RT_ASSERT(rt_object_get_type((rt_object_t)thread) == RT_Object_Class_Thread);
     RT_ASSERT(rt_object_is_systemobject((rt_object_t)thread));
 
+    /* disable interrupt */
+    lock = rt_hw_interrupt_disable();
+
     if ((thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_INIT)
     {
         /* remove from schedule */
@@ -300,16 +365,18 @@ rt_err_t rt_thread_detach(rt_thread_t thread)
 
     if (thread->cleanup != RT_NULL)
     {
-        /* disable interrupt */
-        lock = rt_hw_interrupt_disable();
-
         /* insert to defunct thread list */
         rt_list_insert_after(&rt_thread_defunct, &(thread->tlist));
-
-        /* enable interrupt */
-        rt_hw_interrupt_enable(lock);
     }
 
+#ifdef RT_USING_SMP
+    /* it may be running on another cpu */
+    _rt_thread_kick(thread);
+#endif
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(lock);
+
     return RT_EOK;
 }
 RTM_EXPORT(rt_thread_detach);
@@ -382,6 +449,9 @@ rt_err_t rt_thread_delete(rt_thread_t thread)
     RT_ASSERT(rt_object_get_type((rt_object_t)thread) == RT_Object_Class_Thread);
     RT_ASSERT(rt_object_is_systemobject((rt_object_t)thread) == RT_FALSE);
 
+    /* disable interrupt */
+    lock = rt_hw_interrupt_disable();
+
     if ((thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_INIT)
     {
         /* remove from schedule */
@@ -394,12 +464,14 @@ rt_err_t rt_thread_delete(rt_thread_t thread)
     /* change stat */
     thread->stat = RT_THREAD_CLOSE;
 
-    /* disable interrupt */
-    lock = rt_hw_interrupt_disable();
-
     /* insert to defunct thread list */
     rt_list_insert_after(&rt_thread_defunct, &(thread->tlist));
 
+#ifdef RT_USING_SMP
+    /* it may be running on another cpu */
+    _rt_thread_kick(thread);
+#endif
+
     /* enable interrupt */
     rt_hw_interrupt_enable(lock);
 
@@ -415,13 +487,29 @@ RTM_EXPORT(rt_thread_delete);
  *
  * @return RT_EOK
  */
-rt_err_t rt_threead_yield(void)
+rt_err_t rt_thread_yield(void)
 {
     register rt_base_t level;
     struct rt_thread *thread;
 
+#ifdef RT_USING_SMP
     /* disable interrupt */
-    levle = rt_hw_interrupt_disable();
+    level = rt_hw_interrupt_disable();
+
+    /* the running thread is not in the ready queue, let the scheduler put it
+     * after the ready threads of the same priority */
+    thread = rt_thread_self();
+    thread->stat |= RT_THREAD_STAT_YIELD;
+
+    rt_schedule();
+
+    /* enable interrupt */
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+#else
+    /* disable interrupt */
+    level = rt_hw_interrupt_disable();
 
     /* set to current thread */
     thread = rt_current_thread;
@@ -449,6 +537,7 @@ rt_err_t rt_threead_yield(void)
     rt_hw_interrupt_enable(level);
     
     return RT_EOK;
+#endif
 }
 RTM_EXPORT(rt_thread_yield);
 
@@ -467,7 +556,7 @@ rt_err_t rt_thread_sleep(rt_tick_t tick)
     /* disable interrupt */
     temp = rt_hw_interrupt_disable();
     /* set to current thread */
-    thread = rt_current_thread;
+    thread = rt_thread_self();
     RT_ASSERT(thread != RT_NULL);
     RT_ASSERT(rt_object_get_type((rt_object_t)thread) == RT_Object_Class_Thread);
 
@@ -527,7 +616,11 @@ RTM_EXPORT(rt_thread_mdelay);
  * @param cmd the control command, which includes
  *  RT_THREAD_CTRL_CHANGE_PRIORITY for changing priority level of thread;
  *  RT_THREAD_CTRL_STARTUP for starting a thread;
- *  RT_THREAD_CTRL_CLOSE for delete a thread.
+ *  RT_THREAD_CTRL_CLOSE for delete a thread;
+ *  RT_THREAD_CTRL_BIND_CPU for binding a thread to the cpu index 'arg', or to
+ *  any cpu if it's not less than RT_CPUS_NR, with RT_USING_SMP;
+ *  RT_THREAD_CTRL_INFO for getting the run-time information to the
+ *  struct rt_thread_info 'arg', with RT_USING_CPU_USAGE.
  * @param arg the argument of control command
  *
  * @return RT_EOK
@@ -547,7 +640,7 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
         temp = rt_hw_interrupt_disable();
 
         /* for ready thread, change queue */
-        if ((thread->stat & RT_THREAD_STAT) == RT_THREAD_READY)
+        if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
         {
             /* remove thread from schedule queue first */
             rt_schedule_remove_thread(thread);
@@ -579,12 +672,68 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
 #else
             thread->number_mask = 1L << thread->current_priority;
 #endif
+
+#ifdef RT_USING_SMP
+            if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING)
+            {
+                rt_cpu_index(thread->oncpu)->current_priority = thread->current_priority;
+
+                /* a ready thread may preempt it now */
+                _rt_thread_kick(thread);
+            }
+#endif
         }
 
         /* enable interrupt */
         rt_hw_interrupt_enable(temp);
         break;
 
+#ifdef RT_USING_SMP
+    case RT_THREAD_CTRL_BIND_CPU:
+    {
+        rt_uint8_t cpu;
+
+        cpu = (rt_uint8_t)(rt_ubase_t)arg;
+        if ((rt_ubase_t)arg >= RT_CPUS_NR)
+            cpu = RT_CPUS_NR;
+
+        /* disable interrupt */
+        temp = rt_hw_interrupt_disable();
+
+        if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_READY)
+        {
+            /* move it to the ready queue of the cpu */
+            rt_schedule_remove_thread(thread);
+            thread->bind_cpu = cpu;
+            rt_schedule_insert_thread(thread);
+        }
+        else
+        {
+            thread->bind_cpu = cpu;
+
+            /* the running thread moves to the cpu at next schedule */
+            if ((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_RUNNING &&
+                cpu != RT_CPUS_NR && cpu != thread->oncpu)
+            {
+                if (thread->oncpu == rt_hw_cpu_id())
+                    rt_schedule();
+                else
+                    _rt_thread_kick(thread);
+            }
+        }
+
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+        break;
+    }
+#endif
+
+#ifdef RT_USING_CPU_USAGE
+    case RT_THREAD_CTRL_INFO:
+        rt_thread_usage_get(thread, (struct rt_thread_info *)arg);
+        break;
+#endif
+
     case RT_THREAD_CTRL_STARTUP:
         return rt_thread_startup(thread);
 
@@ -597,7 +746,7 @@ rt_err_t rt_thread_control(rt_thread_t thread, int cmd, void *arg)
         break;
     }
 
-    return RT_EOK；
+    return RT_EOK;
 }
 RTM_EXPORT(rt_thread_control);
 
@@ -616,7 +765,7 @@ rt_err_t rt_thread_suspend(rt_thread_t thread)
     register rt_base_t temp;
 
     /* thread check */
-    RT_ASSERT(thread != RT_NULL)；
+    RT_ASSERT(thread != RT_NULL);
     RT_ASSERT(rt_object_get_type((rt_object_t)thread) == RT_Object_Class_Thread);
 
     /* disable interrupt */
@@ -629,6 +778,11 @@ rt_err_t rt_thread_suspend(rt_thread_t thread)
     /* stop thread timer anyway */
     rt_timer_stop(&(thread->thread_timer));
 
+#ifdef RT_USING_SMP
+    /* it may be running on another cpu */
+    _rt_thread_kick(thread);
+#endif
+
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 
@@ -655,26 +809,32 @@ rt_err_t rt_thread_resume(rt_thread_t thread)
 
     RT_DEBUG_LOG(RT_DEBUG_THREAD, ("thread resume:  %s\n", thread->name));
 
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
     if ((thread->stat & RT_THREAD_STAT_MASK) != RT_THREAD_SUSPEND)
     {
+        /* enable interrupt */
+        rt_hw_interrupt_enable(temp);
+
         RT_DEBUG_LOG(RT_DEBUG_THREAD, ("thread resume: thread disorder, %d\n", 
                                        thread->stat));
 
         return -RT_ERROR;
     } 
 
-    /* disable interrupt */
-    temp = rt_hw_interrupt_disable();
-    
     /* remove from suspend list */
     rt_list_remove(&(thread->tlist));
 
-    /* enable interrupt */
-    rt_hw_interrupt_enable(temp);
+    /* the timeout of the thread timer is no longer wanted */
+    rt_timer_stop(&(thread->thread_timer));
 
     /* insert to schedule ready list */
     rt_schedule_insert_thread(thread);
 
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
     RT_OBJECT_HOOK_CALL(rt_thread_resume_hook, (thread));
 
     return RT_EOK;
@@ -690,14 +850,18 @@ RTM_EXPORT(rt_thread_resume);
 void rt_thread_timeout(void *parameter)
 {
     struct rt_thread *thread;
+    register rt_base_t temp;
 
-    thread = (strcut rt_thread *)parameter;
+    thread = (struct rt_thread *)parameter;
 
     /* thread check */
     RT_ASSERT(thread != RT_NULL);
     RT_ASSERT((thread->stat & RT_THREAD_STAT_MASK) == RT_THREAD_SUSPEND);
     RT_ASSERT(rt_object_get_type((rt_object_t)thread) == RT_Object_Class_Thread);
 
+    /* disable interrupt */
+    temp = rt_hw_interrupt_disable();
+
     /* set error number */
     thread->error = -RT_ETIMEOUT;
 
@@ -707,6 +871,9 @@ void rt_thread_timeout(void *parameter)
     /* insert to schedule ready list */
     rt_schedule_insert_thread(thread);
 
+    /* enable interrupt */
+    rt_hw_interrupt_enable(temp);
+
     /* do schedule */
     rt_schedule();
 }
@@ -723,38 +890,7 @@ RTM_EXPORT(rt_thread_timeout);
  */
 rt_thread_t rt_thread_find(char *name)
 {
-    struct rt_object_infomation *infomation;
-    struct rt_object *object;
-    struct rt_list_node *node;
-
-    /* enter critical */
-    if (rt_thread_self() != RT_NULL)
-        rt_enter_critical;
-
-    /* try to find device object */
-    information = rt_object_get_information(RT_Object_Class_Thread);
-    RT_ASSERT(information != RT_NULL)；
-    for(node = information->object_list.next;
-        node != &(information->object_list);
-        node = node->next)
-    {
-        object = rt_list_entry(node, struct rt_object, list);
-        if (rt_strncmp(object->name, name, RT_NAME_MAX) == 0)
-        {
-            /* leave critical */
-            if (rt_thread_self() != RT_NULL)
-                rt_exit_critical();
-
-            return (rt_thread_t)object;
-        }
-    }
-
-    /* leave critical */
-    if (rt_thread_self() != RT_NULL)
-        rt_exit_critical();
-
-    /* not found */
-    return RT_NULL;
+    return (rt_thread_t)rt_object_find(name, RT_Object_Class_Thread);
 }
 RTM_EXPORT(rt_thread_find);
 
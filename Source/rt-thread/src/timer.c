@@ -1,8 +1,40 @@
 #include <rtthread.h>
 #include <rthw.h>
 
+#ifdef RT_USING_TIMER_WHEEL
+/*
+ * Hierarchical timing wheel: level 0 has one slot per tick, every slot of the
+ * level n covers a whole revolution of the level n - 1. A timer is put to the
+ * level which matches its distance to the wheel tick, and is moved down
+ * (cascaded) when the lower level wraps around, so start/stop are O(1) and
+ * the expiry is O(1) amortised.
+ */
+#ifndef RT_TIMER_WHEEL_BITS
+#define RT_TIMER_WHEEL_BITS             6
+#endif
+
+#define RT_TIMER_WHEEL_SIZE             (1UL << RT_TIMER_WHEEL_BITS)
+#define RT_TIMER_WHEEL_MASK             (RT_TIMER_WHEEL_SIZE - 1)
+/* enough levels for the timeout up to RT_TICK_MAX / 2 */
+#define RT_TIMER_WHEEL_LEVEL            ((32 + RT_TIMER_WHEEL_BITS - 1) / RT_TIMER_WHEEL_BITS)
+
+/* the wheel uses the last row of timer, same as the skip list ordering */
+#define RT_TIMER_WHEEL_ROW              (RT_TIMER_SKIP_LIST_LEVEL - 1)
+
+struct rt_timer_wheel
+{
+    rt_tick_t   tick;                                   /**< the next tick to be processed */
+    rt_uint32_t count;                                  /**< number of timers in the wheel */
+
+    rt_list_t   slot[RT_TIMER_WHEEL_LEVEL][RT_TIMER_WHEEL_SIZE];
+};
+
+/* hard timer wheel */
+static struct rt_timer_wheel rt_timer_wheel;
+#else
 /* hard timer list */
 static rt_list_t rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
+#endif
 
 #ifdef RT_USING_TIMER_SOFT
 
@@ -14,8 +46,13 @@ static rt_list_t rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
 #define RT_TIMER_THREAD_PRIO            0
 #endif
 
+#ifdef RT_USING_TIMER_WHEEL
+/* soft timer wheel */
+static struct rt_timer_wheel rt_soft_timer_wheel;
+#else
 /* soft timer list */
 static rt_list_t rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL];
+#endif
 static struct rt_thread timer_thread;
 ALIGN(RT_ALIGN_SIZE)
 static rt_uint8_t timer_thread_stack[RT_TIMER_THREAD_STACK_SIZE];
@@ -68,12 +105,187 @@ static void _rt_timer_init(rt_timer_t  timer,
     timer->init_tick    = time;
 
     /* initialize timer list */
-    for (i = 0; i < RT_TIMER_SKIP_LIST_LEVEL i++)
+    for (i = 0; i < RT_TIMER_SKIP_LIST_LEVEL; i++)
     {
         rt_list_init(&(timer->row[i]));
     }
 }
 
+#ifdef RT_USING_TIMER_WHEEL
+rt_inline struct rt_timer_wheel *_rt_timer_wheel_of(rt_timer_t timer)
+{
+#ifdef RT_USING_TIMER_SOFT
+    if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
+        return &rt_soft_timer_wheel;
+#endif
+
+    return &rt_timer_wheel;
+}
+
+static void _rt_timer_wheel_init(struct rt_timer_wheel *wheel)
+{
+    int level, index;
+
+    wheel->tick  = rt_tick_get();
+    wheel->count = 0;
+
+    for (level = 0; level < RT_TIMER_WHEEL_LEVEL; level ++)
+    {
+        for (index = 0; index < RT_TIMER_WHEEL_SIZE; index ++)
+            rt_list_init(&(wheel->slot[level][index]));
+    }
+}
+
+/* put the timer to the slot of its timeout tick, interrupt shall be disabled */
+static void _rt_timer_wheel_insert(struct rt_timer_wheel *wheel, rt_timer_t timer)
+{
+    int level;
+    rt_tick_t delta, expires;
+
+    expires = timer->timeout_tick;
+    delta   = expires - wheel->tick;
+    if (delta >= RT_TICK_MAX / 2)
+    {
+        /* already expired, invoke it at the next processed tick */
+        expires = wheel->tick;
+        delta   = 0;
+    }
+
+    for (level = 0; level < RT_TIMER_WHEEL_LEVEL - 1; level ++)
+    {
+        if (delta < (1UL << (RT_TIMER_WHEEL_BITS * (level + 1))))
+            break;
+    }
+
+    /* insert to the tail, the timers of same timeout are invoked in order */
+    rt_list_insert_before(&(wheel->slot[level][(expires >> (RT_TIMER_WHEEL_BITS * level)) & RT_TIMER_WHEEL_MASK]),
+                          &(timer->row[RT_TIMER_WHEEL_ROW]));
+    wheel->count ++;
+}
+
+/* move the timers of a slot to the lower levels */
+static void _rt_timer_wheel_cascade(struct rt_timer_wheel *wheel, int level, int index)
+{
+    struct rt_timer *timer;
+    rt_list_t *slot = &(wheel->slot[level][index]);
+
+    /* the timers of this slot are all less than one revolution of the lower
+     * level away, they never go back to this slot */
+    while (!rt_list_isempty(slot))
+    {
+        timer = rt_list_entry(slot->next, struct rt_timer, row[RT_TIMER_WHEEL_ROW]);
+
+        rt_list_remove(&(timer->row[RT_TIMER_WHEEL_ROW]));
+        wheel->count --;
+
+        _rt_timer_wheel_insert(wheel, timer);
+    }
+}
+
+/*
+ * Move the timers expired up to current_tick to the 'expired' list in the
+ * order of timeout, interrupt shall be disabled. The timers on the 'expired'
+ * list are still counted in the wheel until they are removed.
+ */
+static void _rt_timer_wheel_collect(struct rt_timer_wheel *wheel,
+                                    rt_tick_t              current_tick,
+                                    rt_list_t             *expired)
+{
+    int level, index;
+    rt_list_t *slot;
+
+    if (wheel->count == 0)
+    {
+        /* nothing to do, fast forward */
+        wheel->tick = current_tick + 1;
+
+        return;
+    }
+
+    /* process tick by tick until current_tick */
+    while ((current_tick - wheel->tick) < RT_TICK_MAX / 2)
+    {
+        index = wheel->tick & RT_TIMER_WHEEL_MASK;
+
+        /* level 0 wraps around, cascade the upper levels */
+        if (index == 0)
+        {
+            for (level = 1; level < RT_TIMER_WHEEL_LEVEL; level ++)
+            {
+                index = (wheel->tick >> (RT_TIMER_WHEEL_BITS * level)) & RT_TIMER_WHEEL_MASK;
+                _rt_timer_wheel_cascade(wheel, level, index);
+
+                if (index != 0)
+                    break;
+            }
+            index = 0;
+        }
+
+        slot = &(wheel->slot[0][index]);
+        if (!rt_list_isempty(slot))
+        {
+            /* splice the slot to the tail of expired list */
+            slot->next->prev     = expired->prev;
+            expired->prev->next  = slot->next;
+            slot->prev->next     = expired;
+            expired->prev        = slot->prev;
+            rt_list_init(slot);
+        }
+
+        wheel->tick ++;
+    }
+}
+
+/* the first timer to expire. A slot 'index' slots after the wheel tick on
+ * level n has no timer due in less than (index - 1) << (n * bits) ticks, the
+ * slots of a level are looked at until the earliest timer found so far is
+ * due before that; a slot may hold timers of the next revolution, so the
+ * first non-empty one is not enough */
+static rt_tick_t _rt_timer_wheel_next_timeout(struct rt_timer_wheel *wheel)
+{
+    int level, index, start;
+    rt_list_t *slot, *node;
+    struct rt_timer *timer;
+    rt_tick_t next = RT_TICK_MAX, delta, min_delta = RT_TICK_MAX;
+
+    if (wheel->count == 0)
+        return RT_TICK_MAX;
+
+    for (level = 0; level < RT_TIMER_WHEEL_LEVEL; level ++)
+    {
+        start = (wheel->tick >> (RT_TIMER_WHEEL_BITS * level)) & RT_TIMER_WHEEL_MASK;
+
+        for (index = 0; index < RT_TIMER_WHEEL_SIZE; index ++)
+        {
+            /* no later slot has an earlier timer */
+            if (index > 1 &&
+                (min_delta >> (RT_TIMER_WHEEL_BITS * level)) < (rt_tick_t)(index - 1))
+                break;
+
+            slot = &(wheel->slot[level][(start + index) & RT_TIMER_WHEEL_MASK]);
+            if (rt_list_isempty(slot))
+                continue;
+
+            for (node = slot->next; node != slot; node = node->next)
+            {
+                timer = rt_list_entry(node, struct rt_timer, row[RT_TIMER_WHEEL_ROW]);
+
+                delta = timer->timeout_tick - wheel->tick;
+                if (delta >= RT_TICK_MAX / 2)
+                    delta = 0;
+
+                if (delta < min_delta)
+                {
+                    min_delta = delta;
+                    next      = timer->timeout_tick;
+                }
+            }
+        }
+    }
+
+    return next;
+}
+#else
 /* the first timer always in the last row */
 static rt_tick_t rt_timer_list_next_timeout(rt_list_t timer_list[])
 {
@@ -86,20 +298,29 @@ static rt_tick_t rt_timer_list_next_timeout(rt_list_t timer_list[])
                           struct rt_timer,
                           row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
 
-    return timer->timeout;
+    return timer->timeout_tick;
 }
+#endif
 
 rt_inline void _rt_timer_remove(rt_timer_t timer)
 {
+#ifdef RT_USING_TIMER_WHEEL
+    if (!rt_list_isempty(&timer->row[RT_TIMER_WHEEL_ROW]))
+    {
+        rt_list_remove(&timer->row[RT_TIMER_WHEEL_ROW]);
+        _rt_timer_wheel_of(timer)->count --;
+    }
+#else
     int i;
 
     for (i = 0; i < RT_TIMER_SKIP_LIST_LEVEL; i++)
     {
-        rt_list_remove(&timer->low[i]);
+        rt_list_remove(&timer->row[i]);
     }
+#endif
 }
 
-#if RT_DEBUG_TIMER
+#if RT_DEBUG_TIMER && !defined(RT_USING_TIMER_WHEEL)
 static int rt_timer_count_height(struct rt_timer *timer)
 {
     int i, cnt = 0;
@@ -158,7 +379,7 @@ void rt_timer_init(rt_timer_t  timer,
     RT_ASSERT(timer != RT_NULL);
 
     /* timer object initialization */
-    rt_object_init((rt_object_t)timer, RT_Object_Class_Type_Timer, name);
+    rt_object_init((rt_object_t)timer, RT_Object_Class_Timer, name);
 
     _rt_timer_init(timer, timeout, parameter, time, flag);
 }
@@ -177,7 +398,7 @@ rt_err_t rt_timer_detach(rt_timer_t timer)
 
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Type_Timer);
+    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Timer);
     RT_ASSERT(rt_object_is_systemobject(&timer->parent));
 
     /* disable interrupt */
@@ -215,7 +436,7 @@ rt_timer_t rt_timer_create(const char *name,
     struct rt_timer *timer;
 
     /* allocate a object */
-    timer = (struct rt_timer *)rt_object_allocate(RT_Object_Class_Type_Timer, name);
+    timer = (struct rt_timer *)rt_object_allocate(RT_Object_Class_Timer, name);
     if (timer == RT_NULL)
         return timer;
 
@@ -238,7 +459,7 @@ rt_err_t rt_timer_delete(rt_timer_t timer)
 
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Type_Timer);
+    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Timer);
     RT_ASSERT(rt_object_is_systemobject(&timer->parent) == RT_FALSE);
 
     /* disable interrupt */
@@ -256,25 +477,21 @@ rt_err_t rt_timer_delete(rt_timer_t timer)
 RTM_EXPORT(rt_timer_delete);
 #endif
 
-/**
- * This function will start the timer
- *
- * @param timer the timer to be started
- *
- * @return the operation status, RT_EOK on OK, -RT_ERROR on error
- */
-rt_err_t rt_timer_start(rt_timer_t timer)
+/* start the timer to expire at 'timeout_tick' */
+static rt_err_t _rt_timer_start(rt_timer_t timer, rt_tick_t timeout_tick)
 {
+    register rt_base_t level;
+#ifndef RT_USING_TIMER_WHEEL
     unsigned int row_lvl;
     rt_list_t *timer_list;
-    register rt_base_t level;
     rt_list_t *row_head[RT_TIMER_SKIP_LIST_LEVEL];
     unsigned int tst_nr;
     static unsigned int random_nr;
+#endif
 
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Type_Timer);
+    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Timer);
 
     /* stop timer firstly */
     level = rt_hw_interrupt_disable();
@@ -291,11 +508,14 @@ rt_err_t rt_timer_start(rt_timer_t timer)
      * the max timeout tick shall not great than RT_TICK_MAX/2
      */
     RT_ASSERT(timer->init_tick < RT_TICK_MAX / 2);
-    timer->timeout_tick = rt_tick_get() + timer->init_tick;
+    timer->timeout_tick = timeout_tick;
 
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_insert(_rt_timer_wheel_of(timer), timer);
+#else
 #ifdef RT_USING_TIMER_SOFT
     if (timer->parent.flag & RT_TIMER_FLAG_SOFT_TIMER)
     {
@@ -347,21 +567,22 @@ rt_err_t rt_timer_start(rt_timer_t timer)
     random_nr++;
     tst_nr = random_nr;
 
-    rt_list_insert_after(&row_head[RT_TIMER_SKIP_LIST_LEVEL - 1],
+    rt_list_insert_after(row_head[RT_TIMER_SKIP_LIST_LEVEL - 1],
                          &(timer->row[RT_TIMER_SKIP_LIST_LEVEL - 1]));
     for (row_lvl = 2; row_lvl <= RT_TIMER_SKIP_LIST_LEVEL; row_lvl++)
     {
 
-        if (!(tst_nr & RT)TIMER_SKIP_LIST_MASK)
-            rt_list_insert_after(&row_head[RT_TIMER_SKIP_LIST_LEVEL - row_lvl],
+        if (!(tst_nr & RT_TIMER_SKIP_LIST_MASK))
+            rt_list_insert_after(row_head[RT_TIMER_SKIP_LIST_LEVEL - row_lvl],
                                  &(timer->row[RT_TIMER_SKIP_LIST_LEVEL - row_lvl]));
 
         else
             break;
 
         /* Shift over the bits we have tested. Works well with 1 bit and 2 bits. */
-        tst_nr >>= (TIMER_SKIP_LIST_MASK + 1) >> 1;
+        tst_nr >>= (RT_TIMER_SKIP_LIST_MASK + 1) >> 1;
     }
+#endif
 
     timer->parent.flag |= RT_TIMER_FLAG_ACTIVATED;
 
@@ -383,8 +604,39 @@ rt_err_t rt_timer_start(rt_timer_t timer)
 
     return RT_EOK;
 }
+
+/**
+ * This function will start the timer
+ *
+ * @param timer the timer to be started
+ *
+ * @return the operation status, RT_EOK on OK, -RT_ERROR on error
+ */
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+    /* timer check */
+    RT_ASSERT(timer != RT_NULL);
+
+    return _rt_timer_start(timer, rt_tick_get() + timer->init_tick);
+}
 RTM_EXPORT(rt_timer_start);
 
+/*
+ * Start a periodic timer again after its timeout function. The next timeout
+ * is kept on the period of the last one, so the periods passed, e.g. in a
+ * tickless sleep or a long timeout function, are skipped rather than called.
+ */
+static void _rt_timer_restart(rt_timer_t timer, rt_tick_t current_tick)
+{
+    rt_tick_t passed;
+
+    passed = current_tick - timer->timeout_tick;
+    if (passed < RT_TICK_MAX / 2 && timer->init_tick != 0)
+        _rt_timer_start(timer, current_tick + timer->init_tick - passed % timer->init_tick);
+    else
+        _rt_timer_start(timer, current_tick + timer->init_tick);
+}
+
 /**
  * This function will stop the timer
  *
@@ -398,7 +650,7 @@ rt_err_t rt_timer_stop(rt_timer_t timer)
 
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Type_Timer);
+    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Timer);
 
     if (!(timer->parent.flag & RT_TIMER_FLAG_ACTIVATED))
         return -RT_ERROR;
@@ -433,7 +685,7 @@ rt_err_t rt_timer_control(rt_timer_t timer, int cmd, void *arg)
 {
     /* timer check */
     RT_ASSERT(timer != RT_NULL);
-    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Type_Timer);
+    RT_ASSERT(rt_object_get_type(&timer->parent) == RT_Object_Class_Timer);
 
     switch (cmd)
     {
@@ -468,7 +720,11 @@ void rt_timer_check(void)
 {
     struct rt_timer *t;
     rt_tick_t current_tick;
+    rt_list_t *timer_list;
     register rt_base_t level;
+#ifdef RT_USING_TIMER_WHEEL
+    rt_list_t expired;
+#endif
 
     RT_DEBUG_LOG(RT_DEBUG_TIMER, ("timer check enter\n"));
 
@@ -477,9 +733,17 @@ void rt_timer_check(void)
     /* disable interrupt */
     level = rt_hw_interrupt_disable();
 
-    while (!rt_list_isempty(&rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]))
+#ifdef RT_USING_TIMER_WHEEL
+    rt_list_init(&expired);
+    _rt_timer_wheel_collect(&rt_timer_wheel, current_tick, &expired);
+    timer_list = &expired;
+#else
+    timer_list = &rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1];
+#endif
+
+    while (!rt_list_isempty(timer_list))
     {
-        t = rt_list_enter(rt_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1].next,
+        t = rt_list_entry(timer_list->next,
                           struct rt_timer,
                           row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
 
@@ -507,7 +771,7 @@ void rt_timer_check(void)
             {
                 /* start it */
                 t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
-                rt_timer_start(t);
+                _rt_timer_restart(t, current_tick);
             }
             else
             {
@@ -534,7 +798,11 @@ void rt_timer_check(void)
  */
 rt_tick_t rt_timer_next_timeout_tick(void)
 {
-    return rt_timer_next_timeout(rt_timer_list);
+#ifdef RT_USING_TIMER_WHEEL
+    return _rt_timer_wheel_next_timeout(&rt_timer_wheel);
+#else
+    return rt_timer_list_next_timeout(rt_timer_list);
+#endif
 }
 
 #ifdef RT_USING_TIMER_SOFT
@@ -545,8 +813,12 @@ rt_tick_t rt_timer_next_timeout_tick(void)
 void rt_soft_timer_check(void)
 {
     rt_tick_t current_tick;
-    rt_list_t *n;
+    rt_list_t *timer_list;
     struct rt_timer *t;
+    register rt_base_t level;
+#ifdef RT_USING_TIMER_WHEEL
+    rt_list_t expired;
+#endif
 
     RT_DEBUG_LOG(RT_DEBUG_TIMER, ("software timer check enter\n"));
 
@@ -555,10 +827,22 @@ void rt_soft_timer_check(void)
     /* lock scheduler */
     rt_enter_critical();
 
-    for (n = rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1].next;
-         n != &(rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1]); )
+#ifdef RT_USING_TIMER_WHEEL
+    rt_list_init(&expired);
+
+    level = rt_hw_interrupt_disable();
+    _rt_timer_wheel_collect(&rt_soft_timer_wheel, current_tick, &expired);
+    rt_hw_interrupt_enable(level);
+
+    timer_list = &expired;
+#else
+    timer_list = &rt_soft_timer_list[RT_TIMER_SKIP_LIST_LEVEL - 1];
+#endif
+
+    /* the timeout function may stop any timer, so take the first one each time */
+    while (!rt_list_isempty(timer_list))
     {
-        t = rt_list_entry(n, struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
+        t = rt_list_entry(timer_list->next, struct rt_timer, row[RT_TIMER_SKIP_LIST_LEVEL - 1]);
 
         /*
          * It supposes that the new tick shall less than the half duration of
@@ -568,11 +852,10 @@ void rt_soft_timer_check(void)
         {
             RT_OBJECT_HOOK_CALL(rt_timer_timeout_hook, (t));
 
-            /* move node to the next */
-            n = n->next;
-
             /* remove timer from timer list firstly */
+            level = rt_hw_interrupt_disable();
             _rt_timer_remove(t);
+            rt_hw_interrupt_enable(level);
 
             /* not lock scheduler when performing timeout function */
             rt_exit_critical();
@@ -592,7 +875,7 @@ void rt_soft_timer_check(void)
             {
                 /* start it */
                 t->parent.flag &= ~RT_TIMER_FLAG_ACTIVATED;
-                rt_timer_start(t);
+                _rt_timer_restart(t, current_tick);
             }
             else
             {
@@ -621,7 +904,11 @@ static void rt_thread_timer_entry(void *parameter)
     while (1)
     {
         /* get the next timeout tick */
+#ifdef RT_USING_TIMER_WHEEL
+        next_timeout = _rt_timer_wheel_next_timeout(&rt_soft_timer_wheel);
+#else
         next_timeout = rt_timer_list_next_timeout(rt_soft_timer_list);
+#endif
         if (next_timeout == RT_TICK_MAX)
         {
             /* no software timer exist, suspend self. */
@@ -656,12 +943,16 @@ static void rt_thread_timer_entry(void *parameter)
  */
 void rt_system_timer_init(void)
 {
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_init(&rt_timer_wheel);
+#else
     int i;
 
     for (i = 0; i < sizeof(rt_timer_list) / sizeof(rt_timer_list[0]); i++)
     {
         rt_list_init(rt_timer_list + i);
     }
+#endif
 }
 
 /**
@@ -669,15 +960,19 @@ void rt_system_timer_init(void)
  *
  * This function will initialize system timer thread
  */
-void rt_system_timer_thread_int(void)
+void rt_system_timer_thread_init(void)
 {
 #ifdef RT_USING_TIMER_SOFT
+#ifdef RT_USING_TIMER_WHEEL
+    _rt_timer_wheel_init(&rt_soft_timer_wheel);
+#else
     int i;
 
     for (i = 0; i < sizeof(rt_soft_timer_list) / sizeof(rt_soft_timer_list[0]); i++)
     {
         rt_list_init(rt_soft_timer_list + i);
     }
+#endif
 
     /* start software timer thread */
     rt_thread_init(&timer_thread,
@@ -0,0 +1,578 @@
+/*
+ * Two-Level Segregated Fit memory allocator.
+ *
+ * The free blocks are kept in segregated lists: the first level splits the
+ * sizes by power of two, the second level splits every power of two range
+ * into RT_TLSF_SL_COUNT linear classes. Two bitmaps tell which lists are not
+ * empty, so a suitable free block is found with two find-first-set, and the
+ * allocate, free and realloc are O(1) whatever the fragmentation is.
+ *
+ * Every block has a header with the address of the previous physical block
+ * and the size of its data, the neighbours are merged when a block is freed.
+ *
+ * The allocator is selected by RT_USING_TLSF in place of RT_USING_SMALL_MEM.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#if defined(RT_USING_HEAP) && defined(RT_USING_TLSF)
+
+#if defined(RT_USING_SMALL_MEM) || defined(RT_USING_SLAB) || defined(RT_USING_MEMHEAP_AS_HEAP)
+#error "RT_USING_TLSF can't be used with another system heap"
+#endif
+
+/* log2 of the second level classes count, at most 5 */
+#ifndef RT_TLSF_SL_INDEX_COUNT_LOG2
+#define RT_TLSF_SL_INDEX_COUNT_LOG2     5
+#endif
+
+/* the blocks shall be smaller than 1 << RT_TLSF_FL_INDEX_MAX */
+#ifndef RT_TLSF_FL_INDEX_MAX
+#define RT_TLSF_FL_INDEX_MAX            30
+#endif
+
+#if RT_ALIGN_SIZE >= 16
+#define TLSF_ALIGN_SIZE_LOG2            4
+#elif RT_ALIGN_SIZE >= 8
+#define TLSF_ALIGN_SIZE_LOG2            3
+#else
+#define TLSF_ALIGN_SIZE_LOG2            2
+#endif
+
+#define TLSF_SL_INDEX_COUNT             (1 << RT_TLSF_SL_INDEX_COUNT_LOG2)
+#define TLSF_FL_INDEX_SHIFT             (RT_TLSF_SL_INDEX_COUNT_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_FL_INDEX_COUNT             (RT_TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+#define TLSF_SMALL_BLOCK_SIZE           (1UL << TLSF_FL_INDEX_SHIFT)
+
+#if RT_TLSF_FL_INDEX_MAX > 31 || RT_TLSF_SL_INDEX_COUNT_LOG2 > 5
+#error "the TLSF bitmaps are 32 bits"
+#endif
+
+/* the low bit of block size, the sizes are aligned to RT_ALIGN_SIZE */
+#define TLSF_BLOCK_FREE                 0x01
+#define TLSF_BLOCK_SIZE_MASK            (~(rt_size_t)(RT_ALIGN_SIZE - 1))
+
+struct tlsf_block
+{
+    /* the previous block in memory, RT_NULL for the first one */
+    struct tlsf_block *prev_phys;
+    /* the size of data, and the free flag */
+    rt_size_t size;
+
+    /* the free list, only valid if the block is free; it's in the data */
+    struct tlsf_block *next_free;
+    struct tlsf_block *prev_free;
+};
+
+#define TLSF_HEADER_SIZE                RT_ALIGN(2 * sizeof(void *), RT_ALIGN_SIZE)
+#define TLSF_BLOCK_SIZE_MIN             RT_ALIGN(2 * sizeof(void *), RT_ALIGN_SIZE)
+#define TLSF_BLOCK_SIZE_MAX             RT_ALIGN_DOWN((1UL << RT_TLSF_FL_INDEX_MAX) - 1, RT_ALIGN_SIZE)
+
+#define TLSF_BLOCK_SIZE(b)              ((b)->size & TLSF_BLOCK_SIZE_MASK)
+#define TLSF_BLOCK_IS_FREE(b)           ((b)->size & TLSF_BLOCK_FREE)
+#define TLSF_BLOCK_DATA(b)              ((void *)((rt_uint8_t *)(b) + TLSF_HEADER_SIZE))
+#define TLSF_BLOCK_FROM_DATA(p)         ((struct tlsf_block *)((rt_uint8_t *)(p) - TLSF_HEADER_SIZE))
+#define TLSF_BLOCK_NEXT(b)              ((struct tlsf_block *)((rt_uint8_t *)TLSF_BLOCK_DATA(b) + TLSF_BLOCK_SIZE(b)))
+
+#ifdef RT_USING_HOOK
+static void (*rt_malloc_hook)(void *ptr, rt_size_t size);
+static void (*rt_free_hook)(void *ptr);
+
+/**
+ * @addtogroup Hook
+ */
+
+/**@{*/
+
+/**
+ * This function will set a hook function, which will be invoked when a memory
+ * block is allocated from heap memory.
+ *
+ * @param hook the hook function
+ */
+void rt_malloc_sethook(void (*hook)(void *ptr, rt_size_t size))
+{
+    rt_malloc_hook = hook;
+}
+
+/**
+ * This function will set a hook function, which will be invoked when a memory
+ * block is released to heap memory.
+ *
+ * @param hook the hook function
+ */
+void rt_free_sethook(void (*hook)(void *ptr))
+{
+    rt_free_hook = hook;
+}
+
+/**@}*/
+
+#endif
+
+/* the bitmap of non-empty first level, and of non-empty second level lists */
+static rt_uint32_t fl_bitmap;
+static rt_uint32_t sl_bitmap[TLSF_FL_INDEX_COUNT];
+static struct tlsf_block *free_blocks[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+
+static struct tlsf_block *heap_first, *heap_end;
+
+static struct rt_semaphore heap_sem;
+static rt_size_t mem_size_aligned;
+static rt_size_t used_mem, max_mem;
+
+/* the index of the most significant bit set, value shall not be zero */
+rt_inline int tlsf_fls(rt_size_t value)
+{
+    int bit = 0;
+
+    if (value & 0xffff0000) { value >>= 16; bit += 16; }
+    if (value & 0xff00)     { value >>= 8;  bit += 8;  }
+    if (value & 0xf0)       { value >>= 4;  bit += 4;  }
+    if (value & 0x0c)       { value >>= 2;  bit += 2;  }
+    if (value & 0x02)       { bit += 1; }
+
+    return bit;
+}
+
+/* the index of the least significant bit set, value shall not be zero */
+rt_inline int tlsf_ffs(rt_uint32_t value)
+{
+    return __rt_ffs((int)value) - 1;
+}
+
+/* the list where a free block of this size belongs */
+static void tlsf_mapping_insert(rt_size_t size, int *fl, int *sl)
+{
+    int f, s;
+
+    if (size < TLSF_SMALL_BLOCK_SIZE)
+    {
+        /* the small blocks are in the first list, linear */
+        f = 0;
+        s = (int)(size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT));
+    }
+    else
+    {
+        f = tlsf_fls(size);
+        s = (int)(size >> (f - RT_TLSF_SL_INDEX_COUNT_LOG2)) ^ (1 << RT_TLSF_SL_INDEX_COUNT_LOG2);
+        f -= (TLSF_FL_INDEX_SHIFT - 1);
+    }
+
+    *fl = f;
+    *sl = s;
+}
+
+/* the first list where all the blocks are large enough for this size */
+static void tlsf_mapping_search(rt_size_t size, int *fl, int *sl)
+{
+    if (size >= TLSF_SMALL_BLOCK_SIZE)
+    {
+        /* round up to the next class */
+        size += ((rt_size_t)1 << (tlsf_fls(size) - RT_TLSF_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+
+    tlsf_mapping_insert(size, fl, sl);
+}
+
+static void tlsf_insert_free(struct tlsf_block *block)
+{
+    int fl, sl;
+    struct tlsf_block *head;
+
+    tlsf_mapping_insert(TLSF_BLOCK_SIZE(block), &fl, &sl);
+
+    head = free_blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = RT_NULL;
+    if (head != RT_NULL)
+        head->prev_free = block;
+    free_blocks[fl][sl] = block;
+
+    fl_bitmap     |= (1UL << fl);
+    sl_bitmap[fl] |= (1UL << sl);
+}
+
+static void tlsf_remove_free(struct tlsf_block *block)
+{
+    int fl, sl;
+
+    tlsf_mapping_insert(TLSF_BLOCK_SIZE(block), &fl, &sl);
+
+    if (block->next_free != RT_NULL)
+        block->next_free->prev_free = block->prev_free;
+    if (block->prev_free != RT_NULL)
+        block->prev_free->next_free = block->next_free;
+    else
+        free_blocks[fl][sl] = block->next_free;
+
+    if (free_blocks[fl][sl] == RT_NULL)
+    {
+        sl_bitmap[fl] &= ~(1UL << sl);
+        if (sl_bitmap[fl] == 0)
+            fl_bitmap &= ~(1UL << fl);
+    }
+}
+
+/* find a free block of at least 'size' bytes and take it off the free list */
+static struct tlsf_block *tlsf_take_free(rt_size_t size)
+{
+    int fl, sl;
+    rt_uint32_t map;
+    struct tlsf_block *block;
+
+    tlsf_mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_INDEX_COUNT)
+        return RT_NULL;
+
+    /* the lists of this first level from the second level class */
+    map = sl_bitmap[fl] & (~0UL << sl);
+    if (map == 0)
+    {
+        /* no such block, the larger first levels */
+        map = fl_bitmap & (~0UL << (fl + 1));
+        if (map == 0)
+            return RT_NULL;
+
+        fl  = tlsf_ffs(map);
+        map = sl_bitmap[fl];
+    }
+    sl = tlsf_ffs(map);
+
+    block = free_blocks[fl][sl];
+    RT_ASSERT(block != RT_NULL && TLSF_BLOCK_SIZE(block) >= size);
+    tlsf_remove_free(block);
+
+    return block;
+}
+
+/* cut 'size' bytes of data off the block, the rest becomes a free block */
+static void tlsf_split(struct tlsf_block *block, rt_size_t size)
+{
+    struct tlsf_block *rest, *next;
+    rt_size_t block_size = TLSF_BLOCK_SIZE(block);
+
+    if (block_size < size + TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE_MIN)
+        return;
+
+    next = TLSF_BLOCK_NEXT(block);
+
+    rest = (struct tlsf_block *)((rt_uint8_t *)TLSF_BLOCK_DATA(block) + size);
+    rest->prev_phys = block;
+    rest->size      = (block_size - size - TLSF_HEADER_SIZE) | TLSF_BLOCK_FREE;
+    block->size     = size | (block->size & TLSF_BLOCK_FREE);
+
+    /* the rest can be merged with a free block after it */
+    if (TLSF_BLOCK_IS_FREE(next))
+    {
+        tlsf_remove_free(next);
+        rest->size += TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE(next);
+        next = TLSF_BLOCK_NEXT(rest);
+    }
+    next->prev_phys = rest;
+
+    tlsf_insert_free(rest);
+}
+
+/**
+ * @ingroup SystemInit
+ *
+ * This function will initialize system heap memory.
+ *
+ * @param begin_addr the beginning address of system heap memory.
+ * @param end_addr the end address of system heap memory.
+ */
+void rt_system_heap_init(void *begin_addr, void *end_addr)
+{
+    rt_ubase_t begin_align = RT_ALIGN((rt_ubase_t)begin_addr, RT_ALIGN_SIZE);
+    rt_ubase_t end_align   = RT_ALIGN_DOWN((rt_ubase_t)end_addr, RT_ALIGN_SIZE);
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    if (end_align <= begin_align ||
+        end_align - begin_align < 2 * TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE_MIN)
+    {
+        rt_kprintf("mem init, error, begin address 0x%lx, end address 0x%lx\n",
+                   (rt_ubase_t)begin_addr, (rt_ubase_t)end_addr);
+
+        return;
+    }
+
+    /* one header for the whole free block, one for the end block */
+    mem_size_aligned = end_align - begin_align - 2 * TLSF_HEADER_SIZE;
+    if (mem_size_aligned > TLSF_BLOCK_SIZE_MAX)
+        mem_size_aligned = TLSF_BLOCK_SIZE_MAX;
+
+    RT_DEBUG_LOG(RT_DEBUG_MEM, ("mem init, heap begin address 0x%lx, size %d\n",
+                                begin_align, mem_size_aligned));
+
+    heap_first = (struct tlsf_block *)begin_align;
+    heap_first->prev_phys = RT_NULL;
+    heap_first->size      = mem_size_aligned | TLSF_BLOCK_FREE;
+
+    /* the end block is always used and has no data, it stops the merging */
+    heap_end = TLSF_BLOCK_NEXT(heap_first);
+    heap_end->prev_phys = heap_first;
+    heap_end->size      = 0;
+
+    tlsf_insert_free(heap_first);
+
+    rt_sem_init(&heap_sem, "heap", 1, RT_IPC_FLAG_FIFO);
+}
+
+/**
+ * @addtogroup MM
+ */
+
+/**@{*/
+
+/**
+ * Allocate a block of memory with a minimum of 'size' bytes.
+ *
+ * @param size is the minimum size of the requested block in bytes.
+ *
+ * @return pointer to allocated memory or NULL if no free memory was found.
+ */
+void *rt_malloc(rt_size_t size)
+{
+    struct tlsf_block *block;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    if (size == 0 || size > TLSF_BLOCK_SIZE_MAX)
+        return RT_NULL;
+
+    /* alignment size */
+    size = RT_ALIGN(size, RT_ALIGN_SIZE);
+    if (size < TLSF_BLOCK_SIZE_MIN)
+        size = TLSF_BLOCK_SIZE_MIN;
+
+    /* take memory semaphore */
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+
+    block = tlsf_take_free(size);
+    if (block == RT_NULL)
+    {
+        rt_sem_release(&heap_sem);
+        RT_DEBUG_LOG(RT_DEBUG_MEM, ("no memory\n"));
+
+        return RT_NULL;
+    }
+
+    block->size &= ~TLSF_BLOCK_FREE;
+    tlsf_split(block, size);
+
+    used_mem += TLSF_BLOCK_SIZE(block) + TLSF_HEADER_SIZE;
+    if (max_mem < used_mem)
+        max_mem = used_mem;
+
+    rt_sem_release(&heap_sem);
+
+    RT_DEBUG_LOG(RT_DEBUG_MEM, ("allocate memory at 0x%lx, size: %d\n",
+                                (rt_ubase_t)TLSF_BLOCK_DATA(block), TLSF_BLOCK_SIZE(block)));
+
+    RT_OBJECT_HOOK_CALL(rt_malloc_hook, (TLSF_BLOCK_DATA(block), size));
+
+    return TLSF_BLOCK_DATA(block);
+}
+RTM_EXPORT(rt_malloc);
+
+/**
+ * This function will release the previously allocated memory block by
+ * rt_malloc. The released memory block is taken back to system heap.
+ *
+ * @param rmem the address of memory which will be released
+ */
+void rt_free(void *rmem)
+{
+    struct tlsf_block *block, *prev, *next;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    if (rmem == RT_NULL)
+        return;
+
+    RT_ASSERT((((rt_ubase_t)rmem) & (RT_ALIGN_SIZE - 1)) == 0);
+    RT_ASSERT((rt_uint8_t *)rmem > (rt_uint8_t *)heap_first &&
+              (rt_uint8_t *)rmem < (rt_uint8_t *)heap_end);
+
+    RT_OBJECT_HOOK_CALL(rt_free_hook, (rmem));
+
+    block = TLSF_BLOCK_FROM_DATA(rmem);
+
+    /* protect the heap from concurrent access */
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+
+    next = TLSF_BLOCK_NEXT(block);
+    if (TLSF_BLOCK_IS_FREE(block) || next->prev_phys != block)
+    {
+        rt_kprintf("to free a bad data block: 0x%lx, size: 0x%lx\n",
+                   (rt_ubase_t)rmem, block->size);
+    }
+    RT_ASSERT(!TLSF_BLOCK_IS_FREE(block));
+    RT_ASSERT(next->prev_phys == block);
+
+    used_mem -= TLSF_BLOCK_SIZE(block) + TLSF_HEADER_SIZE;
+
+    /* merge with the previous block */
+    prev = block->prev_phys;
+    if (prev != RT_NULL && TLSF_BLOCK_IS_FREE(prev))
+    {
+        tlsf_remove_free(prev);
+        prev->size += TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE(block);
+        block = prev;
+    }
+
+    /* merge with the next block */
+    if (TLSF_BLOCK_IS_FREE(next))
+    {
+        tlsf_remove_free(next);
+        block->size += TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE(next);
+        next = TLSF_BLOCK_NEXT(block);
+    }
+    next->prev_phys = block;
+
+    block->size |= TLSF_BLOCK_FREE;
+    tlsf_insert_free(block);
+
+    rt_sem_release(&heap_sem);
+}
+RTM_EXPORT(rt_free);
+
+/**
+ * This function will change the previously allocated memory block. The block
+ * is shrunk or grown into the next free block in place if possible.
+ *
+ * @param rmem pointer to memory allocated by rt_malloc
+ * @param newsize the required new size
+ *
+ * @return the changed memory block address
+ */
+void *rt_realloc(void *rmem, rt_size_t newsize)
+{
+    rt_size_t size;
+    struct tlsf_block *block, *next;
+    void *nmem;
+
+    RT_DEBUG_NOT_IN_INTERRUPT;
+
+    if (rmem == RT_NULL)
+        return rt_malloc(newsize);
+
+    if (newsize == 0)
+    {
+        rt_free(rmem);
+
+        return RT_NULL;
+    }
+
+    if (newsize > TLSF_BLOCK_SIZE_MAX)
+        return RT_NULL;
+
+    /* alignment size */
+    newsize = RT_ALIGN(newsize, RT_ALIGN_SIZE);
+    if (newsize < TLSF_BLOCK_SIZE_MIN)
+        newsize = TLSF_BLOCK_SIZE_MIN;
+
+    block = TLSF_BLOCK_FROM_DATA(rmem);
+
+    rt_sem_take(&heap_sem, RT_WAITING_FOREVER);
+
+    RT_ASSERT(!TLSF_BLOCK_IS_FREE(block));
+
+    size = TLSF_BLOCK_SIZE(block);
+    next = TLSF_BLOCK_NEXT(block);
+
+    /* grow into the next free block */
+    if (newsize > size && TLSF_BLOCK_IS_FREE(next) &&
+        size + TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE(next) >= newsize)
+    {
+        tlsf_remove_free(next);
+        block->size += TLSF_HEADER_SIZE + TLSF_BLOCK_SIZE(next);
+        TLSF_BLOCK_NEXT(block)->prev_phys = block;
+    }
+
+    if (newsize <= TLSF_BLOCK_SIZE(block))
+    {
+        tlsf_split(block, newsize);
+
+        used_mem = used_mem - size + TLSF_BLOCK_SIZE(block);
+        if (max_mem < used_mem)
+            max_mem = used_mem;
+
+        rt_sem_release(&heap_sem);
+
+        return rmem;
+    }
+
+    rt_sem_release(&heap_sem);
+
+    /* expand memory */
+    nmem = rt_malloc(newsize);
+    if (nmem != RT_NULL)
+    {
+        rt_memcpy(nmem, rmem, size < newsize ? size : newsize);
+        rt_free(rmem);
+    }
+
+    return nmem;
+}
+RTM_EXPORT(rt_realloc);
+
+/**
+ * This function will contiguously allocate enough space for count objects
+ * that are size bytes of memory each and returns a pointer to the allocated
+ * memory.
+ *
+ * The allocated memory is filled with bytes of value zero.
+ *
+ * @param count number of objects to allocate
+ * @param size size of the objects to allocate
+ *
+ * @return pointer to allocated memory / NULL pointer if there is an error
+ */
+void *rt_calloc(rt_size_t count, rt_size_t size)
+{
+    void *p;
+
+    /* allocate 'count' objects of size 'size' */
+    p = rt_malloc(count * size);
+
+    /* zero the memory */
+    if (p)
+        rt_memset(p, 0, count * size);
+
+    return p;
+}
+RTM_EXPORT(rt_calloc);
+
+void rt_memory_info(rt_uint32_t *total,
+                    rt_uint32_t *used,
+                    rt_uint32_t *max_used)
+{
+    if (total != RT_NULL)
+        *total = mem_size_aligned;
+
+    if (used != RT_NULL)
+        *used = used_mem;
+
+    if (max_used != RT_NULL)
+        *max_used = max_mem;
+}
+
+#ifdef RT_USING_FINSH
+#include <finsh.h>
+
+void list_mem(void)
+{
+    rt_kprintf("total memory: %lu\n", (unsigned long)mem_size_aligned);
+    rt_kprintf("used memory : %lu\n", (unsigned long)used_mem);
+    rt_kprintf("maximum allocated memory: %lu\n", (unsigned long)max_mem);
+}
+FINSH_FUNCTION_EXPORT(list_mem, list memory usage information)
+#endif
+
+/**@}*/
+
+#endif /* end of RT_USING_HEAP && RT_USING_TLSF */